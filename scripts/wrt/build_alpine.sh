@@ -50,7 +50,8 @@ docker run --rm --platform linux/arm64 \
     cmake .. \
         -DCMAKE_BUILD_TYPE=Release \
         -DBUILD_SHARED_LIBS=OFF \
-        -DUA_ENABLE_AMALGAMATION=ON
+        -DUA_ENABLE_AMALGAMATION=ON \
+        -DUA_ENABLE_HISTORIZING=ON
     make -j$(nproc)
     make install
     echo "open62541 安装完成"
@@ -308,6 +308,7 @@ case "$BUILD_CONFIG" in
             -DUA_ENABLE_SUBSCRIPTIONS=ON
             -DUA_ENABLE_METHODCALLS=ON
             -DUA_ENABLE_NODEMANAGEMENT=ON
+            -DUA_ENABLE_HISTORIZING=ON
             -DCMAKE_INSTALL_PREFIX="$INSTALL_PREFIX"
         )
         ;;
@@ -325,6 +326,7 @@ case "$BUILD_CONFIG" in
             -DUA_ENABLE_NODEMANAGEMENT=ON
             -DUA_ENABLE_PUBSUB=ON
             -DUA_ENABLE_PUBSUB_ETH_UADP=ON
+            -DUA_ENABLE_HISTORIZING=ON
             -DCMAKE_INSTALL_PREFIX="$INSTALL_PREFIX"
         )
         ;;
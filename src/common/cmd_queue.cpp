@@ -0,0 +1,13 @@
+#include "cmd_queue.h"
+
+bool CommandChannel::create() {
+    if (!segment_.create(CMD_SHM_NAME, sizeof(CommandQueue))) {
+        return false;
+    }
+    queue()->init();
+    return true;
+}
+
+bool CommandChannel::open() {
+    return segment_.open(CMD_SHM_NAME, sizeof(CommandQueue));
+}
@@ -0,0 +1,256 @@
+/**
+ * @file cmd_queue.h
+ * @brief 反向命令通道：协议守护进程 → rs485d
+ *
+ * 数据环形缓冲区只能从 rs485d 流向各协议守护进程。本文件定义第二条
+ * 共享内存队列，用于把 Modbus 写请求（清零、去皮、模式、设定值）
+ * 送回 rs485d，由 rs485d 转换为对测厚仪的 RTU 写操作。
+ *
+ * 设计特点:
+ * - 有界: 固定 CMD_QUEUE_SIZE 个槽位，满时 try_push() 立即失败
+ * - 无锁: 多生产者单消费者 (MPSC)，基于每槽位序号的 Vyukov 队列
+ * - 非阻塞: 生产者和消费者都不会等待，命令流量不会拖慢采集循环
+ * - 应答: 执行结果按命令 ID 写入应答表，生产者轮询获取
+ *
+ * 共享内存路径: /dev/shm/gw_cmd_queue
+ *
+ * @author Gateway Project
+ * @date 2025-10-21
+ */
+
+#ifndef GATEWAY_CMD_QUEUE_H
+#define GATEWAY_CMD_QUEUE_H
+
+#include "ndm.h"
+#include "shm_segment.h"
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+/// @brief 命令队列共享内存名称（在 /dev/shm/ 下）
+#define CMD_SHM_NAME "/gw_cmd_queue"
+
+/// @brief 命令队列槽位数（必须是 2 的幂）
+#define CMD_QUEUE_SIZE 64
+
+/// @brief 应答表槽位数（必须是 2 的幂）
+#define CMD_ACK_SLOTS 64
+
+/**
+ * @namespace GaugeCommandCode
+ * @brief 测厚仪命令代码
+ */
+namespace GaugeCommandCode {
+    constexpr uint16_t NONE     = 0;  ///< 无命令
+    constexpr uint16_t ZERO     = 1;  ///< 清零（零点校准）
+    constexpr uint16_t TARE     = 2;  ///< 去皮
+    constexpr uint16_t SET_MODE = 3;  ///< 切换测量模式（参数为模式编号）
+    constexpr uint16_t SETPOINT = 4;  ///< 写入设定值（参数为浮点数）
+    constexpr uint16_t MAX_CODE = 4;
+
+    /**
+     * @brief 命令参数是否有效（参数来自 Modbus 客户端写入的寄存器，不可信）
+     *
+     * SET_MODE 的参数须为 0-65535 的整数，SETPOINT 的参数须为有限值；
+     * 其他命令不使用参数。
+     */
+    inline bool arg_valid(uint16_t code, float arg) {
+        if (code == SET_MODE) {
+            return std::isfinite(arg) && arg >= 0.0f && arg <= 65535.0f && std::floor(arg) == arg;
+        }
+        if (code == SETPOINT) {
+            return std::isfinite(arg);
+        }
+        return true;
+    }
+}
+
+/**
+ * @namespace CommandResult
+ * @brief 命令执行状态
+ */
+namespace CommandResult {
+    constexpr uint16_t IDLE     = 0;  ///< 无命令 / 应答已被覆盖
+    constexpr uint16_t PENDING  = 1;  ///< 已入队或正在执行
+    constexpr uint16_t OK       = 2;  ///< 测厚仪已确认
+    constexpr uint16_t FAILED   = 3;  ///< 测厚仪未应答或返回异常
+    constexpr uint16_t REJECTED = 4;  ///< 队列已满 / 通道不可用 / 非法命令
+    constexpr uint16_t TIMEOUT  = 5;  ///< 生产者等待应答超时
+}
+
+/**
+ * @struct GaugeCommand
+ * @brief 单条命令
+ */
+struct GaugeCommand {
+    uint32_t id;            ///< 命令 ID（全局递增，0 保留）
+    uint16_t code;          ///< 命令代码（GaugeCommandCode）
+    uint16_t source;        ///< 来源标识（如 Modbus 单元号）
+    float    arg;           ///< 命令参数
+    uint64_t timestamp_ns;  ///< 入队时间（CLOCK_MONOTONIC）
+};
+
+/**
+ * @class CommandQueue
+ * @brief 位于共享内存中的有界 MPSC 命令队列
+ *
+ * 内存布局:
+ * ```
+ * +------------------------+
+ * | enqueue_pos (4B)       |  生产者位置
+ * | dequeue_pos (4B)       |  消费者位置
+ * | next_id     (4B)       |  命令 ID 分配器
+ * | cells[64]              |  {seq, GaugeCommand}
+ * | acks[64]   (8B each)   |  (id << 32) | result
+ * +------------------------+
+ * ```
+ */
+class CommandQueue {
+public:
+    struct Cell {
+        std::atomic<uint32_t> seq;
+        GaugeCommand cmd;
+    };
+
+    std::atomic<uint32_t> enqueue_pos{0};
+    std::atomic<uint32_t> dequeue_pos{0};
+    std::atomic<uint32_t> next_id{1};
+    Cell cells[CMD_QUEUE_SIZE];
+    std::atomic<uint64_t> acks[CMD_ACK_SLOTS];
+
+    /**
+     * @brief 初始化队列（仅创建者调用一次）
+     */
+    void init() {
+        enqueue_pos.store(0, std::memory_order_relaxed);
+        dequeue_pos.store(0, std::memory_order_relaxed);
+        next_id.store(1, std::memory_order_relaxed);
+        for (uint32_t i = 0; i < CMD_QUEUE_SIZE; i++) {
+            cells[i].seq.store(i, std::memory_order_relaxed);
+        }
+        for (uint32_t i = 0; i < CMD_ACK_SLOTS; i++) {
+            acks[i].store(0, std::memory_order_relaxed);
+        }
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    /**
+     * @brief 入队一条命令（生产者调用，非阻塞）
+     *
+     * @param code 命令代码
+     * @param arg 命令参数
+     * @param source 来源标识
+     * @param[out] out_id 分配到的命令 ID
+     * @return bool true=入队成功, false=队列已满
+     */
+    bool try_push(uint16_t code, float arg, uint16_t source, uint32_t& out_id) {
+        uint32_t pos = enqueue_pos.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells[pos & (CMD_QUEUE_SIZE - 1)];
+            uint32_t seq = cell->seq.load(std::memory_order_acquire);
+            int32_t dif = static_cast<int32_t>(seq - pos);
+            if (dif == 0) {
+                if (enqueue_pos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (dif < 0) {
+                return false;  // 队列已满
+            } else {
+                pos = enqueue_pos.load(std::memory_order_relaxed);
+            }
+        }
+
+        uint32_t id = next_id.fetch_add(1, std::memory_order_relaxed);
+        if (id == 0) {
+            id = next_id.fetch_add(1, std::memory_order_relaxed);
+        }
+        cell->cmd.id = id;
+        cell->cmd.code = code;
+        cell->cmd.source = source;
+        cell->cmd.arg = arg;
+        cell->cmd.timestamp_ns = get_timestamp_ns();
+        set_result(id, CommandResult::PENDING);
+        cell->seq.store(pos + 1, std::memory_order_release);
+
+        out_id = id;
+        return true;
+    }
+
+    /**
+     * @brief 出队一条命令（仅 rs485d 调用，非阻塞）
+     *
+     * @param[out] out 命令
+     * @return bool true=取到命令, false=队列为空
+     */
+    bool try_pop(GaugeCommand& out) {
+        uint32_t pos = dequeue_pos.load(std::memory_order_relaxed);
+        Cell* cell = &cells[pos & (CMD_QUEUE_SIZE - 1)];
+        uint32_t seq = cell->seq.load(std::memory_order_acquire);
+        if (static_cast<int32_t>(seq - (pos + 1)) < 0) {
+            return false;  // 队列为空（或生产者尚未写完）
+        }
+        out = cell->cmd;
+        dequeue_pos.store(pos + 1, std::memory_order_relaxed);
+        cell->seq.store(pos + CMD_QUEUE_SIZE, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief 写入命令执行状态
+     */
+    void set_result(uint32_t id, uint16_t result) {
+        acks[id & (CMD_ACK_SLOTS - 1)].store((static_cast<uint64_t>(id) << 32) | result,
+                                            std::memory_order_release);
+    }
+
+    /**
+     * @brief 查询命令执行状态
+     *
+     * @return uint16_t CommandResult；应答槽已被更新的命令覆盖时返回 IDLE
+     */
+    uint16_t get_result(uint32_t id) const {
+        uint64_t v = acks[id & (CMD_ACK_SLOTS - 1)].load(std::memory_order_acquire);
+        if (static_cast<uint32_t>(v >> 32) != id) {
+            return CommandResult::IDLE;
+        }
+        return static_cast<uint16_t>(v & 0xFFFF);
+    }
+};
+
+/**
+ * @class CommandChannel
+ * @brief 命令队列共享内存管理器
+ *
+ * - rs485d (消费者): 调用 create()，退出时调用 destroy()
+ * - modbusd 等 (生产者): 调用 open()；rs485d 重启后旧队列不再被消费，
+ *   生产者用 replaced() 检查并重新打开
+ */
+class CommandChannel {
+public:
+    /// @brief 创建命令队列（rs485d 调用）
+    bool create();
+
+    /// @brief 打开命令队列（协议守护进程调用）
+    bool open();
+
+    /// @brief 关闭映射
+    void close() { segment_.close(); }
+
+    /// @brief 关闭并删除命令队列（仅创建者生效）
+    void destroy() { segment_.destroy(); }
+
+    /// @brief 队列指针，未连接时为 nullptr
+    CommandQueue* queue() const { return static_cast<CommandQueue*>(segment_.data()); }
+
+    /// @brief 是否已连接
+    bool is_connected() const { return segment_.is_connected(); }
+
+    /// @brief rs485d 重启后重新创建了命令队列，需要重新 open()
+    bool replaced() const { return segment_.replaced(); }
+
+private:
+    ShmSegment segment_;
+};
+
+#endif // GATEWAY_CMD_QUEUE_H
@@ -3,12 +3,420 @@
 #include <iostream>
 #include <filesystem>
 #include <cstring>
+#include <tuple>
 
 namespace fs = std::filesystem;
 
+namespace {
+
+/**
+ * @brief 按点号分隔的路径查找节点，不复制子树
+ * @return const Json::Value* 不存在时为 nullptr
+ */
+const Json::Value* find_path(const Json::Value& root, const std::string& key) {
+    const Json::Value* current = &root;
+    size_t pos = 0;
+    while (true) {
+        const size_t found = key.find('.', pos);
+        const size_t end = (found == std::string::npos) ? key.size() : found;
+        if (!current->isObject()) {
+            return nullptr;
+        }
+        current = current->find(key.data() + pos, key.data() + end);
+        if (!current || found == std::string::npos) {
+            return current;
+        }
+        pos = found + 1;
+    }
+}
+
+std::string str_at(const Json::Value& root, const std::string& key, const std::string& default_val) {
+    const Json::Value* v = find_path(root, key);
+    return v ? v->asString() : default_val;
+}
+
+int int_at(const Json::Value& root, const std::string& key, int default_val) {
+    const Json::Value* v = find_path(root, key);
+    return v ? v->asInt() : default_val;
+}
+
+double double_at(const Json::Value& root, const std::string& key, double default_val) {
+    const Json::Value* v = find_path(root, key);
+    return v ? v->asDouble() : default_val;
+}
+
+bool bool_at(const Json::Value& root, const std::string& key, bool default_val) {
+    const Json::Value* v = find_path(root, key);
+    return v ? v->asBool() : default_val;
+}
+
+ConfigManager::DeadbandConfig parse_deadband(const Json::Value& root, const std::string& prefix) {
+    ConfigManager::DeadbandConfig cfg;
+    cfg.absolute = double_at(root, prefix + ".deadband.absolute", 0.0);
+    cfg.percent = double_at(root, prefix + ".deadband.percent", 0.0);
+    cfg.heartbeat_ms = int_at(root, prefix + ".deadband.heartbeat_ms", 1000);
+    return cfg;
+}
+
+ConfigManager::OutboxConfig parse_outbox(const Json::Value& root, const std::string& prefix,
+                                          const std::string& default_path) {
+    ConfigManager::OutboxConfig cfg;
+    cfg.enabled = bool_at(root, prefix + ".outbox.enabled", false);
+    cfg.capacity = int_at(root, prefix + ".outbox.capacity", 30000);
+    cfg.path = str_at(root, prefix + ".outbox.path", default_path);
+    cfg.backfill_per_cycle = int_at(root, prefix + ".outbox.backfill_per_cycle", 10);
+    return cfg;
+}
+
+ConfigManager::ReconnectConfig parse_reconnect(const Json::Value& root, const std::string& prefix) {
+    ConfigManager::ReconnectConfig cfg;
+    cfg.initial_backoff_ms = int_at(root, prefix + ".reconnect.initial_backoff_ms", 500);
+    cfg.max_backoff_ms = int_at(root, prefix + ".reconnect.max_backoff_ms", 30000);
+    cfg.probe_timeout_ms = int_at(root, prefix + ".reconnect.probe_timeout_ms", 1000);
+    return cfg;
+}
+
+void parse_s7_tags(const Json::Value& tags, std::vector<ConfigManager::S7Config::Tag>& out) {
+    if (!tags.isArray()) {
+        return;
+    }
+    for (const auto& entry : tags) {
+        ConfigManager::S7Config::Tag tag;
+        tag.field = entry.get("field", "thickness").asString();
+        tag.channel = entry.get("channel", 0).asInt();
+        tag.area = entry.get("area", "DB").asString();
+        tag.db_number = entry.get("db", -1).asInt();
+        tag.offset = entry.get("offset", 0).asInt();
+        tag.type = entry.get("type", "REAL").asString();
+        tag.byte_order = entry.get("byte_order", "big").asString();
+        tag.scale = entry.get("scale", 1.0).asDouble();
+        out.push_back(tag);
+    }
+}
+
+ConfigManager::RS485Config parse_rs485(const Json::Value& root) {
+    ConfigManager::RS485Config cfg;
+    cfg.device = str_at(root, "rs485.device", "/dev/ttyUSB0");
+    cfg.baudrate = int_at(root, "rs485.baudrate", 19200);
+    cfg.poll_rate_ms = int_at(root, "rs485.poll_rate_ms", 10);
+    cfg.timeout_ms = int_at(root, "rs485.timeout_ms", 200);
+    cfg.retry_count = int_at(root, "rs485.retry_count", 3);
+    cfg.simulate = bool_at(root, "rs485.simulate", false);
+    cfg.commands.slave_address = int_at(root, "rs485.commands.slave_address", 1);
+    cfg.commands.zero_register = int_at(root, "rs485.commands.zero_register", -1);
+    cfg.commands.tare_register = int_at(root, "rs485.commands.tare_register", -1);
+    cfg.commands.mode_register = int_at(root, "rs485.commands.mode_register", -1);
+    cfg.commands.setpoint_register = int_at(root, "rs485.commands.setpoint_register", -1);
+    return cfg;
+}
+
+ConfigManager::ModbusConfig parse_modbus(const Json::Value& root) {
+    ConfigManager::ModbusConfig cfg;
+    cfg.enabled = bool_at(root, "protocol.modbus.enabled", true);
+    cfg.listen_ip = str_at(root, "protocol.modbus.listen_ip", "0.0.0.0");
+    cfg.port = int_at(root, "protocol.modbus.port", 1502);
+    cfg.slave_id = int_at(root, "protocol.modbus.slave_id", 1);
+    cfg.rtu_enabled = bool_at(root, "protocol.modbus.rtu.enabled", false);
+    cfg.rtu_device = str_at(root, "protocol.modbus.rtu.device", "/dev/ttyS1");
+    cfg.rtu_baudrate = int_at(root, "protocol.modbus.rtu.baudrate", 19200);
+    cfg.rtu_parity = str_at(root, "protocol.modbus.rtu.parity", "N");
+    cfg.rtu_stop_bits = int_at(root, "protocol.modbus.rtu.stop_bits", 1);
+    cfg.rtu_slave_id = int_at(root, "protocol.modbus.rtu.slave_id", cfg.slave_id);
+    cfg.rtu_frame_gap_us = int_at(root, "protocol.modbus.rtu.frame_gap_us", 0);
+    
+    const Json::Value& units = root["protocol"]["modbus"]["units"];
+    if (units.isArray()) {
+        for (const auto& entry : units) {
+            ConfigManager::ModbusConfig::UnitRoute route;
+            route.unit_id = entry.get("unit_id", 1).asInt();
+            route.channel = entry.get("channel", 0).asInt();
+            cfg.units.push_back(route);
+        }
+    }
+    if (cfg.units.empty()) {
+        ConfigManager::ModbusConfig::UnitRoute route;
+        route.unit_id = cfg.slave_id;
+        route.channel = 0;
+        cfg.units.push_back(route);
+    }
+    return cfg;
+}
+
+ConfigManager::S7Config parse_s7(const Json::Value& root) {
+    ConfigManager::S7Config cfg;
+    cfg.name = str_at(root, "protocol.s7.name", "plc0");
+    cfg.enabled = bool_at(root, "protocol.s7.enabled", false);
+    cfg.plc_ip = str_at(root, "protocol.s7.plc_ip", "192.168.1.10");
+    cfg.rack = int_at(root, "protocol.s7.rack", 0);
+    cfg.slot = int_at(root, "protocol.s7.slot", 1);
+    cfg.db_number = int_at(root, "protocol.s7.db_number", 10);
+    cfg.update_interval_ms = int_at(root, "protocol.s7.update_interval_ms", 50);
+    cfg.async_write = bool_at(root, "protocol.s7.async_write", false);
+    cfg.ring_slots = int_at(root, "protocol.s7.sample_ring.slots", 0);
+    cfg.ring_offset = int_at(root, "protocol.s7.sample_ring.offset", 256);
+    cfg.ring_channel = int_at(root, "protocol.s7.sample_ring.channel", 0);
+    cfg.deadband = parse_deadband(root, "protocol.s7");
+    cfg.outbox = parse_outbox(root, "protocol.s7", "/opt/gw/data/outbox_s7.bin");
+    cfg.reconnect = parse_reconnect(root, "protocol.s7");
+    
+    parse_s7_tags(root["protocol"]["s7"]["tags"], cfg.tags);
+    return cfg;
+}
+
+std::vector<ConfigManager::S7Config> parse_s7_plcs(const Json::Value& root) {
+    const ConfigManager::S7Config base = parse_s7(root);
+    std::vector<ConfigManager::S7Config> plcs;
+    
+    const Json::Value& list = root["protocol"]["s7"]["plcs"];
+    if (list.isArray()) {
+        for (Json::ArrayIndex i = 0; i < list.size(); ++i) {
+            const Json::Value& entry = list[i];
+            if (!entry.isObject()) {
+                continue;
+            }
+            // 未填写的字段继承 protocol.s7 顶层配置
+            ConfigManager::S7Config cfg = base;
+            cfg.name = entry.get("name", "plc" + std::to_string(i)).asString();
+            cfg.enabled = base.enabled && entry.get("enabled", true).asBool();
+            cfg.plc_ip = entry.get("plc_ip", base.plc_ip).asString();
+            cfg.rack = entry.get("rack", base.rack).asInt();
+            cfg.slot = entry.get("slot", base.slot).asInt();
+            cfg.db_number = entry.get("db_number", base.db_number).asInt();
+            cfg.update_interval_ms = entry.get("update_interval_ms", base.update_interval_ms).asInt();
+            cfg.async_write = entry.get("async_write", base.async_write).asBool();
+            
+            const Json::Value& ring = entry["sample_ring"];
+            if (ring.isObject()) {
+                cfg.ring_slots = ring.get("slots", base.ring_slots).asInt();
+                cfg.ring_offset = ring.get("offset", base.ring_offset).asInt();
+                cfg.ring_channel = ring.get("channel", base.ring_channel).asInt();
+            }
+            
+            if (entry.isMember("tags")) {
+                cfg.tags.clear();
+                parse_s7_tags(entry["tags"], cfg.tags);
+            }
+            
+            const Json::Value& deadband = entry["deadband"];
+            if (deadband.isObject()) {
+                cfg.deadband.absolute = deadband.get("absolute", base.deadband.absolute).asDouble();
+                cfg.deadband.percent = deadband.get("percent", base.deadband.percent).asDouble();
+                cfg.deadband.heartbeat_ms = deadband.get("heartbeat_ms", base.deadband.heartbeat_ms).asInt();
+            }
+            
+            // 每个 PLC 使用独立的 outbox 文件
+            const Json::Value& outbox = entry["outbox"];
+            cfg.outbox.path = "/opt/gw/data/outbox_s7_" + cfg.name + ".bin";
+            if (outbox.isObject()) {
+                cfg.outbox.enabled = outbox.get("enabled", base.outbox.enabled).asBool();
+                cfg.outbox.capacity = outbox.get("capacity", base.outbox.capacity).asInt();
+                cfg.outbox.path = outbox.get("path", cfg.outbox.path).asString();
+                cfg.outbox.backfill_per_cycle = outbox.get("backfill_per_cycle", base.outbox.backfill_per_cycle).asInt();
+            }
+            
+            const Json::Value& reconnect = entry["reconnect"];
+            if (reconnect.isObject()) {
+                cfg.reconnect.initial_backoff_ms = reconnect.get("initial_backoff_ms", base.reconnect.initial_backoff_ms).asInt();
+                cfg.reconnect.max_backoff_ms = reconnect.get("max_backoff_ms", base.reconnect.max_backoff_ms).asInt();
+                cfg.reconnect.probe_timeout_ms = reconnect.get("probe_timeout_ms", base.reconnect.probe_timeout_ms).asInt();
+            }
+            plcs.push_back(cfg);
+        }
+    }
+    
+    // 未配置 plcs 时只有顶层配置描述的一个 PLC
+    if (plcs.empty()) {
+        plcs.push_back(base);
+    }
+    return plcs;
+}
+
+ConfigManager::OPCUAConfig parse_opcua(const Json::Value& root) {
+    ConfigManager::OPCUAConfig cfg;
+    cfg.enabled = bool_at(root, "protocol.opcua.enabled", false);
+    cfg.mode = str_at(root, "protocol.opcua.mode", "client");
+    cfg.server_url = str_at(root, "protocol.opcua.server_url", "opc.tcp://192.168.1.20:4840");
+    cfg.security_mode = str_at(root, "protocol.opcua.security_mode", "None");
+    cfg.username = str_at(root, "protocol.opcua.username", "");
+    cfg.password = str_at(root, "protocol.opcua.password", "");
+    cfg.nodes.thickness = str_at(root, "protocol.opcua.nodes.thickness", cfg.nodes.thickness);
+    cfg.nodes.timestamp = str_at(root, "protocol.opcua.nodes.timestamp", cfg.nodes.timestamp);
+    cfg.nodes.status = str_at(root, "protocol.opcua.nodes.status", cfg.nodes.status);
+    cfg.nodes.sequence = str_at(root, "protocol.opcua.nodes.sequence", cfg.nodes.sequence);
+    cfg.max_inflight = int_at(root, "protocol.opcua.max_inflight", 8);
+    cfg.server_port = int_at(root, "protocol.opcua.server.port", 4840);
+    cfg.server_channels = int_at(root, "protocol.opcua.server.channels", 1);
+    cfg.server_history_size = int_at(root, "protocol.opcua.server.history_size", 3000);
+    cfg.server_max_queue_size = int_at(root, "protocol.opcua.server.max_queue_size", 1000);
+    cfg.pubsub.enabled = bool_at(root, "protocol.opcua.pubsub.enabled", false);
+    cfg.pubsub.url = str_at(root, "protocol.opcua.pubsub.url", cfg.pubsub.url);
+    cfg.pubsub.publisher_id = int_at(root, "protocol.opcua.pubsub.publisher_id", 1);
+    cfg.pubsub.writer_group_id = int_at(root, "protocol.opcua.pubsub.writer_group_id", 1);
+    cfg.pubsub.dataset_writer_id = int_at(root, "protocol.opcua.pubsub.dataset_writer_id", 1);
+    cfg.pubsub.ttl = int_at(root, "protocol.opcua.pubsub.ttl", 1);
+    cfg.pubsub.interface_ip = str_at(root, "protocol.opcua.pubsub.interface", "");
+    cfg.deadband = parse_deadband(root, "protocol.opcua");
+    cfg.outbox = parse_outbox(root, "protocol.opcua", "/opt/gw/data/outbox_opcua.bin");
+    cfg.reconnect = parse_reconnect(root, "protocol.opcua");
+    return cfg;
+}
+
+ConfigManager::NetworkConfig parse_network(const Json::Value& root) {
+    ConfigManager::NetworkConfig cfg;
+    cfg.mode = str_at(root, "network.eth0.mode", "dhcp");
+    cfg.ip = str_at(root, "network.eth0.ip", "192.168.1.100");
+    cfg.netmask = str_at(root, "network.eth0.netmask", "255.255.255.0");
+    cfg.gateway = str_at(root, "network.eth0.gateway", "192.168.1.1");
+    return cfg;
+}
+
+ConfigManager::StatusFileConfig parse_status_file(const Json::Value& root) {
+    ConfigManager::StatusFileConfig cfg;
+    cfg.enabled = bool_at(root, "system.status_file.enabled", true);
+    cfg.directory = str_at(root, "system.status_file.directory", "/tmp/gw-test");
+    cfg.max_rate_hz = double_at(root, "system.status_file.max_rate_hz", 1.0);
+    cfg.keepalive_s = int_at(root, "system.status_file.keepalive_s", 10);
+    return cfg;
+}
+
+bool output_active_in(const Json::Value& root, const std::string& protocol) {
+    if (!bool_at(root, "protocol." + protocol + ".enabled", protocol == "modbus")) {
+        return false;
+    }
+    const std::string active = str_at(root, "protocol.active", "all");
+    return active == "all" || active == protocol;
+}
+
+} // namespace
+
 ConfigManager::ConfigManager() {
     // 初始化为默认配置
     config_ = get_default_config();
+    publish_locked();
+}
+
+void ConfigManager::publish_locked() {
+    // 整个配置只在这里解析一次，读取方直接使用结构体
+    auto snap = std::make_shared<Snapshot>();
+    snap->version = version_.load(std::memory_order_relaxed) + 1;
+    snap->root = config_;
+    snap->rs485 = parse_rs485(config_);
+    snap->modbus = parse_modbus(config_);
+    snap->s7 = parse_s7(config_);
+    snap->s7_plcs = parse_s7_plcs(config_);
+    snap->opcua = parse_opcua(config_);
+    snap->network = parse_network(config_);
+    snap->status_file = parse_status_file(config_);
+    snap->active_protocol = str_at(config_, "protocol.active", "all");
+    snap->modbus_active = output_active_in(config_, "modbus");
+    snap->s7_active = output_active_in(config_, "s7");
+    snap->opcua_active = output_active_in(config_, "opcua");
+    
+    // 先替换快照再更新序号: 看到新序号的读取方一定能取到新快照
+    std::atomic_store(&snapshot_, std::shared_ptr<const Snapshot>(std::move(snap)));
+    version_.fetch_add(1, std::memory_order_release);
+}
+
+std::shared_ptr<const ConfigManager::Snapshot> ConfigManager::snapshot() const {
+    return std::atomic_load(&snapshot_);
+}
+
+const ConfigManager::Snapshot& ConfigManager::current() const {
+    thread_local std::shared_ptr<const Snapshot> cached;
+    if (!cached || cached->version != version_.load(std::memory_order_acquire)) {
+        cached = snapshot();
+    }
+    return *cached;
+}
+
+bool ConfigManager::Snapshot::output_active(const std::string& protocol) const {
+    if (protocol == "modbus") {
+        return modbus_active;
+    }
+    if (protocol == "s7") {
+        return s7_active;
+    }
+    if (protocol == "opcua") {
+        return opcua_active;
+    }
+    return output_active_in(root, protocol);
+}
+
+// 配置结构逐字段比较（ConfigWatcher 按分区比较新旧快照）
+
+bool ConfigManager::RS485Config::GaugeCommands::operator==(const GaugeCommands& o) const {
+    return std::tie(slave_address, zero_register, tare_register, mode_register, setpoint_register) ==
+           std::tie(o.slave_address, o.zero_register, o.tare_register, o.mode_register, o.setpoint_register);
+}
+
+bool ConfigManager::RS485Config::operator==(const RS485Config& o) const {
+    return std::tie(device, baudrate, poll_rate_ms, timeout_ms, retry_count, simulate, commands) ==
+           std::tie(o.device, o.baudrate, o.poll_rate_ms, o.timeout_ms, o.retry_count, o.simulate, o.commands);
+}
+
+bool ConfigManager::DeadbandConfig::operator==(const DeadbandConfig& o) const {
+    return std::tie(absolute, percent, heartbeat_ms) == std::tie(o.absolute, o.percent, o.heartbeat_ms);
+}
+
+bool ConfigManager::OutboxConfig::operator==(const OutboxConfig& o) const {
+    return std::tie(enabled, capacity, path, backfill_per_cycle) ==
+           std::tie(o.enabled, o.capacity, o.path, o.backfill_per_cycle);
+}
+
+bool ConfigManager::ReconnectConfig::operator==(const ReconnectConfig& o) const {
+    return std::tie(initial_backoff_ms, max_backoff_ms, probe_timeout_ms) ==
+           std::tie(o.initial_backoff_ms, o.max_backoff_ms, o.probe_timeout_ms);
+}
+
+bool ConfigManager::S7Config::Tag::operator==(const Tag& o) const {
+    return std::tie(field, channel, area, db_number, offset, type, byte_order, scale) ==
+           std::tie(o.field, o.channel, o.area, o.db_number, o.offset, o.type, o.byte_order, o.scale);
+}
+
+bool ConfigManager::S7Config::operator==(const S7Config& o) const {
+    return std::tie(name, enabled, plc_ip, rack, slot, db_number, update_interval_ms, async_write,
+                    ring_slots, ring_offset, ring_channel, tags, deadband, outbox, reconnect) ==
+           std::tie(o.name, o.enabled, o.plc_ip, o.rack, o.slot, o.db_number, o.update_interval_ms, o.async_write,
+                    o.ring_slots, o.ring_offset, o.ring_channel, o.tags, o.deadband, o.outbox, o.reconnect);
+}
+
+bool ConfigManager::OPCUAConfig::Nodes::operator==(const Nodes& o) const {
+    return std::tie(thickness, timestamp, status, sequence) ==
+           std::tie(o.thickness, o.timestamp, o.status, o.sequence);
+}
+
+bool ConfigManager::OPCUAConfig::PubSub::operator==(const PubSub& o) const {
+    return std::tie(enabled, url, publisher_id, writer_group_id, dataset_writer_id, ttl, interface_ip) ==
+           std::tie(o.enabled, o.url, o.publisher_id, o.writer_group_id, o.dataset_writer_id, o.ttl, o.interface_ip);
+}
+
+bool ConfigManager::OPCUAConfig::operator==(const OPCUAConfig& o) const {
+    return std::tie(enabled, mode, server_url, security_mode, username, password, nodes, max_inflight,
+                    server_port, server_channels, server_history_size, server_max_queue_size,
+                    pubsub, deadband, outbox, reconnect) ==
+           std::tie(o.enabled, o.mode, o.server_url, o.security_mode, o.username, o.password, o.nodes, o.max_inflight,
+                    o.server_port, o.server_channels, o.server_history_size, o.server_max_queue_size,
+                    o.pubsub, o.deadband, o.outbox, o.reconnect);
+}
+
+bool ConfigManager::ModbusConfig::UnitRoute::operator==(const UnitRoute& o) const {
+    return unit_id == o.unit_id && channel == o.channel;
+}
+
+bool ConfigManager::ModbusConfig::operator==(const ModbusConfig& o) const {
+    return std::tie(enabled, listen_ip, port, slave_id, rtu_enabled, rtu_device, rtu_baudrate, rtu_parity,
+                    rtu_stop_bits, rtu_slave_id, rtu_frame_gap_us, units) ==
+           std::tie(o.enabled, o.listen_ip, o.port, o.slave_id, o.rtu_enabled, o.rtu_device, o.rtu_baudrate,
+                    o.rtu_parity, o.rtu_stop_bits, o.rtu_slave_id, o.rtu_frame_gap_us, o.units);
+}
+
+bool ConfigManager::NetworkConfig::operator==(const NetworkConfig& o) const {
+    return std::tie(mode, ip, netmask, gateway) == std::tie(o.mode, o.ip, o.netmask, o.gateway);
+}
+
+bool ConfigManager::StatusFileConfig::operator==(const StatusFileConfig& o) const {
+    return std::tie(enabled, directory, max_rate_hz, keepalive_s) ==
+           std::tie(o.enabled, o.directory, o.max_rate_hz, o.keepalive_s);
 }
 
 bool ConfigManager::load(const std::string& path) {
@@ -18,7 +426,8 @@ bool ConfigManager::load(const std::string& path) {
     if (!fs::exists(path)) {
         std::cerr << "Config file not found: " << path << ", using defaults" << std::endl;
         config_ = get_default_config();
-        return save(path); // 保存默认配置
+        publish_locked();
+        return save_locked(path); // 保存默认配置
     }
     
     // 读取文件
@@ -31,19 +440,25 @@ bool ConfigManager::load(const std::string& path) {
     // 解析 JSON
     Json::CharReaderBuilder builder;
     std::string errs;
+    Json::Value parsed;
     
-    if (!Json::parseFromStream(builder, ifs, &config_, &errs)) {
+    if (!Json::parseFromStream(builder, ifs, &parsed, &errs)) {
+        // 保留当前配置（启动时即默认配置），避免热重载读到写了一半的文件时回到默认值
         std::cerr << "Failed to parse config: " << errs << std::endl;
-        config_ = get_default_config();
         return false;
     }
     
+    config_ = std::move(parsed);
+    publish_locked();
     return true;
 }
 
 bool ConfigManager::save(const std::string& path) {
     std::lock_guard<std::mutex> lock(mutex_);
-    
+    return save_locked(path);
+}
+
+bool ConfigManager::save_locked(const std::string& path) {
     // 创建目录（如果不存在）
     fs::path file_path(path);
     fs::create_directories(file_path.parent_path());
@@ -83,77 +498,29 @@ bool ConfigManager::save(const std::string& path) {
     return true;
 }
 
+Json::Value ConfigManager::get_config() const {
+    return snapshot()->root;
+}
+
 std::string ConfigManager::get_string(const std::string& key, const std::string& default_val) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
     // 支持点号分隔的嵌套路径，如 "rs485.device"
-    Json::Value current = config_;
-    size_t pos = 0;
-    size_t found;
-    
-    while ((found = key.find('.', pos)) != std::string::npos) {
-        std::string part = key.substr(pos, found - pos);
-        if (!current.isMember(part)) {
-            return default_val;
-        }
-        current = current[part];
-        pos = found + 1;
-    }
-    
-    std::string last_part = key.substr(pos);
-    if (!current.isMember(last_part)) {
-        return default_val;
-    }
-    
-    return current[last_part].asString();
+    const auto snap = snapshot();
+    return str_at(snap->root, key, default_val);
 }
 
 int ConfigManager::get_int(const std::string& key, int default_val) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    Json::Value current = config_;
-    size_t pos = 0;
-    size_t found;
-    
-    while ((found = key.find('.', pos)) != std::string::npos) {
-        std::string part = key.substr(pos, found - pos);
-        if (!current.isMember(part)) {
-            return default_val;
-        }
-        current = current[part];
-        pos = found + 1;
-    }
-    
-    std::string last_part = key.substr(pos);
-    if (!current.isMember(last_part)) {
-        return default_val;
-    }
-    
-    return current[last_part].asInt();
+    const auto snap = snapshot();
+    return int_at(snap->root, key, default_val);
+}
+
+double ConfigManager::get_double(const std::string& key, double default_val) const {
+    const auto snap = snapshot();
+    return double_at(snap->root, key, default_val);
 }
 
 bool ConfigManager::get_bool(const std::string& key, bool default_val) const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    
-    Json::Value current = config_;
-    size_t pos = 0;
-    size_t found;
-    
-    while ((found = key.find('.', pos)) != std::string::npos) {
-        std::string part = key.substr(pos, found - pos);
-        if (!current.isMember(part)) {
-            return default_val;
-        }
-        current = current[part];
-        pos = found + 1;
-    }
-    
-    std::string last_part = key.substr(pos);
-    if (!current.isMember(last_part)) {
-        return default_val;
-    }
-    
-    return current[last_part].asBool();
+    const auto snap = snapshot();
+    return bool_at(snap->root, key, default_val);
 }
 
 void ConfigManager::set(const std::string& key, const Json::Value& value) {
@@ -175,61 +542,45 @@ void ConfigManager::set(const std::string& key, const Json::Value& value) {
     
     std::string last_part = key.substr(pos);
     (*current)[last_part] = value;
+    publish_locked();
 }
 
 ConfigManager::RS485Config ConfigManager::get_rs485_config() const {
-    RS485Config cfg;
-    cfg.device = get_string("rs485.device", "/dev/ttyUSB0");
-    cfg.baudrate = get_int("rs485.baudrate", 19200);
-    cfg.poll_rate_ms = get_int("rs485.poll_rate_ms", 10);
-    cfg.timeout_ms = get_int("rs485.timeout_ms", 200);
-    cfg.retry_count = get_int("rs485.retry_count", 3);
-    cfg.simulate = get_bool("rs485.simulate", false);
-    return cfg;
+    return snapshot()->rs485;
 }
 
 ConfigManager::ModbusConfig ConfigManager::get_modbus_config() const {
-    ModbusConfig cfg;
-    cfg.enabled = get_bool("protocol.modbus.enabled", true);
-    cfg.listen_ip = get_string("protocol.modbus.listen_ip", "0.0.0.0");
-    cfg.port = get_int("protocol.modbus.port", 1502);
-    cfg.slave_id = get_int("protocol.modbus.slave_id", 1);
-    return cfg;
+    return snapshot()->modbus;
 }
 
 ConfigManager::S7Config ConfigManager::get_s7_config() const {
-    S7Config cfg;
-    cfg.enabled = get_bool("protocol.s7.enabled", false);
-    cfg.plc_ip = get_string("protocol.s7.plc_ip", "192.168.1.10");
-    cfg.rack = get_int("protocol.s7.rack", 0);
-    cfg.slot = get_int("protocol.s7.slot", 1);
-    cfg.db_number = get_int("protocol.s7.db_number", 10);
-    cfg.update_interval_ms = get_int("protocol.s7.update_interval_ms", 50);
-    return cfg;
+    return snapshot()->s7;
+}
+
+std::vector<ConfigManager::S7Config> ConfigManager::get_s7_plc_configs() const {
+    return snapshot()->s7_plcs;
+}
+
+bool ConfigManager::is_output_active(const std::string& protocol) const {
+    return snapshot()->output_active(protocol);
 }
 
 ConfigManager::OPCUAConfig ConfigManager::get_opcua_config() const {
-    OPCUAConfig cfg;
-    cfg.enabled = get_bool("protocol.opcua.enabled", false);
-    cfg.server_url = get_string("protocol.opcua.server_url", "opc.tcp://192.168.1.20:4840");
-    cfg.security_mode = get_string("protocol.opcua.security_mode", "None");
-    cfg.username = get_string("protocol.opcua.username", "");
-    cfg.password = get_string("protocol.opcua.password", "");
-    return cfg;
+    return snapshot()->opcua;
 }
 
 ConfigManager::NetworkConfig ConfigManager::get_network_config() const {
-    NetworkConfig cfg;
-    cfg.mode = get_string("network.eth0.mode", "dhcp");
-    cfg.ip = get_string("network.eth0.ip", "192.168.1.100");
-    cfg.netmask = get_string("network.eth0.netmask", "255.255.255.0");
-    cfg.gateway = get_string("network.eth0.gateway", "192.168.1.1");
-    return cfg;
+    return snapshot()->network;
+}
+
+ConfigManager::StatusFileConfig ConfigManager::get_status_file_config() const {
+    return snapshot()->status_file;
 }
 
 void ConfigManager::reset_to_default() {
     std::lock_guard<std::mutex> lock(mutex_);
     config_ = get_default_config();
+    publish_locked();
     std::cout << "Config reset to default" << std::endl;
 }
 
@@ -251,35 +602,96 @@ Json::Value ConfigManager::get_default_config() const {
     root["rs485"]["timeout_ms"] = 200;
     root["rs485"]["retry_count"] = 3;
     root["rs485"]["simulate"] = false;
+    root["rs485"]["commands"]["slave_address"] = 1;
+    root["rs485"]["commands"]["zero_register"] = -1;
+    root["rs485"]["commands"]["tare_register"] = -1;
+    root["rs485"]["commands"]["mode_register"] = -1;
+    root["rs485"]["commands"]["setpoint_register"] = -1;
     
     // 协议配置
-    root["protocol"]["active"] = "modbus";
+    root["protocol"]["active"] = "all";  // all=所有已启用的输出同时转发
     
     // Modbus TCP
     root["protocol"]["modbus"]["enabled"] = true;
     root["protocol"]["modbus"]["listen_ip"] = "0.0.0.0";
     root["protocol"]["modbus"]["port"] = 1502;
     root["protocol"]["modbus"]["slave_id"] = 1;
+    root["protocol"]["modbus"]["rtu"]["enabled"] = false;
+    root["protocol"]["modbus"]["rtu"]["device"] = "/dev/ttyS1";
+    root["protocol"]["modbus"]["rtu"]["baudrate"] = 19200;
+    root["protocol"]["modbus"]["rtu"]["parity"] = "N";
+    root["protocol"]["modbus"]["rtu"]["stop_bits"] = 1;
+    root["protocol"]["modbus"]["rtu"]["slave_id"] = 1;
+    root["protocol"]["modbus"]["rtu"]["frame_gap_us"] = 0;
+    root["protocol"]["modbus"]["units"] = Json::Value(Json::arrayValue);
     
     // S7 (可选)
+    root["protocol"]["s7"]["name"] = "plc0";
     root["protocol"]["s7"]["enabled"] = false;
     root["protocol"]["s7"]["plc_ip"] = "192.168.1.10";
     root["protocol"]["s7"]["rack"] = 0;
     root["protocol"]["s7"]["slot"] = 1;
     root["protocol"]["s7"]["db_number"] = 10;
     root["protocol"]["s7"]["update_interval_ms"] = 50;
+    root["protocol"]["s7"]["async_write"] = false;
+    root["protocol"]["s7"]["sample_ring"]["slots"] = 0;
+    root["protocol"]["s7"]["sample_ring"]["offset"] = 256;
+    root["protocol"]["s7"]["sample_ring"]["channel"] = 0;
+    root["protocol"]["s7"]["tags"] = Json::Value(Json::arrayValue);
+    root["protocol"]["s7"]["plcs"] = Json::Value(Json::arrayValue);
+    root["protocol"]["s7"]["deadband"]["absolute"] = 0.0;
+    root["protocol"]["s7"]["deadband"]["percent"] = 0.0;
+    root["protocol"]["s7"]["deadband"]["heartbeat_ms"] = 1000;
+    root["protocol"]["s7"]["outbox"]["enabled"] = false;
+    root["protocol"]["s7"]["outbox"]["capacity"] = 30000;
+    root["protocol"]["s7"]["outbox"]["path"] = "/opt/gw/data/outbox_s7.bin";
+    root["protocol"]["s7"]["outbox"]["backfill_per_cycle"] = 10;
+    root["protocol"]["s7"]["reconnect"]["initial_backoff_ms"] = 500;
+    root["protocol"]["s7"]["reconnect"]["max_backoff_ms"] = 30000;
+    root["protocol"]["s7"]["reconnect"]["probe_timeout_ms"] = 1000;
     
     // OPC UA (可选)
     root["protocol"]["opcua"]["enabled"] = false;
+    root["protocol"]["opcua"]["mode"] = "client";
     root["protocol"]["opcua"]["server_url"] = "opc.tcp://192.168.1.20:4840";
     root["protocol"]["opcua"]["security_mode"] = "None";
     root["protocol"]["opcua"]["username"] = "";
     root["protocol"]["opcua"]["password"] = "";
+    root["protocol"]["opcua"]["nodes"]["thickness"] = "ns=2;s=Gateway.Thickness";
+    root["protocol"]["opcua"]["nodes"]["timestamp"] = "ns=2;s=Gateway.Timestamp";
+    root["protocol"]["opcua"]["nodes"]["status"] = "ns=2;s=Gateway.Status";
+    root["protocol"]["opcua"]["nodes"]["sequence"] = "ns=2;s=Gateway.Sequence";
+    root["protocol"]["opcua"]["max_inflight"] = 8;
+    root["protocol"]["opcua"]["server"]["port"] = 4840;
+    root["protocol"]["opcua"]["server"]["channels"] = 1;
+    root["protocol"]["opcua"]["server"]["history_size"] = 3000;
+    root["protocol"]["opcua"]["server"]["max_queue_size"] = 1000;
+    root["protocol"]["opcua"]["pubsub"]["enabled"] = false;
+    root["protocol"]["opcua"]["pubsub"]["url"] = "opc.udp://239.0.0.1:4840";
+    root["protocol"]["opcua"]["pubsub"]["publisher_id"] = 1;
+    root["protocol"]["opcua"]["pubsub"]["writer_group_id"] = 1;
+    root["protocol"]["opcua"]["pubsub"]["dataset_writer_id"] = 1;
+    root["protocol"]["opcua"]["pubsub"]["ttl"] = 1;
+    root["protocol"]["opcua"]["pubsub"]["interface"] = "";
+    root["protocol"]["opcua"]["deadband"]["absolute"] = 0.0;
+    root["protocol"]["opcua"]["deadband"]["percent"] = 0.0;
+    root["protocol"]["opcua"]["deadband"]["heartbeat_ms"] = 1000;
+    root["protocol"]["opcua"]["outbox"]["enabled"] = false;
+    root["protocol"]["opcua"]["outbox"]["capacity"] = 30000;
+    root["protocol"]["opcua"]["outbox"]["path"] = "/opt/gw/data/outbox_opcua.bin";
+    root["protocol"]["opcua"]["outbox"]["backfill_per_cycle"] = 10;
+    root["protocol"]["opcua"]["reconnect"]["initial_backoff_ms"] = 500;
+    root["protocol"]["opcua"]["reconnect"]["max_backoff_ms"] = 30000;
+    root["protocol"]["opcua"]["reconnect"]["probe_timeout_ms"] = 1000;
     
     // 系统配置
     root["system"]["log_level"] = "INFO";
     root["system"]["watchdog_timeout_s"] = 30;
     root["system"]["data_retention_days"] = 7;
+    root["system"]["status_file"]["enabled"] = true;
+    root["system"]["status_file"]["directory"] = "/tmp/gw-test";
+    root["system"]["status_file"]["max_rate_hz"] = 1.0;
+    root["system"]["status_file"]["keepalive_s"] = 10;
     
     return root;
 }
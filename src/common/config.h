@@ -8,6 +8,8 @@
  * - 原子写入（防止断电损坏）
  * - 自动备份
  * - 类型安全的配置读取
+ * - 只读快照: 每次加载/修改后把配置解析为一个不可变的 Snapshot
+ *   （全部 *Config 结构体），读取方无锁获取，不遍历 JSON、不分配内存
  * 
  * 配置文件结构示例：
  * ```json
@@ -36,6 +38,10 @@
  * // 修改配置
  * config.set("rs485.baudrate", 38400);
  * config.save();
+ * 
+ * // 热路径读取（本线程缓存的快照，配置未变化时不加锁、不分配）
+ * const ConfigManager::Snapshot& cfg = config.current();
+ * int poll_ms = cfg.rs485.poll_rate_ms;
  * ```
  * 
  * @author Gateway Project
@@ -45,7 +51,11 @@
 #ifndef GATEWAY_CONFIG_H
 #define GATEWAY_CONFIG_H
 
+#include <atomic>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
 #include <json/json.h>
 #include <mutex>
 
@@ -57,7 +67,9 @@
  * 
  * 设计特点：
  * - 单例模式：全局唯一实例
- * - 线程安全：使用互斥锁保护
+ * - 线程安全：修改（load/set/reset）由互斥锁串行化，读取使用快照
+ * - RCU 式发布：修改后生成新的 Snapshot，原子替换 shared_ptr；
+ *   读取方持有的旧快照在最后一个引用释放时销毁
  * - 原子写入：临时文件 + rename，防止断电损坏
  * - 自动备份：保存时自动创建 .backup 文件
  * - 嵌套访问：支持 "a.b.c" 形式的路径
@@ -89,12 +101,12 @@ public:
      * 2. 如果不存在，生成默认配置并保存
      * 3. 读取文件内容
      * 4. 解析 JSON
-     * 5. 如果解析失败，使用默认配置
+     * 5. 如果解析失败，保留当前配置（首次加载时即默认配置）
      * 
      * @param path 配置文件路径（默认 /opt/gw/conf/config.json）
      * @return bool true=成功, false=失败
      * 
-     * @note 失败时会自动使用默认配置，不会导致程序崩溃
+     * @note 失败时继续使用当前配置，不会导致程序崩溃
      * 
      * @example
      * ConfigManager& config = ConfigManager::instance();
@@ -127,26 +139,19 @@ public:
     bool save(const std::string& path = "/opt/gw/conf/config.json");
     
     /**
-     * @brief 获取完整配置对象
-     * 
-     * @return Json::Value& 配置的根节点引用
+     * @brief 获取完整配置对象（当前快照的副本）
      * 
-     * @note 返回的是引用，可以直接修改
-     * @warning 修改后需要调用 save() 才能持久化
-     */
-    Json::Value& get_config() { return config_; }
-    
-    /**
-     * @brief 获取完整配置对象（只读）
+     * @return Json::Value 配置的根节点
      * 
-     * @return const Json::Value& 配置的根节点常量引用
+     * @note 修改配置请使用 set()，修改后需要调用 save() 才能持久化
      */
-    const Json::Value& get_config() const { return config_; }
+    Json::Value get_config() const;
     
     /**
      * @brief 获取字符串配置项
      * 
-     * 支持嵌套路径，如 "network.eth0.mode"
+     * 支持嵌套路径，如 "network.eth0.mode"。在当前快照上按路径查找，
+     * 不复制 JSON 树；频繁读取的配置请使用 current() 中的结构体。
      * 
      * @param key 配置键（支持点号分隔的路径）
      * @param default_val 默认值（键不存在时返回）
@@ -171,6 +176,18 @@ public:
      */
     int get_int(const std::string& key, int default_val = 0) const;
     
+    /**
+     * @brief 获取浮点配置项
+     * 
+     * @param key 配置键
+     * @param default_val 默认值
+     * @return double 配置值
+     * 
+     * @example
+     * double band = config.get_double("protocol.s7.deadband.absolute", 0.0);
+     */
+    double get_double(const std::string& key, double default_val = 0.0) const;
+    
     /**
      * @brief 获取布尔配置项
      * 
@@ -213,6 +230,62 @@ public:
         int timeout_ms = 200;                  ///< 超时时间（毫秒）
         int retry_count = 3;                   ///< 重试次数
         bool simulate = false;                 ///< 是否启用模拟模式
+        
+        /// @brief 测厚仪命令寄存器（按测厚仪手册填写，-1=未配置，拒绝该命令）
+        struct GaugeCommands {
+            int slave_address = 1;             ///< 测厚仪从站地址
+            int zero_register = -1;            ///< 写 1 执行清零 (FC06)
+            int tare_register = -1;            ///< 写 1 执行去皮 (FC06)
+            int mode_register = -1;            ///< 测量模式编号 (FC06)
+            int setpoint_register = -1;        ///< Float32 设定值，2 个寄存器 Big-Endian (FC16)
+            
+            bool operator==(const GaugeCommands& other) const;
+            bool operator!=(const GaugeCommands& other) const { return !(*this == other); }
+        };
+        GaugeCommands commands;                ///< rs485.commands
+        
+        bool operator==(const RS485Config& other) const;
+        bool operator!=(const RS485Config& other) const { return !(*this == other); }
+    };
+    
+    /**
+     * @struct DeadbandConfig
+     * @brief 死区/心跳发布过滤配置（见 deadband.h）
+     */
+    struct DeadbandConfig {
+        double absolute = 0.0;                 ///< 绝对死区 (mm)，0=不使用
+        double percent = 0.0;                  ///< 相对死区 (%)，0=不使用
+        int heartbeat_ms = 1000;               ///< 最长发布间隔，0=无心跳
+        
+        bool operator==(const DeadbandConfig& other) const;
+        bool operator!=(const DeadbandConfig& other) const { return !(*this == other); }
+    };
+    
+    /**
+     * @struct OutboxConfig
+     * @brief 断线缓存配置（见 outbox.h）
+     */
+    struct OutboxConfig {
+        bool enabled = false;
+        int capacity = 30000;                  ///< 样本数（50 Hz 约 10 分钟）
+        std::string path;                      ///< 持久化文件，空=只缓存在内存
+        int backfill_per_cycle = 10;           ///< 恢复连接后每周期补发的样本数上限
+        
+        bool operator==(const OutboxConfig& other) const;
+        bool operator!=(const OutboxConfig& other) const { return !(*this == other); }
+    };
+    
+    /**
+     * @struct ReconnectConfig
+     * @brief 后台重连参数（见 connect_worker.h）
+     */
+    struct ReconnectConfig {
+        int initial_backoff_ms = 500;          ///< 首次失败后的等待时间
+        int max_backoff_ms = 30000;            ///< 指数退避上限
+        int probe_timeout_ms = 1000;           ///< TCP 预探测超时
+        
+        bool operator==(const ReconnectConfig& other) const;
+        bool operator!=(const ReconnectConfig& other) const { return !(*this == other); }
     };
     
     /**
@@ -220,12 +293,39 @@ public:
      * @brief 西门子 S7 协议配置
      */
     struct S7Config {
+        /// @brief 自定义变量映射（见 s7d/s7_tag_map.h）
+        struct Tag {
+            std::string field = "thickness";   ///< thickness/timestamp/status/sequence
+            int channel = 0;
+            std::string area = "DB";           ///< DB/M/Q
+            int db_number = -1;                ///< -1=使用 S7Config::db_number
+            int offset = 0;                    ///< 字节偏移
+            std::string type = "REAL";         ///< REAL/DINT/WORD/LREAL/DTL
+            std::string byte_order = "big";    ///< big/little
+            double scale = 1.0;
+            
+            bool operator==(const Tag& other) const;
+            bool operator!=(const Tag& other) const { return !(*this == other); }
+        };
+        
+        std::string name = "plc0";             ///< 会话名称（日志与状态中区分 PLC）
         bool enabled = false;
         std::string plc_ip = "192.168.1.10";
         int rack = 0;
         int slot = 1;
         int db_number = 10;
         int update_interval_ms = 50;
+        bool async_write = false;              ///< 异步写入（Cli_AsDBWrite，与往返时间重叠）
+        int ring_slots = 0;                    ///< DB 样本环槽位数，0=禁用
+        int ring_offset = 256;                 ///< 样本环在 DB 中的起始字节
+        int ring_channel = 0;                  ///< 写入样本环的通道
+        std::vector<Tag> tags;                 ///< 非空时替代默认通道块布局
+        DeadbandConfig deadband;               ///< 每通道死区过滤
+        OutboxConfig outbox;                   ///< 断线缓存（补发到样本环）
+        ReconnectConfig reconnect;             ///< 后台重连
+        
+        bool operator==(const S7Config& other) const;
+        bool operator!=(const S7Config& other) const { return !(*this == other); }
     };
     
     /**
@@ -233,11 +333,50 @@ public:
      * @brief OPC UA 协议配置
      */
     struct OPCUAConfig {
+        /// @brief 数据节点 ID（ns=/nsu= + i=/s=/g=，见 opcuad/opcua_node_map.h）
+        struct Nodes {
+            std::string thickness = "ns=2;s=Gateway.Thickness";
+            std::string timestamp = "ns=2;s=Gateway.Timestamp";
+            std::string status = "ns=2;s=Gateway.Status";
+            std::string sequence = "ns=2;s=Gateway.Sequence";
+            
+            bool operator==(const Nodes& other) const;
+            bool operator!=(const Nodes& other) const { return !(*this == other); }
+        };
+        
+        /// @brief PubSub UADP 发布（UDP 组播/单播，见 opcuad/uadp_publisher.h）
+        struct PubSub {
+            bool enabled = false;
+            std::string url = "opc.udp://239.0.0.1:4840";
+            int publisher_id = 1;
+            int writer_group_id = 1;
+            int dataset_writer_id = 1;         ///< 通道 N 使用 dataset_writer_id + N
+            int ttl = 1;                       ///< 组播 TTL
+            std::string interface_ip;          ///< 组播出口网卡地址，空=按路由
+            
+            bool operator==(const PubSub& other) const;
+            bool operator!=(const PubSub& other) const { return !(*this == other); }
+        };
+        
         bool enabled = false;
+        std::string mode = "client";           ///< client=写入外部服务器 / server=内嵌服务器 / both
         std::string server_url = "opc.tcp://192.168.1.20:4840";
         std::string security_mode = "None";
         std::string username;
         std::string password;
+        Nodes nodes;                           ///< 数据节点
+        int max_inflight = 8;                  ///< 客户端同时在途的 Write 请求数 (1-32)
+        int server_port = 4840;                ///< 内嵌服务器端口
+        int server_channels = 1;               ///< 内嵌服务器发布的通道数
+        int server_history_size = 3000;        ///< 内嵌服务器每个变量保留的历史样本数，0=不保留
+        int server_max_queue_size = 1000;      ///< 内嵌服务器 MonitoredItem 队列长度上限
+        PubSub pubsub;                         ///< UADP 发布
+        DeadbandConfig deadband;               ///< 死区过滤
+        OutboxConfig outbox;                   ///< 断线缓存（带源时间戳补发）
+        ReconnectConfig reconnect;             ///< 后台重连
+        
+        bool operator==(const OPCUAConfig& other) const;
+        bool operator!=(const OPCUAConfig& other) const { return !(*this == other); }
     };
     
     /**
@@ -249,6 +388,27 @@ public:
         std::string listen_ip = "0.0.0.0";    ///< 监听地址
         int port = 502;                        ///< 监听端口
         int slave_id = 1;                      ///< 从站 ID
+        
+        bool rtu_enabled = false;              ///< 是否同时作为 RTU 从站服务
+        std::string rtu_device = "/dev/ttyS1"; ///< RTU 从站串口设备
+        int rtu_baudrate = 19200;              ///< RTU 波特率（最高 115200）
+        std::string rtu_parity = "N";          ///< 校验位：N/E/O
+        int rtu_stop_bits = 1;                 ///< 停止位：1 或 2
+        int rtu_slave_id = 1;                  ///< RTU 从站地址
+        int rtu_frame_gap_us = 0;              ///< 帧间隔 t3.5（微秒，0=按波特率自动计算）
+        
+        /// @brief 单元号 → 采集通道映射
+        struct UnitRoute {
+            int unit_id = 1;                   ///< Modbus 单元号 / RTU 从站地址 (1-247)
+            int channel = 0;                   ///< NormalizedData::channel
+            
+            bool operator==(const UnitRoute& other) const;
+            bool operator!=(const UnitRoute& other) const { return !(*this == other); }
+        };
+        std::vector<UnitRoute> units;          ///< 为空时等价于 {slave_id → 通道 0}
+        
+        bool operator==(const ModbusConfig& other) const;
+        bool operator!=(const ModbusConfig& other) const { return !(*this == other); }
     };
     
     /**
@@ -260,8 +420,72 @@ public:
         std::string ip = "192.168.1.100";     ///< IP 地址（static 模式）
         std::string netmask = "255.255.255.0"; ///< 子网掩码
         std::string gateway = "192.168.1.1";   ///< 默认网关
+        
+        bool operator==(const NetworkConfig& other) const;
+        bool operator!=(const NetworkConfig& other) const { return !(*this == other); }
+    };
+    
+    /**
+     * @struct StatusFileConfig
+     * @brief 状态文件输出（供外部脚本读取，webcfg 使用共享内存状态表）
+     */
+    struct StatusFileConfig {
+        bool enabled = true;                   ///< 是否输出 status_<组件>.json
+        std::string directory = "/tmp/gw-test"; ///< 输出目录
+        double max_rate_hz = 1.0;              ///< 每个文件的最大写入频率
+        int keepalive_s = 10;                  ///< 内容不变时至少每隔该时间重写一次（刷新时间戳）
+        
+        bool operator==(const StatusFileConfig& other) const;
+        bool operator!=(const StatusFileConfig& other) const { return !(*this == other); }
+    };
+    
+    /**
+     * @struct Snapshot
+     * @brief 某一版本配置的不可变快照
+     * 
+     * load()/set()/reset_to_default() 后由 JSON 解析一次生成，之后只读。
+     * 多个线程可同时读取同一个快照，无需加锁。
+     */
+    struct Snapshot {
+        uint64_t version = 0;                  ///< 发布序号（每次修改递增）
+        Json::Value root;                      ///< 原始 JSON（按路径查询和 Web 输出使用）
+        RS485Config rs485;
+        ModbusConfig modbus;
+        S7Config s7;                           ///< protocol.s7 顶层配置
+        std::vector<S7Config> s7_plcs;         ///< 全部 PLC（见 get_s7_plc_configs()）
+        OPCUAConfig opcua;
+        NetworkConfig network;
+        StatusFileConfig status_file;
+        std::string active_protocol = "all";   ///< protocol.active
+        bool modbus_active = false;            ///< is_output_active("modbus")
+        bool s7_active = false;                ///< is_output_active("s7")
+        bool opcua_active = false;             ///< is_output_active("opcua")
+        
+        /**
+         * @brief 指定输出协议是否应转发数据（见 is_output_active()）
+         */
+        bool output_active(const std::string& protocol) const;
     };
     
+    /**
+     * @brief 获取当前配置快照
+     * 
+     * @return std::shared_ptr<const Snapshot> 持有期间快照不会被释放，
+     *         之后的重载不影响已取得的快照
+     */
+    std::shared_ptr<const Snapshot> snapshot() const;
+    
+    /**
+     * @brief 获取当前配置快照（本线程缓存，用于热路径）
+     * 
+     * 每个线程缓存一份快照引用，只比较一次发布序号: 配置未变化时
+     * 不加锁、不修改引用计数。
+     * 
+     * @return const Snapshot& 在本线程下一次调用 current() 之前有效；
+     *         需要跨调用持有时使用 snapshot()
+     */
+    const Snapshot& current() const;
+    
     /**
      * @brief 获取 RS-485 配置
      * 
@@ -286,11 +510,32 @@ public:
      */
     S7Config get_s7_config() const;
     
+    /**
+     * @brief 获取所有 S7 PLC 的配置
+     * 
+     * protocol.s7.plcs 数组中每一项描述一个 PLC，未填写的字段继承
+     * protocol.s7 顶层配置；数组为空或不存在时返回顶层配置本身（单 PLC）。
+     * 
+     * @return std::vector<S7Config> 至少包含一项
+     */
+    std::vector<S7Config> get_s7_plc_configs() const;
+    
     /**
      * @brief 获取 OPC UA 协议配置
      */
     OPCUAConfig get_opcua_config() const;
     
+    /**
+     * @brief 指定输出协议是否应转发数据
+     * 
+     * 各输出独立运行: protocol.<name>.enabled 为真即转发。
+     * protocol.active 为 "all"（默认）时所有已启用的输出同时转发；
+     * 兼容旧配置，设为 "modbus"/"s7"/"opcua" 时只转发该协议。
+     * 
+     * @param protocol "modbus" / "s7" / "opcua"
+     */
+    bool is_output_active(const std::string& protocol) const;
+    
     /**
      * @brief 获取网络配置
      * 
@@ -298,6 +543,11 @@ public:
      */
     NetworkConfig get_network_config() const;
     
+    /**
+     * @brief 获取状态文件输出配置（system.status_file）
+     */
+    StatusFileConfig get_status_file_config() const;
+    
     /**
      * @brief 恢复出厂设置
      * 
@@ -329,8 +579,21 @@ private:
     /// @brief 禁用赋值操作符
     ConfigManager& operator=(const ConfigManager&) = delete;
     
-    Json::Value config_;        ///< 配置的根节点
-    mutable std::mutex mutex_;  ///< 互斥锁（保护并发访问）
+    Json::Value config_;        ///< 配置的根节点（工作副本，持有 mutex_ 时访问）
+    mutable std::mutex mutex_;  ///< 互斥锁（串行化修改）
+    
+    std::shared_ptr<const Snapshot> snapshot_;  ///< 当前快照（std::atomic_load/atomic_store 访问）
+    std::atomic<uint64_t> version_{0};          ///< 当前快照的发布序号
+    
+    /**
+     * @brief 由 config_ 生成并发布新快照（调用方持有 mutex_）
+     */
+    void publish_locked();
+    
+    /**
+     * @brief 保存 config_ 到文件（调用方持有 mutex_）
+     */
+    bool save_locked(const std::string& path);
     
     /**
      * @brief 生成默认配置
@@ -0,0 +1,252 @@
+#include "config_watcher.h"
+#include "logger.h"
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+
+namespace {
+/// @brief 收到事件后等待后续事件的时间（编辑器保存时常连续产生多个事件）
+constexpr int SETTLE_MS = 50;
+/// @brief 无法使用 inotify 时检查修改时间的间隔
+constexpr int FALLBACK_POLL_MS = 1000;
+
+/// @brief 文件修改时间（纳秒），不存在时为 0
+int64_t file_mtime_ns(const std::string& path) {
+    struct stat st;
+    if (::stat(path.c_str(), &st) != 0) {
+        return 0;
+    }
+    return static_cast<int64_t>(st.st_mtim.tv_sec) * 1000000000LL + st.st_mtim.tv_nsec;
+}
+
+/// @brief 进程内共享监视器及其订阅者（g_shared_mutex 保护）
+std::mutex g_shared_mutex;
+ConfigWatcher* g_shared = nullptr;
+std::vector<ConfigWatcher*> g_subscribers;
+}
+
+ConfigWatcher::ConfigWatcher(const std::string& path) : path_(path) {
+    std::filesystem::path p(path);
+    dir_ = p.has_parent_path() ? p.parent_path().string() : ".";
+    name_ = p.filename().string();
+}
+
+ConfigWatcher::~ConfigWatcher() {
+    stop();
+}
+
+void ConfigWatcher::on_change(uint32_t sections, Callback callback) {
+    handlers_.push_back({sections, std::move(callback)});
+}
+
+void ConfigWatcher::start() {
+    stop();
+    current_ = ConfigManager::instance().snapshot();
+    {
+        std::lock_guard<std::mutex> lock(g_shared_mutex);
+        if (g_shared && g_shared->path_ == path_) {
+            g_subscribers.push_back(this);
+            subscribed_ = true;
+            return;
+        }
+    }
+    stop_fd_ = eventfd(0, EFD_CLOEXEC);
+    if (stop_fd_ < 0) {
+        LOG_ERROR("Config watcher: eventfd failed: %s", strerror(errno));
+        return;
+    }
+
+    // 在返回之前开始监视，start() 之后的保存不会漏掉
+    // 监视目录而不是文件: rename() 替换文件后，对旧 inode 的监视会失效
+    inotify_fd_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (inotify_fd_ >= 0 && inotify_add_watch(inotify_fd_, dir_.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        ::close(inotify_fd_);
+        inotify_fd_ = -1;
+    }
+    if (inotify_fd_ < 0) {
+        LOG_WARN("Config watcher: cannot watch %s (%s), polling every %d ms",
+                 dir_.c_str(), strerror(errno), FALLBACK_POLL_MS);
+    }
+    thread_ = std::thread(&ConfigWatcher::run, this, file_mtime_ns(path_));
+}
+
+void ConfigWatcher::start_shared() {
+    start();
+    if (subscribed_ || !thread_.joinable()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(g_shared_mutex);
+    g_shared = this;
+    shared_ = true;
+}
+
+void ConfigWatcher::stop() {
+    if (subscribed_ || shared_) {
+        std::lock_guard<std::mutex> lock(g_shared_mutex);
+        if (subscribed_) {
+            g_subscribers.erase(std::remove(g_subscribers.begin(), g_subscribers.end(), this), g_subscribers.end());
+            subscribed_ = false;
+        }
+        if (shared_) {
+            g_shared = nullptr;
+            shared_ = false;
+        }
+    }
+    if (thread_.joinable()) {
+        const uint64_t one = 1;
+        ssize_t ignored = ::write(stop_fd_, &one, sizeof(one));
+        (void)ignored;
+        thread_.join();
+    }
+    if (stop_fd_ >= 0) {
+        ::close(stop_fd_);
+        stop_fd_ = -1;
+    }
+    if (inotify_fd_ >= 0) {
+        ::close(inotify_fd_);
+        inotify_fd_ = -1;
+    }
+}
+
+uint32_t ConfigWatcher::dispatch() {
+    if (!has_pending_.load(std::memory_order_acquire)) {
+        return 0;
+    }
+
+    std::shared_ptr<const ConfigManager::Snapshot> next;
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        next = std::move(pending_);
+        has_pending_.store(false, std::memory_order_relaxed);
+    }
+    if (!next) {
+        return 0;
+    }
+
+    const uint32_t changed = current_ ? diff(*current_, *next) : ALL;
+    current_ = std::move(next);
+    for (const auto& handler : handlers_) {
+        if (handler.sections & changed) {
+            handler.callback(*current_);
+        }
+    }
+    return changed;
+}
+
+void ConfigWatcher::wait_until(std::chrono::steady_clock::time_point deadline) {
+    std::unique_lock<std::mutex> lock(pending_mutex_);
+    pending_cv_.wait_until(lock, deadline, [this]() { return has_pending_.load(std::memory_order_relaxed); });
+}
+
+uint32_t ConfigWatcher::diff(const ConfigManager::Snapshot& before, const ConfigManager::Snapshot& after) {
+    uint32_t changed = 0;
+    if (before.rs485 != after.rs485) {
+        changed |= RS485;
+    }
+    if (before.modbus != after.modbus) {
+        changed |= MODBUS;
+    }
+    if (before.s7 != after.s7 || before.s7_plcs != after.s7_plcs) {
+        changed |= S7;
+    }
+    if (before.opcua != after.opcua) {
+        changed |= OPCUA;
+    }
+    if (before.active_protocol != after.active_protocol || before.modbus_active != after.modbus_active ||
+        before.s7_active != after.s7_active || before.opcua_active != after.opcua_active) {
+        changed |= ACTIVE;
+    }
+    if (before.network != after.network) {
+        changed |= NETWORK;
+    }
+    if (before.status_file != after.status_file) {
+        changed |= STATUS_FILE;
+    }
+    return changed;
+}
+
+void ConfigWatcher::reload() {
+    ConfigManager& config = ConfigManager::instance();
+    if (!config.load(path_)) {
+        LOG_WARN("Config reload failed: %s", path_.c_str());
+        return;
+    }
+    const auto snapshot = config.snapshot();
+    deliver(snapshot);
+
+    std::lock_guard<std::mutex> lock(g_shared_mutex);
+    if (g_shared == this) {
+        for (ConfigWatcher* subscriber : g_subscribers) {
+            subscriber->deliver(snapshot);
+        }
+    }
+}
+
+void ConfigWatcher::deliver(const std::shared_ptr<const ConfigManager::Snapshot>& snapshot) {
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        pending_ = snapshot;
+        has_pending_.store(true, std::memory_order_release);
+    }
+    pending_cv_.notify_all();
+}
+
+void ConfigWatcher::run(int64_t last_mtime) {
+    const int inotify_fd = inotify_fd_;
+    bool settling = false;
+    alignas(struct inotify_event) char buffer[4096];
+
+    struct pollfd fds[2];
+    fds[0] = {stop_fd_, POLLIN, 0};
+    fds[1] = {inotify_fd, POLLIN, 0};
+    const nfds_t nfds = inotify_fd >= 0 ? 2 : 1;
+
+    while (true) {
+        const int timeout = settling ? SETTLE_MS : (inotify_fd >= 0 ? -1 : FALLBACK_POLL_MS);
+        const int n = ::poll(fds, nfds, timeout);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("Config watcher: poll failed: %s", strerror(errno));
+            break;
+        }
+        if (fds[0].revents) {
+            break;
+        }
+
+        if (n == 0) {
+            if (inotify_fd < 0) {
+                const int64_t mtime = file_mtime_ns(path_);
+                if (mtime == last_mtime) {
+                    continue;
+                }
+                last_mtime = mtime;
+            }
+            settling = false;
+            reload();
+            continue;
+        }
+
+        if (nfds > 1 && (fds[1].revents & POLLIN)) {
+            ssize_t len;
+            while ((len = ::read(inotify_fd, buffer, sizeof(buffer))) > 0) {
+                for (char* p = buffer; p < buffer + len;) {
+                    const auto* event = reinterpret_cast<const struct inotify_event*>(p);
+                    if ((event->mask & IN_Q_OVERFLOW) || (event->len > 0 && name_ == event->name)) {
+                        settling = true;
+                    }
+                    p += sizeof(struct inotify_event) + event->len;
+                }
+            }
+        }
+    }
+}
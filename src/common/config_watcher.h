@@ -0,0 +1,156 @@
+/**
+ * @file config_watcher.h
+ * @brief 配置文件变化通知（inotify）与按分区的热重载回调
+ *
+ * 取代各守护进程每秒 stat() 一次配置文件、变化后再拼接字符串签名比较的方式:
+ *
+ * 1. 后台线程用 inotify 监视配置文件所在目录，阻塞在 poll() 上，
+ *    没有周期性的系统调用。ConfigManager::save() 写临时文件后 rename()，
+ *    产生 IN_MOVED_TO；直接改写文件的编辑器产生 IN_CLOSE_WRITE
+ * 2. 收到事件后再等待 50ms 合并连续事件，然后调用一次 ConfigManager::load()
+ * 3. 主循环每个周期调用 dispatch()，没有变化时只读一个原子标志；有变化时
+ *    按分区逐字段比较新旧快照，只调用关心的分区发生变化的回调
+ *
+ * 回调在调用 dispatch() 的线程中执行，与主循环的其他代码没有并发。
+ * 配置目录无法监视时（inotify 实例数用尽等）退回每秒检查一次修改时间。
+ *
+ * 单进程网关（gatewayd）中各服务共享同一个 ConfigManager: gatewayd 用
+ * start_shared() 启动唯一的监视线程，各服务的 ConfigWatcher 在 start() 时
+ * 发现已有共享监视器（同一路径）就只登记为订阅者，不再各自监视和 load()。
+ * 一次保存只解析一次文件，新快照分发给每个订阅者，回调仍在各服务自己的线程中执行。
+ *
+ * 示例:
+ * @code
+ * ConfigWatcher watcher(config_path);
+ * watcher.on_change(ConfigWatcher::S7 | ConfigWatcher::ACTIVE,
+ *                   [&](const ConfigManager::Snapshot& cfg) { rebuild(cfg.s7_plcs); });
+ * watcher.start();
+ * while (running) {
+ *     watcher.dispatch();
+ *     ...
+ * }
+ * @endcode
+ *
+ * @author Gateway Project
+ * @date 2025-11-01
+ */
+
+#ifndef GATEWAY_CONFIG_WATCHER_H
+#define GATEWAY_CONFIG_WATCHER_H
+
+#include "config.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @class ConfigWatcher
+ * @brief 单个配置文件的变化监视
+ */
+class ConfigWatcher {
+public:
+    /// @brief 配置分区（按位组合）
+    enum Section : uint32_t {
+        RS485       = 1u << 0,   ///< rs485
+        MODBUS      = 1u << 1,   ///< protocol.modbus
+        S7          = 1u << 2,   ///< protocol.s7（含 plcs）
+        OPCUA       = 1u << 3,   ///< protocol.opcua
+        ACTIVE      = 1u << 4,   ///< protocol.active 及各输出的激活状态
+        NETWORK     = 1u << 5,   ///< network
+        STATUS_FILE = 1u << 6,   ///< system.status_file
+        ALL         = 0x7Fu,
+    };
+
+    /// @brief 分区变化回调，参数为新快照
+    using Callback = std::function<void(const ConfigManager::Snapshot&)>;
+
+    /**
+     * @param path 配置文件路径（须与 ConfigManager::load() 使用的一致）
+     */
+    explicit ConfigWatcher(const std::string& path);
+    ~ConfigWatcher();
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    /**
+     * @brief 注册回调（在 start() 之前调用）
+     *
+     * @param sections 关心的分区，任一发生变化时调用一次
+     * @param callback 回调
+     */
+    void on_change(uint32_t sections, Callback callback);
+
+    /**
+     * @brief 启动监视线程，以 ConfigManager 的当前快照作为比较基准
+     *
+     * 已有同一路径的共享监视器时不启动线程，改为订阅其重载结果。
+     */
+    void start();
+
+    /**
+     * @brief 作为进程内共享监视器启动（gatewayd 在启动各服务之前调用）
+     */
+    void start_shared();
+
+    /**
+     * @brief 停止监视线程或取消订阅（析构时自动调用）
+     */
+    void stop();
+
+    /**
+     * @brief 处理已重载的配置（主循环每个周期调用）
+     *
+     * @return uint32_t 本次发生变化的分区，0=无变化
+     */
+    uint32_t dispatch();
+
+    /**
+     * @brief 休眠到指定时间，期间完成重载时提前返回（之后调用 dispatch()）
+     *
+     * 主循环平时休眠较长时用它代替 sleep_until()，配置变化不必等到下一个周期。
+     */
+    void wait_until(std::chrono::steady_clock::time_point deadline);
+
+    /**
+     * @brief 比较两个快照，返回发生变化的分区
+     */
+    static uint32_t diff(const ConfigManager::Snapshot& before, const ConfigManager::Snapshot& after);
+
+private:
+    struct Handler {
+        uint32_t sections;
+        Callback callback;
+    };
+
+    void run(int64_t last_mtime);
+    void reload();
+    void deliver(const std::shared_ptr<const ConfigManager::Snapshot>& snapshot);
+
+    std::string path_;
+    std::string dir_;
+    std::string name_;
+    std::vector<Handler> handlers_;
+
+    std::shared_ptr<const ConfigManager::Snapshot> current_;   ///< 已分发的快照（dispatch() 线程使用）
+    std::shared_ptr<const ConfigManager::Snapshot> pending_;   ///< 已重载未分发的快照
+    std::mutex pending_mutex_;
+    std::condition_variable pending_cv_;
+    std::atomic<bool> has_pending_{false};
+
+    std::thread thread_;
+    int stop_fd_ = -1;   ///< eventfd，写入后监视线程退出
+    int inotify_fd_ = -1;   ///< 监视配置目录，-1=退回轮询修改时间
+    bool shared_ = false;       ///< 本实例是共享监视器
+    bool subscribed_ = false;   ///< 本实例订阅了共享监视器
+};
+
+#endif // GATEWAY_CONFIG_WATCHER_H
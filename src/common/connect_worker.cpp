@@ -0,0 +1,186 @@
+#include "connect_worker.h"
+#include "logger.h"
+#include "ndm.h"
+
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+
+ConnectWorker::~ConnectWorker() {
+    stop();
+}
+
+void ConnectWorker::start(const Options& options, ConnectFn connect) {
+    stop();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    options_ = options;
+    connect_ = std::move(connect);
+    stop_ = false;
+    state_ = State::CONNECTING;
+    failures_in_row_ = 0;
+    current_backoff_ms_ = 0;
+    down_since_ns_ = get_timestamp_ns();
+    rng_state_ = static_cast<uint32_t>(down_since_ns_) | 1u;
+    thread_ = std::thread(&ConnectWorker::run, this);
+}
+
+void ConnectWorker::stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stop_ = true;
+    }
+    cv_.notify_all();
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    state_ = State::IDLE;
+}
+
+bool ConnectWorker::take_connected() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (state_ != State::CONNECTED) {
+        return false;
+    }
+    state_ = State::IDLE;
+    return true;
+}
+
+void ConnectWorker::connection_lost() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (state_ != State::IDLE || !thread_.joinable()) {
+            return;
+        }
+        state_ = State::CONNECTING;
+        failures_in_row_ = 0;
+        current_backoff_ms_ = 0;
+        down_since_ns_ = get_timestamp_ns();
+    }
+    cv_.notify_all();
+}
+
+int ConnectWorker::next_backoff_ms() {
+    // 指数退避: initial × 2^(n-1)，上限 max
+    int64_t backoff = options_.initial_backoff_ms > 0 ? options_.initial_backoff_ms : 1;
+    for (int i = 1; i < failures_in_row_ && backoff < options_.max_backoff_ms; ++i) {
+        backoff *= 2;
+    }
+    if (backoff > options_.max_backoff_ms) {
+        backoff = options_.max_backoff_ms;
+    }
+
+    // 抖动: [backoff/2, backoff]（xorshift32，不需要密码学强度）
+    rng_state_ ^= rng_state_ << 13;
+    rng_state_ ^= rng_state_ >> 17;
+    rng_state_ ^= rng_state_ << 5;
+    const int64_t half = backoff / 2;
+    return static_cast<int>(half + (half > 0 ? rng_state_ % static_cast<uint32_t>(half + 1) : 0));
+}
+
+void ConnectWorker::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!stop_) {
+        cv_.wait(lock, [this] { return stop_ || state_ == State::CONNECTING; });
+        if (stop_) {
+            break;
+        }
+
+        attempts_++;
+        const Options options = options_;
+        lock.unlock();
+
+        // 端口不通时不进入协议库的阻塞连接
+        const bool reachable = options.port <= 0 || probe(options.host, options.port, options.probe_timeout_ms);
+        const bool connected = reachable && connect_();
+
+        lock.lock();
+        if (stop_) {
+            break;
+        }
+        if (connected) {
+            const uint64_t elapsed_ms = (get_timestamp_ns() - down_since_ns_) / 1000000ULL;
+            reconnects_++;
+            last_reconnect_ms_ = elapsed_ms;
+            total_reconnect_ms_ += elapsed_ms;
+            if (elapsed_ms > max_reconnect_ms_) {
+                max_reconnect_ms_ = elapsed_ms;
+            }
+            LOG_INFO("Connected to %s:%d after %llu ms (%d failed attempts)",
+                     options.host.c_str(), options.port,
+                     static_cast<unsigned long long>(elapsed_ms), failures_in_row_);
+            failures_in_row_ = 0;
+            current_backoff_ms_ = 0;
+            state_ = State::CONNECTED;
+            continue;
+        }
+
+        if (reachable) {
+            connect_failures_++;
+        } else {
+            probe_failures_++;
+        }
+        failures_in_row_++;
+        current_backoff_ms_ = next_backoff_ms();
+        LOG_DEBUG("Connect to %s:%d failed (%s), retry in %d ms",
+                  options.host.c_str(), options.port, reachable ? "protocol" : "tcp probe",
+                  current_backoff_ms_);
+        cv_.wait_for(lock, std::chrono::milliseconds(current_backoff_ms_), [this] { return stop_; });
+    }
+}
+
+bool ConnectWorker::probe(const std::string& host, int port, int timeout_ms) {
+    struct addrinfo hints{};
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+    struct addrinfo* result = nullptr;
+    const std::string service = std::to_string(port);
+    if (getaddrinfo(host.c_str(), service.c_str(), &hints, &result) != 0 || !result) {
+        return false;
+    }
+
+    bool ok = false;
+    int fd = socket(result->ai_family, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd >= 0) {
+        int rc = ::connect(fd, result->ai_addr, result->ai_addrlen);
+        if (rc == 0) {
+            ok = true;
+        } else if (errno == EINPROGRESS) {
+            struct pollfd pfd{fd, POLLOUT, 0};
+            if (poll(&pfd, 1, timeout_ms) == 1) {
+                int err = 0;
+                socklen_t len = sizeof(err);
+                ok = (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &len) == 0 && err == 0);
+            }
+        }
+        ::close(fd);
+    }
+    freeaddrinfo(result);
+    return ok;
+}
+
+Json::Value ConnectWorker::stats() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    Json::Value out(Json::objectValue);
+    out["state"] = state_ == State::CONNECTING ? "connecting" : (state_ == State::CONNECTED ? "connected" : "idle");
+    out["attempts"] = static_cast<Json::UInt64>(attempts_);
+    out["probe_failures"] = static_cast<Json::UInt64>(probe_failures_);
+    out["connect_failures"] = static_cast<Json::UInt64>(connect_failures_);
+    out["backoff_ms"] = current_backoff_ms_;
+    out["reconnects"] = static_cast<Json::UInt64>(reconnects_);
+    out["last_reconnect_ms"] = static_cast<Json::UInt64>(last_reconnect_ms_);
+    out["max_reconnect_ms"] = static_cast<Json::UInt64>(max_reconnect_ms_);
+    out["avg_reconnect_ms"] = static_cast<Json::UInt64>(reconnects_ ? total_reconnect_ms_ / reconnects_ : 0);
+    if (state_ == State::CONNECTING) {
+        out["down_ms"] = static_cast<Json::UInt64>((get_timestamp_ns() - down_since_ns_) / 1000000ULL);
+    }
+    return out;
+}
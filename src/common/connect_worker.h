@@ -0,0 +1,120 @@
+/**
+ * @file connect_worker.h
+ * @brief 后台连接线程（指数退避 + 抖动 + TCP 预探测）
+ *
+ * s7_connect() / opcua_connect() 在对端不可达时会阻塞数秒（OPC UA 超时 5 秒），
+ * 放在主循环里会卡住状态更新和环形缓冲区读取。ConnectWorker 把建立连接
+ * 移到后台线程:
+ *
+ * 1. 主循环发现断线后调用 connection_lost()，后台线程开始重连
+ * 2. 每次尝试前先用非阻塞 connect() 探测 TCP 端口（超时可配置），
+ *    端口不通时不调用协议库的连接函数，避免长时间阻塞在库内部
+ * 3. 失败后按指数退避等待: initial × 2^n，上限 max，并在 [1/2, 1] 倍之间随机抖动，
+ *    多台网关同时重连时不会同步冲击 PLC
+ * 4. 连接成功后由主循环通过 take_connected() 接管客户端
+ *
+ * 客户端对象的所有权: 后台线程只在"连接中"状态使用客户端，主循环只在
+ * take_connected() 返回 true 之后使用，两者不会同时访问。
+ *
+ * 同时统计重连耗时（从断线到重新连上）: 最近一次、最大、平均。
+ *
+ * @author Gateway Project
+ * @date 2025-10-27
+ */
+
+#ifndef GATEWAY_CONNECT_WORKER_H
+#define GATEWAY_CONNECT_WORKER_H
+
+#include <json/json.h>
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+/**
+ * @class ConnectWorker
+ * @brief 单个对端的后台重连线程
+ */
+class ConnectWorker {
+public:
+    /// @brief 建立连接的函数（在后台线程中调用）
+    using ConnectFn = std::function<bool()>;
+
+    struct Options {
+        std::string host;                  ///< 预探测的主机
+        int port = 0;                      ///< 预探测的端口，0=不探测
+        int probe_timeout_ms = 1000;       ///< TCP 预探测超时
+        int initial_backoff_ms = 500;      ///< 首次失败后的等待时间
+        int max_backoff_ms = 30000;        ///< 等待时间上限
+    };
+
+    ConnectWorker() = default;
+    ~ConnectWorker();
+
+    ConnectWorker(const ConnectWorker&) = delete;
+    ConnectWorker& operator=(const ConnectWorker&) = delete;
+
+    /**
+     * @brief 启动后台线程并立即开始连接
+     */
+    void start(const Options& options, ConnectFn connect);
+
+    /**
+     * @brief 停止后台线程（等待进行中的一次尝试结束）
+     */
+    void stop();
+
+    /**
+     * @brief 连接是否已建立且尚未被主循环接管；返回 true 后客户端归主循环使用
+     */
+    bool take_connected();
+
+    /**
+     * @brief 主循环发现连接断开（已断开客户端）后调用，后台线程开始重连
+     */
+    void connection_lost();
+
+    /**
+     * @brief 连接统计（尝试次数、退避、重连耗时）
+     */
+    Json::Value stats() const;
+
+    /**
+     * @brief TCP 端口探测（非阻塞 connect + poll）
+     * @return bool true=端口可连接
+     */
+    static bool probe(const std::string& host, int port, int timeout_ms);
+
+private:
+    enum class State { IDLE, CONNECTING, CONNECTED };
+
+    void run();
+    int next_backoff_ms();
+
+    Options options_;
+    ConnectFn connect_;
+    std::thread thread_;
+    mutable std::mutex mutex_;
+    std::condition_variable cv_;
+    State state_ = State::IDLE;
+    bool stop_ = false;
+
+    // 统计（mutex_ 保护）
+    int failures_in_row_ = 0;
+    int current_backoff_ms_ = 0;
+    uint64_t attempts_ = 0;
+    uint64_t probe_failures_ = 0;
+    uint64_t connect_failures_ = 0;
+    uint64_t reconnects_ = 0;
+    uint64_t down_since_ns_ = 0;
+    uint64_t last_reconnect_ms_ = 0;
+    uint64_t max_reconnect_ms_ = 0;
+    uint64_t total_reconnect_ms_ = 0;
+    uint32_t rng_state_ = 0;
+};
+
+#endif // GATEWAY_CONNECT_WORKER_H
@@ -0,0 +1,28 @@
+#include "deadband.h"
+
+#include <cmath>
+
+bool DeadbandFilter::should_publish(const NormalizedData& data, uint64_t now_ns) {
+    bool publish = !last_.valid || (cfg_.absolute <= 0.0 && cfg_.percent <= 0.0) || data.status != last_.status;
+
+    if (!publish) {
+        const double delta = std::fabs(static_cast<double>(data.thickness_mm) - last_.value);
+        if (cfg_.absolute > 0.0 && delta > cfg_.absolute) {
+            publish = true;
+        } else if (cfg_.percent > 0.0 && delta > std::fabs(last_.value) * cfg_.percent / 100.0) {
+            publish = true;
+        } else if (cfg_.heartbeat_ms > 0 &&
+                   now_ns - last_.publish_ns >= static_cast<uint64_t>(cfg_.heartbeat_ms) * 1000000ULL) {
+            publish = true;
+        }
+    }
+
+    if (!publish) {
+        suppressed_++;
+        return false;
+    }
+
+    last_ = Reference{true, data.thickness_mm, data.status, now_ns};
+    published_++;
+    return true;
+}
@@ -0,0 +1,98 @@
+/**
+ * @file deadband.h
+ * @brief 死区/变化驱动的发布过滤
+ *
+ * 厚度值稳定时每个周期重复写入 PLC / OPC UA 服务器没有意义，
+ * 在拥塞的车间网络上还会挤占其他设备的带宽。过滤规则:
+ * - 第一个样本、状态位变化: 发布
+ * - 与上次发布值之差超过绝对死区 absolute 或相对死区 percent(%): 发布
+ * - 距上次发布超过 heartbeat_ms: 发布（心跳，证明数据仍在更新）
+ * - 其余样本: 抑制并计数
+ *
+ * absolute 与 percent 均为 0 时不过滤（每个样本都发布）。
+ * 与上次"发布"值比较而不是上一个样本，缓慢漂移累计超过死区时同样会发布。
+ *
+ * 发布值先作为暂定基准（异步写入时避免应答返回前每个样本都判为变化），
+ * 写入成功后调用 confirm() 确认，失败时调用 revert() 退回上次确认的值，
+ * 失败的写入不会抑制之后的样本。
+ *
+ * @author Gateway Project
+ * @date 2025-10-27
+ */
+
+#ifndef GATEWAY_DEADBAND_H
+#define GATEWAY_DEADBAND_H
+
+#include "config.h"
+#include "ndm.h"
+
+#include <cstdint>
+
+/**
+ * @class DeadbandFilter
+ * @brief 单个数据点（通道）的死区过滤器
+ */
+class DeadbandFilter {
+public:
+    DeadbandFilter() = default;
+
+    /**
+     * @brief 设置过滤参数并清空历史（配置变化时调用）
+     */
+    void configure(const ConfigManager::DeadbandConfig& cfg) {
+        cfg_ = cfg;
+        reset();
+    }
+
+    /**
+     * @brief 清空上次发布的值（重连后调用，下一个样本一定发布）
+     */
+    void reset() {
+        last_ = Reference{};
+        confirmed_ = Reference{};
+    }
+
+    /**
+     * @brief 判断样本是否需要发布；需要时记录为上次发布值（暂定基准）
+     *
+     * @param data 样本
+     * @param now_ns 当前单调时间（纳秒）
+     * @return bool true=发布, false=抑制
+     */
+    bool should_publish(const NormalizedData& data, uint64_t now_ns);
+
+    /**
+     * @brief 样本已写入成功，作为确认的基准（按发送顺序调用）
+     *
+     * @param data 写入成功的样本
+     * @param sent_ns 发布时传给 should_publish() 的时间
+     */
+    void confirm(const NormalizedData& data, uint64_t sent_ns) {
+        confirmed_ = Reference{true, data.thickness_mm, data.status, sent_ns};
+    }
+
+    /**
+     * @brief 写入失败，基准退回上次确认的值
+     */
+    void revert() { last_ = confirmed_; }
+
+    uint64_t published() const { return published_; }
+    uint64_t suppressed() const { return suppressed_; }
+
+private:
+    /// @brief 比较基准（上次发布的样本）
+    struct Reference {
+        bool valid = false;
+        float value = 0.0f;
+        uint16_t status = 0;
+        uint64_t publish_ns = 0;
+    };
+
+    ConfigManager::DeadbandConfig cfg_;
+    Reference last_;        ///< 当前比较基准（含在途写入）
+    Reference confirmed_;   ///< 已确认写入成功的基准
+    uint64_t published_ = 0;
+    uint64_t suppressed_ = 0;
+};
+
+#endif // GATEWAY_DEADBAND_H
@@ -15,6 +15,18 @@ static const char* level_to_string(Logger::Level level) {
     return "UNKNOWN";
 }
 
+namespace {
+thread_local std::string t_thread_name;
+}
+
+void Logger::set_thread_name(const std::string& name) {
+    t_thread_name = name;
+}
+
+const char* Logger::current_name() {
+    return t_thread_name.empty() ? instance().name_.c_str() : t_thread_name.c_str();
+}
+
 void Logger::log(Level level, const char* format, ...) {
     va_list args;
     va_start(args, format);
@@ -36,7 +48,7 @@ void Logger::log(Level level, const char* format, ...) {
         fprintf(stderr, "[%s] [%s] [%s] ", 
                 time_buf, 
                 level_to_string(level),
-                instance().name_.c_str());
+                current_name());
         
         // 打印日志内容
         vfprintf(stderr, format, args);
@@ -58,7 +70,7 @@ void Logger::trace(const char* format, ...) {
         localtime_r(&now, &tm_info);
         char time_buf[64];
         strftime(time_buf, sizeof(time_buf), "%Y-%m-%d %H:%M:%S", &tm_info);
-        fprintf(stderr, "[%s] [TRACE] [%s] ", time_buf, instance().name_.c_str());
+        fprintf(stderr, "[%s] [TRACE] [%s] ", time_buf, current_name());
         vfprintf(stderr, format, args);
         fprintf(stderr, "\n");
     }
@@ -78,7 +90,7 @@ void Logger::debug(const char* format, ...) {
         localtime_r(&now, &tm_info);
         char time_buf[64];
         strftime(time_buf, sizeof(time_buf), "%Y-%m-%d %H:%M:%S", &tm_info);
-        fprintf(stderr, "[%s] [DEBUG] [%s] ", time_buf, instance().name_.c_str());
+        fprintf(stderr, "[%s] [DEBUG] [%s] ", time_buf, current_name());
         vfprintf(stderr, format, args);
         fprintf(stderr, "\n");
     }
@@ -98,7 +110,7 @@ void Logger::info(const char* format, ...) {
         localtime_r(&now, &tm_info);
         char time_buf[64];
         strftime(time_buf, sizeof(time_buf), "%Y-%m-%d %H:%M:%S", &tm_info);
-        fprintf(stderr, "[%s] [INFO ] [%s] ", time_buf, instance().name_.c_str());
+        fprintf(stderr, "[%s] [INFO ] [%s] ", time_buf, current_name());
         vfprintf(stderr, format, args);
         fprintf(stderr, "\n");
     }
@@ -118,7 +130,7 @@ void Logger::warn(const char* format, ...) {
         localtime_r(&now, &tm_info);
         char time_buf[64];
         strftime(time_buf, sizeof(time_buf), "%Y-%m-%d %H:%M:%S", &tm_info);
-        fprintf(stderr, "[%s] [WARN ] [%s] ", time_buf, instance().name_.c_str());
+        fprintf(stderr, "[%s] [WARN ] [%s] ", time_buf, current_name());
         vfprintf(stderr, format, args);
         fprintf(stderr, "\n");
     }
@@ -138,7 +150,7 @@ void Logger::error(const char* format, ...) {
         localtime_r(&now, &tm_info);
         char time_buf[64];
         strftime(time_buf, sizeof(time_buf), "%Y-%m-%d %H:%M:%S", &tm_info);
-        fprintf(stderr, "[%s] [ERROR] [%s] ", time_buf, instance().name_.c_str());
+        fprintf(stderr, "[%s] [ERROR] [%s] ", time_buf, current_name());
         vfprintf(stderr, format, args);
         fprintf(stderr, "\n");
     }
@@ -158,7 +170,7 @@ void Logger::fatal(const char* format, ...) {
         localtime_r(&now, &tm_info);
         char time_buf[64];
         strftime(time_buf, sizeof(time_buf), "%Y-%m-%d %H:%M:%S", &tm_info);
-        fprintf(stderr, "[%s] [FATAL] [%s] ", time_buf, instance().name_.c_str());
+        fprintf(stderr, "[%s] [FATAL] [%s] ", time_buf, current_name());
         vfprintf(stderr, format, args);
         fprintf(stderr, "\n");
     }
@@ -88,6 +88,16 @@ public:
         }
     }
     
+    /**
+     * @brief 设置当前线程的日志名称
+     * 
+     * gatewayd 单进程模式下各服务作为线程运行，用它让每个服务的日志
+     * 仍以自己的名称（rs485d、modbusd 等）输出；未设置时使用 init() 的名称。
+     * 
+     * @param name 线程日志名称
+     */
+    static void set_thread_name(const std::string& name);
+    
     /**
      * @brief 通用日志输出函数
      * 
@@ -142,6 +152,9 @@ private:
         return inst;
     }
     
+    /// @brief 当前线程使用的日志名称
+    static const char* current_name();
+    
     static constexpr int to_syslog_priority(Level level) {
         switch (level) {
             case TRACE: return LOG_DEBUG;
@@ -0,0 +1,70 @@
+/**
+ * @file modbus_crc.h
+ * @brief Modbus RTU CRC-16 校验
+ *
+ * Modbus RTU 帧以 CRC-16/MODBUS 结尾（多项式 0xA001 反射形式，初始值 0xFFFF），
+ * 低字节在前、高字节在后。rs485d（主站）和 modbusd（RTU 从站）共用此实现。
+ *
+ * @author Gateway Project
+ * @date 2025-10-20
+ */
+
+#ifndef GATEWAY_MODBUS_CRC_H
+#define GATEWAY_MODBUS_CRC_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief 计算 Modbus RTU CRC-16
+ *
+ * @param data 数据指针（不含 CRC 字段）
+ * @param len 数据长度（字节）
+ * @return uint16_t CRC 值（发送时低字节在前）
+ */
+inline uint16_t modbus_crc16(const uint8_t* data, size_t len) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= data[i];
+        for (int j = 0; j < 8; j++) {
+            if (crc & 0x0001) {
+                crc = (crc >> 1) ^ 0xA001;
+            } else {
+                crc >>= 1;
+            }
+        }
+    }
+    return crc;
+}
+
+/**
+ * @brief 在帧末尾追加 CRC（低字节在前）
+ *
+ * @param frame 帧缓冲区，需至少预留 len + 2 字节
+ * @param len 不含 CRC 的帧长度
+ * @return size_t 追加 CRC 后的帧长度
+ */
+inline size_t modbus_append_crc(uint8_t* frame, size_t len) {
+    uint16_t crc = modbus_crc16(frame, len);
+    frame[len] = static_cast<uint8_t>(crc & 0xFF);
+    frame[len + 1] = static_cast<uint8_t>(crc >> 8);
+    return len + 2;
+}
+
+/**
+ * @brief 校验完整 RTU 帧（含末尾 2 字节 CRC）
+ *
+ * @param frame 帧数据
+ * @param len 帧总长度
+ * @return bool true=校验通过
+ */
+inline bool modbus_check_crc(const uint8_t* frame, size_t len) {
+    if (len < 4) {
+        return false;
+    }
+    uint16_t crc = modbus_crc16(frame, len - 2);
+    return frame[len - 2] == static_cast<uint8_t>(crc & 0xFF) &&
+           frame[len - 1] == static_cast<uint8_t>(crc >> 8);
+}
+
+#endif // GATEWAY_MODBUS_CRC_H
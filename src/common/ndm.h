@@ -34,7 +34,7 @@
  * [8-11]  sequence      - 4字节序列号
  * [12-15] thickness_mm  - 4字节浮点数
  * [16-17] status        - 2字节状态位
- * [18-19] reserved      - 2字节保留
+ * [18-19] channel       - 2字节采集通道号
  * [20]    crc8          - 1字节校验
  * [21-23] padding       - 3字节填充
  */
@@ -43,7 +43,7 @@ struct NormalizedData {
     uint32_t sequence;          ///< 数据序列号 (循环递增，用于检测丢失或重复)
     float    thickness_mm;      ///< 厚度值，单位: 毫米 (IEEE754 单精度浮点数)
     uint16_t status;            ///< 状态位 (见下方 NDMStatus 定义)
-    uint16_t reserved;          ///< 保留字段，用于未来扩展
+    uint16_t channel;           ///< 采集通道号（0 起；单台测厚仪时恒为 0）
     uint8_t  crc8;              ///< 数据完整性校验 (CRC-8/MAXIM)
     uint8_t  padding[3];        ///< 内存对齐填充，确保结构体大小为 24 字节
 } __attribute__((packed, aligned(64)));  // packed: 紧凑排列, aligned(64): 按缓存行对齐
@@ -94,6 +94,27 @@ inline uint64_t get_timestamp_ns() {
     return static_cast<uint64_t>(ts.tv_sec) * 1000000000ULL + ts.tv_nsec;
 }
 
+/**
+ * @brief 把单调时钟时间戳换算为墙上时间（Unix 纪元起的纳秒）
+ * 
+ * 按当前 CLOCK_REALTIME 与 CLOCK_MONOTONIC 的差值平移，
+ * 用于 OPC UA SourceTimestamp、S7 DTL 等需要日历时间的输出。
+ * 
+ * @param timestamp_ns get_timestamp_ns() 得到的时间戳
+ * @return uint64_t 墙上时间（纳秒）
+ * 
+ * @note 系统时间被调整后，换算结果随之平移（换算的是"现在看来"的采集时刻）
+ */
+inline uint64_t ndm_wall_time_ns(uint64_t timestamp_ns) {
+    struct timespec mono, real;
+    clock_gettime(CLOCK_MONOTONIC, &mono);
+    clock_gettime(CLOCK_REALTIME, &real);
+    const int64_t offset_ns = (static_cast<int64_t>(real.tv_sec) - mono.tv_sec) * 1000000000LL
+                              + (real.tv_nsec - mono.tv_nsec);
+    const int64_t wall_ns = static_cast<int64_t>(timestamp_ns) + offset_ns;
+    return wall_ns > 0 ? static_cast<uint64_t>(wall_ns) : 0;
+}
+
 /**
  * @brief 计算 CRC-8 校验值
  * 
@@ -0,0 +1,262 @@
+#include "outbox.h"
+#include "logger.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstring>
+#include <filesystem>
+
+namespace {
+
+constexpr uint32_t OUTBOX_MAGIC = 0x424F5747;   // "GWOB"
+constexpr uint16_t OUTBOX_VERSION = 2;           // 2: 记录时间戳为墙上时间
+constexpr uint16_t OUTBOX_VERSION_MONOTONIC = 1; // 1: 记录时间戳为单调时钟
+
+struct OutboxHeader {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t record_size;
+    uint32_t capacity;
+    uint32_t head;
+    uint32_t count;
+    uint32_t reserved;
+};
+static_assert(sizeof(OutboxHeader) == 24, "OutboxHeader layout");
+
+/// @brief 墙上时间换算回单调时钟；早于本次启动的样本为 0
+uint64_t monotonic_of(uint64_t wall_ns) {
+    const uint64_t offset_ns = ndm_wall_time_ns(0);
+    return wall_ns > offset_ns ? wall_ns - offset_ns : 0;
+}
+
+} // namespace
+
+Outbox::~Outbox() {
+    close();
+}
+
+bool Outbox::open(size_t capacity, const std::string& path) {
+    close();
+    if (capacity == 0 || capacity > 0xFFFFFFFFu) {
+        LOG_ERROR("Outbox capacity %zu invalid", capacity);
+        return false;
+    }
+
+    capacity_ = capacity;
+    slots_.assign(capacity, NormalizedData{});
+    head_ = 0;
+    count_ = 0;
+    dropped_ = 0;
+    path_ = path;
+
+    if (path.empty()) {
+        return true;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(std::filesystem::path(path).parent_path(), ec);
+
+    // 文件有效且容量相同: 原地沿用，不重写
+    if (load_file()) {
+        if (count_ > 0) {
+            LOG_INFO("Outbox %s: restored %zu samples", path.c_str(), count_);
+        }
+        return true;
+    }
+
+    // 其余情况（不存在、无法识别、容量或版本变化、有损坏记录）: 已读取的样本
+    // 写入临时文件后替换，替换完成前旧文件保持不变
+    if (!rewrite_file()) {
+        // 退化为内存缓存，仍然保留已读取的样本
+        return false;
+    }
+    if (count_ > 0) {
+        LOG_INFO("Outbox %s: restored %zu samples (file rewritten)", path.c_str(), count_);
+    }
+    return true;
+}
+
+bool Outbox::load_file() {
+    int fd = ::open(path_.c_str(), O_RDWR | O_CLOEXEC);
+    if (fd < 0) {
+        return false;
+    }
+
+    OutboxHeader header{};
+    bool ok = (pread(fd, &header, sizeof(header), 0) == static_cast<ssize_t>(sizeof(header)) &&
+               header.magic == OUTBOX_MAGIC &&
+               (header.version == OUTBOX_VERSION || header.version == OUTBOX_VERSION_MONOTONIC) &&
+               header.record_size == sizeof(NormalizedData) &&
+               header.capacity > 0 && header.head < header.capacity && header.count <= header.capacity);
+    if (!ok) {
+        LOG_WARN("Outbox file %s not recognized, discarding", path_.c_str());
+        ::close(fd);
+        return false;
+    }
+
+    std::vector<NormalizedData> saved;
+    saved.reserve(header.count);
+    bool intact = (header.version == OUTBOX_VERSION && header.capacity == capacity_);
+    for (uint32_t i = 0; i < header.count; ++i) {
+        const uint32_t slot = (header.head + i) % header.capacity;
+        NormalizedData data;
+        const off_t offset = static_cast<off_t>(sizeof(header) + slot * sizeof(NormalizedData));
+        if (pread(fd, &data, sizeof(data), offset) != static_cast<ssize_t>(sizeof(data))) {
+            intact = false;
+            break;
+        }
+        if (!ndm_verify_crc(data)) {
+            intact = false;
+            continue;
+        }
+        if (header.version == OUTBOX_VERSION_MONOTONIC) {
+            // 旧版本按当前时钟差换算（假定文件写于本次启动期间）
+            data.timestamp_ns = ndm_wall_time_ns(data.timestamp_ns);
+            ndm_set_crc(data);
+        }
+        saved.push_back(data);
+    }
+
+    if (intact) {
+        // 槽位布局与文件一致，直接沿用文件描述符
+        for (uint32_t i = 0; i < header.count; ++i) {
+            slots_[(header.head + i) % header.capacity] = saved[i];
+        }
+        head_ = header.head;
+        count_ = header.count;
+        fd_ = fd;
+        return true;
+    }
+    ::close(fd);
+
+    // 容量变小时只保留最新的样本
+    const size_t skip = saved.size() > capacity_ ? saved.size() - capacity_ : 0;
+    dropped_ += skip;
+    for (size_t i = skip; i < saved.size(); ++i) {
+        slots_[count_++] = saved[i];
+    }
+    return false;
+}
+
+bool Outbox::rewrite_file() {
+    const std::string tmp_path = path_ + ".tmp";
+    int fd = ::open(tmp_path.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) {
+        LOG_ERROR("Failed to open outbox file %s: %s", tmp_path.c_str(), strerror(errno));
+        return false;
+    }
+
+    const size_t records = capacity_ * sizeof(NormalizedData);
+    bool ok = (ftruncate(fd, static_cast<off_t>(sizeof(OutboxHeader) + records)) == 0 &&
+               pwrite(fd, slots_.data(), records, sizeof(OutboxHeader)) == static_cast<ssize_t>(records));
+    if (ok) {
+        fd_ = fd;
+        write_header();
+        ok = (fsync(fd) == 0 && ::rename(tmp_path.c_str(), path_.c_str()) == 0);
+    }
+    if (!ok) {
+        LOG_ERROR("Failed to write outbox file %s: %s", path_.c_str(), strerror(errno));
+        ::close(fd);
+        ::unlink(tmp_path.c_str());
+        fd_ = -1;
+        return false;
+    }
+
+    // rename() 本身持久化
+    int dir_fd = ::open(std::filesystem::path(path_).parent_path().string().c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (dir_fd >= 0) {
+        fsync(dir_fd);
+        ::close(dir_fd);
+    }
+    return true;
+}
+
+void Outbox::close() {
+    if (fd_ >= 0) {
+        write_header();
+        fsync(fd_);
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+void Outbox::write_record(size_t slot) {
+    if (fd_ < 0) {
+        return;
+    }
+    const off_t offset = static_cast<off_t>(sizeof(OutboxHeader) + slot * sizeof(NormalizedData));
+    if (pwrite(fd_, &slots_[slot], sizeof(NormalizedData), offset) != static_cast<ssize_t>(sizeof(NormalizedData))) {
+        LOG_WARN("Outbox write failed: %s", strerror(errno));
+    }
+}
+
+void Outbox::write_header() {
+    header_dirty_ = false;
+    if (fd_ < 0) {
+        return;
+    }
+    OutboxHeader header{};
+    header.magic = OUTBOX_MAGIC;
+    header.version = OUTBOX_VERSION;
+    header.record_size = static_cast<uint16_t>(sizeof(NormalizedData));
+    header.capacity = static_cast<uint32_t>(capacity_);
+    header.head = static_cast<uint32_t>(head_);
+    header.count = static_cast<uint32_t>(count_);
+    if (pwrite(fd_, &header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header))) {
+        LOG_WARN("Outbox header write failed: %s", strerror(errno));
+    }
+}
+
+void Outbox::push(const NormalizedData& data) {
+    if (capacity_ == 0) {
+        return;
+    }
+    if (count_ == capacity_) {
+        // 满: 覆盖最旧的样本
+        head_ = (head_ + 1) % capacity_;
+        count_--;
+        dropped_++;
+    }
+    const size_t slot = (head_ + count_) % capacity_;
+    NormalizedData& record = slots_[slot];
+    record = data;
+    record.timestamp_ns = ndm_wall_time_ns(data.timestamp_ns);
+    ndm_set_crc(record);
+    count_++;
+    write_record(slot);
+    header_dirty_ = true;
+}
+
+bool Outbox::front(NormalizedData& data, uint64_t* wall_ns) const {
+    return at(0, data, wall_ns);
+}
+
+bool Outbox::at(size_t index, NormalizedData& data, uint64_t* wall_ns) const {
+    if (index >= count_) {
+        return false;
+    }
+    data = slots_[(head_ + index) % capacity_];
+    if (wall_ns) {
+        *wall_ns = data.timestamp_ns;
+    }
+    data.timestamp_ns = monotonic_of(data.timestamp_ns);
+    ndm_set_crc(data);
+    return true;
+}
+
+void Outbox::pop() {
+    if (count_ == 0) {
+        return;
+    }
+    head_ = (head_ + 1) % capacity_;
+    count_--;
+    header_dirty_ = true;
+}
+
+void Outbox::sync() {
+    if (header_dirty_) {
+        write_header();
+    }
+}
@@ -0,0 +1,114 @@
+/**
+ * @file outbox.h
+ * @brief 断线缓存（store-and-forward）
+ *
+ * PLC / OPC UA 服务器断线期间（交换机重启等），输出守护进程原先直接丢弃数据。
+ * Outbox 在断线期间按顺序缓存样本，恢复连接后由调用方按限速从最旧的开始补发。
+ *
+ * 设计:
+ * - 容量固定（样本数），满了丢弃最旧的样本并计数
+ * - 可选持久化: 磁盘文件与内存使用相同的环形布局，push() 只写一条记录，
+ *   头部（读位置/数量）由 sync() 每周期最多写一次；守护进程重启后继续补发
+ * - 打开时旧文件有效且容量相同则原地沿用；否则把旧样本写入临时文件，
+ *   fsync 后 rename() 替换，任何时刻崩溃都不会丢失已缓存的积压
+ * - 记录中的时间戳为墙上时间（Unix 纪元纳秒），重启后单调时钟从 0 开始，
+ *   墙上时间仍然有效；front()/at() 返回时换算回单调时钟
+ *
+ * 文件格式: 24 字节头（magic/版本/记录大小/容量/读位置/数量） + 容量 × 记录
+ * （版本 1 的记录为单调时钟时间戳，打开时按当前时钟差换算后重写为版本 2）
+ *
+ * @author Gateway Project
+ * @date 2025-10-27
+ */
+
+#ifndef GATEWAY_OUTBOX_H
+#define GATEWAY_OUTBOX_H
+
+#include "ndm.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @class Outbox
+ * @brief 有界的断线缓存队列（单线程使用）
+ */
+class Outbox {
+public:
+    Outbox() = default;
+    ~Outbox();
+
+    Outbox(const Outbox&) = delete;
+    Outbox& operator=(const Outbox&) = delete;
+
+    /**
+     * @brief 打开缓存
+     *
+     * @param capacity 最大样本数
+     * @param path 持久化文件路径，空字符串表示只在内存中缓存
+     * @return bool false=参数无效或文件无法打开（此时退化为内存缓存）
+     */
+    bool open(size_t capacity, const std::string& path);
+
+    /**
+     * @brief 写出头部并关闭文件
+     */
+    void close();
+
+    bool is_open() const { return capacity_ > 0; }
+    bool empty() const { return count_ == 0; }
+    size_t size() const { return count_; }
+    size_t capacity() const { return capacity_; }
+
+    /**
+     * @brief 追加样本（满时丢弃最旧的样本）
+     */
+    void push(const NormalizedData& data);
+
+    /**
+     * @brief 查看最旧的样本
+     *
+     * @param data 样本，timestamp_ns 为单调时钟（采集于本次启动之前的样本为 0）
+     * @param wall_ns 可选，样本的墙上时间（Unix 纪元纳秒）
+     * @return bool false=队列为空
+     */
+    bool front(NormalizedData& data, uint64_t* wall_ns = nullptr) const;
+
+    /**
+     * @brief 查看第 index 旧的样本（index=0 同 front()，用于多个在途补发）
+     * @return bool false=index 超出队列长度
+     */
+    bool at(size_t index, NormalizedData& data, uint64_t* wall_ns = nullptr) const;
+
+    /**
+     * @brief 移除最旧的样本（front() 的样本发送成功后调用）
+     */
+    void pop();
+
+    /**
+     * @brief 头部有变化时写入磁盘（每周期调用一次）
+     */
+    void sync();
+
+    /// @brief 因容量已满被丢弃的样本数
+    uint64_t dropped() const { return dropped_; }
+
+private:
+    bool load_file();
+    bool rewrite_file();
+    void write_record(size_t slot);
+    void write_header();
+
+    std::vector<NormalizedData> slots_;   ///< 记录（时间戳为墙上时间）
+    size_t capacity_ = 0;
+    size_t head_ = 0;            ///< 最旧样本所在槽位
+    size_t count_ = 0;
+    uint64_t dropped_ = 0;
+    int fd_ = -1;
+    std::string path_;
+    bool header_dirty_ = false;
+};
+
+#endif // GATEWAY_OUTBOX_H
@@ -0,0 +1,54 @@
+#include "service_host.h"
+
+#include "logger.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <mutex>
+#include <set>
+#include <string>
+
+namespace ServiceHost {
+namespace {
+bool g_hosted = false;
+std::mutex g_ready_mutex;
+std::condition_variable g_ready_cv;
+std::set<std::string> g_ready;
+}
+
+void set_hosted(bool hosted) {
+    g_hosted = hosted;
+}
+
+bool hosted() {
+    return g_hosted;
+}
+
+void init(const char* name, void (*on_signal)(int)) {
+    if (g_hosted) {
+        Logger::set_thread_name(name);
+        return;
+    }
+    Logger::init(name, false);
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    // 对端关闭的套接字返回 EPIPE，而不是终止进程
+    signal(SIGPIPE, SIG_IGN);
+}
+
+void notify_ready(const char* name) {
+    {
+        std::lock_guard<std::mutex> lock(g_ready_mutex);
+        g_ready.insert(name);
+    }
+    g_ready_cv.notify_all();
+}
+
+bool wait_ready(const char* name, int timeout_ms) {
+    std::unique_lock<std::mutex> lock(g_ready_mutex);
+    return g_ready_cv.wait_for(lock, std::chrono::milliseconds(timeout_ms),
+                               [name]() { return g_ready.count(name) > 0; });
+}
+
+} // namespace ServiceHost
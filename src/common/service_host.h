@@ -0,0 +1,58 @@
+/**
+ * @file service_host.h
+ * @brief 服务运行环境（独立进程 / gatewayd 单进程中的线程）
+ *
+ * 各守护进程的主体写成 `<服务名>::run(argc, argv)`，独立编译时由
+ * 文件末尾的 main() 调用；gatewayd 以 GATEWAY_HOSTED 编译同一份源文件，
+ * 在一个进程中为每个服务启动一个线程，共享进程内的环形缓冲区
+ * （SharedMemoryManager::use_local_ring()）和 ConfigManager 单例。
+ *
+ * 两种模式只在启动和退出时不同:
+ * - 独立进程: init() 初始化日志并注册 SIGINT/SIGTERM
+ * - 托管: init() 只设置本线程的日志名；信号由 gatewayd 统一接收，
+ *   再调用各服务的 stop()
+ *
+ * @author Gateway Project
+ * @date 2025-10-30
+ */
+
+#ifndef GATEWAY_SERVICE_HOST_H
+#define GATEWAY_SERVICE_HOST_H
+
+namespace ServiceHost {
+
+/**
+ * @brief 标记当前进程为 gatewayd（在启动服务线程之前调用）
+ */
+void set_hosted(bool hosted);
+
+/**
+ * @brief 是否运行在 gatewayd 中
+ */
+bool hosted();
+
+/**
+ * @brief 服务启动时调用
+ *
+ * @param name 服务名（日志名）
+ * @param on_signal 独立进程时的 SIGINT/SIGTERM 处理函数
+ */
+void init(const char* name, void (*on_signal)(int));
+
+/**
+ * @brief 服务已完成初始化（如 rs485d 已创建环形缓冲区和命令队列）
+ */
+void notify_ready(const char* name);
+
+/**
+ * @brief 等待服务完成初始化（gatewayd 按依赖顺序启动服务时使用）
+ *
+ * @param name 服务名
+ * @param timeout_ms 最长等待时间
+ * @return bool false=超时
+ */
+bool wait_ready(const char* name, int timeout_ms);
+
+} // namespace ServiceHost
+
+#endif // GATEWAY_SERVICE_HOST_H
@@ -3,9 +3,49 @@
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <cerrno>
+#include <climits>
 #include <cstring>
+#include <ctime>
 #include <iostream>
 
+// ============================================================================
+// 新数据通知
+// ============================================================================
+
+// write_idx 位于 MAP_SHARED 映射中，使用共享（非 PRIVATE）futex 跨进程等待/唤醒
+static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t), "futex word must be 32-bit");
+
+bool RingBuffer::wait_next(uint32_t cursor, int timeout_ms) const {
+    if (write_idx.load(std::memory_order_acquire) != cursor) {
+        return true;
+    }
+    if (timeout_ms <= 0) {
+        return false;
+    }
+    
+    struct timespec timeout;
+    timeout.tv_sec = timeout_ms / 1000;
+    timeout.tv_nsec = static_cast<long>(timeout_ms % 1000) * 1000000L;
+    // write_idx 仍为 cursor 时才进入睡眠；被唤醒、超时或被信号中断都重新检查一次
+    syscall(SYS_futex, reinterpret_cast<const uint32_t*>(&write_idx), FUTEX_WAIT,
+            cursor, &timeout, nullptr, 0);
+    return write_idx.load(std::memory_order_acquire) != cursor;
+}
+
+void RingBuffer::notify() {
+    syscall(SYS_futex, reinterpret_cast<uint32_t*>(&write_idx), FUTEX_WAKE,
+            INT_MAX, nullptr, nullptr, 0);
+}
+
+RingBuffer* SharedMemoryManager::local_ring_ = nullptr;
+
+void SharedMemoryManager::use_local_ring(RingBuffer* ring) {
+    local_ring_ = ring;
+}
+
 SharedMemoryManager::SharedMemoryManager() 
     : shm_fd_(-1), ring_(nullptr), is_creator_(false) {
 }
@@ -15,6 +55,13 @@ SharedMemoryManager::~SharedMemoryManager() {
 }
 
 bool SharedMemoryManager::create() {
+    if (local_ring_) {
+        ring_ = local_ring_;
+        ring_->write_idx.store(0);
+        ring_->read_idx.store(0);
+        return true;
+    }
+    
     // 先尝试删除已存在的共享内存
     shm_unlink(SHM_NAME);
     
@@ -56,6 +103,11 @@ bool SharedMemoryManager::create() {
 }
 
 bool SharedMemoryManager::open() {
+    if (local_ring_) {
+        ring_ = local_ring_;
+        return true;
+    }
+    
     // 打开已存在的共享内存
     shm_fd_ = shm_open(SHM_NAME, O_RDWR, 0666);
     if (shm_fd_ < 0) {
@@ -81,6 +133,11 @@ bool SharedMemoryManager::open() {
 }
 
 void SharedMemoryManager::close() {
+    if (ring_ != nullptr && ring_ == local_ring_) {
+        ring_ = nullptr;  // 进程内缓冲区不解除映射
+        return;
+    }
+    
     if (ring_ != nullptr && ring_ != MAP_FAILED) {
         munmap(ring_, sizeof(RingBuffer));
         ring_ = nullptr;
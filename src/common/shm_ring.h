@@ -14,7 +14,8 @@
  * 使用场景:
  * - rs485d (生产者) → modbusd/s7d/opcuad (消费者)
  * - 生产者以 50Hz 频率写入数据
- * - 消费者按需读取最新数据
+ * - 各输出同时运行，每个消费者用自己的 RingCursor 按自己的速率读取，
+ *   互不影响（共享内存中不保存消费者状态）
  * 
  * @author Gateway Project
  * @date 2025-10-10
@@ -41,15 +42,15 @@
  * 
  * 工作原理:
  * 1. 生产者 (rs485d) 不断写入新数据，write_idx 递增
- * 2. 消费者 (modbusd 等) 读取最新数据，更新自己的 read_idx
+ * 2. 每个消费者在进程内维护自己的读游标（RingCursor），不写共享内存
  * 3. 使用 memory_order 保证内存可见性
  * 4. 无锁设计避免了互斥锁的性能开销
  * 
  * 内存布局:
  * ```
  * +-------------------+
- * | write_idx (8B)    |  原子变量，生产者写索引
- * | read_idx  (8B)    |  原子变量，消费者读索引
+ * | write_idx (4B)    |  原子变量，生产者写索引
+ * | read_idx  (4B)    |  保留（不再使用，保持布局兼容）
  * | data[0]   (24B)   |  数据数组开始
  * | data[1]   (24B)   |
  * | ...               |
@@ -65,7 +66,8 @@ public:
     /// @brief 写索引 - 生产者写入位置（原子变量，支持并发访问）
     std::atomic<uint32_t> write_idx{0};
     
-    /// @brief 读索引 - 消费者读取位置（原子变量，每个消费者独立维护）
+    /// @brief 保留字段: 曾用作共享读索引。多个消费者共用一个读索引时
+    /// 会互相"取走"样本，现由各消费者的 RingCursor 代替；保留以维持共享内存布局
     std::atomic<uint32_t> read_idx{0};
     
     /// @brief 数据数组 - 存储 NDM 数据
@@ -89,79 +91,70 @@ public:
      * ring->push(data);  // 写入数据
      */
     void push(const NormalizedData& d) {
-        // 原子地获取并递增写索引
-        // memory_order_relaxed: 不需要同步其他内存操作
-        uint32_t idx = write_idx.fetch_add(1, std::memory_order_relaxed) % RING_SIZE;
+        // 单生产者: 先写数据，再发布写索引
+        uint32_t w = write_idx.load(std::memory_order_relaxed);
+        data[w % RING_SIZE] = d;
         
-        // 写入数据到指定位置
-        data[idx] = d;
+        // memory_order_release: 消费者看到新索引时一定能看到数据
+        write_idx.store(w + 1, std::memory_order_release);
         
-        // 内存屏障: 确保数据写入对消费者可见
-        // memory_order_release: 之前的所有写操作必须在此之前完成
-        std::atomic_thread_fence(std::memory_order_release);
+        // 唤醒在 wait_next() 中等待的消费者
+        notify();
     }
     
     /**
-     * @brief 读取最新数据（消费者调用）
-     * 
-     * 读取环形缓冲区中最新的一条数据。
-     * 如果有新数据，返回 true 并填充 d 参数。
-     * 如果没有新数据，返回 false。
-     * 
-     * @param[out] d 用于接收数据的 NDM 结构引用
-     * @return bool true=成功读取新数据, false=无新数据
-     * 
-     * @note 线程安全: 支持多消费者，每个消费者独立维护读索引
-     * @note 性能: O(1) 复杂度，无锁操作
-     * 
-     * @example
-     * RingBuffer* ring = ...;
-     * NormalizedData data;
-     * if (ring->pop_latest(data)) {
-     *     // 成功读取到新数据
-     *     process_data(data);
-     * } else {
-     *     // 没有新数据，可以稍后重试
-     * }
+     * @brief 等待生产者写入新数据（跨进程 futex，不占用 CPU）
+     *
+     * 消费者用它代替固定间隔的休眠: 新样本写入后立即被唤醒，
+     * 事件循环中的其他工作（网络收发等）由超时驱动。
+     *
+     * @param cursor 调用方已读到的位置；write_idx 已不等于 cursor 时立即返回
+     * @param timeout_ms 最长等待时间（毫秒，0=不等待）
+     * @return bool true=有新数据, false=超时
+     */
+    bool wait_next(uint32_t cursor, int timeout_ms) const;
+    
+    /**
+     * @brief 唤醒所有等待新数据的消费者（push() 内部调用）
      */
-    bool pop_latest(NormalizedData& d) {
-        // 原子地读取写索引
-        // memory_order_acquire: 确保能看到生产者的所有写操作
+    void notify();
+    
+    /**
+     * @brief 按调用方自己的游标顺序读取数据（不修改共享读索引）
+     *
+     * 多通道数据交错写入同一个环形缓冲区时，只取最新一条会丢掉其他
+     * 通道的样本；需要逐条处理的消费者用本方法按顺序读取。
+     * 游标落后超过 RING_SIZE 时（数据已被覆盖）跳到仍然有效的最旧数据。
+     *
+     * @param[in,out] cursor 调用方维护的读位置（初始可取 write_idx）
+     * @param[out] d 接收数据的结构体
+     * @return bool true=读到一条数据, false=没有新数据
+     *
+     * @note 读取期间可能被生产者覆盖，调用方应使用 ndm_verify_crc() 校验
+     */
+    bool read_next(uint32_t& cursor, NormalizedData& d) const {
         uint32_t w = write_idx.load(std::memory_order_acquire);
-        
-        // 读取当前的读索引
-        // memory_order_relaxed: 读索引只有本消费者使用
-        uint32_t r = read_idx.load(std::memory_order_relaxed);
-        
-        // 检查是否有新数据
-        if (w == r) {
-            return false; // 没有新数据
+        if (cursor == w) {
+            return false;
         }
-        
-        // 读取最新的数据（写索引的前一个位置）
-        uint32_t idx = (w - 1) % RING_SIZE;
-        d = data[idx];
-        
-        // 更新读索引到最新位置
-        // memory_order_release: 确保数据读取完成后再更新索引
-        read_idx.store(w, std::memory_order_release);
-        
+        if (w - cursor > RING_SIZE) {
+            cursor = w - RING_SIZE;
+        }
+        d = data[cursor % RING_SIZE];
+        cursor++;
         return true;
     }
     
     /**
-     * @brief 获取当前未读数据量
-     * 
-     * 计算写索引和读索引的差值，即未读数据的数量。
+     * @brief 获取缓冲区中仍然有效的样本数（最多 RING_SIZE）
      * 
-     * @return uint32_t 未读数据数量
+     * 各消费者的未读数量见 RingCursor::lag()。
      * 
-     * @note 由于是无锁设计，返回值可能不是精确的，但足够用于监控
+     * @return uint32_t 有效样本数
      */
     uint32_t size() const {
         uint32_t w = write_idx.load(std::memory_order_acquire);
-        uint32_t r = read_idx.load(std::memory_order_acquire);
-        return w - r;  // 无符号整数，自动处理溢出
+        return w < RING_SIZE ? w : RING_SIZE;
     }
     
     /**
@@ -190,6 +183,78 @@ public:
     }
 };
 
+/**
+ * @class RingCursor
+ * @brief 单个消费者的读位置和读取统计
+ *
+ * 每个输出（Modbus / S7 / OPC UA 会话等）各持有一个游标，从创建时的
+ * 最新样本开始按顺序读取。游标落后超过 RING_SIZE 时，被覆盖的样本
+ * 计入 overruns()，用于在状态中反映该输出是否跟得上采集速率。
+ */
+class RingCursor {
+public:
+    RingCursor() = default;
+    
+    /**
+     * @brief 绑定环形缓冲区，从最新一条样本开始读取
+     */
+    explicit RingCursor(const RingBuffer* ring) { attach(ring); }
+    
+    void attach(const RingBuffer* ring) {
+        ring_ = ring;
+        position_ = 0;
+        if (ring_) {
+            position_ = ring_->write_idx.load(std::memory_order_acquire);
+            if (position_ > 0) {
+                position_--;
+            }
+        }
+    }
+    
+    /**
+     * @brief 读取下一条样本
+     * @return bool false=没有新数据
+     */
+    bool next(NormalizedData& d) {
+        if (!ring_) {
+            return false;
+        }
+        const uint32_t w = ring_->write_idx.load(std::memory_order_acquire);
+        if (w - position_ > RING_SIZE) {
+            overruns_ += w - position_ - RING_SIZE;
+        }
+        if (!ring_->read_next(position_, d)) {
+            return false;
+        }
+        read_++;
+        return true;
+    }
+    
+    /**
+     * @brief 等待新样本（见 RingBuffer::wait_next()）
+     */
+    bool wait(int timeout_ms) const {
+        return ring_ && ring_->wait_next(position_, timeout_ms);
+    }
+    
+    /// @brief 尚未读取的样本数
+    uint32_t lag() const {
+        return ring_ ? ring_->write_idx.load(std::memory_order_acquire) - position_ : 0;
+    }
+    
+    /// @brief 已读取的样本数
+    uint64_t read() const { return read_; }
+    
+    /// @brief 未来得及读取即被覆盖的样本数
+    uint64_t overruns() const { return overruns_; }
+    
+private:
+    const RingBuffer* ring_ = nullptr;
+    uint32_t position_ = 0;
+    uint64_t read_ = 0;
+    uint64_t overruns_ = 0;
+};
+
 /**
  * @class SharedMemoryManager
  * @brief 共享内存管理器
@@ -203,6 +268,9 @@ public:
  * 
  * 共享内存路径: /dev/shm/gw_data_ring
  * 
+ * gatewayd 单进程模式下调用 use_local_ring() 后，create()/open() 都返回
+ * 进程内的同一个缓冲区，不再创建 /dev/shm 对象。
+ * 
  * @note RAII 设计: 构造时分配资源，析构时自动释放
  */
 class SharedMemoryManager {
@@ -296,7 +364,18 @@ public:
      */
     bool is_connected() const { return ring_ != nullptr; }
     
+    /**
+     * @brief 使用进程内的环形缓冲区代替 POSIX 共享内存（gatewayd 单进程模式）
+     * 
+     * 须在启动各服务线程之前调用；ring 的生命周期由调用方保证。
+     * 
+     * @param ring 进程内缓冲区，nullptr=恢复使用共享内存
+     */
+    static void use_local_ring(RingBuffer* ring);
+    
 private:
+    static RingBuffer* local_ring_;  ///< 进程内缓冲区（单进程模式）
+    
     int shm_fd_;            ///< 共享内存文件描述符
     RingBuffer* ring_;      ///< 映射到共享内存的环形缓冲区指针
     bool is_creator_;       ///< 是否是创建者（用于判断是否需要销毁）
@@ -0,0 +1,142 @@
+#include "shm_segment.h"
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+ShmSegment::~ShmSegment() {
+    close();
+}
+
+bool ShmSegment::create(const std::string& name, size_t size) {
+    close();
+    name_ = name;
+
+    // 先尝试删除已存在的共享内存
+    shm_unlink(name_.c_str());
+
+    fd_ = shm_open(name_.c_str(), O_CREAT | O_RDWR, 0666);
+    if (fd_ < 0) {
+        std::cerr << "Failed to create shared memory " << name_ << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    if (ftruncate(fd_, static_cast<off_t>(size)) < 0) {
+        std::cerr << "Failed to set shared memory size " << name_ << ": " << strerror(errno) << std::endl;
+        ::close(fd_);
+        fd_ = -1;
+        shm_unlink(name_.c_str());
+        return false;
+    }
+
+    if (!map(size)) {
+        shm_unlink(name_.c_str());
+        return false;
+    }
+
+    // ftruncate 保证新段内容为 0，这里显式清零以免依赖实现
+    std::memset(addr_, 0, size);
+    is_creator_ = true;
+    return true;
+}
+
+bool ShmSegment::open(const std::string& name, size_t size) {
+    close();
+    name_ = name;
+
+    fd_ = shm_open(name_.c_str(), O_RDWR, 0666);
+    if (fd_ < 0) {
+        std::cerr << "Failed to open shared memory " << name_ << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    // 防止映射一个由旧版本创建的、尺寸更小的段
+    struct stat st;
+    if (fstat(fd_, &st) < 0 || static_cast<size_t>(st.st_size) < size) {
+        std::cerr << "Shared memory " << name_ << " has unexpected size" << std::endl;
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    is_creator_ = false;
+    return map(size);
+}
+
+bool ShmSegment::open_or_create(const std::string& name, size_t size) {
+    close();
+    name_ = name;
+
+    fd_ = shm_open(name_.c_str(), O_CREAT | O_RDWR, 0666);
+    if (fd_ < 0) {
+        std::cerr << "Failed to open shared memory " << name_ << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    // 只扩展不截断: 多个进程同时调用时 ftruncate 到相同大小是幂等的
+    struct stat st;
+    if (fstat(fd_, &st) < 0 ||
+        (static_cast<size_t>(st.st_size) < size && ftruncate(fd_, static_cast<off_t>(size)) < 0)) {
+        std::cerr << "Failed to size shared memory " << name_ << ": " << strerror(errno) << std::endl;
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+
+    is_creator_ = false;
+    return map(size);
+}
+
+bool ShmSegment::map(size_t size) {
+    void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+    if (addr == MAP_FAILED) {
+        std::cerr << "Failed to map shared memory " << name_ << ": " << strerror(errno) << std::endl;
+        ::close(fd_);
+        fd_ = -1;
+        return false;
+    }
+    addr_ = addr;
+    size_ = size;
+    return true;
+}
+
+bool ShmSegment::replaced() const {
+    if (name_.empty()) {
+        return false;
+    }
+    // Linux 的 POSIX 共享内存对象位于 /dev/shm，比较 inode 即可判断是否同一个对象
+    struct stat named;
+    if (stat(("/dev/shm" + name_).c_str(), &named) != 0) {
+        return false;
+    }
+    if (fd_ < 0) {
+        return true;
+    }
+    struct stat mapped;
+    return fstat(fd_, &mapped) == 0 && (mapped.st_ino != named.st_ino || mapped.st_dev != named.st_dev);
+}
+
+void ShmSegment::close() {
+    if (addr_ != nullptr) {
+        munmap(addr_, size_);
+        addr_ = nullptr;
+        size_ = 0;
+    }
+
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+void ShmSegment::destroy() {
+    close();
+
+    if (is_creator_ && !name_.empty()) {
+        shm_unlink(name_.c_str());
+        is_creator_ = false;
+    }
+}
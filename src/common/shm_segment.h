@@ -0,0 +1,98 @@
+/**
+ * @file shm_segment.h
+ * @brief 通用 POSIX 共享内存段
+ *
+ * SharedMemoryManager 专门管理数据环形缓冲区；其他跨进程结构
+ * （命令队列等）使用本类完成 shm_open/ftruncate/mmap 的样板工作。
+ *
+ * 使用方式与 SharedMemoryManager 一致:
+ * - 创建者调用 create()，退出时调用 destroy()
+ * - 使用者调用 open()，退出时调用 close()
+ *
+ * @author Gateway Project
+ * @date 2025-10-21
+ */
+
+#ifndef GATEWAY_SHM_SEGMENT_H
+#define GATEWAY_SHM_SEGMENT_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @class ShmSegment
+ * @brief 固定大小的命名共享内存段（RAII）
+ */
+class ShmSegment {
+public:
+    ShmSegment() = default;
+    ~ShmSegment();
+
+    ShmSegment(const ShmSegment&) = delete;
+    ShmSegment& operator=(const ShmSegment&) = delete;
+
+    /**
+     * @brief 创建共享内存段（已存在则先删除），内容清零
+     *
+     * @param name 共享内存名称（如 "/gw_cmd_queue"）
+     * @param size 段大小（字节）
+     * @return bool true=成功
+     */
+    bool create(const std::string& name, size_t size);
+
+    /**
+     * @brief 打开已存在的共享内存段
+     *
+     * @param name 共享内存名称
+     * @param size 期望的段大小（字节），实际大小不足时失败
+     * @return bool true=成功
+     */
+    bool open(const std::string& name, size_t size);
+
+    /**
+     * @brief 打开共享内存段，不存在时创建（不删除已有内容）
+     *
+     * 用于没有固定创建者的段（如状态表）: 任一进程先启动都可以创建，
+     * 新段内容为 0；已有段小于 size 时扩展。本方式打开的段不会被 destroy() 删除。
+     *
+     * @param name 共享内存名称
+     * @param size 段大小（字节）
+     * @return bool true=成功
+     */
+    bool open_or_create(const std::string& name, size_t size);
+
+    /**
+     * @brief 解除映射并关闭文件描述符
+     */
+    void close();
+
+    /**
+     * @brief 关闭并删除共享内存段（仅创建者生效）
+     */
+    void destroy();
+
+    /// @brief 映射地址，未连接时为 nullptr
+    void* data() const { return addr_; }
+
+    /// @brief 是否已映射
+    bool is_connected() const { return addr_ != nullptr; }
+
+    /**
+     * @brief 同名共享内存已被重新创建（创建者重启），当前映射不再是它
+     *
+     * 用于使用者判断是否需要重新 open()。未连接时只要同名段存在即返回 true；
+     * 同名段不存在（创建者尚未启动）时返回 false。
+     */
+    bool replaced() const;
+
+private:
+    bool map(size_t size);
+
+    std::string name_;         ///< 共享内存名称
+    int fd_ = -1;              ///< 共享内存文件描述符
+    void* addr_ = nullptr;     ///< 映射地址
+    size_t size_ = 0;          ///< 映射大小
+    bool is_creator_ = false;  ///< 是否是创建者
+};
+
+#endif // GATEWAY_SHM_SEGMENT_H
@@ -0,0 +1,199 @@
+/**
+ * @file status_table.h
+ * @brief 共享内存状态表：各协议守护进程 → webcfg
+ *
+ * 每个组件在表中占一个固定位置的状态块，由该组件独占写入，
+ * webcfg 在收到 HTTP 请求时读取并生成 JSON。取代每个周期重写
+ * /tmp/gw-test/status_<组件>.json 的方式:
+ * - 热字段（激活/连接状态、最新样本、读游标）每个周期更新，
+ *   只是几次内存写入，不分配内存、不做系统调用
+ * - 详情（配置、发布统计、会话列表等）按原来的节奏（每秒/状态变化时）
+ *   序列化为紧凑 JSON 存入块内的详情区
+ *
+ * 热字段和详情区各用一个 seqlock 保护: 写入前后各递增一次序号
+ * （写入期间为奇数），读取方复制数据后序号不变才采用，否则重试。
+ * 写入方从不等待读取方。
+ *
+ * 状态表没有固定的创建者，任一进程先启动时创建（内容全 0 表示
+ * 该组件尚无状态），进程退出时不删除；webcfg 按 updated_ns 判断是否过期。
+ *
+ * 共享内存路径: /dev/shm/gw_status
+ *
+ * @author Gateway Project
+ * @date 2025-10-31
+ */
+
+#ifndef GATEWAY_STATUS_TABLE_H
+#define GATEWAY_STATUS_TABLE_H
+
+#include "ndm.h"
+#include "shm_segment.h"
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <thread>
+
+/// @brief 状态表共享内存名称（在 /dev/shm/ 下）
+#define STATUS_SHM_NAME "/gw_status"
+
+/// @brief 每个组件的详情区大小（紧凑 JSON）
+#define STATUS_DETAIL_SIZE 16384
+
+/**
+ * @namespace StatusComponent
+ * @brief 组件在状态表中的位置
+ */
+namespace StatusComponent {
+    constexpr uint32_t MODBUS         = 0;  ///< modbusd
+    constexpr uint32_t MODBUS_METRICS = 1;  ///< modbusd 请求统计（只有详情）
+    constexpr uint32_t S7             = 2;  ///< s7d
+    constexpr uint32_t OPCUA          = 3;  ///< opcuad
+    constexpr uint32_t COUNT          = 4;
+}
+
+/**
+ * @struct StatusHot
+ * @brief 状态块的热字段（每个周期更新）
+ */
+struct StatusHot {
+    uint64_t updated_ns;      ///< 最近一次更新时间（CLOCK_MONOTONIC），0=从未更新
+    uint8_t  active;          ///< 组件是否处于激活/转发状态
+    uint8_t  connected;       ///< 组件报告的连接状态
+    uint8_t  has_data;        ///< sample 是否有效
+    uint8_t  has_ring;        ///< ring_* 是否有效
+    uint32_t ring_lag;        ///< 读游标未读样本数
+    uint64_t ring_read;       ///< 读游标已读样本数
+    uint64_t ring_overruns;   ///< 被覆盖而未读到的样本数
+    NormalizedData sample;    ///< 最新样本
+};
+
+/**
+ * @class StatusBlock
+ * @brief 单个组件的状态块（缓存行对齐，避免组件之间伪共享）
+ *
+ * 内存布局:
+ * ```
+ * +---------------------------+
+ * | hot_seq, hot              |  seqlock + 热字段
+ * | detail_seq, detail_len    |
+ * | detail_ns, detail[16KB]   |  seqlock + 紧凑 JSON
+ * +---------------------------+
+ * ```
+ */
+class alignas(64) StatusBlock {
+public:
+    std::atomic<uint32_t> hot_seq{0};
+    StatusHot hot;
+
+    alignas(64) std::atomic<uint32_t> detail_seq{0};
+    uint32_t detail_len;
+    uint64_t detail_ns;
+    char detail[STATUS_DETAIL_SIZE];
+
+    /**
+     * @brief 写入热字段（仅该组件调用）
+     */
+    void write_hot(const StatusHot& value) {
+        const uint32_t seq = hot_seq.load(std::memory_order_relaxed);
+        hot_seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        hot = value;
+        hot_seq.store(seq + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief 读取热字段（任意进程调用）
+     * @return bool false=多次重试仍与写入冲突
+     */
+    bool read_hot(StatusHot& out) const {
+        for (int attempt = 0; attempt < 64; attempt++) {
+            const uint32_t before = hot_seq.load(std::memory_order_acquire);
+            if ((before & 1U) == 0) {
+                std::memcpy(&out, &hot, sizeof(out));
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (hot_seq.load(std::memory_order_relaxed) == before) {
+                    return true;
+                }
+            }
+            std::this_thread::yield();  // 让写入方完成（同一 CPU 上时）
+        }
+        return false;
+    }
+
+    /**
+     * @brief 写入详情（仅该组件调用）
+     *
+     * @param text 紧凑 JSON
+     * @param len 字节数（不超过 STATUS_DETAIL_SIZE，由调用方保证）
+     * @param now_ns 写入时间
+     */
+    void write_detail(const char* text, uint32_t len, uint64_t now_ns) {
+        const uint32_t seq = detail_seq.load(std::memory_order_relaxed);
+        detail_seq.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        std::memcpy(detail, text, len);
+        detail_len = len;
+        detail_ns = now_ns;
+        detail_seq.store(seq + 2, std::memory_order_release);
+    }
+
+    /**
+     * @brief 读取详情（任意进程调用）
+     *
+     * @param[out] out 缓冲区，至少 STATUS_DETAIL_SIZE 字节
+     * @param[out] len 字节数，0=尚无详情
+     * @param[out] written_ns 详情写入时间
+     * @return bool false=多次重试仍与写入冲突
+     */
+    bool read_detail(char* out, uint32_t& len, uint64_t& written_ns) const {
+        for (int attempt = 0; attempt < 64; attempt++) {
+            const uint32_t before = detail_seq.load(std::memory_order_acquire);
+            // 长度越界说明与写入交错，同样重试
+            const uint32_t n = detail_len;
+            if ((before & 1U) == 0 && n <= STATUS_DETAIL_SIZE) {
+                const uint64_t ns = detail_ns;
+                std::memcpy(out, detail, n);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (detail_seq.load(std::memory_order_relaxed) == before) {
+                    len = n;
+                    written_ns = ns;
+                    return true;
+                }
+            }
+            std::this_thread::yield();
+        }
+        return false;
+    }
+};
+
+/**
+ * @struct StatusTable
+ * @brief 共享内存中的状态表
+ */
+struct StatusTable {
+    StatusBlock blocks[StatusComponent::COUNT];
+};
+
+/**
+ * @class StatusChannel
+ * @brief 状态表共享内存管理器
+ *
+ * 写入方（各协议守护进程）和读取方（webcfg）都调用 open()，
+ * 谁先启动谁创建；不删除共享内存段。
+ */
+class StatusChannel {
+public:
+    /// @brief 打开状态表，不存在时创建
+    bool open() { return segment_.open_or_create(STATUS_SHM_NAME, sizeof(StatusTable)); }
+
+    /// @brief 状态表指针，未连接时为 nullptr
+    StatusTable* table() const { return static_cast<StatusTable*>(segment_.data()); }
+
+    /// @brief 是否已连接
+    bool is_connected() const { return segment_.is_connected(); }
+
+private:
+    ShmSegment segment_;
+};
+
+#endif // GATEWAY_STATUS_TABLE_H
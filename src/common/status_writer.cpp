@@ -1,65 +1,276 @@
 #include "status_writer.h"
 
+#include <atomic>
+#include <cstdio>
 #include <filesystem>
 #include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <vector>
 
 #include "logger.h"
 
 namespace StatusWriter {
 namespace {
-std::filesystem::path status_directory() {
-    return std::filesystem::path("/tmp/gw-test");
+const char* const COMPONENT_NAMES[StatusComponent::COUNT] = {
+    "modbus", "modbus_metrics", "s7", "opcua",
+};
+
+/// @brief 进程内共享的状态表映射（首次使用时打开，不存在时创建）
+StatusTable* status_table() {
+    static StatusChannel channel;
+    static const bool opened = channel.open();
+    return opened ? channel.table() : nullptr;
 }
 
-std::filesystem::path status_path_for(const std::string& component) {
-    return status_directory() / ("status_" + component + ".json");
+StatusBlock* block_for(uint32_t component) {
+    StatusTable* table = status_table();
+    if (!table || component >= StatusComponent::COUNT) {
+        return nullptr;
+    }
+    return &table->blocks[component];
 }
+
+// ---------------------------------------------------------------------------
+// 状态文件输出
+// ---------------------------------------------------------------------------
+
+/// @brief 每个组件的文件输出状态（只由该组件的线程访问）
+struct FileState {
+    uint64_t last_check_ns = 0;   ///< 上次检查（渲染）的时间
+    uint64_t last_write_ns = 0;   ///< 上次实际写文件的时间
+    size_t last_hash = 0;         ///< 上次写入内容（不含时间戳）的哈希
+    bool written = false;
+};
+
+std::mutex g_file_mutex;                          ///< 保护 g_file_cfg
+ConfigManager::StatusFileConfig g_file_cfg;
+std::atomic<bool> g_file_enabled{false};
+std::atomic<uint64_t> g_file_interval_ns{1000000000ULL};
+std::atomic<uint64_t> g_file_keepalive_ns{10000000000ULL};
+FileState g_file_state[StatusComponent::COUNT];
+
+/// @brief 缓存的 StreamWriter（StreamWriter 不是线程安全的，每个线程一份）
+Json::StreamWriter& cached_writer(bool pretty) {
+    thread_local std::unique_ptr<Json::StreamWriter> compact;
+    thread_local std::unique_ptr<Json::StreamWriter> indented;
+    std::unique_ptr<Json::StreamWriter>& writer = pretty ? indented : compact;
+    if (!writer) {
+        Json::StreamWriterBuilder builder;
+        builder["indentation"] = pretty ? "  " : "";
+        writer.reset(builder.newStreamWriter());
+    }
+    return *writer;
 }
 
-void write_component_status(const std::string& component,
-                            const NormalizedData* data,
-                            bool active,
-                            const Json::Value& extra) {
-    try {
-        std::filesystem::create_directories(status_directory());
-    } catch (const std::exception& ex) {
-        LOG_WARN("Failed to create status directory: %s", ex.what());
+std::string render(const Json::Value& value, bool pretty) {
+    thread_local std::ostringstream oss;
+    oss.str(std::string());
+    oss.clear();
+    cached_writer(pretty).write(value, &oss);
+    return oss.str();
+}
+
+/**
+ * @brief 写入临时文件后 rename() 替换，读取方只会看到完整的旧文件或新文件
+ */
+bool write_atomically(const std::filesystem::path& path, const std::string& text) {
+    std::filesystem::path tmp = path;
+    tmp += ".tmp";
+    {
+        std::ofstream ofs(tmp, std::ios::trunc);
+        if (!ofs.is_open()) {
+            return false;
+        }
+        ofs << text;
+        if (!ofs.good()) {
+            return false;
+        }
+    }
+    if (std::rename(tmp.c_str(), path.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+void emit_file(uint32_t component) {
+    if (!g_file_enabled.load(std::memory_order_relaxed) || component >= StatusComponent::COUNT) {
         return;
     }
 
+    // 距上次检查不足一个周期: 本次更新合并到下一次写入
+    FileState& state = g_file_state[component];
     const uint64_t now_ns = get_timestamp_ns();
+    if (state.written && now_ns - state.last_check_ns < g_file_interval_ns.load(std::memory_order_relaxed)) {
+        return;
+    }
+    state.last_check_ns = now_ns;
 
+    Json::Value root = read_component_status(COMPONENT_NAMES[component]);
+    if (root.isNull()) {
+        return;
+    }
+
+    // 时间戳与逐样本变化的字段（序列号、采集时间、厚度、读位置）不参与比较，
+    // 否则有数据时每个周期都会重写；这些字段由 keepalive 定期刷新
+    Json::Value content = root;
+    content.removeMember("updated_ns");
+    content.removeMember("updated_ms");
+    if (content["data"].isObject()) {
+        content["data"].removeMember("sequence");
+        content["data"].removeMember("timestamp_ns");
+        content["data"].removeMember("thickness_mm");
+    }
+    if (content["extra"].isObject() && content["extra"]["ring"].isObject()) {
+        content["extra"]["ring"].removeMember("read");
+        content["extra"]["ring"].removeMember("lag");
+    }
+    const size_t hash = std::hash<std::string>()(render(content, false));
+    if (state.written && hash == state.last_hash &&
+        now_ns - state.last_write_ns < g_file_keepalive_ns.load(std::memory_order_relaxed)) {
+        return;
+    }
+
+    std::filesystem::path directory;
+    {
+        std::lock_guard<std::mutex> lock(g_file_mutex);
+        directory = g_file_cfg.directory;
+    }
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    const std::filesystem::path path = directory / (std::string("status_") + COMPONENT_NAMES[component] + ".json");
+    if (!write_atomically(path, render(root, true))) {
+        LOG_WARN("Failed to write status file %s", path.c_str());
+    }
+    // 失败时同样按周期重试，不在每个循环重复尝试
+    state.last_write_ns = now_ns;
+    state.last_hash = hash;
+    state.written = true;
+}
+}
+
+void configure_files(const ConfigManager::StatusFileConfig& cfg) {
+    {
+        std::lock_guard<std::mutex> lock(g_file_mutex);
+        g_file_cfg = cfg;
+    }
+    const double rate = cfg.max_rate_hz > 0.0 ? cfg.max_rate_hz : 1.0;
+    g_file_interval_ns.store(static_cast<uint64_t>(1e9 / rate), std::memory_order_relaxed);
+    g_file_keepalive_ns.store(static_cast<uint64_t>(cfg.keepalive_s > 0 ? cfg.keepalive_s : 1) * 1000000000ULL,
+                              std::memory_order_relaxed);
+    g_file_enabled.store(cfg.enabled && !cfg.directory.empty(), std::memory_order_relaxed);
+}
+
+void update(uint32_t component,
+            const NormalizedData* data,
+            bool active,
+            bool connected,
+            const RingCursor* cursor) {
+    StatusBlock* block = block_for(component);
+    if (!block) {
+        return;
+    }
+
+    StatusHot hot{};
+    hot.updated_ns = get_timestamp_ns();
+    hot.active = active ? 1 : 0;
+    hot.connected = connected ? 1 : 0;
+    if (data) {
+        hot.has_data = 1;
+        hot.sample = *data;
+    }
+    if (cursor) {
+        hot.has_ring = 1;
+        hot.ring_lag = cursor->lag();
+        hot.ring_read = cursor->read();
+        hot.ring_overruns = cursor->overruns();
+    }
+    block->write_hot(hot);
+    emit_file(component);
+}
+
+void write_detail(uint32_t component, const Json::Value& extra) {
+    StatusBlock* block = block_for(component);
+    if (!block) {
+        return;
+    }
+
+    std::string text = render(extra, false);
+    if (text.size() > STATUS_DETAIL_SIZE) {
+        LOG_WARN("Status detail for %s too large (%zu bytes), truncated",
+                 COMPONENT_NAMES[component], text.size());
+        text = "{\"truncated\":true}";
+    }
+    block->write_detail(text.data(), static_cast<uint32_t>(text.size()), get_timestamp_ns());
+    emit_file(component);
+}
+
+Json::Value read_component_status(const std::string& component) {
+    uint32_t index = 0;
+    while (index < StatusComponent::COUNT && component != COMPONENT_NAMES[index]) {
+        index++;
+    }
+    const StatusBlock* block = block_for(index);
+    if (!block) {
+        return Json::Value(Json::nullValue);
+    }
+
+    StatusHot hot;
+    std::vector<char> detail(STATUS_DETAIL_SIZE);
+    uint32_t detail_len = 0;
+    uint64_t detail_ns = 0;
+    if (!block->read_hot(hot) || !block->read_detail(detail.data(), detail_len, detail_ns)) {
+        LOG_DEBUG("Status of %s is being rewritten, skipped", component.c_str());
+        return Json::Value(Json::nullValue);
+    }
+    if (hot.updated_ns == 0 && detail_len == 0) {
+        return Json::Value(Json::nullValue);
+    }
+
+    const uint64_t updated_ns = hot.updated_ns > detail_ns ? hot.updated_ns : detail_ns;
     Json::Value root;
     root["component"] = component;
-    root["active"] = active;
-    root["updated_ns"] = static_cast<Json::UInt64>(now_ns);
-    root["updated_ms"] = static_cast<Json::UInt64>(now_ns / 1000000ULL);
+    root["active"] = hot.active != 0;
+    root["updated_ns"] = static_cast<Json::UInt64>(updated_ns);
+    root["updated_ms"] = static_cast<Json::UInt64>(updated_ns / 1000000ULL);
 
-    if (data) {
+    if (hot.has_data) {
         Json::Value payload(Json::objectValue);
-        payload["sequence"] = static_cast<Json::UInt64>(data->sequence);
-        payload["thickness_mm"] = data->thickness_mm;
-        payload["status_flags"] = data->status;
-        payload["timestamp_ns"] = static_cast<Json::UInt64>(data->timestamp_ns);
+        payload["sequence"] = static_cast<Json::UInt64>(hot.sample.sequence);
+        payload["thickness_mm"] = hot.sample.thickness_mm;
+        payload["status_flags"] = hot.sample.status;
+        payload["timestamp_ns"] = static_cast<Json::UInt64>(hot.sample.timestamp_ns);
         root["data"] = payload;
     } else {
         root["data"] = Json::nullValue;
     }
 
-    if (!extra.isNull()) {
-        root["extra"] = extra;
+    Json::Value extra(Json::objectValue);
+    if (detail_len > 0) {
+        Json::CharReaderBuilder builder;
+        std::unique_ptr<Json::CharReader> reader(builder.newCharReader());
+        std::string errs;
+        if (!reader->parse(detail.data(), detail.data() + detail_len, &extra, &errs) || !extra.isObject()) {
+            extra = Json::Value(Json::objectValue);
+        }
     }
-
-    std::ofstream ofs(status_path_for(component));
-    if (!ofs.is_open()) {
-        LOG_WARN("Failed to open status file for component %s", component.c_str());
-        return;
+    if (hot.updated_ns != 0) {
+        extra["connected"] = hot.connected != 0;
     }
-
-    Json::StreamWriterBuilder builder;
-    builder["indentation"] = "  ";
-    std::unique_ptr<Json::StreamWriter> writer(builder.newStreamWriter());
-    writer->write(root, &ofs);
+    if (hot.has_ring) {
+        Json::Value ring(Json::objectValue);
+        ring["lag"] = static_cast<Json::UInt>(hot.ring_lag);
+        ring["read"] = static_cast<Json::UInt64>(hot.ring_read);
+        ring["overruns"] = static_cast<Json::UInt64>(hot.ring_overruns);
+        extra["ring"] = ring;
+    }
+    if (!extra.empty()) {
+        root["extra"] = extra;
+    }
+    return root;
 }
 
 } // namespace StatusWriter
@@ -4,22 +4,63 @@
 #include <json/json.h>
 #include <string>
 
+#include "config.h"
 #include "ndm.h"
+#include "shm_ring.h"
+#include "status_table.h"
 
+/**
+ * 组件状态经共享内存状态表（status_table.h）交给 webcfg:
+ * - update(): 热字段，每个周期调用，不分配内存
+ * - write_detail(): 详情 JSON，每秒或状态变化时调用
+ * - read_component_status(): webcfg 处理 HTTP 请求时读取并生成 JSON
+ *
+ * 外部脚本仍可读取 <directory>/status_<组件>.json（system.status_file）:
+ * - 每个文件最多按 max_rate_hz 写入，期间的更新合并到下一次写入
+ * - 先写 .tmp 再 rename()，读取方不会看到写了一半的文件
+ * - 除时间戳和逐样本字段（序列号、采集时间、厚度、读位置）外内容没有变化时不写
+ *   （至多每 keepalive_s 重写一次），减少闪存写入
+ */
 namespace StatusWriter {
 
 /**
- * @brief 将组件运行状态写入共享状态文件，供 Web 前端展示
+ * @brief 更新组件的热字段（激活/连接状态、最新样本、读游标）
  *
- * @param component 组件标识，如 "modbus"、"s7"、"opcua"
- * @param data      可选的最新数据指针，nullptr 表示无新数据
+ * @param component 组件位置（StatusComponent::*）
+ * @param data      最新数据指针，nullptr 表示尚无数据
  * @param active    当前组件是否处于激活/转发状态
- * @param extra     附加信息（可选）
+ * @param connected 组件的连接状态（没有连接概念的组件传 true）
+ * @param cursor    环形缓冲区读游标（可选）
+ */
+void update(uint32_t component,
+            const NormalizedData* data,
+            bool active,
+            bool connected,
+            const RingCursor* cursor = nullptr);
+
+/**
+ * @brief 写入组件的详情（配置、统计等），显示在 JSON 的 extra 中
+ *
+ * @param component 组件位置（StatusComponent::*）
+ * @param extra     详情对象
+ */
+void write_detail(uint32_t component, const Json::Value& extra);
+
+/**
+ * @brief 读取组件状态并生成 JSON（webcfg 调用）
+ *
+ * 格式与原状态文件相同: component/active/updated_ns/updated_ms/data/extra，
+ * extra.ring 和 extra.connected 取自热字段。
+ *
+ * @param component 组件标识，如 "modbus"、"modbus_metrics"、"s7"、"opcua"
+ * @return Json::Value 组件尚未写入过状态时为 null
+ */
+Json::Value read_component_status(const std::string& component);
+
+/**
+ * @brief 设置状态文件输出（启动和配置重载时调用）
  */
-void write_component_status(const std::string& component,
-                            const NormalizedData* data,
-                            bool active,
-                            const Json::Value& extra = Json::Value());
+void configure_files(const ConfigManager::StatusFileConfig& cfg);
 
 } // namespace StatusWriter
 
@@ -0,0 +1,174 @@
+/**
+ * @file main.cpp
+ * @brief 单进程网关（gatewayd）
+ *
+ * 把 rs485d、modbusd、s7d、opcuad、webcfg 作为线程运行在同一个进程中:
+ * - 环形缓冲区改为进程内对象（不经过 /dev/shm），写入端与各读取端共享
+ * - 配置由 ConfigManager 单例共享；只有一个配置监视器，每次保存只解析一次文件，
+ *   各服务的 ConfigWatcher 订阅它并在各自线程中处理变化
+ * - 一个 systemd 单元、一个进程，适合内存较小的设备
+ *
+ * 各服务的源文件与独立进程完全相同，以 GATEWAY_HOSTED 编译时不生成 main()。
+ * 多进程部署（gw-*.service）不受影响，两种模式二选一。
+ *
+ * 用法: gatewayd [config.json] [服务名...]
+ *   不指定服务名时启动全部服务；rs485d 总是最先启动。
+ *
+ * @author Gateway Project
+ * @date 2025-10-30
+ */
+
+#include "../common/config_watcher.h"
+#include "../common/logger.h"
+#include "../common/shm_ring.h"
+#include "../common/service_host.h"
+
+#include <algorithm>
+#include <atomic>
+#include <csignal>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+
+namespace rs485d { int run(int argc, char* argv[]); void stop(); }
+namespace modbusd { int run(int argc, char* argv[]); void stop(); }
+namespace s7d { int run(int argc, char* argv[]); void stop(); }
+namespace opcuad { int run(int argc, char* argv[]); void stop(); }
+namespace webcfg { int run(int argc, char* argv[]); void stop(); }
+
+namespace {
+
+/// @brief 一个被托管的服务
+struct Service {
+    const char* name;
+    int (*run)(int, char**);
+    void (*stop)();
+};
+
+/// @brief 全部服务，按启动顺序排列（rs485d 必须第一个）
+const Service SERVICES[] = {
+    {"rs485d", &rs485d::run, &rs485d::stop},
+    {"modbusd", &modbusd::run, &modbusd::stop},
+    {"s7d", &s7d::run, &s7d::stop},
+    {"opcuad", &opcuad::run, &opcuad::stop},
+    {"webcfg", &webcfg::run, &webcfg::stop},
+};
+
+/// @brief 启动 rs485d 后等待其创建环形缓冲区的时间
+constexpr int READY_TIMEOUT_MS = 5000;
+
+/// @brief 进程内环形缓冲区（替代 /dev/shm/gw_data_ring）
+RingBuffer g_ring;
+
+/// @brief 运行中的服务线程
+struct Worker {
+    const Service* service;
+    std::thread thread;
+    std::atomic<bool> finished{false};
+    int exit_code = 0;
+};
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    Logger::init("gatewayd", false);
+    ServiceHost::set_hosted(true);
+
+    std::string config_path = "/opt/gw/conf/config.json";
+    if (argc > 1) {
+        config_path = argv[1];
+    }
+
+    // 要启动的服务（默认全部）
+    std::vector<const Service*> selected;
+    for (const Service& service : SERVICES) {
+        bool wanted = (argc <= 2);
+        for (int i = 2; i < argc && !wanted; ++i) {
+            wanted = (std::strcmp(argv[i], service.name) == 0);
+        }
+        // 其他服务都从 rs485d 的缓冲区读取数据，rs485d 总是启动
+        if (wanted || &service == &SERVICES[0]) {
+            selected.push_back(&service);
+        }
+    }
+    for (int i = 2; i < argc; ++i) {
+        bool known = std::any_of(std::begin(SERVICES), std::end(SERVICES),
+                                 [&](const Service& s) { return std::strcmp(argv[i], s.name) == 0; });
+        if (!known) {
+            LOG_WARN("未知服务名已忽略: %s", argv[i]);
+        }
+    }
+
+    LOG_INFO("========================================");
+    LOG_INFO("单进程网关启动中，配置文件: %s", config_path.c_str());
+    LOG_INFO("========================================");
+
+    SharedMemoryManager::use_local_ring(&g_ring);
+
+    // 服务线程中任何对已关闭套接字的写入都不能终止整个网关
+    signal(SIGPIPE, SIG_IGN);
+
+    // 信号只由主线程接收: 先屏蔽，服务线程继承屏蔽字
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    // 共享配置监视器: 须在服务启动前建立，服务的 ConfigWatcher::start() 据此只订阅
+    ConfigWatcher config_watcher(config_path);
+    config_watcher.start_shared();
+
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (const Service* service : selected) {
+        std::unique_ptr<Worker> worker(new Worker());
+        worker->service = service;
+        Worker* w = worker.get();
+        worker->thread = std::thread([w, config_path]() {
+            std::string arg0 = w->service->name;
+            std::string arg1 = config_path;
+            char* args[] = {&arg0[0], &arg1[0], nullptr};
+            w->exit_code = w->service->run(2, args);
+            w->finished = true;
+        });
+        workers.push_back(std::move(worker));
+        LOG_INFO("服务已启动: %s", service->name);
+
+        if (service == &SERVICES[0] && !ServiceHost::wait_ready(service->name, READY_TIMEOUT_MS)) {
+            LOG_ERROR("%s 未能在 %d ms 内就绪，停止启动", service->name, READY_TIMEOUT_MS);
+            break;
+        }
+    }
+
+    // 等待退出信号；数据源 rs485d 退出时整个网关随之退出
+    int exit_code = 0;
+    while (true) {
+        struct timespec timeout = {1, 0};
+        int signum = sigtimedwait(&signals, nullptr, &timeout);
+        if (signum > 0) {
+            LOG_INFO("收到信号 %d，准备退出...", signum);
+            break;
+        }
+        if (workers.front()->finished) {
+            LOG_ERROR("rs485d 已退出 (代码 %d)，停止全部服务", workers.front()->exit_code);
+            exit_code = 1;
+            break;
+        }
+    }
+
+    // 逆序停止: 先停读取端，最后停数据源
+    for (auto it = workers.rbegin(); it != workers.rend(); ++it) {
+        (*it)->service->stop();
+        (*it)->thread.join();
+        LOG_INFO("服务已停止: %s (代码 %d)", (*it)->service->name, (*it)->exit_code);
+    }
+
+    config_watcher.stop();
+    SharedMemoryManager::use_local_ring(nullptr);
+    LOG_INFO("单进程网关已退出");
+    return exit_code;
+}
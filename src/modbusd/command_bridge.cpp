@@ -0,0 +1,135 @@
+#include "command_bridge.h"
+
+#include "../common/logger.h"
+
+#include <cstring>
+
+CommandBridge::CommandBridge(CommandQueue* queue, int timeout_ms)
+    : queue_(queue),
+      timeout_ns_(static_cast<uint64_t>(timeout_ms > 0 ? timeout_ms : 3000) * 1000000ULL) {
+}
+
+void CommandBridge::on_request(const uint8_t* pdu, size_t pdu_len, uint16_t source, uint16_t* regs) {
+    if (pdu_len < 5) {
+        return;
+    }
+
+    // 只关心写入了命令代码寄存器的请求
+    const uint8_t function = pdu[0];
+    const int start = (pdu[1] << 8) | pdu[2];
+    if (function == 0x06) {
+        if (start != CommandRegisters::CODE) {
+            return;
+        }
+    } else if (function == 0x10) {
+        const int quantity = (pdu[3] << 8) | pdu[4];
+        if (CommandRegisters::CODE < start || CommandRegisters::CODE >= start + quantity) {
+            return;
+        }
+    } else if (function == 0x17) {
+        // FC23 读写多个寄存器: 写入范围在读取范围之后
+        if (pdu_len < 9) {
+            return;
+        }
+        const int write_start = (pdu[5] << 8) | pdu[6];
+        const int write_quantity = (pdu[7] << 8) | pdu[8];
+        if (CommandRegisters::CODE < write_start || CommandRegisters::CODE >= write_start + write_quantity) {
+            return;
+        }
+    } else {
+        return;
+    }
+
+    const uint16_t code = regs[CommandRegisters::CODE];
+    if (code == GaugeCommandCode::NONE) {
+        return;
+    }
+    regs[CommandRegisters::CODE] = 0;  // 代码寄存器只作为触发，执行后清零
+
+    uint32_t raw = (static_cast<uint32_t>(regs[CommandRegisters::ARG_HI]) << 16) |
+                   regs[CommandRegisters::ARG_LO];
+    float arg;
+    memcpy(&arg, &raw, sizeof(arg));
+
+    if (code > GaugeCommandCode::MAX_CODE) {
+        LOG_WARN("Rejected unknown gauge command %u from unit %u", code, source);
+        pending_id_ = 0;
+        set_status(regs, CommandResult::REJECTED);
+        return;
+    }
+    if (!GaugeCommandCode::arg_valid(code, arg)) {
+        LOG_WARN("Rejected gauge command %u from unit %u: invalid argument %g", code, source, arg);
+        pending_id_ = 0;
+        set_status(regs, CommandResult::REJECTED);
+        return;
+    }
+    if (!queue_) {
+        LOG_WARN("Rejected gauge command %u: command channel unavailable", code);
+        pending_id_ = 0;
+        set_status(regs, CommandResult::REJECTED);
+        return;
+    }
+
+    uint32_t id = 0;
+    if (!queue_->try_push(code, arg, source, id)) {
+        LOG_WARN("Rejected gauge command %u: command queue full", code);
+        pending_id_ = 0;
+        set_status(regs, CommandResult::REJECTED);
+        return;
+    }
+
+    LOG_INFO("Gauge command %u (arg=%.3f) queued as #%u from unit %u", code, arg, id, source);
+    pending_id_ = id;
+    submitted_ns_ = get_timestamp_ns();
+    regs[CommandRegisters::CMD_ID] = static_cast<uint16_t>(id & 0xFFFF);
+    set_status(regs, CommandResult::PENDING);
+}
+
+void CommandBridge::refresh_status(uint16_t* regs) {
+    if (pending_id_ == 0 || !queue_) {
+        return;
+    }
+
+    uint16_t status = queue_->get_result(pending_id_);
+    if (status == CommandResult::PENDING || status == CommandResult::IDLE) {
+        if (get_timestamp_ns() - submitted_ns_ < timeout_ns_) {
+            return;
+        }
+        LOG_WARN("Gauge command #%u timed out", pending_id_);
+        status = CommandResult::TIMEOUT;
+    }
+
+    set_status(regs, status);
+    pending_id_ = 0;
+}
+
+bool CommandBridge::is_command_write(const uint8_t* pdu, size_t pdu_len) {
+    int start = 0;
+    int quantity = 0;
+    if (pdu_len >= 5 && pdu[0] == 0x06) {
+        start = (pdu[1] << 8) | pdu[2];
+        quantity = 1;
+    } else if (pdu_len >= 5 && pdu[0] == 0x10) {
+        start = (pdu[1] << 8) | pdu[2];
+        quantity = (pdu[3] << 8) | pdu[4];
+    } else if (pdu_len >= 9 && pdu[0] == 0x17) {
+        start = (pdu[5] << 8) | pdu[6];
+        quantity = (pdu[7] << 8) | pdu[8];
+    } else {
+        return false;
+    }
+    return start < CommandRegisters::END && start + quantity > CommandRegisters::CODE;
+}
+
+void CommandBridge::set_queue(CommandQueue* queue, uint16_t* regs) {
+    if (pending_id_ != 0) {
+        LOG_WARN("Gauge command #%u lost: command queue was recreated", pending_id_);
+        set_status(regs, CommandResult::FAILED);
+        pending_id_ = 0;
+    }
+    queue_ = queue;
+}
+
+void CommandBridge::set_status(uint16_t* regs, uint16_t status) {
+    regs[CommandRegisters::STATUS] = status;
+}
@@ -0,0 +1,105 @@
+/**
+ * @file command_bridge.h
+ * @brief Modbus 写请求 → 测厚仪命令
+ *
+ * 保持寄存器中划出一块命令区，FC06/FC16/FC23 写入命令代码寄存器时，
+ * 把命令放入共享内存命令队列交给 rs485d 执行，并通过状态寄存器
+ * 反馈执行结果。
+ *
+ * 命令寄存器 (0-based 地址 / 40001-based 地址):
+ * - 16 / 40017: Uint16  命令代码 (1=清零, 2=去皮, 3=模式, 4=设定值)，写入即触发
+ * - 17 / 40018: Float32 参数高字 (Big-Endian，与厚度值相同)
+ * - 18 / 40019: Float32 参数低字
+ * - 19 / 40020: Uint16  命令状态 (0=空闲, 1=执行中, 2=成功, 3=失败, 4=拒绝, 5=超时)
+ * - 20 / 40021: Uint16  最近一条命令 ID (低 16 位)
+ *
+ * 带参数的命令可以一次 FC16 写入 40017-40019，也可以先写参数再用 FC06 写代码。
+ * 参数无效（模式编号不是 0-65535 的整数、设定值不是有限值）的命令直接拒绝。
+ *
+ * @note 所有方法都必须在持有寄存器映射互斥锁的情况下调用，
+ *       本类自身的状态也由这把锁保护。
+ *
+ * @author Gateway Project
+ * @date 2025-10-21
+ */
+
+#ifndef GATEWAY_COMMAND_BRIDGE_H
+#define GATEWAY_COMMAND_BRIDGE_H
+
+#include "../common/cmd_queue.h"
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @namespace CommandRegisters
+ * @brief 命令区保持寄存器地址（0-based）
+ */
+namespace CommandRegisters {
+    constexpr int CODE   = 16;  ///< 命令代码，写入触发
+    constexpr int ARG_HI = 17;  ///< Float32 参数高字
+    constexpr int ARG_LO = 18;  ///< Float32 参数低字
+    constexpr int STATUS = 19;  ///< 命令状态（CommandResult）
+    constexpr int CMD_ID = 20;  ///< 最近一条命令 ID 低 16 位
+    constexpr int END    = 21;  ///< 命令区结束（不含）
+}
+
+/**
+ * @class CommandBridge
+ * @brief 把命令寄存器写入转换为命令队列条目
+ */
+class CommandBridge {
+public:
+    /**
+     * @param queue 命令队列（nullptr 表示 rs485d 未提供命令通道，命令一律拒绝）
+     * @param timeout_ms 等待 rs485d 应答的超时时间
+     */
+    explicit CommandBridge(CommandQueue* queue, int timeout_ms = 3000);
+
+    /**
+     * @brief 在 modbus_reply() 成功处理请求后调用
+     *
+     * @param pdu 请求 PDU（功能码开始，不含 MBAP 头/RTU 地址）
+     * @param pdu_len PDU 长度
+     * @param source 来源标识（单元号/从站地址）
+     * @param regs 保持寄存器数组（至少 CommandRegisters::END 个）
+     */
+    void on_request(const uint8_t* pdu, size_t pdu_len, uint16_t source, uint16_t* regs);
+
+    /**
+     * @brief 把最近一条命令的执行状态刷新到状态寄存器（更新线程周期调用）
+     *
+     * @param regs 保持寄存器数组
+     */
+    void refresh_status(uint16_t* regs);
+
+    /**
+     * @brief 切换到新的命令队列（rs485d 重启后重新打开时调用）
+     *
+     * 旧队列中等待应答的命令不会再被执行，状态置为失败。
+     *
+     * @param queue 新队列（nullptr=命令一律拒绝）
+     * @param regs 保持寄存器数组
+     */
+    void set_queue(CommandQueue* queue, uint16_t* regs);
+
+    /**
+     * @brief 请求是否写入命令区（FC06/FC16/FC23 的写入范围与命令区相交）
+     *
+     * 没有命令桥的单元（不对应测厚仪）用它拒绝命令写入。
+     *
+     * @param pdu 请求 PDU（功能码开始）
+     * @param pdu_len PDU 长度
+     */
+    static bool is_command_write(const uint8_t* pdu, size_t pdu_len);
+
+private:
+    void set_status(uint16_t* regs, uint16_t status);
+
+    CommandQueue* queue_;        ///< 共享内存命令队列
+    uint64_t timeout_ns_;        ///< 应答超时
+    uint32_t pending_id_ = 0;    ///< 正在等待应答的命令 ID（0=无）
+    uint64_t submitted_ns_ = 0;  ///< 入队时间
+};
+
+#endif // GATEWAY_COMMAND_BRIDGE_H
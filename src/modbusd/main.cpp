@@ -1,7 +1,15 @@
 #include "../common/logger.h"
 #include "../common/config.h"
+#include "../common/config_watcher.h"
 #include "../common/shm_ring.h"
 #include "../common/status_writer.h"
+#include "../common/cmd_queue.h"
+#include "../common/service_host.h"
+#include "command_bridge.h"
+#include "modbus_metrics.h"
+#include "modbus_pdu.h"
+#include "modbus_rtu_slave.h"
+#include "unit_router.h"
 #include <modbus/modbus.h>
 #include <iostream>
 #include <thread>
@@ -9,25 +17,42 @@
 #include <csignal>
 #include <cstring>
 #include <atomic>
-#include <filesystem>
+#include <memory>
+#include <mutex>
 #include <unistd.h>
+#include <cerrno>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+
+namespace modbusd {
 
 // 全局运行标志
-volatile sig_atomic_t g_running = 1;
+std::atomic<bool> g_running{true};
 
 void signal_handler(int signum) {
     LOG_INFO("Received signal %d, shutting down...", signum);
-    g_running = 0;
+    g_running = false;
 }
 
 /**
  * Modbus TCP Server
  * Modbus TCP 服务器
+ *
+ * 使用 epoll 同时服务多个客户端，请求由 ModbusPduEngine 在调用方缓冲区上
+ * 直接处理；一次 recv() 读到的多个流水线请求在同一次加锁内依次应答。
+ * 请求按 MBAP 单元号路由到对应通道的寄存器映像。
  */
 class ModbusTCPServer {
 public:
-    ModbusTCPServer(const std::string& ip, int port)
-        : ip_(ip), port_(port), ctx_(nullptr), mapping_(nullptr), socket_(-1) {
+    static constexpr int MAX_CONNECTIONS = 16;          // 同时服务的客户端数
+    static constexpr size_t CONN_BUFFER_SIZE = 4096;    // 每个连接的收/发缓冲区
+    
+    ModbusTCPServer(const std::string& ip, int port, UnitRouter& router)
+        : ip_(ip), port_(port), router_(router), metrics_(nullptr),
+          socket_(-1), epoll_fd_(-1), connections_(new Connection[MAX_CONNECTIONS]) {
     }
     
     ~ModbusTCPServer() {
@@ -35,34 +60,9 @@ public:
     }
     
     bool start() {
-        // 创建 Modbus TCP 上下文
-        ctx_ = modbus_new_tcp(ip_.c_str(), port_);
-        if (!ctx_) {
-            LOG_ERROR("Failed to create Modbus TCP context");
-            return false;
-        }
-        
-        // 创建寄存器映射
-        // 参数: 线圈数, 离散输入数, 保持寄存器数, 输入寄存器数
-        mapping_ = modbus_mapping_new(0, 0, 100, 0);
-        if (!mapping_) {
-            LOG_ERROR("Failed to create Modbus mapping");
-            modbus_free(ctx_);
-            ctx_ = nullptr;
-            return false;
-        }
-        
-        // 初始化寄存器为 0
-        memset(mapping_->tab_registers, 0, 100 * sizeof(uint16_t));
-        
         // 监听连接
-        socket_ = modbus_tcp_listen(ctx_, 1);
-        if (socket_ < 0) {
-            LOG_ERROR("Failed to listen on %s:%d", ip_.c_str(), port_);
-            modbus_mapping_free(mapping_);
-            modbus_free(ctx_);
-            mapping_ = nullptr;
-            ctx_ = nullptr;
+        if (!open_listener()) {
+            stop();
             return false;
         }
         
@@ -71,112 +71,313 @@ public:
     }
     
     void stop() {
+        for (int i = 0; i < MAX_CONNECTIONS; ++i) {
+            if (connections_[i].fd >= 0) {
+                close_connection(i);
+            }
+        }
+        
+        if (epoll_fd_ >= 0) {
+            close(epoll_fd_);
+            epoll_fd_ = -1;
+        }
+        
         if (socket_ >= 0) {
             close(socket_);
             socket_ = -1;
+            LOG_INFO("Modbus TCP server stopped");
         }
+    }
+    
+    // 请求统计分片（仅 poll() 所在线程写入）
+    void set_metrics(MetricsShard* metrics) { metrics_ = metrics; }
+    
+    // 等待并处理网络事件（新连接、请求、待发送的应答）
+    void poll(int timeout_ms) {
+        if (epoll_fd_ < 0) return;
         
-        if (mapping_) {
-            modbus_mapping_free(mapping_);
-            mapping_ = nullptr;
+        struct epoll_event events[MAX_CONNECTIONS + 1];
+        int n = epoll_wait(epoll_fd_, events, MAX_CONNECTIONS + 1, timeout_ms);
+        if (n < 0) {
+            if (errno != EINTR) {
+                LOG_ERROR("epoll_wait failed: %s", strerror(errno));
+            }
+            return;
         }
         
-        if (ctx_) {
-            modbus_close(ctx_);
-            modbus_free(ctx_);
-            ctx_ = nullptr;
+        for (int i = 0; i < n; ++i) {
+            if (events[i].data.u32 == LISTENER_TAG) {
+                accept_clients();
+                continue;
+            }
+            
+            const int index = static_cast<int>(events[i].data.u32);
+            Connection& conn = connections_[index];
+            if (conn.fd < 0) continue;
+            
+            if (events[i].events & (EPOLLERR | EPOLLHUP)) {
+                close_connection(index);
+                continue;
+            }
+            if ((events[i].events & EPOLLOUT) && !flush_output(index)) {
+                continue;
+            }
+            if ((events[i].events & EPOLLIN) && !conn.output_blocked()) {
+                read_requests(index);
+            }
         }
-        
-        LOG_INFO("Modbus TCP server stopped");
     }
     
-    // 更新寄存器（从共享内存读取数据）
-    void update_registers(const NormalizedData& data) {
-        if (!mapping_) return;
+private:
+    static constexpr uint32_t LISTENER_TAG = 0xFFFFFFFFu;
+    
+    // 单个客户端连接（预先分配，运行中不做堆分配）
+    struct Connection {
+        int fd = -1;
+        uint32_t client_key = ModbusMetricsKey::OVERFLOW;
+        size_t in_len = 0;                    // 已接收未处理的字节
+        size_t out_len = 0;                   // 待发送字节
+        size_t out_off = 0;                   // 已发送到的位置
+        bool waiting_writable = false;        // 当前在 epoll 中等待 EPOLLOUT
+        uint8_t in[CONN_BUFFER_SIZE];
+        uint8_t out[CONN_BUFFER_SIZE];
         
-        uint16_t* regs = mapping_->tab_registers;
+        bool output_blocked() const { return out_len > out_off; }
+    };
+    
+    bool open_listener() {
+        socket_ = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (socket_ < 0) {
+            LOG_ERROR("Failed to create socket: %s", strerror(errno));
+            return false;
+        }
         
-        // 寄存器映射:
-        // 40001-40002: Float32 厚度值 (Big-Endian)
-        // 40003-40006: Uint64 时间戳 (Big-Endian, Unix ms)
-        // 40007:       Uint16 状态位
-        // 40008:       Uint16 序列号 (低 16 位)
+        int enable = 1;
+        setsockopt(socket_, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
         
-        // Float32 转 2×Uint16 (Big-Endian)
-        uint32_t thickness_raw = 0;
-        static_assert(sizeof(thickness_raw) == sizeof(data.thickness_mm), "float size mismatch");
-        memcpy(&thickness_raw, &data.thickness_mm, sizeof(thickness_raw));
-        regs[0] = static_cast<uint16_t>((thickness_raw >> 16) & 0xFFFF);
-        regs[1] = static_cast<uint16_t>(thickness_raw & 0xFFFF);
+        struct sockaddr_in addr;
+        memset(&addr, 0, sizeof(addr));
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(port_));
+        if (ip_.empty() || ip_ == "0.0.0.0") {
+            addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        } else if (inet_pton(AF_INET, ip_.c_str(), &addr.sin_addr) != 1) {
+            LOG_ERROR("Invalid listen address %s", ip_.c_str());
+            return false;
+        }
         
-        // Uint64 时间戳转 Unix ms (Big-Endian)
-        uint64_t timestamp_ms = data.timestamp_ns / 1000000ULL;
-        regs[2] = static_cast<uint16_t>((timestamp_ms >> 48) & 0xFFFF);
-        regs[3] = static_cast<uint16_t>((timestamp_ms >> 32) & 0xFFFF);
-        regs[4] = static_cast<uint16_t>((timestamp_ms >> 16) & 0xFFFF);
-        regs[5] = static_cast<uint16_t>(timestamp_ms & 0xFFFF);
+        if (bind(socket_, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0 ||
+            listen(socket_, MAX_CONNECTIONS) < 0) {
+            LOG_ERROR("Failed to listen on %s:%d: %s", ip_.c_str(), port_, strerror(errno));
+            return false;
+        }
         
-        // 状态位
-        regs[6] = data.status;
+        epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+        if (epoll_fd_ < 0) {
+            LOG_ERROR("epoll_create1 failed: %s", strerror(errno));
+            return false;
+        }
         
-        // 序列号
-        regs[7] = data.sequence & 0xFFFF;
+        struct epoll_event ev;
+        ev.events = EPOLLIN;
+        ev.data.u32 = LISTENER_TAG;
+        return epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, socket_, &ev) == 0;
     }
     
-    // 处理客户端请求
-    void handle_client() {
-        if (!ctx_ || socket_ < 0) return;
-        
-        // 接受客户端连接
-        int client_socket = modbus_tcp_accept(ctx_, &socket_);
-        if (client_socket < 0) {
-            if (g_running) {
-                LOG_ERROR("Failed to accept client connection");
+    void accept_clients() {
+        while (true) {
+            struct sockaddr_in peer;
+            socklen_t peer_len = sizeof(peer);
+            int fd = accept4(socket_, reinterpret_cast<struct sockaddr*>(&peer), &peer_len,
+                             SOCK_NONBLOCK | SOCK_CLOEXEC);
+            if (fd < 0) {
+                if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
+                    LOG_ERROR("Failed to accept client connection: %s", strerror(errno));
+                }
+                return;
             }
+            
+            // 客户端地址用于按来源统计
+            const uint32_t client_key = peer.sin_family == AF_INET
+                                            ? ntohl(peer.sin_addr.s_addr)
+                                            : ModbusMetricsKey::OVERFLOW;
+            
+            int index = -1;
+            for (int i = 0; i < MAX_CONNECTIONS; ++i) {
+                if (connections_[i].fd < 0) {
+                    index = i;
+                    break;
+                }
+            }
+            if (index < 0) {
+                LOG_WARN("Too many Modbus clients, rejecting %s",
+                         modbus_metrics_client_name(client_key).c_str());
+                close(fd);
+                continue;
+            }
+            
+            int enable = 1;
+            setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+            
+            struct epoll_event ev;
+            ev.events = EPOLLIN;
+            ev.data.u32 = static_cast<uint32_t>(index);
+            if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &ev) < 0) {
+                LOG_ERROR("epoll_ctl failed: %s", strerror(errno));
+                close(fd);
+                continue;
+            }
+            
+            Connection& conn = connections_[index];
+            conn.fd = fd;
+            conn.client_key = client_key;
+            conn.in_len = 0;
+            conn.out_len = 0;
+            conn.out_off = 0;
+            conn.waiting_writable = false;
+            LOG_INFO("Client connected: %s", modbus_metrics_client_name(client_key).c_str());
+        }
+    }
+    
+    void close_connection(int index) {
+        Connection& conn = connections_[index];
+        epoll_ctl(epoll_fd_, EPOLL_CTL_DEL, conn.fd, nullptr);
+        close(conn.fd);
+        conn.fd = -1;
+        LOG_INFO("Client disconnected: %s", modbus_metrics_client_name(conn.client_key).c_str());
+    }
+    
+    void read_requests(int index) {
+        Connection& conn = connections_[index];
+        ssize_t n = recv(conn.fd, conn.in + conn.in_len, sizeof(conn.in) - conn.in_len, 0);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) {
+            close_connection(index);
             return;
         }
+        if (n < 0) {
+            return;
+        }
+        conn.in_len += static_cast<size_t>(n);
         
-        LOG_INFO("Client connected");
+        if (!process_requests(conn)) {
+            LOG_WARN("Invalid Modbus TCP frame from %s",
+                     modbus_metrics_client_name(conn.client_key).c_str());
+            close_connection(index);
+            return;
+        }
+        flush_output(index);
+    }
+    
+    // 处理缓冲区中所有完整的请求；输出缓冲区放不下时留到发送完成后继续
+    bool process_requests(Connection& conn) {
+        size_t consumed = 0;
+        {
+            std::lock_guard<std::mutex> lock(router_.mutex());
+            while (sizeof(conn.out) - conn.out_len >= ModbusPduEngine::MAX_ADU_LENGTH) {
+                long frame_len = ModbusPduEngine::frame_length(conn.in + consumed, conn.in_len - consumed);
+                if (frame_len < 0) {
+                    return false;
+                }
+                if (frame_len == 0) {
+                    break;
+                }
+                
+                const uint64_t received_ns = get_timestamp_ns();
+                const uint8_t* req = conn.in + consumed;
+                uint8_t* resp = conn.out + conn.out_len;
+                const uint8_t* req_pdu = req + ModbusPduEngine::MBAP_LENGTH;
+                const size_t req_pdu_len = static_cast<size_t>(frame_len) - ModbusPduEngine::MBAP_LENGTH;
+                
+                // MBAP 头第 7 字节为单元号
+                UnitImage* image = router_.find(req[6]);
+                size_t resp_len;
+                if (image && UnitRouter::rejects_command(*image, req_pdu, req_pdu_len)) {
+                    resp_len = ModbusPduEngine::exception_adu(req, ModbusException::ILLEGAL_DATA_ADDRESS, resp);
+                } else if (image) {
+                    resp_len = image->engine->process_adu(req, static_cast<size_t>(frame_len), resp);
+                } else {
+                    resp_len = ModbusPduEngine::exception_adu(req, ModbusException::GATEWAY_TARGET, resp);
+                }
+                const bool exception = ModbusPduEngine::is_exception(resp + ModbusPduEngine::MBAP_LENGTH);
+                
+                if (image && image->command_bridge && !exception) {
+                    image->command_bridge->on_request(req_pdu, req_pdu_len, req[6],
+                                                      image->mapping->tab_registers);
+                }
+                if (metrics_) {
+                    metrics_->record(conn.client_key, req_pdu[0], exception,
+                                     static_cast<size_t>(frame_len), resp_len,
+                                     (get_timestamp_ns() - received_ns) / 1000ULL);
+                }
+                
+                conn.out_len += resp_len;
+                consumed += static_cast<size_t>(frame_len);
+            }
+        }
         
-        uint8_t query[MODBUS_TCP_MAX_ADU_LENGTH];
+        if (consumed > 0) {
+            conn.in_len -= consumed;
+            memmove(conn.in, conn.in + consumed, conn.in_len);
+        }
+        return true;
+    }
+    
+    // 发送待发数据；返回 false 表示连接已关闭
+    bool flush_output(int index) {
+        Connection& conn = connections_[index];
+        while (conn.output_blocked()) {
+            ssize_t n = send(conn.fd, conn.out + conn.out_off, conn.out_len - conn.out_off, MSG_NOSIGNAL);
+            if (n < 0) {
+                if (errno == EINTR) continue;
+                if (errno == EAGAIN || errno == EWOULDBLOCK) break;
+                close_connection(index);
+                return false;
+            }
+            conn.out_off += static_cast<size_t>(n);
+        }
         
-        while (g_running) {
-            // 接收请求
-            int rc = modbus_receive(ctx_, query);
-            if (rc > 0) {
-                // 处理请求
-                modbus_reply(ctx_, query, rc, mapping_);
-            } else if (rc == -1) {
-                // 连接断开或错误
-                break;
+        if (!conn.output_blocked()) {
+            conn.out_len = 0;
+            conn.out_off = 0;
+            // 输出阻塞期间积压的请求
+            if (conn.in_len > 0 && !process_requests(conn)) {
+                close_connection(index);
+                return false;
+            }
+            if (conn.output_blocked()) {
+                return flush_output(index);
             }
         }
         
-        close(client_socket);
-        LOG_INFO("Client disconnected");
+        // 有积压输出时改为等待可写，暂停读取
+        if (conn.output_blocked() != conn.waiting_writable) {
+            conn.waiting_writable = conn.output_blocked();
+            struct epoll_event ev;
+            ev.events = conn.waiting_writable ? EPOLLOUT : EPOLLIN;
+            ev.data.u32 = static_cast<uint32_t>(index);
+            epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, conn.fd, &ev);
+        }
+        return true;
     }
     
-private:
     std::string ip_;
     int port_;
-    modbus_t* ctx_;
-    modbus_mapping_t* mapping_;
+    UnitRouter& router_;
+    MetricsShard* metrics_;
     int socket_;
+    int epoll_fd_;
+    std::unique_ptr<Connection[]> connections_;
 };
 
 /**
  * Modbus Daemon Main Function
  */
-int main(int argc, char* argv[]) {
-    // 初始化日志
-    Logger::init("modbusd", false);
+int run(int argc, char* argv[]) {
+    // 初始化日志和信号处理
+    ServiceHost::init("modbusd", signal_handler);
     
     LOG_INFO("Modbus TCP Daemon starting...");
     
-    // 注册信号处理
-    signal(SIGINT, signal_handler);
-    signal(SIGTERM, signal_handler);
-    
     // 加载配置
     ConfigManager& config = ConfigManager::instance();
     
@@ -188,10 +389,10 @@ int main(int argc, char* argv[]) {
     if (!config.load(config_path)) {
         LOG_WARN("Failed to load config, using defaults");
     }
+    StatusWriter::configure_files(config.get_status_file_config());
     
     // 获取 Modbus 配置
     auto modbus_cfg = config.get_modbus_config();
-    std::string active_protocol = config.get_string("protocol.active", "modbus");
     
     if (!modbus_cfg.enabled) {
         LOG_WARN("Modbus TCP is disabled in config");
@@ -214,8 +415,25 @@ int main(int argc, char* argv[]) {
         return 1;
     }
     
+    // 打开命令队列（由 rs485d 创建），用于把写命令转发给测厚仪
+    auto cmd_channel = std::make_unique<CommandChannel>();
+    if (!cmd_channel->open()) {
+        LOG_WARN("Command channel unavailable, gauge commands will be rejected");
+    }
+    
+    // 单元号 → 通道寄存器映像
+    UnitRouter router;
+    if (!router.init(modbus_cfg, cmd_channel->is_connected() ? cmd_channel->queue() : nullptr)) {
+        LOG_FATAL("Invalid Modbus unit configuration");
+        return 1;
+    }
+    
+    // 按客户端/功能码的请求统计，每个服务线程一个分片
+    ModbusMetrics metrics;
+    
     // 创建 Modbus TCP 服务器
-    ModbusTCPServer server(modbus_cfg.listen_ip, modbus_cfg.port);
+    ModbusTCPServer server(modbus_cfg.listen_ip, modbus_cfg.port, router);
+    server.set_metrics(metrics.register_shard("tcp"));
     if (!server.start()) {
         LOG_FATAL("Failed to start Modbus TCP server");
         return 1;
@@ -223,80 +441,124 @@ int main(int argc, char* argv[]) {
     
     LOG_INFO("Modbus TCP Daemon started successfully");
     
+    // 可选：在第二串口上以 RTU 从站身份提供同一份寄存器映像
+    std::unique_ptr<ModbusRTUSlave> rtu_slave;
+    std::thread rtu_thread;
+    if (modbus_cfg.rtu_enabled) {
+        rtu_slave = std::make_unique<ModbusRTUSlave>(modbus_cfg, router);
+        rtu_slave->set_metrics(metrics.register_shard("rtu"));
+        if (rtu_slave->open()) {
+            rtu_thread = std::thread([&rtu_slave]() { rtu_slave->run(g_running); });
+        } else {
+            LOG_ERROR("Modbus RTU slave disabled: cannot open %s", modbus_cfg.rtu_device.c_str());
+            rtu_slave.reset();
+        }
+    }
+    
     // 启动数据更新线程
     std::thread update_thread([&, config_path]() {
         NormalizedData data;
         NormalizedData last_data;
         memset(&last_data, 0, sizeof(last_data));
-        bool config_dirty = false;
-        std::atomic<bool> protocol_active{active_protocol == "modbus"};
-        std::filesystem::file_time_type last_mtime{};
-        auto last_mtime_check = std::chrono::steady_clock::now();
+        std::atomic<bool> protocol_active{config.snapshot()->modbus_active};
         bool has_data = false;
+        // 逐条读取环形缓冲区，各通道的样本都要送到对应映像；从最新一条开始
+        // （独立游标，与其他输出同时运行、互不影响）
+        RingCursor cursor(ring);
+        auto last_metrics_write = std::chrono::steady_clock::now();
+        
+        // 配置热重载: 激活状态立即生效；监听地址、端口、单元映射等需要重启
+        ConfigWatcher watcher(config_path);
+        watcher.on_change(ConfigWatcher::ACTIVE, [&](const ConfigManager::Snapshot& cfg) {
+            protocol_active = cfg.modbus_active;
+        });
+        watcher.on_change(ConfigWatcher::MODBUS, [](const ConfigManager::Snapshot&) {
+            LOG_WARN("Modbus settings changed, restart modbusd to apply");
+        });
+        watcher.on_change(ConfigWatcher::STATUS_FILE, [](const ConfigManager::Snapshot& cfg) {
+            StatusWriter::configure_files(cfg.status_file);
+        });
+        watcher.start();
         
         while (g_running) {
             auto now = std::chrono::steady_clock::now();
-            if (now - last_mtime_check > std::chrono::seconds(1)) {
-                std::error_code ec;
-                auto current_mtime = std::filesystem::last_write_time(config_path, ec);
-                if (!ec && current_mtime != last_mtime) {
-                    last_mtime = current_mtime;
-                    if (config.load(config_path)) {
-                        auto refreshed = config.get_string("protocol.active", "modbus");
-                        bool new_state = (refreshed == "modbus");
-                        if (new_state != protocol_active.load()) {
-                            config_dirty = true;
-                        }
-                        protocol_active = new_state;
-                    }
-                }
-                last_mtime_check = now;
-            }
+            watcher.dispatch();
             
-            // 从共享内存读取最新数据
-            if (ring->pop_latest(data)) {
+            // 从共享内存读取新数据
+            while (cursor.next(data)) {
                 // 验证 CRC
                 if (ndm_verify_crc(data)) {
-                    // 只在数据变化时更新寄存器
-                    if (data.sequence != last_data.sequence) {
-                        if (protocol_active.load()) {
-                            server.update_registers(data);
-                        }
-                        last_data = data;
-                        has_data = true;
+                    if (protocol_active.load()) {
+                        router.update(data);
                     }
+                    last_data = data;
+                    has_data = true;
                 } else {
                     LOG_WARN("CRC verification failed for sequence %u", data.sequence);
                 }
+            }
+            
+            // 状态表热字段每个周期更新（无新数据时 Web 端据此判断本输出仍在运行）
+            StatusWriter::update(StatusComponent::MODBUS, has_data ? &last_data : nullptr,
+                                 protocol_active.load(), true, &cursor);
+            
+            router.refresh_command_status();
+            
+            // 请求统计每秒汇总一次
+            if (now - last_metrics_write >= std::chrono::seconds(1)) {
+                StatusWriter::write_detail(StatusComponent::MODBUS_METRICS, metrics.snapshot());
+                last_metrics_write = now;
                 
-                StatusWriter::write_component_status("modbus", &data, protocol_active.load());
-            } else if (config_dirty) {
-                StatusWriter::write_component_status("modbus", has_data ? &last_data : nullptr, protocol_active.load());
+                // rs485d 重启会重新创建命令队列，旧映射不再被消费: 每秒检查一次并重新打开
+                if (cmd_channel->replaced()) {
+                    auto fresh = std::make_unique<CommandChannel>();
+                    if (fresh->open()) {
+                        router.set_command_queue(fresh->queue());
+                        cmd_channel.swap(fresh);  // 旧映射在命令桥切换后才解除
+                        LOG_INFO("Command channel reopened");
+                    }
+                }
             }
             
             // 休眠 10ms
             std::this_thread::sleep_for(std::chrono::milliseconds(10));
-            config_dirty = false;
         }
     });
     
-    // 主循环：处理客户端连接
+    // 主循环：处理客户端连接与请求（100 ms 超时以便检查退出标志）
     while (g_running) {
-        server.handle_client();
-        
-        // 短暂休眠，避免 CPU 占用过高
-        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        server.poll(100);
     }
     
     LOG_INFO("Modbus TCP Daemon shutting down...");
     
     // 等待更新线程结束
     update_thread.join();
+    if (rtu_thread.joinable()) {
+        rtu_thread.join();
+    }
+    rtu_slave.reset();
     
     // 清理资源
     server.stop();
+    cmd_channel->close();
     shm.close();
     
     LOG_INFO("Modbus TCP Daemon stopped");
     return 0;
 }
+
+/**
+ * @brief 请求退出（gatewayd 收到信号时调用）
+ */
+void stop() {
+    g_running = false;
+}
+
+}  // namespace modbusd
+
+#ifndef GATEWAY_HOSTED
+int main(int argc, char* argv[]) {
+    return modbusd::run(argc, argv);
+}
+#endif
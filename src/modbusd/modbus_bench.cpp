@@ -0,0 +1,222 @@
+/**
+ * @file modbus_bench.cpp
+ * @brief Modbus TCP 吞吐量对比：libmodbus vs ModbusPduEngine
+ *
+ * 在本机回环上各启动一个服务端线程，客户端以指定流水线深度连续发送
+ * FC03 读 8 个保持寄存器的请求，统计每秒完成的请求数。
+ *
+ * 用法: modbus_bench [请求数] [流水线深度...]
+ * 例如: modbus_bench 200000 1 8 32
+ *
+ * @author Gateway Project
+ * @date 2025-10-23
+ */
+
+#include "modbus_pdu.h"
+
+#include <modbus/modbus.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr int NB_REGISTERS = 100;
+
+int listen_loopback(uint16_t& port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = 0;
+    socklen_t len = sizeof(addr);
+    if (fd < 0 || bind(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0 ||
+        listen(fd, 1) < 0 || getsockname(fd, reinterpret_cast<struct sockaddr*>(&addr), &len) < 0) {
+        perror("listen");
+        exit(1);
+    }
+    port = ntohs(addr.sin_port);
+    return fd;
+}
+
+int accept_client(int listen_fd) {
+    int fd = accept(listen_fd, nullptr, nullptr);
+    int enable = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+    close(listen_fd);
+    return fd;
+}
+
+// 现有路径：每个请求 modbus_receive() + modbus_reply()
+void serve_libmodbus(int listen_fd, modbus_mapping_t* mapping) {
+    int fd = accept_client(listen_fd);
+    modbus_t* ctx = modbus_new_tcp("127.0.0.1", 0);
+    modbus_set_socket(ctx, fd);
+
+    uint8_t query[MODBUS_TCP_MAX_ADU_LENGTH];
+    while (true) {
+        int rc = modbus_receive(ctx, query);
+        if (rc > 0) {
+            modbus_reply(ctx, query, rc, mapping);
+        } else if (rc == -1) {
+            break;
+        }
+    }
+    close(fd);
+    modbus_free(ctx);
+}
+
+// 新路径：一次 recv() 处理缓冲区中所有完整请求，应答合并为一次 send()
+void serve_engine(int listen_fd, modbus_mapping_t* mapping) {
+    int fd = accept_client(listen_fd);
+
+    ModbusRegisterMap map;
+    map.holding_registers = mapping->tab_registers;
+    map.nb_holding_registers = mapping->nb_registers;
+    ModbusPduEngine engine(map);
+
+    uint8_t in[4096];
+    uint8_t out[4096];
+    size_t in_len = 0;
+    while (true) {
+        ssize_t n = recv(fd, in + in_len, sizeof(in) - in_len, 0);
+        if (n <= 0) {
+            break;
+        }
+        in_len += static_cast<size_t>(n);
+
+        size_t consumed = 0;
+        size_t out_len = 0;
+        long frame_len;
+        while (sizeof(out) - out_len >= ModbusPduEngine::MAX_ADU_LENGTH &&
+               (frame_len = ModbusPduEngine::frame_length(in + consumed, in_len - consumed)) > 0) {
+            out_len += engine.process_adu(in + consumed, static_cast<size_t>(frame_len), out + out_len);
+            consumed += static_cast<size_t>(frame_len);
+        }
+        in_len -= consumed;
+        memmove(in, in + consumed, in_len);
+
+        if (out_len > 0 && send(fd, out, out_len, MSG_NOSIGNAL) != static_cast<ssize_t>(out_len)) {
+            break;
+        }
+    }
+    close(fd);
+}
+
+double run_client(uint16_t port, long requests, int depth) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (connect(fd, reinterpret_cast<struct sockaddr*>(&addr), sizeof(addr)) < 0) {
+        perror("connect");
+        exit(1);
+    }
+    int enable = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+    // FC03 读 40001 起 8 个寄存器
+    uint8_t request[12] = {0, 0, 0, 0, 0, 6, 1, 0x03, 0, 0, 0, 8};
+    uint16_t tid = 0;
+    auto send_requests = [&](int count) {
+        uint8_t batch[12 * 64];
+        for (int i = 0; i < count; ++i) {
+            request[0] = static_cast<uint8_t>(tid >> 8);
+            request[1] = static_cast<uint8_t>(tid & 0xFF);
+            tid++;
+            memcpy(batch + i * 12, request, 12);
+        }
+        send(fd, batch, static_cast<size_t>(count) * 12, MSG_NOSIGNAL);
+    };
+
+    uint8_t in[8192];
+    size_t in_len = 0;
+    long sent = 0;
+    long completed = 0;
+
+    auto start = std::chrono::steady_clock::now();
+    const int first = static_cast<int>(std::min<long>(depth, requests));
+    send_requests(first);
+    sent += first;
+
+    while (completed < requests) {
+        ssize_t n = recv(fd, in + in_len, sizeof(in) - in_len, 0);
+        if (n <= 0) {
+            fprintf(stderr, "server closed connection\n");
+            break;
+        }
+        in_len += static_cast<size_t>(n);
+
+        size_t consumed = 0;
+        int replies = 0;
+        long frame_len;
+        while ((frame_len = ModbusPduEngine::frame_length(in + consumed, in_len - consumed)) > 0) {
+            consumed += static_cast<size_t>(frame_len);
+            replies++;
+        }
+        in_len -= consumed;
+        memmove(in, in + consumed, in_len);
+        completed += replies;
+
+        // 保持 depth 个请求在途
+        const int refill = static_cast<int>(std::min<long>(replies, requests - sent));
+        if (refill > 0) {
+            send_requests(refill);
+            sent += refill;
+        }
+    }
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    close(fd);
+    return completed / elapsed;
+}
+
+double bench(void (*server)(int, modbus_mapping_t*), modbus_mapping_t* mapping, long requests, int depth) {
+    uint16_t port = 0;
+    int listen_fd = listen_loopback(port);
+    std::thread server_thread(server, listen_fd, mapping);
+    double rate = run_client(port, requests, depth);
+    server_thread.join();
+    return rate;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    long requests = argc > 1 ? atol(argv[1]) : 100000;
+    std::vector<int> depths;
+    for (int i = 2; i < argc; ++i) {
+        depths.push_back(std::max(1, std::min(64, atoi(argv[i]))));
+    }
+    if (depths.empty()) {
+        depths = {1, 8, 32};
+    }
+
+    modbus_mapping_t* mapping = modbus_mapping_new(0, 0, NB_REGISTERS, 0);
+    for (int i = 0; i < NB_REGISTERS; ++i) {
+        mapping->tab_registers[i] = static_cast<uint16_t>(i);
+    }
+
+    printf("%-8s %12s %12s %8s\n", "depth", "libmodbus", "engine", "ratio");
+    for (int depth : depths) {
+        double legacy = bench(serve_libmodbus, mapping, requests, depth);
+        double engine = bench(serve_engine, mapping, requests, depth);
+        printf("%-8d %10.0f/s %10.0f/s %7.2fx\n", depth, legacy, engine, engine / legacy);
+    }
+
+    modbus_mapping_free(mapping);
+    return 0;
+}
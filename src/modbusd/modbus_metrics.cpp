@@ -0,0 +1,214 @@
+#include "modbus_metrics.h"
+
+#include "../common/ndm.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace {
+
+// 单写者累加：避免 fetch_add 的总线锁开销
+inline void bump(std::atomic<uint64_t>& counter, uint64_t value) {
+    counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+struct Totals {
+    uint64_t requests = 0;
+    uint64_t exceptions = 0;
+    uint64_t bytes_in = 0;
+    uint64_t bytes_out = 0;
+    uint64_t latency_sum_us = 0;
+    uint64_t latency[RequestCounters::LATENCY_BUCKETS] = {};
+    uint64_t last_seen_ms = 0;
+
+    void add(const RequestCounters& c) {
+        requests += c.requests.load(std::memory_order_relaxed);
+        exceptions += c.exceptions.load(std::memory_order_relaxed);
+        bytes_in += c.bytes_in.load(std::memory_order_relaxed);
+        bytes_out += c.bytes_out.load(std::memory_order_relaxed);
+        latency_sum_us += c.latency_sum_us.load(std::memory_order_relaxed);
+        for (int i = 0; i < RequestCounters::LATENCY_BUCKETS; ++i) {
+            latency[i] += c.latency[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    Json::Value to_json() const {
+        Json::Value v(Json::objectValue);
+        v["requests"] = static_cast<Json::UInt64>(requests);
+        v["exceptions"] = static_cast<Json::UInt64>(exceptions);
+        v["bytes_in"] = static_cast<Json::UInt64>(bytes_in);
+        v["bytes_out"] = static_cast<Json::UInt64>(bytes_out);
+        v["avg_us"] = requests > 0 ? static_cast<Json::UInt64>(latency_sum_us / requests) : 0;
+        v["p50_us"] = static_cast<Json::UInt64>(ModbusMetrics::percentile_us(latency, 0.50));
+        v["p99_us"] = static_cast<Json::UInt64>(ModbusMetrics::percentile_us(latency, 0.99));
+        return v;
+    }
+};
+
+inline uint64_t now_ms() {
+    return get_timestamp_ns() / 1000000ULL;
+}
+
+} // namespace
+
+void RequestCounters::record(bool exception, size_t in, size_t out, uint64_t service_us) {
+    bump(requests, 1);
+    if (exception) {
+        bump(exceptions, 1);
+    }
+    bump(bytes_in, in);
+    bump(bytes_out, out);
+    bump(latency_sum_us, service_us);
+    bump(latency[ModbusMetrics::bucket_for(service_us)], 1);
+}
+
+MetricsShard::ClientSlot* MetricsShard::find_slot(uint32_t client) {
+    // 开放寻址，槽位一旦写入键就不再回收
+    uint32_t h = (client * 2654435761u) % MAX_CLIENTS;
+    for (int probe = 0; probe < MAX_CLIENTS; ++probe) {
+        ClientSlot& slot = clients_[(h + probe) % MAX_CLIENTS];
+        uint32_t key = slot.key.load(std::memory_order_relaxed);
+        if (key == client) {
+            return &slot;
+        }
+        if (key == ModbusMetricsKey::EMPTY) {
+            // 计数器在构造时已清零，release 发布键后读线程即可看到该槽位
+            slot.key.store(client, std::memory_order_release);
+            return &slot;
+        }
+    }
+    return &overflow_;
+}
+
+void MetricsShard::record(uint32_t client, uint8_t function, bool exception,
+                          size_t bytes_in, size_t bytes_out, uint64_t service_us) {
+    ClientSlot* slot = find_slot(client);
+    slot->counters.record(exception, bytes_in, bytes_out, service_us);
+    slot->last_seen_ms.store(now_ms(), std::memory_order_relaxed);
+
+    functions_[function & 0x7F].record(exception, bytes_in, bytes_out, service_us);
+}
+
+MetricsShard* ModbusMetrics::register_shard(const std::string& name) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shards_.push_back(std::make_unique<MetricsShard>(name));
+    return shards_.back().get();
+}
+
+int ModbusMetrics::bucket_for(uint64_t service_us) {
+    int bucket = 0;
+    while (service_us > 0 && bucket < RequestCounters::LATENCY_BUCKETS - 1) {
+        service_us >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+uint64_t ModbusMetrics::percentile_us(const uint64_t* buckets, double p) {
+    uint64_t total = 0;
+    for (int i = 0; i < RequestCounters::LATENCY_BUCKETS; ++i) {
+        total += buckets[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    const uint64_t rank = static_cast<uint64_t>(p * static_cast<double>(total - 1)) + 1;
+    uint64_t seen = 0;
+    for (int i = 0; i < RequestCounters::LATENCY_BUCKETS; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            return i == 0 ? 0 : (1ULL << i) - 1;
+        }
+    }
+    return (1ULL << (RequestCounters::LATENCY_BUCKETS - 1)) - 1;
+}
+
+Json::Value ModbusMetrics::snapshot() {
+    std::lock_guard<std::mutex> lock(mutex_);
+
+    std::unordered_map<uint32_t, Totals> clients;
+    Totals functions[MetricsShard::MAX_FUNCTIONS];
+    Totals total;
+
+    for (const auto& shard : shards_) {
+        auto collect = [&clients](uint32_t key, const MetricsShard::ClientSlot& slot) {
+            Totals& t = clients[key];
+            t.add(slot.counters);
+            t.last_seen_ms = std::max(t.last_seen_ms, slot.last_seen_ms.load(std::memory_order_relaxed));
+        };
+        for (const auto& slot : shard->clients_) {
+            uint32_t key = slot.key.load(std::memory_order_acquire);
+            if (key != ModbusMetricsKey::EMPTY) {
+                collect(key, slot);
+            }
+        }
+        if (shard->overflow_.counters.requests.load(std::memory_order_relaxed) > 0) {
+            collect(ModbusMetricsKey::OVERFLOW, shard->overflow_);
+        }
+        for (int fc = 0; fc < MetricsShard::MAX_FUNCTIONS; ++fc) {
+            functions[fc].add(shard->functions_[fc]);
+            total.add(shard->functions_[fc]);
+        }
+    }
+
+    const uint64_t now = now_ms();
+    const double elapsed_s = last_snapshot_ms_ > 0 ? (now - last_snapshot_ms_) / 1000.0 : 0.0;
+
+    // 按请求数降序，最频繁的轮询方排在最前
+    std::vector<std::pair<uint32_t, const Totals*>> ordered;
+    ordered.reserve(clients.size());
+    for (const auto& kv : clients) {
+        ordered.emplace_back(kv.first, &kv.second);
+    }
+    std::sort(ordered.begin(), ordered.end(), [](const auto& a, const auto& b) {
+        return a.second->requests > b.second->requests;
+    });
+
+    Json::Value client_list(Json::arrayValue);
+    for (const auto& entry : ordered) {
+        const Totals& t = *entry.second;
+        Json::Value v = t.to_json();
+        v["client"] = modbus_metrics_client_name(entry.first);
+        v["idle_ms"] = static_cast<Json::UInt64>(t.last_seen_ms > 0 && now > t.last_seen_ms ? now - t.last_seen_ms : 0);
+
+        double rate = 0.0;
+        auto prev = last_requests_.find(entry.first);
+        if (elapsed_s > 0.0 && prev != last_requests_.end() && t.requests >= prev->second) {
+            rate = static_cast<double>(t.requests - prev->second) / elapsed_s;
+        }
+        v["rate_per_s"] = rate;
+        last_requests_[entry.first] = t.requests;
+        client_list.append(v);
+    }
+    last_snapshot_ms_ = now;
+
+    Json::Value function_list(Json::arrayValue);
+    for (int fc = 0; fc < MetricsShard::MAX_FUNCTIONS; ++fc) {
+        if (functions[fc].requests == 0) {
+            continue;
+        }
+        Json::Value v = functions[fc].to_json();
+        v["function"] = fc;
+        function_list.append(v);
+    }
+
+    Json::Value root(Json::objectValue);
+    root["clients"] = client_list;
+    root["functions"] = function_list;
+    root["total"] = total.to_json();
+    return root;
+}
+
+std::string modbus_metrics_client_name(uint32_t key) {
+    if (key == ModbusMetricsKey::RTU) {
+        return "rtu";
+    }
+    if (key == ModbusMetricsKey::OVERFLOW) {
+        return "other";
+    }
+    char buf[16];
+    snprintf(buf, sizeof(buf), "%u.%u.%u.%u",
+             (key >> 24) & 0xFF, (key >> 16) & 0xFF, (key >> 8) & 0xFF, key & 0xFF);
+    return buf;
+}
@@ -0,0 +1,153 @@
+/**
+ * @file modbus_metrics.h
+ * @brief modbusd 请求统计（按客户端 / 按功能码）
+ *
+ * 每个服务线程（TCP 主循环、RTU 从站）持有一个独立的 MetricsShard，
+ * 只有该线程写入，计数器使用 relaxed 原子变量，记录路径上无锁、无分配。
+ * 更新线程每秒调用 ModbusMetrics::snapshot() 汇总所有分片，
+ * 生成 JSON 写入共享内存状态表（modbus_metrics）供 webcfg 展示。
+ *
+ * 统计内容:
+ * - 请求数、异常应答数、收发字节数
+ * - 服务时间直方图（log2 微秒分桶），由此估算 p50/p99
+ * - 客户端按 IPv4 地址区分，RTU 从站统一记为 "rtu"，
+ *   客户端表写满后新客户端计入 "other"
+ *
+ * @author Gateway Project
+ * @date 2025-10-22
+ */
+
+#ifndef GATEWAY_MODBUS_METRICS_H
+#define GATEWAY_MODBUS_METRICS_H
+
+#include <json/json.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace ModbusMetricsKey {
+    constexpr uint32_t EMPTY    = 0;           ///< 空槽位
+    constexpr uint32_t RTU      = 0xFFFFFFFFu; ///< RTU 串口上的主站
+    constexpr uint32_t OVERFLOW = 0xFFFFFFFEu; ///< 客户端表已满
+}
+
+/**
+ * @struct RequestCounters
+ * @brief 一组请求计数器 + 服务时间直方图
+ *
+ * 单写者：写线程用 load + store 累加（relaxed），读线程只读。
+ */
+struct RequestCounters {
+    static constexpr int LATENCY_BUCKETS = 24;  ///< 第 i 桶: [2^(i-1), 2^i) us，最后一桶为溢出
+
+    std::atomic<uint64_t> requests{0};
+    std::atomic<uint64_t> exceptions{0};
+    std::atomic<uint64_t> bytes_in{0};
+    std::atomic<uint64_t> bytes_out{0};
+    std::atomic<uint64_t> latency_sum_us{0};
+    std::atomic<uint64_t> latency[LATENCY_BUCKETS];
+
+    RequestCounters() {
+        for (auto& b : latency) {
+            b.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    void record(bool exception, size_t in, size_t out, uint64_t service_us);
+};
+
+/**
+ * @class MetricsShard
+ * @brief 单个服务线程的统计分片
+ */
+class MetricsShard {
+public:
+    static constexpr int MAX_CLIENTS = 32;     ///< 每个分片跟踪的客户端数
+    static constexpr int MAX_FUNCTIONS = 128;  ///< 功能码 0..127（异常位以下）
+
+    explicit MetricsShard(const std::string& name) : name_(name) {}
+
+    MetricsShard(const MetricsShard&) = delete;
+    MetricsShard& operator=(const MetricsShard&) = delete;
+
+    /**
+     * @brief 记录一次已处理的请求（仅所属线程调用）
+     *
+     * @param client 客户端键（IPv4 主机序地址或 ModbusMetricsKey::RTU）
+     * @param function 功能码
+     * @param exception 是否为异常应答
+     * @param bytes_in 请求 ADU 字节数
+     * @param bytes_out 应答 ADU 字节数
+     * @param service_us 从收到完整请求到应答发出的时间（微秒）
+     */
+    void record(uint32_t client, uint8_t function, bool exception,
+                size_t bytes_in, size_t bytes_out, uint64_t service_us);
+
+    const std::string& name() const { return name_; }
+
+private:
+    friend class ModbusMetrics;
+
+    struct ClientSlot {
+        std::atomic<uint32_t> key{ModbusMetricsKey::EMPTY}; ///< 发布后不再改变
+        std::atomic<uint64_t> last_seen_ms{0};
+        RequestCounters counters;
+    };
+
+    ClientSlot* find_slot(uint32_t client);
+
+    std::string name_;
+    ClientSlot clients_[MAX_CLIENTS];
+    ClientSlot overflow_;
+    RequestCounters functions_[MAX_FUNCTIONS];
+};
+
+/**
+ * @class ModbusMetrics
+ * @brief 统计分片注册表与汇总
+ */
+class ModbusMetrics {
+public:
+    /**
+     * @brief 为调用线程注册一个分片（返回的指针在本对象生命周期内有效）
+     */
+    MetricsShard* register_shard(const std::string& name);
+
+    /**
+     * @brief 汇总所有分片
+     *
+     * 同时根据与上一次快照的差值计算每个客户端的请求速率（次/秒）。
+     *
+     * @return Json::Value {"clients":[...], "functions":[...], "total":{...}}
+     */
+    Json::Value snapshot();
+
+    /**
+     * @brief 由直方图估算分位数（返回所在桶的上界，单位微秒）
+     */
+    static uint64_t percentile_us(const uint64_t* buckets, double p);
+
+    /**
+     * @brief 服务时间所在的直方图桶
+     */
+    static int bucket_for(uint64_t service_us);
+
+private:
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<MetricsShard>> shards_;
+    std::unordered_map<uint32_t, uint64_t> last_requests_;  ///< 上次快照时各客户端请求数
+    uint64_t last_snapshot_ms_ = 0;
+};
+
+/**
+ * @brief IPv4 地址（主机序）转点分十进制
+ */
+std::string modbus_metrics_client_name(uint32_t key);
+
+#endif // GATEWAY_MODBUS_METRICS_H
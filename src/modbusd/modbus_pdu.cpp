@@ -0,0 +1,253 @@
+#include "modbus_pdu.h"
+
+#include <cstring>
+
+namespace {
+
+inline uint16_t get_u16(const uint8_t* p) {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+inline void put_u16(uint8_t* p, uint16_t v) {
+    p[0] = static_cast<uint8_t>(v >> 8);
+    p[1] = static_cast<uint8_t>(v & 0xFF);
+}
+
+// 协议规定的单次数量上限
+constexpr int MAX_READ_BITS = 2000;
+constexpr int MAX_WRITE_BITS = 1968;
+constexpr int MAX_READ_REGISTERS = 125;
+constexpr int MAX_WRITE_REGISTERS = 123;
+constexpr int MAX_RW_WRITE_REGISTERS = 121;
+
+inline bool in_range(int address, int quantity, int size) {
+    return address + quantity <= size;
+}
+
+} // namespace
+
+long ModbusPduEngine::frame_length(const uint8_t* buf, size_t len) {
+    if (len < MBAP_LENGTH) {
+        return 0;
+    }
+    if (get_u16(buf + 2) != 0) {
+        return -1;  // 协议号必须为 0
+    }
+    // 长度字段 = 单元号 + PDU，PDU 至少包含功能码
+    const uint16_t length = get_u16(buf + 4);
+    if (length < 2 || length > MAX_PDU_LENGTH + 1) {
+        return -1;
+    }
+    const size_t total = 6 + static_cast<size_t>(length);
+    return len >= total ? static_cast<long>(total) : 0;
+}
+
+size_t ModbusPduEngine::process_adu(const uint8_t* req, size_t req_len, uint8_t* resp) const {
+    const size_t pdu_len = process_pdu(req + MBAP_LENGTH, req_len - MBAP_LENGTH, resp + MBAP_LENGTH);
+    resp[0] = req[0];
+    resp[1] = req[1];
+    resp[2] = 0;
+    resp[3] = 0;
+    put_u16(resp + 4, static_cast<uint16_t>(pdu_len + 1));
+    resp[6] = req[6];
+    return MBAP_LENGTH + pdu_len;
+}
+
+size_t ModbusPduEngine::exception_adu(const uint8_t* req, uint8_t code, uint8_t* resp) {
+    resp[0] = req[0];
+    resp[1] = req[1];
+    resp[2] = 0;
+    resp[3] = 0;
+    put_u16(resp + 4, 3);
+    resp[6] = req[6];
+    return MBAP_LENGTH + exception(req[MBAP_LENGTH], code, resp + MBAP_LENGTH);
+}
+
+size_t ModbusPduEngine::exception(uint8_t function, uint8_t code, uint8_t* resp) {
+    resp[0] = static_cast<uint8_t>(function | 0x80);
+    resp[1] = code;
+    return 2;
+}
+
+size_t ModbusPduEngine::process_pdu(const uint8_t* req, size_t req_len, uint8_t* resp) const {
+    const uint8_t function = req[0];
+    switch (function) {
+        case 0x01:
+            return read_bits(req, req_len, resp, map_.coils, map_.nb_coils);
+        case 0x02:
+            return read_bits(req, req_len, resp, map_.discrete_inputs, map_.nb_discrete_inputs);
+        case 0x03:
+            return read_registers(req, req_len, resp, map_.holding_registers, map_.nb_holding_registers);
+        case 0x04:
+            return read_registers(req, req_len, resp, map_.input_registers, map_.nb_input_registers);
+        case 0x05:
+            return write_single_coil(req, req_len, resp);
+        case 0x06:
+            return write_single_register(req, req_len, resp);
+        case 0x0F:
+            return write_multiple_coils(req, req_len, resp);
+        case 0x10:
+            return write_multiple_registers(req, req_len, resp);
+        case 0x17:
+            return read_write_registers(req, req_len, resp);
+        default:
+            return exception(function, ModbusException::ILLEGAL_FUNCTION, resp);
+    }
+}
+
+size_t ModbusPduEngine::read_bits(const uint8_t* req, size_t req_len, uint8_t* resp,
+                                  const uint8_t* bits, int nb_bits) const {
+    if (req_len != 5) {
+        return exception(req[0], ModbusException::ILLEGAL_DATA_VALUE, resp);
+    }
+    const int address = get_u16(req + 1);
+    const int quantity = get_u16(req + 3);
+    if (quantity < 1 || quantity > MAX_READ_BITS) {
+        return exception(req[0], ModbusException::ILLEGAL_DATA_VALUE, resp);
+    }
+    if (!bits || !in_range(address, quantity, nb_bits)) {
+        return exception(req[0], ModbusException::ILLEGAL_DATA_ADDRESS, resp);
+    }
+
+    const int byte_count = (quantity + 7) / 8;
+    resp[0] = req[0];
+    resp[1] = static_cast<uint8_t>(byte_count);
+    memset(resp + 2, 0, byte_count);
+    for (int i = 0; i < quantity; ++i) {
+        if (bits[address + i]) {
+            resp[2 + i / 8] |= static_cast<uint8_t>(1u << (i % 8));
+        }
+    }
+    return 2 + static_cast<size_t>(byte_count);
+}
+
+size_t ModbusPduEngine::read_registers(const uint8_t* req, size_t req_len, uint8_t* resp,
+                                       const uint16_t* regs, int nb_regs) const {
+    if (req_len != 5) {
+        return exception(req[0], ModbusException::ILLEGAL_DATA_VALUE, resp);
+    }
+    const int address = get_u16(req + 1);
+    const int quantity = get_u16(req + 3);
+    if (quantity < 1 || quantity > MAX_READ_REGISTERS) {
+        return exception(req[0], ModbusException::ILLEGAL_DATA_VALUE, resp);
+    }
+    if (!regs || !in_range(address, quantity, nb_regs)) {
+        return exception(req[0], ModbusException::ILLEGAL_DATA_ADDRESS, resp);
+    }
+
+    resp[0] = req[0];
+    resp[1] = static_cast<uint8_t>(quantity * 2);
+    for (int i = 0; i < quantity; ++i) {
+        put_u16(resp + 2 + i * 2, regs[address + i]);
+    }
+    return 2 + static_cast<size_t>(quantity) * 2;
+}
+
+size_t ModbusPduEngine::write_single_coil(const uint8_t* req, size_t req_len, uint8_t* resp) const {
+    if (req_len != 5) {
+        return exception(req[0], ModbusException::ILLEGAL_DATA_VALUE, resp);
+    }
+    const int address = get_u16(req + 1);
+    const uint16_t value = get_u16(req + 3);
+    // 与 modbus_reply() 相同: 先检查地址，再检查值
+    if (!map_.coils || !in_range(address, 1, map_.nb_coils)) {
+        return exception(req[0], ModbusException::ILLEGAL_DATA_ADDRESS, resp);
+    }
+    if (value != 0xFF00 && value != 0x0000) {
+        return exception(req[0], ModbusException::ILLEGAL_DATA_VALUE, resp);
+    }
+
+    map_.coils[address] = value ? 1 : 0;
+    memcpy(resp, req, 5);
+    return 5;
+}
+
+size_t ModbusPduEngine::write_single_register(const uint8_t* req, size_t req_len, uint8_t* resp) const {
+    if (req_len != 5) {
+        return exception(req[0], ModbusException::ILLEGAL_DATA_VALUE, resp);
+    }
+    const int address = get_u16(req + 1);
+    if (!map_.holding_registers || !in_range(address, 1, map_.nb_holding_registers)) {
+        return exception(req[0], ModbusException::ILLEGAL_DATA_ADDRESS, resp);
+    }
+
+    map_.holding_registers[address] = get_u16(req + 3);
+    memcpy(resp, req, 5);
+    return 5;
+}
+
+size_t ModbusPduEngine::write_multiple_coils(const uint8_t* req, size_t req_len, uint8_t* resp) const {
+    if (req_len < 6) {
+        return exception(req[0], ModbusException::ILLEGAL_DATA_VALUE, resp);
+    }
+    const int address = get_u16(req + 1);
+    const int quantity = get_u16(req + 3);
+    const size_t byte_count = req[5];
+    if (quantity < 1 || quantity > MAX_WRITE_BITS ||
+        byte_count != static_cast<size_t>((quantity + 7) / 8) || req_len != 6 + byte_count) {
+        return exception(req[0], ModbusException::ILLEGAL_DATA_VALUE, resp);
+    }
+    if (!map_.coils || !in_range(address, quantity, map_.nb_coils)) {
+        return exception(req[0], ModbusException::ILLEGAL_DATA_ADDRESS, resp);
+    }
+
+    for (int i = 0; i < quantity; ++i) {
+        map_.coils[address + i] = (req[6 + i / 8] >> (i % 8)) & 0x01;
+    }
+    memcpy(resp, req, 5);
+    return 5;
+}
+
+size_t ModbusPduEngine::write_multiple_registers(const uint8_t* req, size_t req_len, uint8_t* resp) const {
+    if (req_len < 6) {
+        return exception(req[0], ModbusException::ILLEGAL_DATA_VALUE, resp);
+    }
+    const int address = get_u16(req + 1);
+    const int quantity = get_u16(req + 3);
+    const size_t byte_count = req[5];
+    if (quantity < 1 || quantity > MAX_WRITE_REGISTERS ||
+        byte_count != static_cast<size_t>(quantity) * 2 || req_len != 6 + byte_count) {
+        return exception(req[0], ModbusException::ILLEGAL_DATA_VALUE, resp);
+    }
+    if (!map_.holding_registers || !in_range(address, quantity, map_.nb_holding_registers)) {
+        return exception(req[0], ModbusException::ILLEGAL_DATA_ADDRESS, resp);
+    }
+
+    for (int i = 0; i < quantity; ++i) {
+        map_.holding_registers[address + i] = get_u16(req + 6 + i * 2);
+    }
+    memcpy(resp, req, 5);
+    return 5;
+}
+
+size_t ModbusPduEngine::read_write_registers(const uint8_t* req, size_t req_len, uint8_t* resp) const {
+    if (req_len < 10) {
+        return exception(req[0], ModbusException::ILLEGAL_DATA_VALUE, resp);
+    }
+    const int read_address = get_u16(req + 1);
+    const int read_quantity = get_u16(req + 3);
+    const int write_address = get_u16(req + 5);
+    const int write_quantity = get_u16(req + 7);
+    const size_t byte_count = req[9];
+    if (read_quantity < 1 || read_quantity > MAX_READ_REGISTERS ||
+        write_quantity < 1 || write_quantity > MAX_RW_WRITE_REGISTERS ||
+        byte_count != static_cast<size_t>(write_quantity) * 2 || req_len != 10 + byte_count) {
+        return exception(req[0], ModbusException::ILLEGAL_DATA_VALUE, resp);
+    }
+    if (!map_.holding_registers ||
+        !in_range(read_address, read_quantity, map_.nb_holding_registers) ||
+        !in_range(write_address, write_quantity, map_.nb_holding_registers)) {
+        return exception(req[0], ModbusException::ILLEGAL_DATA_ADDRESS, resp);
+    }
+
+    // 规范要求先写后读
+    for (int i = 0; i < write_quantity; ++i) {
+        map_.holding_registers[write_address + i] = get_u16(req + 10 + i * 2);
+    }
+    resp[0] = req[0];
+    resp[1] = static_cast<uint8_t>(read_quantity * 2);
+    for (int i = 0; i < read_quantity; ++i) {
+        put_u16(resp + 2 + i * 2, map_.holding_registers[read_address + i]);
+    }
+    return 2 + static_cast<size_t>(read_quantity) * 2;
+}
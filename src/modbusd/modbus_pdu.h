@@ -0,0 +1,123 @@
+/**
+ * @file modbus_pdu.h
+ * @brief 零分配 Modbus TCP 帧解析 / 应答编码
+ *
+ * libmodbus 的 modbus_receive()/modbus_reply() 每个 modbus_t 只能服务一个
+ * 阻塞连接，且每个请求至少两次 read() 系统调用。本模块只做协议处理:
+ * - 调用方提供输入/输出缓冲区，处理过程中不做任何堆分配
+ * - frame_length() 从字节流中切出完整 ADU，一次 recv() 读到的多个
+ *   流水线请求（不同事务号）可以连续处理
+ * - 直接读写寄存器映像应答 FC01-06、FC15、FC16、FC23，
+ *   其他功能码返回非法功能异常
+ *
+ * 寄存器映像的内存布局与 modbus_mapping_t 相同（线圈每位占一个字节），
+ * 因此可以与 RTU 从站共享同一份 libmodbus 映射。
+ *
+ * @note 本类不加锁，调用方需要在持有寄存器映射互斥锁时调用 process_*()。
+ *
+ * @author Gateway Project
+ * @date 2025-10-23
+ */
+
+#ifndef GATEWAY_MODBUS_PDU_H
+#define GATEWAY_MODBUS_PDU_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @namespace ModbusException
+ * @brief Modbus 异常码
+ */
+namespace ModbusException {
+    constexpr uint8_t ILLEGAL_FUNCTION     = 0x01;
+    constexpr uint8_t ILLEGAL_DATA_ADDRESS = 0x02;
+    constexpr uint8_t ILLEGAL_DATA_VALUE   = 0x03;
+    constexpr uint8_t GATEWAY_TARGET       = 0x0B;  ///< 网关目标设备无响应
+}
+
+/**
+ * @struct ModbusRegisterMap
+ * @brief 寄存器映像视图（不持有内存）
+ */
+struct ModbusRegisterMap {
+    uint8_t* coils = nullptr;             ///< 线圈，每位一个字节 (0/1)
+    int nb_coils = 0;
+    uint8_t* discrete_inputs = nullptr;   ///< 离散输入，每位一个字节
+    int nb_discrete_inputs = 0;
+    uint16_t* holding_registers = nullptr;
+    int nb_holding_registers = 0;
+    uint16_t* input_registers = nullptr;
+    int nb_input_registers = 0;
+};
+
+/**
+ * @class ModbusPduEngine
+ * @brief Modbus 请求处理器（PDU 与 Modbus TCP ADU 两级接口）
+ */
+class ModbusPduEngine {
+public:
+    static constexpr size_t MBAP_LENGTH = 7;     ///< 事务号 + 协议号 + 长度 + 单元号
+    static constexpr size_t MAX_PDU_LENGTH = 253;
+    static constexpr size_t MAX_ADU_LENGTH = MBAP_LENGTH + MAX_PDU_LENGTH;  ///< 260
+
+    explicit ModbusPduEngine(const ModbusRegisterMap& map) : map_(map) {}
+
+    /**
+     * @brief 判断缓冲区开头是否为完整的 Modbus TCP ADU
+     *
+     * @param buf 接收缓冲区
+     * @param len 缓冲区中的有效字节数
+     * @return long >0=完整 ADU 的长度, 0=数据不足, -1=非法帧（协议号或长度错误，应断开连接）
+     */
+    static long frame_length(const uint8_t* buf, size_t len);
+
+    /**
+     * @brief 处理一个请求 PDU
+     *
+     * @param req 请求 PDU（功能码开始）
+     * @param req_len 请求 PDU 长度
+     * @param resp 应答 PDU 输出缓冲区（至少 MAX_PDU_LENGTH 字节）
+     * @return size_t 应答 PDU 长度（异常应答为 2 字节，resp[0] 最高位置 1）
+     */
+    size_t process_pdu(const uint8_t* req, size_t req_len, uint8_t* resp) const;
+
+    /**
+     * @brief 处理一个完整的 Modbus TCP 请求 ADU
+     *
+     * 应答复制请求的事务号与单元号，长度字段按应答 PDU 计算。
+     *
+     * @param req 请求 ADU（长度必须等于 frame_length() 的返回值）
+     * @param req_len 请求 ADU 长度
+     * @param resp 应答 ADU 输出缓冲区（至少 MAX_ADU_LENGTH 字节）
+     * @return size_t 应答 ADU 长度
+     */
+    size_t process_adu(const uint8_t* req, size_t req_len, uint8_t* resp) const;
+
+    /**
+     * @brief 生成 Modbus TCP 异常应答 ADU（用于单元号路由等场景）
+     */
+    static size_t exception_adu(const uint8_t* req, uint8_t code, uint8_t* resp);
+
+    /**
+     * @brief 应答是否为异常应答
+     */
+    static bool is_exception(const uint8_t* resp_pdu) { return (resp_pdu[0] & 0x80) != 0; }
+
+private:
+    size_t read_bits(const uint8_t* req, size_t req_len, uint8_t* resp,
+                     const uint8_t* bits, int nb_bits) const;
+    size_t read_registers(const uint8_t* req, size_t req_len, uint8_t* resp,
+                          const uint16_t* regs, int nb_regs) const;
+    size_t write_single_coil(const uint8_t* req, size_t req_len, uint8_t* resp) const;
+    size_t write_single_register(const uint8_t* req, size_t req_len, uint8_t* resp) const;
+    size_t write_multiple_coils(const uint8_t* req, size_t req_len, uint8_t* resp) const;
+    size_t write_multiple_registers(const uint8_t* req, size_t req_len, uint8_t* resp) const;
+    size_t read_write_registers(const uint8_t* req, size_t req_len, uint8_t* resp) const;
+
+    static size_t exception(uint8_t function, uint8_t code, uint8_t* resp);
+
+    ModbusRegisterMap map_;
+};
+
+#endif // GATEWAY_MODBUS_PDU_H
@@ -0,0 +1,245 @@
+#include "modbus_rtu_slave.h"
+
+#include "../common/logger.h"
+#include "../common/modbus_crc.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+ModbusRTUSlave::ModbusRTUSlave(const ConfigManager::ModbusConfig& cfg, UnitRouter& router)
+    : device_(cfg.rtu_device),
+      baudrate_(cfg.rtu_baudrate),
+      parity_(cfg.rtu_parity.empty() ? 'N' : cfg.rtu_parity[0]),
+      stop_bits_(cfg.rtu_stop_bits == 2 ? 2 : 1),
+      frame_gap_us_(cfg.rtu_frame_gap_us > 0
+                        ? static_cast<uint32_t>(cfg.rtu_frame_gap_us)
+                        : compute_frame_gap_us(cfg.rtu_baudrate)),
+      fd_(-1),
+      ctx_(nullptr),
+      router_(router) {
+}
+
+ModbusRTUSlave::~ModbusRTUSlave() {
+    close();
+}
+
+uint32_t ModbusRTUSlave::compute_frame_gap_us(int baudrate) {
+    if (baudrate <= 0 || baudrate > 19200) {
+        return 1750;
+    }
+    // 3.5 个字符 × 11 位 / 波特率
+    return static_cast<uint32_t>((3.5 * 11.0 * 1000000.0) / baudrate + 0.5);
+}
+
+bool ModbusRTUSlave::open() {
+    fd_ = ::open(device_.c_str(), O_RDWR | O_NOCTTY | O_NONBLOCK);
+    if (fd_ < 0) {
+        LOG_ERROR("Failed to open RTU device %s: %s", device_.c_str(), strerror(errno));
+        return false;
+    }
+
+    if (!configure_port()) {
+        close();
+        return false;
+    }
+
+    // RTU 上下文不负责收发，只借用 modbus_reply() 生成应答帧并写入 fd_
+    ctx_ = modbus_new_rtu(device_.c_str(), baudrate_, parity_, 8, stop_bits_);
+    if (!ctx_) {
+        LOG_ERROR("Failed to create Modbus RTU context");
+        close();
+        return false;
+    }
+    modbus_set_socket(ctx_, fd_);
+
+    LOG_INFO("Modbus RTU slave on %s (%d %c%d, t3.5=%u us)",
+             device_.c_str(), baudrate_, parity_, stop_bits_, frame_gap_us_);
+    return true;
+}
+
+void ModbusRTUSlave::close() {
+    if (ctx_) {
+        // 不调用 modbus_close()，fd_ 由本类自己关闭
+        modbus_free(ctx_);
+        ctx_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+bool ModbusRTUSlave::configure_port() {
+    struct termios options;
+    if (tcgetattr(fd_, &options) < 0) {
+        LOG_ERROR("tcgetattr failed on %s: %s", device_.c_str(), strerror(errno));
+        return false;
+    }
+
+    speed_t speed;
+    switch (baudrate_) {
+        case 1200:   speed = B1200; break;
+        case 2400:   speed = B2400; break;
+        case 4800:   speed = B4800; break;
+        case 9600:   speed = B9600; break;
+        case 19200:  speed = B19200; break;
+        case 38400:  speed = B38400; break;
+        case 57600:  speed = B57600; break;
+        case 115200: speed = B115200; break;
+        default:
+            LOG_ERROR("Unsupported RTU baudrate %d", baudrate_);
+            return false;
+    }
+    cfsetispeed(&options, speed);
+    cfsetospeed(&options, speed);
+
+    options.c_cflag &= ~(CSIZE | PARENB | PARODD | CSTOPB | CRTSCTS);
+    options.c_cflag |= CS8 | CREAD | CLOCAL;
+    if (parity_ == 'E' || parity_ == 'e') {
+        options.c_cflag |= PARENB;
+    } else if (parity_ == 'O' || parity_ == 'o') {
+        options.c_cflag |= PARENB | PARODD;
+    }
+    if (stop_bits_ == 2) {
+        options.c_cflag |= CSTOPB;
+    }
+
+    // 原始模式，完全由 ppoll() 控制等待
+    options.c_lflag &= ~(ICANON | ECHO | ECHOE | ISIG | IEXTEN);
+    options.c_iflag &= ~(IXON | IXOFF | IXANY | ICRNL | INLCR | IGNCR | ISTRIP | BRKINT);
+    options.c_oflag &= ~OPOST;
+    options.c_cc[VMIN] = 0;
+    options.c_cc[VTIME] = 0;
+
+    if (tcsetattr(fd_, TCSANOW, &options) < 0) {
+        LOG_ERROR("tcsetattr failed on %s: %s", device_.c_str(), strerror(errno));
+        return false;
+    }
+    tcflush(fd_, TCIOFLUSH);
+    return true;
+}
+
+void ModbusRTUSlave::run(const std::atomic<bool>& running) {
+    if (fd_ < 0) {
+        return;
+    }
+
+    uint8_t frame[MODBUS_RTU_MAX_ADU_LENGTH];
+    size_t frame_len = 0;
+    bool overrun = false;
+
+    const struct timespec idle_timeout = {0, 100 * 1000000L};
+    const struct timespec gap_timeout = {
+        static_cast<time_t>(frame_gap_us_ / 1000000U),
+        static_cast<long>(frame_gap_us_ % 1000000U) * 1000L
+    };
+
+    while (running) {
+        struct pollfd pfd;
+        pfd.fd = fd_;
+        pfd.events = POLLIN;
+        pfd.revents = 0;
+
+        // 帧接收中：等待 t3.5；空闲时：100 ms 超时以便检查退出标志
+        const bool receiving = frame_len > 0 || overrun;
+        int rc = ppoll(&pfd, 1, receiving ? &gap_timeout : &idle_timeout, nullptr);
+        if (rc < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("RTU ppoll failed: %s", strerror(errno));
+            break;
+        }
+
+        if (rc == 0) {
+            // 静默超过 t3.5，当前帧结束
+            if (frame_len > 0 && !overrun) {
+                handle_frame(frame, frame_len);
+            }
+            frame_len = 0;
+            overrun = false;
+            continue;
+        }
+
+        if (pfd.revents & (POLLERR | POLLHUP | POLLNVAL)) {
+            LOG_ERROR("RTU device %s reported an error, stopping RTU slave", device_.c_str());
+            break;
+        }
+
+        uint8_t buf[MODBUS_RTU_MAX_ADU_LENGTH];
+        ssize_t n = read(fd_, buf, sizeof(buf));
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EINTR) {
+                continue;
+            }
+            LOG_ERROR("RTU read failed: %s", strerror(errno));
+            break;
+        }
+
+        if (overrun) {
+            continue;  // 丢弃直到下一次 t3.5 静默
+        }
+        if (frame_len + static_cast<size_t>(n) > sizeof(frame)) {
+            frames_overrun_++;
+            overrun = true;
+            frame_len = 0;
+            continue;
+        }
+        memcpy(frame + frame_len, buf, static_cast<size_t>(n));
+        frame_len += static_cast<size_t>(n);
+    }
+
+    LOG_INFO("Modbus RTU slave stopped (ok=%llu, crc_errors=%llu, overruns=%llu)",
+             static_cast<unsigned long long>(frames_ok_),
+             static_cast<unsigned long long>(frames_crc_error_),
+             static_cast<unsigned long long>(frames_overrun_));
+}
+
+void ModbusRTUSlave::handle_frame(const uint8_t* frame, size_t len) {
+    if (!modbus_check_crc(frame, len)) {
+        frames_crc_error_++;
+        LOG_DEBUG("RTU frame CRC mismatch (%zu bytes)", len);
+        return;
+    }
+
+    const int address = frame[0];
+    if (address == 0) {
+        // 广播帧不得应答；网关寄存器不接受广播写入，直接忽略
+        return;
+    }
+    UnitImage* image = router_.find(static_cast<uint8_t>(address));
+    if (!image) {
+        return;  // 总线上其他从站的帧
+    }
+
+    const uint64_t received_ns = get_timestamp_ns();
+    std::lock_guard<std::mutex> lock(router_.mutex());
+    // modbus_reply() 按请求帧中的地址组应答帧，别名地址也能正确应答；
+    // 非测厚仪单元的命令写入以异常应答拒绝
+    const bool rejected = UnitRouter::rejects_command(*image, frame + 1, len - 3);
+    const int sent = rejected
+        ? modbus_reply_exception(ctx_, frame, ModbusException::ILLEGAL_DATA_ADDRESS)
+        : modbus_reply(ctx_, frame, static_cast<int>(len), image->mapping);
+    if (metrics_) {
+        // 异常应答固定为 地址 + 功能码 + 异常码 + CRC = 5 字节
+        metrics_->record(ModbusMetricsKey::RTU, frame[1], sent <= 5,
+                         len, sent > 0 ? static_cast<size_t>(sent) : 0,
+                         (get_timestamp_ns() - received_ns) / 1000ULL);
+    }
+    if (sent < 0) {
+        LOG_WARN("RTU reply failed: %s", strerror(errno));
+        return;
+    }
+    frames_ok_++;
+    if (rejected || !image->command_bridge) {
+        return;
+    }
+
+    // 去掉 1 字节地址和 2 字节 CRC 即为 PDU
+    image->command_bridge->on_request(frame + 1, len - 3, static_cast<uint16_t>(address),
+                                      image->mapping->tab_registers);
+}
@@ -0,0 +1,110 @@
+/**
+ * @file modbus_rtu_slave.h
+ * @brief Modbus RTU 从站（第二串口）
+ *
+ * 部分 CNC 控制器只支持 Modbus RTU。modbusd 可以在一个独立的 tty 上
+ * 以 RTU 从站身份对外提供与 Modbus TCP 完全相同的寄存器映像，
+ * 省去外置的 TCP/RTU 转换器及其带来的额外延迟。
+ *
+ * 实现要点:
+ * - 串口以非阻塞方式打开，使用 ppoll() 等待数据，可随时响应退出信号
+ * - 按 Modbus 串行链路规范使用 t3.5 静默间隔判定帧结束
+ *   (波特率 <= 19200 时为 3.5 个字符时间，更高波特率固定为 1750 us)
+ * - 帧地址与 CRC 由本模块校验，PDU 处理复用 libmodbus 的 modbus_reply()
+ * - 从站地址按 UnitRouter 路由到对应通道的映像（与 TCP 共享），
+ *   未配置的地址不应答；访问映像时持有路由表的互斥锁
+ *
+ * @author Gateway Project
+ * @date 2025-10-20
+ */
+
+#ifndef GATEWAY_MODBUS_RTU_SLAVE_H
+#define GATEWAY_MODBUS_RTU_SLAVE_H
+
+#include "../common/config.h"
+#include "modbus_metrics.h"
+#include "unit_router.h"
+
+#include <modbus/modbus.h>
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+/**
+ * @class ModbusRTUSlave
+ * @brief 基于 t3.5 帧间隔的非阻塞 Modbus RTU 从站
+ */
+class ModbusRTUSlave {
+public:
+    /**
+     * @brief 构造函数
+     *
+     * @param cfg Modbus 配置（使用 rtu_* 字段）
+     * @param router 与 TCP 服务共享的单元号路由表
+     */
+    ModbusRTUSlave(const ConfigManager::ModbusConfig& cfg, UnitRouter& router);
+
+    ~ModbusRTUSlave();
+
+    ModbusRTUSlave(const ModbusRTUSlave&) = delete;
+    ModbusRTUSlave& operator=(const ModbusRTUSlave&) = delete;
+
+    /**
+     * @brief 打开并配置串口
+     * @return bool true=成功, false=失败
+     */
+    bool open();
+
+    /**
+     * @brief 关闭串口
+     */
+    void close();
+
+    /**
+     * @brief 从站主循环（在独立线程中运行）
+     *
+     * @param running 运行标志，变为 false 时在 100 ms 内退出
+     */
+    void run(const std::atomic<bool>& running);
+
+    /**
+     * @brief 设置请求统计分片（由 RTU 线程独占写入）
+     */
+    void set_metrics(MetricsShard* metrics) { metrics_ = metrics; }
+
+    /**
+     * @brief 当前使用的帧间隔 t3.5（微秒）
+     */
+    uint32_t frame_gap_us() const { return frame_gap_us_; }
+
+    /**
+     * @brief 按波特率计算 t3.5
+     *
+     * 每个字符按 11 位计算（起始位 + 8 数据位 + 校验/停止位 + 停止位）。
+     * 规范规定波特率高于 19200 时使用固定值 1750 us。
+     *
+     * @param baudrate 波特率
+     * @return uint32_t t3.5（微秒）
+     */
+    static uint32_t compute_frame_gap_us(int baudrate);
+
+private:
+    bool configure_port();
+    void handle_frame(const uint8_t* frame, size_t len);
+
+    std::string device_;           ///< 串口设备路径
+    int baudrate_;                 ///< 波特率
+    char parity_;                  ///< 校验位 N/E/O
+    int stop_bits_;                ///< 停止位
+    uint32_t frame_gap_us_;        ///< 帧间隔 t3.5（微秒）
+    int fd_;                       ///< 串口文件描述符
+    modbus_t* ctx_;                ///< 仅用于 modbus_reply() 组帧的 RTU 上下文
+    UnitRouter& router_;           ///< 从站地址 → 寄存器映像
+    MetricsShard* metrics_ = nullptr;         ///< 请求统计（可选）
+
+    uint64_t frames_ok_ = 0;       ///< 已应答的帧数
+    uint64_t frames_crc_error_ = 0;///< CRC 错误帧数
+    uint64_t frames_overrun_ = 0;  ///< 超长帧数
+};
+
+#endif // GATEWAY_MODBUS_RTU_SLAVE_H
@@ -0,0 +1,134 @@
+#include "unit_router.h"
+
+#include "../common/logger.h"
+
+#include <cstring>
+
+UnitImage::~UnitImage() {
+    engine.reset();
+    if (mapping) {
+        modbus_mapping_free(mapping);
+        mapping = nullptr;
+    }
+}
+
+UnitRouter::UnitRouter() {
+    for (auto& entry : table_) {
+        entry = nullptr;
+    }
+}
+
+UnitImage* UnitRouter::add_unit(int unit_id, int channel, CommandQueue* cmd_queue) {
+    auto image = std::make_unique<UnitImage>();
+    image->unit_id = static_cast<uint8_t>(unit_id);
+    image->channel = static_cast<uint16_t>(channel);
+
+    // 参数: 线圈数, 离散输入数, 保持寄存器数, 输入寄存器数
+    image->mapping = modbus_mapping_new(0, 0, NB_REGISTERS, 0);
+    if (!image->mapping) {
+        LOG_ERROR("Failed to create Modbus mapping for unit %d", unit_id);
+        return nullptr;
+    }
+    memset(image->mapping->tab_registers, 0, NB_REGISTERS * sizeof(uint16_t));
+
+    ModbusRegisterMap map;
+    map.holding_registers = image->mapping->tab_registers;
+    map.nb_holding_registers = image->mapping->nb_registers;
+    image->engine = std::make_unique<ModbusPduEngine>(map);
+    if (channel == GAUGE_CHANNEL) {
+        image->command_bridge = std::make_unique<CommandBridge>(cmd_queue);
+    }
+
+    table_[unit_id] = image.get();
+    units_.push_back(std::move(image));
+    return units_.back().get();
+}
+
+bool UnitRouter::init(const ConfigManager::ModbusConfig& cfg, CommandQueue* cmd_queue) {
+    for (const auto& route : cfg.units) {
+        // 0 为广播地址，248-255 为保留地址
+        if (route.unit_id < 1 || route.unit_id > 247) {
+            LOG_ERROR("Invalid Modbus unit id %d", route.unit_id);
+            return false;
+        }
+        if (route.channel < 0 || route.channel > 0xFFFF) {
+            LOG_ERROR("Invalid channel %d for unit %d", route.channel, route.unit_id);
+            return false;
+        }
+        if (table_[route.unit_id]) {
+            LOG_ERROR("Duplicate Modbus unit id %d", route.unit_id);
+            return false;
+        }
+        if (!add_unit(route.unit_id, route.channel, cmd_queue)) {
+            return false;
+        }
+        LOG_INFO("Modbus unit %d -> channel %d", route.unit_id, route.channel);
+    }
+
+    // 兼容旧配置：RTU 从站地址与 TCP 单元号不同时，指向通道 0 的映像
+    if (cfg.rtu_enabled && cfg.rtu_slave_id >= 1 && cfg.rtu_slave_id <= 247 && !table_[cfg.rtu_slave_id]) {
+        for (const auto& image : units_) {
+            if (image->channel == 0) {
+                table_[cfg.rtu_slave_id] = image.get();
+                LOG_INFO("Modbus RTU address %d aliases unit %d", cfg.rtu_slave_id, image->unit_id);
+                break;
+            }
+        }
+    }
+
+    return !units_.empty();
+}
+
+void UnitRouter::update(const NormalizedData& data) {
+    // 寄存器映射:
+    // 40001-40002: Float32 厚度值 (Big-Endian)
+    // 40003-40006: Uint64 时间戳 (Big-Endian, Unix ms)
+    // 40007:       Uint16 状态位
+    // 40008:       Uint16 序列号 (低 16 位)
+    uint32_t thickness_raw = 0;
+    static_assert(sizeof(thickness_raw) == sizeof(data.thickness_mm), "float size mismatch");
+    memcpy(&thickness_raw, &data.thickness_mm, sizeof(thickness_raw));
+    const uint64_t timestamp_ms = data.timestamp_ns / 1000000ULL;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& image : units_) {
+        if (image->channel != data.channel) {
+            continue;
+        }
+        uint16_t* regs = image->mapping->tab_registers;
+
+        // Float32 转 2×Uint16 (Big-Endian)
+        regs[0] = static_cast<uint16_t>((thickness_raw >> 16) & 0xFFFF);
+        regs[1] = static_cast<uint16_t>(thickness_raw & 0xFFFF);
+
+        // Uint64 时间戳转 Unix ms (Big-Endian)
+        regs[2] = static_cast<uint16_t>((timestamp_ms >> 48) & 0xFFFF);
+        regs[3] = static_cast<uint16_t>((timestamp_ms >> 32) & 0xFFFF);
+        regs[4] = static_cast<uint16_t>((timestamp_ms >> 16) & 0xFFFF);
+        regs[5] = static_cast<uint16_t>(timestamp_ms & 0xFFFF);
+
+        // 状态位
+        regs[6] = data.status;
+
+        // 序列号
+        regs[7] = data.sequence & 0xFFFF;
+    }
+}
+
+void UnitRouter::set_command_queue(CommandQueue* cmd_queue) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& image : units_) {
+        if (image->command_bridge) {
+            image->command_bridge->set_queue(cmd_queue, image->mapping->tab_registers);
+        }
+    }
+}
+
+void UnitRouter::refresh_command_status() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (const auto& image : units_) {
+        if (image->command_bridge) {
+            image->command_bridge->refresh_status(image->mapping->tab_registers);
+        }
+    }
+}
@@ -0,0 +1,123 @@
+/**
+ * @file unit_router.h
+ * @brief Modbus 单元号路由
+ *
+ * 每个采集通道（测厚仪）以独立的 Modbus 单元号对外提供一份寄存器映像，
+ * SCADA 可以通过同一个 TCP 端口（或同一条 RTU 总线）把每台测厚仪
+ * 当作独立设备访问。
+ *
+ * - 单元号 → 映像通过 256 项数组查表，O(1)
+ * - 每个映像有自己的 modbus_mapping_t（RTU 从站的 modbus_reply() 使用）和
+ *   ModbusPduEngine（TCP 使用）
+ * - rs485d 只连接一台测厚仪（通道 GAUGE_CHANNEL），命令也只能发给它:
+ *   只有映射到该通道的单元有 CommandBridge，其他单元写命令区时
+ *   返回 ILLEGAL_DATA_ADDRESS 异常
+ * - 所有映像由同一把互斥锁保护
+ *
+ * 未配置的单元号: TCP 返回 0x0B 异常（网关目标设备无响应），
+ * RTU 不应答（与总线上不存在的从站行为一致）。
+ *
+ * @author Gateway Project
+ * @date 2025-10-24
+ */
+
+#ifndef GATEWAY_UNIT_ROUTER_H
+#define GATEWAY_UNIT_ROUTER_H
+
+#include "../common/cmd_queue.h"
+#include "../common/config.h"
+#include "../common/ndm.h"
+#include "command_bridge.h"
+#include "modbus_pdu.h"
+
+#include <modbus/modbus.h>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * @struct UnitImage
+ * @brief 一个单元号对应的寄存器映像
+ */
+struct UnitImage {
+    uint8_t unit_id = 0;                          ///< Modbus 单元号
+    uint16_t channel = 0;                         ///< 采集通道号
+    modbus_mapping_t* mapping = nullptr;          ///< 寄存器映射
+    std::unique_ptr<ModbusPduEngine> engine;      ///< TCP 请求处理
+    std::unique_ptr<CommandBridge> command_bridge;///< 命令寄存器 → rs485d（仅测厚仪通道，否则为空）
+
+    ~UnitImage();
+};
+
+/**
+ * @class UnitRouter
+ * @brief 单元号 → 寄存器映像
+ */
+class UnitRouter {
+public:
+    static constexpr int NB_REGISTERS = 100;  ///< 每个映像的保持寄存器数
+    static constexpr uint16_t GAUGE_CHANNEL = 0; ///< rs485d 所接测厚仪的通道（接受命令）
+
+    UnitRouter();
+
+    UnitRouter(const UnitRouter&) = delete;
+    UnitRouter& operator=(const UnitRouter&) = delete;
+
+    /**
+     * @brief 按配置建立映像
+     *
+     * @param cfg Modbus 配置（units 路由表；启用 RTU 且 rtu_slave_id 未出现在
+     *            路由表中时，作为通道 0 映像的别名）
+     * @param cmd_queue 命令队列（nullptr 表示命令一律拒绝）
+     * @return bool true=成功, false=配置无效或内存不足
+     */
+    bool init(const ConfigManager::ModbusConfig& cfg, CommandQueue* cmd_queue);
+
+    /**
+     * @brief 查找单元号对应的映像
+     * @return UnitImage* 未配置时返回 nullptr
+     */
+    UnitImage* find(uint8_t unit_id) const { return table_[unit_id]; }
+
+    /**
+     * @brief 请求是否为发往非测厚仪单元的命令写入（调用方应返回 ILLEGAL_DATA_ADDRESS）
+     */
+    static bool rejects_command(const UnitImage& image, const uint8_t* pdu, size_t pdu_len) {
+        return !image.command_bridge && CommandBridge::is_command_write(pdu, pdu_len);
+    }
+
+    /**
+     * @brief 用一条采集数据更新对应通道的所有映像（内部加锁）
+     */
+    void update(const NormalizedData& data);
+
+    /**
+     * @brief 刷新所有映像的命令状态寄存器（内部加锁）
+     */
+    void refresh_command_status();
+
+    /**
+     * @brief 所有命令桥切换到新的命令队列（内部加锁）
+     */
+    void set_command_queue(CommandQueue* cmd_queue);
+
+    /**
+     * @brief 保护所有映像的互斥锁
+     */
+    std::mutex& mutex() { return mutex_; }
+
+    /**
+     * @brief 已配置的映像（不含别名）
+     */
+    const std::vector<std::unique_ptr<UnitImage>>& units() const { return units_; }
+
+private:
+    UnitImage* add_unit(int unit_id, int channel, CommandQueue* cmd_queue);
+
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<UnitImage>> units_;
+    UnitImage* table_[256];
+};
+
+#endif // GATEWAY_UNIT_ROUTER_H
@@ -6,19 +6,34 @@
  * - 从共享内存读取测厚仪数据
  * - 将数据写入 OPC UA 服务器变量节点
  * - 支持配置热重载
- * - 自动重连机制
+ * - 自动重连机制（后台线程，指数退避 + TCP 预探测，见 connect_worker.h）
  * 
  * OPC UA 通信:
  * - 使用 open62541 库实现
  * - 支持安全模式: None/Sign/SignAndEncrypt
  * - 支持用户名/密码认证
  * 
- * 数据节点映射:
+ * 数据节点映射（默认值，可通过 protocol.opcua.nodes 配置，见 opcua_node_map.h）:
  * - ns=2;s=Gateway.Thickness    - Float - 厚度值 (mm)
  * - ns=2;s=Gateway.Timestamp    - Int64 - 时间戳 (Unix ms)
  * - ns=2;s=Gateway.Status       - UInt16 - 状态位
  * - ns=2;s=Gateway.Sequence     - UInt32 - 序列号
  * 
+ * 一个样本的 4 个节点在同一个 Write 请求中写入（一次往返）。
+ * Write 请求异步发出，最多 max_inflight 个同时在途（见 opcua_async_writer.h），
+ * 发布速率不再受 1/RTT 限制。主循环在共享内存有新样本时立即唤醒，
+ * 有在途请求时每 1 ms 调用一次 UA_Client_run_iterate() 接收应答。
+ * 
+ * mode=server/both 时另外运行内嵌 OPC UA 服务器，每个通道的数据作为变量发布，
+ * MES 等系统可直接订阅网关（见 opcua_server.h）。
+ * 
+ * 启用 pubsub 时每个样本另外编码为 UADP 报文，通过 UDP 组播/单播发出，
+ * 订阅方无需会话（见 uadp_publisher.h）。
+ * 
+ * 配置 deadband 后，厚度变化不超过死区且未到心跳间隔的样本不写入服务器。
+ * 启用 outbox 时，断线期间的样本缓存到磁盘，恢复后按原始时间作为
+ * SourceTimestamp 限速补发（服务器端历史记录保持正确的时间）。
+ * 
  * @author Gateway Project
  * @date 2025-10-11
  * @version 2.0
@@ -26,13 +41,25 @@
 
 #include "../common/logger.h"
 #include "../common/config.h"
+#include "../common/config_watcher.h"
 #include "../common/shm_ring.h"
 #include "../common/status_writer.h"
+#include "../common/deadband.h"
+#include "../common/outbox.h"
+#include "../common/connect_worker.h"
+#include "../common/service_host.h"
+#include "opcua_async_writer.h"
+#include "opcua_backfill.h"
+#include "opcua_node_map.h"
+#include "opcua_server.h"
+#include "uadp_publisher.h"
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <csignal>
-#include <filesystem>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 #include <thread>
 
@@ -46,12 +73,14 @@ extern "C" {
 
 using namespace std::chrono_literals;
 
+namespace opcuad {
+
 // ============================================================================
 // 全局变量
 // ============================================================================
 
 /// @brief 运行标志,收到信号时设置为0
-volatile sig_atomic_t g_running = 1;
+std::atomic<bool> g_running{true};
 
 /// @brief OPC UA 客户端句柄
 UA_Client* g_opcua_client = nullptr;
@@ -66,7 +95,7 @@ UA_Client* g_opcua_client = nullptr;
  */
 void signal_handler(int signum) {
     LOG_INFO("收到信号 %d, 正在关闭...", signum);
-    g_running = 0;
+    g_running = false;
 }
 
 // ============================================================================
@@ -138,6 +167,27 @@ bool opcua_connect(const std::string& server_url,
     }
 }
 
+/**
+ * @brief 从 opc.tcp://host:port/path 中取出主机和端口（用于 TCP 预探测）
+ * @return bool false=地址格式无法识别
+ */
+bool opcua_parse_endpoint(const std::string& url, std::string& host, int& port) {
+    const std::string scheme = "opc.tcp://";
+    if (url.compare(0, scheme.size(), scheme) != 0) {
+        return false;
+    }
+    std::string rest = url.substr(scheme.size());
+    rest = rest.substr(0, rest.find('/'));
+    port = 4840;
+    const size_t colon = rest.rfind(':');
+    if (colon != std::string::npos) {
+        port = std::atoi(rest.c_str() + colon + 1);
+        rest.resize(colon);
+    }
+    host = rest;
+    return !host.empty() && port > 0;
+}
+
 /**
  * @brief 断开 OPC UA 连接
  */
@@ -166,204 +216,61 @@ bool opcua_is_connected() {
             channel_state == UA_SECURECHANNELSTATE_OPEN);
 }
 
-/**
- * @brief 写入 Float 变量
- * @param node_id 节点 ID 字符串 (如 "ns=2;s=Gateway.Thickness")
- * @param value 值
- * @return bool true=成功, false=失败
- */
-bool opcua_write_float(const std::string& node_id, float value) {
-    if (!g_opcua_client || !opcua_is_connected()) {
-        return false;
-    }
-    
-    // 解析节点 ID
-    UA_NodeId nodeId = UA_NODEID_STRING_ALLOC(2, node_id.c_str() + 6); // 跳过 "ns=2;s="
-    
-    // 创建变量
-    UA_Variant variant;
-    UA_Variant_init(&variant);
-    UA_Variant_setScalarCopy(&variant, &value, &UA_TYPES[UA_TYPES_FLOAT]);
-    
-    // 写入变量
-    UA_StatusCode retval = UA_Client_writeValueAttribute(g_opcua_client, nodeId, &variant);
-    
-    // 清理
-    UA_Variant_clear(&variant);
-    UA_NodeId_clear(&nodeId);
-    
-    if (retval == UA_STATUSCODE_GOOD) {
-        return true;
-    } else {
-        LOG_DEBUG("OPC UA 写入失败 [%s]: %s",
-                 node_id.c_str(), UA_StatusCode_name(retval));
-        return false;
-    }
-}
-
-/**
- * @brief 写入 Int64 变量
- * @param node_id 节点 ID 字符串
- * @param value 值
- * @return bool true=成功, false=失败
- */
-bool opcua_write_int64(const std::string& node_id, int64_t value) {
-    if (!g_opcua_client || !opcua_is_connected()) {
-        return false;
-    }
-    
-    UA_NodeId nodeId = UA_NODEID_STRING_ALLOC(2, node_id.c_str() + 6);
-    
-    UA_Variant variant;
-    UA_Variant_init(&variant);
-    UA_Variant_setScalarCopy(&variant, &value, &UA_TYPES[UA_TYPES_INT64]);
-    
-    UA_StatusCode retval = UA_Client_writeValueAttribute(g_opcua_client, nodeId, &variant);
-    
-    UA_Variant_clear(&variant);
-    UA_NodeId_clear(&nodeId);
-    
-    return (retval == UA_STATUSCODE_GOOD);
-}
-
-/**
- * @brief 写入 UInt16 变量
- * @param node_id 节点 ID 字符串
- * @param value 值
- * @return bool true=成功, false=失败
- */
-bool opcua_write_uint16(const std::string& node_id, uint16_t value) {
-    if (!g_opcua_client || !opcua_is_connected()) {
-        return false;
-    }
-    
-    UA_NodeId nodeId = UA_NODEID_STRING_ALLOC(2, node_id.c_str() + 6);
-    
-    UA_Variant variant;
-    UA_Variant_init(&variant);
-    UA_Variant_setScalarCopy(&variant, &value, &UA_TYPES[UA_TYPES_UINT16]);
-    
-    UA_StatusCode retval = UA_Client_writeValueAttribute(g_opcua_client, nodeId, &variant);
-    
-    UA_Variant_clear(&variant);
-    UA_NodeId_clear(&nodeId);
-    
-    return (retval == UA_STATUSCODE_GOOD);
-}
-
-/**
- * @brief 写入 UInt32 变量
- * @param node_id 节点 ID 字符串
- * @param value 值
- * @return bool true=成功, false=失败
- */
-bool opcua_write_uint32(const std::string& node_id, uint32_t value) {
-    if (!g_opcua_client || !opcua_is_connected()) {
-        return false;
-    }
-    
-    UA_NodeId nodeId = UA_NODEID_STRING_ALLOC(2, node_id.c_str() + 6);
-    
-    UA_Variant variant;
-    UA_Variant_init(&variant);
-    UA_Variant_setScalarCopy(&variant, &value, &UA_TYPES[UA_TYPES_UINT32]);
-    
-    UA_StatusCode retval = UA_Client_writeValueAttribute(g_opcua_client, nodeId, &variant);
-    
-    UA_Variant_clear(&variant);
-    UA_NodeId_clear(&nodeId);
-    
-    return (retval == UA_STATUSCODE_GOOD);
-}
-
-/**
- * @brief 写入数据到 OPC UA 服务器
- * 
- * 写入4个变量节点:
- * - ns=2;s=Gateway.Thickness  - 厚度值 (Float)
- * - ns=2;s=Gateway.Timestamp  - 时间戳 (Int64)
- * - ns=2;s=Gateway.Status     - 状态位 (UInt16)
- * - ns=2;s=Gateway.Sequence   - 序列号 (UInt32)
- * 
- * @param data 归一化数据
- * @return bool true=全部写入成功, false=至少一个失败
- */
-bool opcua_write_data(const NormalizedData& data) {
-    if (!g_opcua_client || !opcua_is_connected()) {
-        LOG_WARN("OPC UA 未连接,无法写入数据");
-        return false;
-    }
-    
-    bool ok = true;
-    
-    // 1. 写入厚度值
-    if (!opcua_write_float("ns=2;s=Gateway.Thickness", data.thickness_mm)) {
-        ok = false;
-    }
-    
-    // 2. 写入时间戳
-    const int64_t timestamp_ms = static_cast<int64_t>(data.timestamp_ns / 1000000ULL);
-    if (!opcua_write_int64("ns=2;s=Gateway.Timestamp", timestamp_ms)) {
-        ok = false;
-    }
-    
-    // 3. 写入状态位
-    if (!opcua_write_uint16("ns=2;s=Gateway.Status", data.status)) {
-        ok = false;
-    }
-    
-    // 4. 写入序列号
-    if (!opcua_write_uint32("ns=2;s=Gateway.Sequence", data.sequence)) {
-        ok = false;
-    }
-    
-    if (ok) {
-        LOG_DEBUG("OPC UA 写入成功: thickness=%.3f mm, seq=%u", data.thickness_mm, data.sequence);
-    } else {
-        LOG_WARN("OPC UA 写入部分失败");
-    }
-    
-    return ok;
-}
-
 // ============================================================================
 // 状态写入
 // ============================================================================
 
 /**
- * @brief 写入组件状态到状态文件
- * @param sample 数据样本 (可为nullptr)
+ * @brief 写入组件状态详情到状态表（最新样本和读游标由 StatusWriter::update() 更新）
  * @param connected 是否已连接
  * @param cfg OPC UA配置
  * @param active_protocol 当前激活的协议
+ * @param filter 死区过滤器（发布/抑制计数）
+ * @param outbox 断线缓存
+ * @param connection 重连统计
+ * @param server 内嵌服务器状态
+ * @param pubsub UADP 发布状态
  */
-static void write_status(const NormalizedData* sample,
-                         bool connected,
+static void write_status(bool connected,
                          const ConfigManager::OPCUAConfig& cfg,
-                         const std::string& active_protocol) {
+                         const std::string& active_protocol,
+                         const DeadbandFilter& filter,
+                         const Outbox& outbox,
+                         const Json::Value& connection,
+                         const Json::Value& server,
+                         const Json::Value& pubsub) {
     Json::Value extra(Json::objectValue);
     Json::Value conf(Json::objectValue);
     conf["enabled"] = cfg.enabled;
+    conf["mode"] = cfg.mode;
     conf["server_url"] = cfg.server_url;
     conf["security_mode"] = cfg.security_mode;
     conf["username"] = cfg.username;
+    conf["deadband_absolute"] = cfg.deadband.absolute;
+    conf["deadband_percent"] = cfg.deadband.percent;
+    conf["heartbeat_ms"] = cfg.deadband.heartbeat_ms;
     extra["config"] = conf;
     extra["active_protocol"] = active_protocol;
     extra["connected"] = connected;
-    StatusWriter::write_component_status("opcua", sample, connected, extra);
+    Json::Value publish(Json::objectValue);
+    publish["published"] = static_cast<Json::UInt64>(filter.published());
+    publish["suppressed"] = static_cast<Json::UInt64>(filter.suppressed());
+    publish["outbox_size"] = static_cast<Json::UInt64>(outbox.size());
+    publish["outbox_dropped"] = static_cast<Json::UInt64>(outbox.dropped());
+    extra["publish"] = publish;
+    extra["connection"] = connection;
+    extra["server"] = server;
+    extra["pubsub"] = pubsub;
+    StatusWriter::write_detail(StatusComponent::OPCUA, extra);
 }
 
 // ============================================================================
 // 主程序
 // ============================================================================
 
-int main(int argc, char* argv[]) {
-    // 初始化日志
-    Logger::init("opcuad", false);
-    
-    // 注册信号处理
-    signal(SIGINT, signal_handler);
-    signal(SIGTERM, signal_handler);
+int run(int argc, char* argv[]) {
+    // 初始化日志和信号处理
+    ServiceHost::init("opcuad", signal_handler);
     
     // 加载配置
     ConfigManager& config = ConfigManager::instance();
@@ -375,22 +282,19 @@ int main(int argc, char* argv[]) {
     if (!config.load(config_path)) {
         LOG_WARN("配置加载失败,使用默认配置");
     }
+    StatusWriter::configure_files(config.get_status_file_config());
     
-    // 获取配置
-    auto opcua_cfg = config.get_opcua_config();
-    auto active_protocol = config.get_string("protocol.active", "modbus");
-    
-    // 配置签名 (用于检测配置变化)
-    auto make_signature = [](const ConfigManager::OPCUAConfig& cfg, const std::string& proto) {
-        return proto + "|" + (cfg.enabled ? "1" : "0") + "|" + cfg.server_url + "|" +
-               cfg.security_mode + "|" + cfg.username + "|" + cfg.password;
-    };
-    std::string config_signature = make_signature(opcua_cfg, active_protocol);
+    // 获取配置（同一快照，之后由 watcher 分发的快照替换）
+    const auto startup_cfg = config.snapshot();
+    auto opcua_cfg = startup_cfg->opcua;
+    auto active_protocol = startup_cfg->active_protocol;
+    bool output_active = startup_cfg->opcua_active;
     
     // 打印启动信息
     LOG_INFO("========================================");
     LOG_INFO("OPC UA 客户端守护进程启动");
     LOG_INFO("========================================");
+    LOG_INFO("模式: %s", opcua_cfg.mode.c_str());
     LOG_INFO("服务器: %s", opcua_cfg.server_url.c_str());
     LOG_INFO("安全模式: %s", opcua_cfg.security_mode.c_str());
     LOG_INFO("激活协议: %s", active_protocol.c_str());
@@ -404,107 +308,346 @@ int main(int argc, char* argv[]) {
     }
     RingBuffer* ring = shm.get_ring();
     
+    // 独立的读游标: 与其他输出同时运行；断线缓存需要每个样本，在线时只写最新的一个
+    RingCursor cursor(ring);
+    
     // 状态变量
     bool is_connected = false;
-    bool protocol_active = (active_protocol == "opcua" && opcua_cfg.enabled);
+    bool client_active = false;
+    bool server_active = false;
+    auto update_active = [&]() {
+        client_active = output_active && opcua_cfg.mode != "server";
+        server_active = output_active && (opcua_cfg.mode == "server" || opcua_cfg.mode == "both");
+    };
+    update_active();
     NormalizedData last_data{};
     bool has_data = false;
-    auto last_reload = std::chrono::steady_clock::now();
-    auto last_connect_attempt = std::chrono::steady_clock::now();
-    std::filesystem::file_time_type last_mtime{};
     
     // 统计信息
     uint64_t total_writes = 0;
     uint64_t failed_writes = 0;
     auto stats_start = std::chrono::steady_clock::now();
     
+    // 死区过滤
+    DeadbandFilter filter;
+    filter.configure(opcua_cfg.deadband);
+    
+    // 数据节点: 加载配置时解析一次，连接后解析命名空间 URI
+    OpcuaNodeMap nodes;
+    auto load_nodes = [&]() {
+        if (!nodes.configure(opcua_cfg.nodes)) {
+            LOG_WARN("OPC UA 节点配置无效,使用默认节点");
+        }
+    };
+    load_nodes();
+    
+    // 异步写入: 在途请求窗口
+    OpcuaAsyncWriter writer;
+    writer.set_window(opcua_cfg.max_inflight);
+    OpcuaBackfill backfill;          // 在途的补发请求（对应缓存中最旧的若干样本）
+    
+    // 内嵌服务器: 只有服务器自身的配置变化时才重启（重启会断开所有订阅、清空历史）
+    OpcuaGatewayServer server;
+    std::string server_signature;
+    auto load_server = [&]() {
+        const std::string signature = server_active
+            ? std::to_string(opcua_cfg.server_port) + "|" + std::to_string(opcua_cfg.server_channels) + "|" +
+              std::to_string(opcua_cfg.server_history_size) + "|" + std::to_string(opcua_cfg.server_max_queue_size)
+            : std::string();
+        if (signature == server_signature && server.running() == server_active) {
+            return;
+        }
+        server_signature = signature;
+        server.stop();
+        if (server_active) {
+            OpcuaGatewayServer::Options options;
+            options.port = opcua_cfg.server_port;
+            options.channels = opcua_cfg.server_channels;
+            options.history_size = opcua_cfg.server_history_size;
+            options.max_queue_size = opcua_cfg.server_max_queue_size;
+            server.start(options);
+        }
+    };
+    load_server();
+    
+    // UADP 发布: 与客户端/服务器模式无关，只要求协议激活且 pubsub.enabled
+    UadpPublisher publisher;
+    auto load_publisher = [&]() {
+        publisher.close();
+        if (output_active && opcua_cfg.pubsub.enabled) {
+            UadpPublisher::Options options;
+            options.url = opcua_cfg.pubsub.url;
+            options.publisher_id = static_cast<uint16_t>(opcua_cfg.pubsub.publisher_id);
+            options.writer_group_id = static_cast<uint16_t>(opcua_cfg.pubsub.writer_group_id);
+            options.dataset_writer_id = static_cast<uint16_t>(opcua_cfg.pubsub.dataset_writer_id);
+            options.ttl = opcua_cfg.pubsub.ttl;
+            options.interface_ip = opcua_cfg.pubsub.interface_ip;
+            publisher.open(options);
+        }
+    };
+    load_publisher();
+    
+    // 断线缓存
+    Outbox outbox;
+    auto load_outbox = [&]() {
+        outbox.close();
+        if (opcua_cfg.outbox.enabled) {
+            outbox.open(static_cast<size_t>(opcua_cfg.outbox.capacity > 0 ? opcua_cfg.outbox.capacity : 1),
+                        opcua_cfg.outbox.path);
+            LOG_INFO("OPC UA outbox: 容量 %zu, 已缓存 %zu", outbox.capacity(), outbox.size());
+        }
+    };
+    load_outbox();
+    
+    // 后台连接线程: 主循环不再阻塞在 UA_Client_connect() 上（超时 5 秒）
+    ConnectWorker connector;
+    auto start_connector = [&]() {
+        connector.stop();
+        if (!client_active) {
+            return;
+        }
+        ConnectWorker::Options options;
+        if (!opcua_parse_endpoint(opcua_cfg.server_url, options.host, options.port)) {
+            options.port = 0;  // 无法识别时不做预探测
+        }
+        options.probe_timeout_ms = opcua_cfg.reconnect.probe_timeout_ms;
+        options.initial_backoff_ms = opcua_cfg.reconnect.initial_backoff_ms;
+        options.max_backoff_ms = opcua_cfg.reconnect.max_backoff_ms;
+        const std::string url = opcua_cfg.server_url;
+        const std::string username = opcua_cfg.username;
+        const std::string password = opcua_cfg.password;
+        LOG_INFO("开始连接 OPC UA 服务器: %s ...", url.c_str());
+        connector.start(options, [url, username, password]() {
+            return opcua_connect(url, username, password);
+        });
+    };
+    
+    // 连接断开: 关闭会话，交给后台线程重连
+    // （断开时 open62541 取消在途请求，失败结果仍进入 writer 的完成队列）
+    auto drop_connection = [&]() {
+        LOG_WARN("OPC UA 连接断开,将尝试重连");
+        opcua_disconnect();
+        is_connected = false;
+        nodes.invalidate();
+        connector.connection_lost();
+    };
+    
+    // 处理已完成的写入请求（按发送顺序）
+    auto drain_completions = [&]() {
+        OpcuaAsyncWriter::Completion done;
+        while (writer.poll(done)) {
+            if (done.kind == OpcuaAsyncWriter::BACKFILL) {
+                if (backfill.complete(done.ok)) {
+                    outbox.pop();
+                    if (outbox.empty()) {
+                        LOG_INFO("OPC UA outbox 补发完成");
+                    }
+                } else if (!done.ok) {
+                    // 缓存中从失败的样本起保留，在途请求全部完成后从它重新补发
+                    // （其后已成功的可能重复写入）
+                    failed_writes++;
+                }
+            } else if (done.ok) {
+                // 写入成功后才成为死区的确认基准
+                filter.confirm(done.data, done.data.timestamp_ns);
+                LOG_DEBUG("OPC UA 写入成功: thickness=%.3f mm, seq=%u, %llu us",
+                         done.data.thickness_mm, done.data.sequence,
+                         static_cast<unsigned long long>(done.latency_us));
+            } else {
+                LOG_WARN("OPC UA 写入失败: seq=%u (%s)", done.data.sequence, UA_StatusCode_name(done.status));
+                failed_writes++;
+                // 失败的样本不作为死区基准，之后的样本与上次成功写入的值比较
+                filter.revert();
+                // 断线导致的失败: 样本进入断线缓存，恢复后补发
+                if (!is_connected || !opcua_is_connected()) {
+                    if (outbox.is_open()) {
+                        outbox.push(done.data);
+                    }
+                }
+            }
+            if (!done.ok && is_connected && !opcua_is_connected()) {
+                drop_connection();
+            }
+        }
+    };
+    
+    // 状态表: 热字段（连接状态、最新样本、读游标）每个周期更新；
+    // 详情 JSON 连接状态变化时立即写，其余每秒写一次
+    auto last_status_write = std::chrono::steady_clock::now();
+    bool status_connected = is_connected;
+    auto update_status = [&](bool connected) {
+        // 仅服务器模式时，"已连接"表示服务器正在监听
+        const bool online = (server_active && !client_active) ? server.running() : connected;
+        StatusWriter::update(StatusComponent::OPCUA, has_data ? &last_data : nullptr, online, online, &cursor);
+        return online;
+    };
+    auto report_status = [&](bool connected) {
+        const bool online = update_status(connected);
+        write_status(online, opcua_cfg, active_protocol, filter, outbox,
+                     connector.stats(), server.stats(), publisher.stats());
+        last_status_write = std::chrono::steady_clock::now();
+    };
+    
     // 写入初始状态
-    write_status(nullptr, is_connected, opcua_cfg, active_protocol);
+    report_status(is_connected);
+    start_connector();
+    
+    // 配置热重载: OPC UA 配置或激活状态变化时重新连接
+    ConfigWatcher watcher(config_path);
+    watcher.on_change(ConfigWatcher::OPCUA | ConfigWatcher::ACTIVE, [&](const ConfigManager::Snapshot& cfg) {
+        LOG_INFO("配置已更新,重新连接...");
+        
+        // 停止连接线程并断开旧连接（线程可能刚连上、尚未被接管）
+        connector.stop();
+        opcua_disconnect();
+        is_connected = false;
+        writer.reset();
+        backfill.reset();
+        
+        // 更新配置
+        opcua_cfg = cfg.opcua;
+        active_protocol = cfg.active_protocol;
+        output_active = cfg.opcua_active;
+        update_active();
+        filter.configure(opcua_cfg.deadband);
+        writer.set_window(opcua_cfg.max_inflight);
+        load_nodes();
+        load_outbox();
+        load_server();
+        load_publisher();
+        start_connector();
+        
+        LOG_INFO("新配置: active=%s, enabled=%s, mode=%s, url=%s",
+                active_protocol.c_str(),
+                opcua_cfg.enabled ? "true" : "false",
+                opcua_cfg.mode.c_str(),
+                opcua_cfg.server_url.c_str());
+        
+        report_status(is_connected);
+    });
+    watcher.on_change(ConfigWatcher::STATUS_FILE, [](const ConfigManager::Snapshot& cfg) {
+        StatusWriter::configure_files(cfg.status_file);
+    });
+    watcher.start();
     
     // 主循环
     while (g_running) {
         auto now = std::chrono::steady_clock::now();
         
         // ====================================================================
-        // 1. 配置热重载 (每1秒检查一次)
+        // 1. 配置热重载 (文件变化时由 watcher 重载，这里只分发)
         // ====================================================================
-        if (now - last_reload > 1s) {
-            std::error_code ec;
-            auto current_mtime = std::filesystem::last_write_time(config_path, ec);
-            if (!ec && current_mtime != last_mtime) {
-                last_mtime = current_mtime;
-                if (config.load(config_path)) {
-                    auto new_cfg = config.get_opcua_config();
-                    auto new_active_protocol = config.get_string("protocol.active", "modbus");
-                    auto new_signature = make_signature(new_cfg, new_active_protocol);
-                    
-                    if (new_signature != config_signature) {
-                        LOG_INFO("配置已更新,重新连接...");
-                        
-                        // 断开旧连接
-                        if (is_connected) {
-                            opcua_disconnect();
-                            is_connected = false;
-                        }
-                        
-                        // 更新配置
-                        opcua_cfg = new_cfg;
-                        active_protocol = new_active_protocol;
-                        protocol_active = (active_protocol == "opcua" && opcua_cfg.enabled);
-                        config_signature = new_signature;
-                        
-                        LOG_INFO("新配置: active=%s, enabled=%s, url=%s",
-                                active_protocol.c_str(),
-                                opcua_cfg.enabled ? "true" : "false",
-                                opcua_cfg.server_url.c_str());
-                        
-                        write_status(has_data ? &last_data : nullptr, is_connected, opcua_cfg, active_protocol);
-                    }
-                }
-            }
-            last_reload = now;
-        }
+        watcher.dispatch();
         
         // ====================================================================
-        // 2. 连接管理 (每5秒尝试一次重连)
+        // 2. 连接管理 (后台线程连接成功后在这里接管客户端)
         // ====================================================================
-        if (protocol_active && !is_connected) {
-            if (now - last_connect_attempt > 5s) {
-                LOG_INFO("尝试连接 OPC UA 服务器: %s ...", opcua_cfg.server_url.c_str());
-                is_connected = opcua_connect(opcua_cfg.server_url,
-                                            opcua_cfg.username,
-                                            opcua_cfg.password);
-                last_connect_attempt = now;
-                write_status(has_data ? &last_data : nullptr, is_connected, opcua_cfg, active_protocol);
+        if (client_active && !is_connected && connector.take_connected()) {
+            is_connected = true;
+            // 命名空间索引以服务器当前的命名空间数组为准
+            if (nodes.resolve(g_opcua_client)) {
+                // 服务器中的值可能已过期，重连后第一个样本一定写入
+                filter.reset();
+            } else {
+                // 服务器地址空间尚未就绪（或配置错误）: 断开，按退避间隔重试
+                drop_connection();
             }
+            report_status(is_connected);
         }
         
         // ====================================================================
         // 3. 数据读取和写入
         // ====================================================================
         if (ring) {
+            // 断开时被取消的请求先转入断线缓存，排在本周期新样本之前（缓存按序列号有序）
+            if (!is_connected) {
+                drain_completions();
+            }
+            
             NormalizedData data;
-            if (ring->pop_latest(data)) {
+            bool has_new = false;
+            while (cursor.next(data)) {
                 // 验证CRC
-                if (ndm_verify_crc(data)) {
-                    last_data = data;
-                    has_data = true;
-                    
-                    // 如果OPC UA已激活且已连接,写入数据
-                    if (protocol_active && is_connected) {
-                        bool write_ok = opcua_write_data(data);
-                        total_writes++;
-                        if (!write_ok) {
-                            failed_writes++;
-                            // 写入失败可能是连接断开
-                            if (!opcua_is_connected()) {
-                                LOG_WARN("OPC UA 连接断开,将尝试重连");
-                                is_connected = false;
-                            }
+                if (!ndm_verify_crc(data)) {
+                    continue;
+                }
+                last_data = data;
+                has_data = true;
+                has_new = true;
+                
+                // 内嵌服务器: 每个样本都更新地址空间（带采集时间）
+                server.update(data);
+                
+                // UADP: 每个样本一个报文，不经过死区过滤
+                publisher.publish(data);
+                
+                // 断线中或仍有积压: 每个样本按顺序进入断线缓存
+                if (outbox.is_open() && client_active && (!is_connected || !outbox.empty())) {
+                    outbox.push(data);
+                }
+            }
+            
+            // 接收应答（不阻塞）: 回调把结果放入完成队列
+            if (client_active && is_connected) {
+                UA_StatusCode state = UA_Client_run_iterate(g_opcua_client, 0);
+                drain_completions();
+                if (is_connected && state != UA_STATUSCODE_GOOD) {
+                    drop_connection();
+                    drain_completions();
+                }
+            }
+            
+            // 积压补发: 最旧的先发，每周期最多发起 backfill_per_cycle 个，
+            // 应答成功后才从缓存中移除
+            if (client_active && is_connected && !outbox.empty()) {
+                NormalizedData backlog;
+                uint64_t wall_ns = 0;
+                size_t index = 0;
+                int sent = 0;
+                while (sent < opcua_cfg.outbox.backfill_per_cycle && !writer.full() &&
+                       backfill.next(index) && outbox.at(index, backlog, &wall_ns)) {
+                    // 缓存中保存的是墙上时间，重启前采集的样本同样带原始时间
+                    const UA_DateTime source_time = OpcuaGatewayServer::wall_time(wall_ns);
+                    total_writes++;
+                    UA_StatusCode result = writer.send(g_opcua_client, nodes, backlog,
+                                                       OpcuaAsyncWriter::BACKFILL, &source_time);
+                    if (result != UA_STATUSCODE_GOOD) {
+                        failed_writes++;
+                        if (!opcua_is_connected()) {
+                            drop_connection();
+                            drain_completions();
+                        }
+                        break;
+                    }
+                    backfill.sent();
+                    sent++;
+                }
+                has_new = false;  // 最新样本已在缓存中按顺序发送
+            }
+            
+            // 如果OPC UA已激活且已连接,写入通过死区过滤的最新数据
+            // （窗口已满时跳过本样本，死区心跳保证之后仍会写入）
+            if (has_new && outbox.empty() && client_active && is_connected && !writer.full() &&
+                filter.should_publish(last_data, last_data.timestamp_ns)) {
+                total_writes++;
+                UA_StatusCode result = writer.send(g_opcua_client, nodes, last_data,
+                                                   OpcuaAsyncWriter::LATEST, nullptr);
+                if (result != UA_STATUSCODE_GOOD) {
+                    LOG_WARN("OPC UA 写入失败: seq=%u (%s)", last_data.sequence, UA_StatusCode_name(result));
+                    failed_writes++;
+                    filter.revert();
+                    // 发送失败可能是连接断开
+                    if (!opcua_is_connected()) {
+                        drop_connection();
+                        drain_completions();
+                        // 未写入的样本作为积压的最后一条
+                        if (outbox.is_open()) {
+                            outbox.push(last_data);
                         }
                     }
                 }
             }
+            outbox.sync();
         }
         
         // ====================================================================
@@ -512,12 +655,15 @@ int main(int argc, char* argv[]) {
         // ====================================================================
         auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - stats_start).count();
         if (elapsed >= 10) {
-            if (protocol_active && total_writes > 0) {
+            if (client_active && total_writes > 0) {
                 double error_rate = (double)failed_writes / total_writes * 100.0;
-                LOG_INFO("OPC UA 统计: 总写入=%llu, 失败=%llu, 失败率=%.2f%%",
+                LOG_INFO("OPC UA 统计: 总写入=%llu, 失败=%llu, 失败率=%.2f%%, 死区抑制(累计)=%llu, 在途=%d, 往返=%llu us",
                         static_cast<unsigned long long>(total_writes),
                         static_cast<unsigned long long>(failed_writes),
-                        error_rate);
+                        error_rate,
+                        static_cast<unsigned long long>(filter.suppressed()),
+                        writer.in_flight(),
+                        static_cast<unsigned long long>(writer.last_latency_us()));
             }
             stats_start = now;
             total_writes = 0;
@@ -525,12 +671,29 @@ int main(int argc, char* argv[]) {
         }
         
         // ====================================================================
-        // 5. 周期性状态更新
+        // 5. 状态更新 (热字段每个周期; 详情每1秒, 连接断开时立即更新)
         // ====================================================================
-        write_status(has_data ? &last_data : nullptr, is_connected, opcua_cfg, active_protocol);
+        if (is_connected != status_connected || now - last_status_write >= 1s) {
+            report_status(is_connected);
+            status_connected = is_connected;
+        } else {
+            update_status(is_connected);
+        }
         
-        // 休眠50ms
-        std::this_thread::sleep_for(50ms);
+        // 等待新样本，最长 50ms（内嵌服务器按其下一次处理时间、
+        // 有在途写入时按 1ms 提前唤醒以及时接收应答）
+        std::chrono::milliseconds wait = 50ms;
+        if (server.running()) {
+            wait = std::min(wait, std::chrono::milliseconds(server.iterate()));
+        }
+        if (writer.in_flight() > 0) {
+            wait = std::min(wait, 1ms);
+        }
+        if (ring) {
+            cursor.wait(static_cast<int>(wait.count()));
+        } else {
+            std::this_thread::sleep_for(wait);
+        }
     }
     
     // ========================================================================
@@ -539,10 +702,17 @@ int main(int argc, char* argv[]) {
     
     LOG_INFO("OPC UA 守护进程正在退出...");
     
-    // 断开连接
+    // 未补发的样本留在文件中，下次启动继续
+    outbox.close();
+    server.stop();
+    publisher.close();
+    
+    // 停止连接线程后断开连接（在途请求随之取消）
+    connector.stop();
     if (is_connected) {
         opcua_disconnect();
     }
+    writer.reset();
     
     // 销毁客户端
     if (g_opcua_client) {
@@ -551,8 +721,23 @@ int main(int argc, char* argv[]) {
     }
     
     // 写入最终状态
-    write_status(has_data ? &last_data : nullptr, false, opcua_cfg, active_protocol);
+    report_status(false);
     
     LOG_INFO("OPC UA 守护进程已退出");
     return 0;
 }
+
+/**
+ * @brief 请求退出（gatewayd 收到信号时调用）
+ */
+void stop() {
+    g_running = false;
+}
+
+}  // namespace opcuad
+
+#ifndef GATEWAY_HOSTED
+int main(int argc, char* argv[]) {
+    return opcuad::run(argc, argv);
+}
+#endif
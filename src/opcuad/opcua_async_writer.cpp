@@ -0,0 +1,153 @@
+#include "opcua_async_writer.h"
+
+#include "../common/logger.h"
+
+#include <cstring>
+
+void OpcuaAsyncWriter::set_window(int window) {
+    if (window < 1) {
+        window = 1;
+    } else if (window > MAX_WINDOW) {
+        window = MAX_WINDOW;
+    }
+    window_ = window;
+}
+
+UA_StatusCode OpcuaAsyncWriter::send(UA_Client* client, const OpcuaNodeMap& nodes, const NormalizedData& data,
+                                     Kind kind, const UA_DateTime* source_time) {
+    if (!client || !nodes.ready()) {
+        return UA_STATUSCODE_BADNOTCONNECTED;
+    }
+    if (full()) {
+        return UA_STATUSCODE_BADTOOMANYOPERATIONS;
+    }
+
+    int index = 0;
+    while (slots_[index].used) {
+        index++;
+    }
+    Slot& slot = slots_[index];
+
+    UA_Float thickness = data.thickness_mm;
+    UA_Int64 timestamp_ms = static_cast<UA_Int64>(data.timestamp_ns / 1000000ULL);
+    UA_UInt16 status = data.status;
+    UA_UInt32 sequence = data.sequence;
+
+    const struct {
+        void* value;
+        const UA_DataType* type;
+    } items[OpcuaNodeMap::FIELD_COUNT] = {
+        {&thickness, &UA_TYPES[UA_TYPES_FLOAT]},
+        {&timestamp_ms, &UA_TYPES[UA_TYPES_INT64]},
+        {&status, &UA_TYPES[UA_TYPES_UINT16]},
+        {&sequence, &UA_TYPES[UA_TYPES_UINT32]},
+    };
+
+    // 浅复制模板: 节点 ID 的字符串仍由 OpcuaNodeMap 持有
+    UA_WriteValue values[OpcuaNodeMap::FIELD_COUNT];
+    std::memcpy(values, nodes.templates(), sizeof(values));
+    for (size_t i = 0; i < OpcuaNodeMap::FIELD_COUNT; ++i) {
+        UA_Variant_setScalar(&values[i].value.value, items[i].value, items[i].type);
+        values[i].value.hasValue = true;
+        if (source_time) {
+            values[i].value.sourceTimestamp = *source_time;
+            values[i].value.hasSourceTimestamp = true;
+        }
+    }
+
+    UA_WriteRequest request;
+    UA_WriteRequest_init(&request);
+    request.nodesToWrite = values;
+    request.nodesToWriteSize = OpcuaNodeMap::FIELD_COUNT;
+
+    slot.owner = this;
+    slot.used = true;
+    slot.done = false;
+    slot.request_id = 0;
+    slot.started_ns = get_timestamp_ns();
+    slot.completion = Completion();
+    slot.completion.kind = kind;
+    slot.completion.data = data;
+    nodes_ = &nodes;
+
+    // 请求在发送时完成编码，返回后栈上的 values 不再被引用
+    UA_UInt32 request_id = 0;
+    UA_StatusCode result = UA_Client_sendAsyncRequest(client, &request, &UA_TYPES[UA_TYPES_WRITEREQUEST],
+                                                      &OpcuaAsyncWriter::on_response,
+                                                      &UA_TYPES[UA_TYPES_WRITERESPONSE], &slot, &request_id);
+    if (result != UA_STATUSCODE_GOOD) {
+        slot.used = false;
+        return result;
+    }
+    slot.request_id = request_id;
+    order_[(order_head_ + used_) % MAX_WINDOW] = index;
+    used_++;
+    return UA_STATUSCODE_GOOD;
+}
+
+void OpcuaAsyncWriter::on_response(UA_Client* /*client*/, void* userdata, UA_UInt32 request_id, void* response) {
+    Slot* slot = static_cast<Slot*>(userdata);
+    // reset() 之后到达的应答（槽位已复用或已释放）直接丢弃
+    if (!slot || !slot->owner || !slot->used || slot->done ||
+        (slot->request_id != 0 && slot->request_id != request_id)) {
+        return;
+    }
+    slot->owner->complete(*slot, static_cast<const UA_WriteResponse*>(response));
+}
+
+void OpcuaAsyncWriter::complete(Slot& slot, const UA_WriteResponse* response) {
+    Completion& c = slot.completion;
+    c.latency_us = (get_timestamp_ns() - slot.started_ns) / 1000ULL;
+    last_latency_us_ = c.latency_us;
+    slot.done = true;
+
+    // 断开连接时 open62541 以 BadShutdown 等状态取消在途请求
+    c.status = response ? response->responseHeader.serviceResult : UA_STATUSCODE_BADCONNECTIONCLOSED;
+    if (c.status != UA_STATUSCODE_GOOD) {
+        LOG_DEBUG("OPC UA 写入请求失败: %s", UA_StatusCode_name(c.status));
+        return;
+    }
+    if (response->resultsSize != OpcuaNodeMap::FIELD_COUNT) {
+        LOG_DEBUG("OPC UA 写入应答结果数不符: %zu", response->resultsSize);
+        c.status = UA_STATUSCODE_BADUNEXPECTEDERROR;
+        return;
+    }
+    for (size_t i = 0; i < response->resultsSize; ++i) {
+        if (response->results[i] != UA_STATUSCODE_GOOD) {
+            LOG_DEBUG("OPC UA 写入失败 [%s]: %s",
+                     nodes_ ? nodes_->text(static_cast<int>(i)).c_str() : "?",
+                     UA_StatusCode_name(response->results[i]));
+            if (c.status == UA_STATUSCODE_GOOD) {
+                c.status = response->results[i];
+            }
+        }
+    }
+    c.ok = (c.status == UA_STATUSCODE_GOOD);
+}
+
+bool OpcuaAsyncWriter::poll(Completion& completion) {
+    if (used_ == 0) {
+        return false;
+    }
+    // 只取最早发出的请求，保证补发结果按缓存顺序处理
+    Slot& slot = slots_[order_[order_head_]];
+    if (!slot.done) {
+        return false;
+    }
+    completion = slot.completion;
+    slot.used = false;
+    slot.done = false;
+    order_head_ = (order_head_ + 1) % MAX_WINDOW;
+    used_--;
+    return true;
+}
+
+void OpcuaAsyncWriter::reset() {
+    for (Slot& slot : slots_) {
+        slot.used = false;
+        slot.done = false;
+        slot.request_id = 0;
+    }
+    order_head_ = 0;
+    used_ = 0;
+}
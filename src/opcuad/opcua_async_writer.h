@@ -0,0 +1,125 @@
+/**
+ * @file opcua_async_writer.h
+ * @brief OPC UA 异步写入（多个在途 Write 请求）
+ *
+ * 同步写入 (UA_Client_Service_write) 时主循环阻塞在一次往返上，
+ * 发布速率上限为 1/RTT，超时时最多阻塞 5 秒。异步模式下每个样本的
+ * Write 请求用 UA_Client_sendAsyncRequest() 发出后立即返回，
+ * 应答由主循环中的 UA_Client_run_iterate() 接收并回调:
+ * - 最多 window 个请求同时在途，窗口满时调用方不再发起新请求
+ * - 应答（或超时、断线取消）按请求顺序进入完成队列，主循环用 poll() 取出
+ * - 每个在途请求保留样本副本，失败时调用方可转入断线缓存
+ *
+ * 请求在发送时已完成编码，WriteValue 仍从 OpcuaNodeMap 的模板复制，
+ * 值指向栈上数据，不做堆分配。槽位在完成结果被 poll() 取走后才释放。
+ *
+ * @author Gateway Project
+ * @date 2025-10-29
+ */
+
+#ifndef GATEWAY_OPCUA_ASYNC_WRITER_H
+#define GATEWAY_OPCUA_ASYNC_WRITER_H
+
+#include "opcua_node_map.h"
+#include "../common/ndm.h"
+
+#include <cstddef>
+#include <cstdint>
+
+extern "C" {
+    #include <open62541/client.h>
+}
+
+/**
+ * @class OpcuaAsyncWriter
+ * @brief 有界窗口的异步样本写入
+ */
+class OpcuaAsyncWriter {
+public:
+    static constexpr int MAX_WINDOW = 32;     ///< 在途请求数上限
+    static constexpr int DEFAULT_WINDOW = 8;
+
+    /// @brief 请求类型（决定完成后的处理方式）
+    enum Kind : uint8_t {
+        LATEST = 0,     ///< 实时样本（经过死区过滤）
+        BACKFILL = 1,   ///< 断线缓存补发（带源时间戳）
+    };
+
+    /// @brief 一个已完成的请求
+    struct Completion {
+        Kind kind = LATEST;
+        bool ok = false;                          ///< 全部节点写入成功
+        UA_StatusCode status = UA_STATUSCODE_GOOD; ///< 服务结果；节点被拒绝时为第一个节点的错误
+        uint64_t latency_us = 0;                  ///< 发送到完成的时间
+        NormalizedData data{};                    ///< 请求中的样本
+    };
+
+    OpcuaAsyncWriter() = default;
+
+    OpcuaAsyncWriter(const OpcuaAsyncWriter&) = delete;
+    OpcuaAsyncWriter& operator=(const OpcuaAsyncWriter&) = delete;
+
+    /**
+     * @brief 设置在途请求窗口（1..MAX_WINDOW）
+     */
+    void set_window(int window);
+
+    int window() const { return window_; }
+
+    /// @brief 占用的槽位数（在途 + 已完成未取走）
+    int in_flight() const { return used_; }
+
+    /// @brief 窗口已满，不能再发起请求
+    bool full() const { return used_ >= window_; }
+
+    /**
+     * @brief 发起一个样本的 Write 请求（不阻塞）
+     *
+     * @param client 已连接的客户端
+     * @param nodes 数据节点（须已解析）
+     * @param data 样本
+     * @param kind 请求类型
+     * @param source_time 样本采集时间（nullptr=不带 SourceTimestamp）
+     * @return UA_StatusCode GOOD=已发出；窗口已满时为 BADTOOMANYOPERATIONS，
+     *         否则为发送失败的状态码（不产生完成结果）
+     */
+    UA_StatusCode send(UA_Client* client, const OpcuaNodeMap& nodes, const NormalizedData& data,
+                       Kind kind, const UA_DateTime* source_time);
+
+    /**
+     * @brief 取出一个已完成的请求（按发送顺序）
+     * @return bool false=没有已完成的请求
+     */
+    bool poll(Completion& completion);
+
+    /**
+     * @brief 放弃全部在途请求和未取走的结果（客户端断开后调用）
+     */
+    void reset();
+
+    /// @brief 最近一次完成的请求的往返时间（微秒）
+    uint64_t last_latency_us() const { return last_latency_us_; }
+
+private:
+    struct Slot {
+        OpcuaAsyncWriter* owner = nullptr;
+        bool used = false;
+        bool done = false;
+        UA_UInt32 request_id = 0;
+        uint64_t started_ns = 0;
+        Completion completion;
+    };
+
+    static void on_response(UA_Client* client, void* userdata, UA_UInt32 request_id, void* response);
+    void complete(Slot& slot, const UA_WriteResponse* response);
+
+    Slot slots_[MAX_WINDOW];
+    int order_[MAX_WINDOW] = {};   ///< 按发送顺序排列的槽位号（环形）
+    int order_head_ = 0;
+    int used_ = 0;
+    int window_ = DEFAULT_WINDOW;
+    const OpcuaNodeMap* nodes_ = nullptr;
+    uint64_t last_latency_us_ = 0;
+};
+
+#endif // GATEWAY_OPCUA_ASYNC_WRITER_H
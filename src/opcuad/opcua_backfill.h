@@ -0,0 +1,77 @@
+/**
+ * @file opcua_backfill.h
+ * @brief OPC UA 断线缓存补发的在途窗口
+ *
+ * 补发请求按缓存顺序发出，在途的 N 个请求总是缓存中最旧的 N 个样本；
+ * 应答按发送顺序到达，成功时从缓存头部出队。
+ *
+ * 某个请求失败后缓存头部就是这个失败的样本，其后在途请求的位置不再
+ * 与缓存对应:
+ * - 本轮其后的应答不再出队（成功的样本下一轮会重复写入）
+ * - 不再发起新的补发，等在途请求全部完成后从缓存头部（失败的样本）重新开始
+ *
+ * @author Gateway Project
+ * @date 2025-11-03
+ */
+
+#ifndef GATEWAY_OPCUA_BACKFILL_H
+#define GATEWAY_OPCUA_BACKFILL_H
+
+#include <cstddef>
+
+/**
+ * @class OpcuaBackfill
+ * @brief 补发请求与缓存位置的对应关系
+ */
+class OpcuaBackfill {
+public:
+    /**
+     * @brief 下一个补发样本在缓存中的位置
+     * @return bool false=本轮有失败，等在途请求全部完成后再发
+     */
+    bool next(size_t& index) const {
+        if (failed_) {
+            return false;
+        }
+        index = static_cast<size_t>(in_flight_);
+        return true;
+    }
+
+    /// @brief 已发出 next() 给出的样本
+    void sent() { in_flight_++; }
+
+    /**
+     * @brief 一个补发请求完成（按发送顺序调用）
+     * @return bool true=该样本已写入，应从缓存中出队
+     */
+    bool complete(bool ok) {
+        if (in_flight_ > 0) {
+            in_flight_--;
+        }
+        const bool pop = ok && !failed_;
+        if (!ok) {
+            failed_ = true;
+        }
+        if (in_flight_ == 0) {
+            failed_ = false;
+        }
+        return pop;
+    }
+
+    /// @brief 放弃全部在途请求（与 OpcuaAsyncWriter::reset() 一起调用）
+    void reset() {
+        in_flight_ = 0;
+        failed_ = false;
+    }
+
+    int in_flight() const { return in_flight_; }
+
+    /// @brief 本轮有失败，正在等待在途请求完成
+    bool failed() const { return failed_; }
+
+private:
+    int in_flight_ = 0;
+    bool failed_ = false;
+};
+
+#endif // GATEWAY_OPCUA_BACKFILL_H
@@ -0,0 +1,206 @@
+#include "opcua_node_map.h"
+
+#include "../common/logger.h"
+
+#include <cstdlib>
+#include <cstring>
+
+extern "C" {
+    #include <open62541/client_highlevel.h>
+}
+
+namespace {
+const char* const DEFAULT_NODES[OpcuaNodeMap::FIELD_COUNT] = {
+    "ns=2;s=Gateway.Thickness",
+    "ns=2;s=Gateway.Timestamp",
+    "ns=2;s=Gateway.Status",
+    "ns=2;s=Gateway.Sequence",
+};
+
+/// @brief 解析不带符号的十进制整数（全部字符都必须是数字）
+bool parse_uint(const std::string& text, unsigned long max, unsigned long& value) {
+    if (text.empty() || text.size() > 10) {
+        return false;
+    }
+    value = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        value = value * 10 + static_cast<unsigned long>(c - '0');
+    }
+    return value <= max;
+}
+
+/// @brief 解析 N 个十六进制字符
+bool parse_hex(const char* text, int digits, uint32_t& value) {
+    value = 0;
+    for (int i = 0; i < digits; ++i) {
+        char c = text[i];
+        int v;
+        if (c >= '0' && c <= '9') v = c - '0';
+        else if (c >= 'a' && c <= 'f') v = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F') v = c - 'A' + 10;
+        else return false;
+        value = (value << 4) | static_cast<uint32_t>(v);
+    }
+    return true;
+}
+
+/// @brief 解析 "xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx"
+bool parse_guid(const std::string& text, UA_Guid& guid) {
+    if (text.size() != 36 || text[8] != '-' || text[13] != '-' || text[18] != '-' || text[23] != '-') {
+        return false;
+    }
+    const char* p = text.c_str();
+    uint32_t v = 0;
+    if (!parse_hex(p, 8, v)) return false;
+    guid.data1 = v;
+    if (!parse_hex(p + 9, 4, v)) return false;
+    guid.data2 = static_cast<UA_UInt16>(v);
+    if (!parse_hex(p + 14, 4, v)) return false;
+    guid.data3 = static_cast<UA_UInt16>(v);
+    // data4: 2 字节 + 6 字节
+    static const int offsets[8] = {19, 21, 24, 26, 28, 30, 32, 34};
+    for (int i = 0; i < 8; ++i) {
+        if (!parse_hex(p + offsets[i], 2, v)) return false;
+        guid.data4[i] = static_cast<UA_Byte>(v);
+    }
+    return true;
+}
+}  // namespace
+
+OpcuaNodeMap::OpcuaNodeMap() {
+    for (auto& value : templates_) {
+        UA_WriteValue_init(&value);
+    }
+}
+
+bool OpcuaNodeMap::parse(const std::string& text, ParsedId& out) {
+    out = ParsedId{};
+    std::string rest = text;
+    
+    // 命名空间: "ns=<索引>;" 或 "nsu=<URI>;"，省略时为 0
+    if (rest.compare(0, 3, "ns=") == 0 || rest.compare(0, 4, "nsu=") == 0) {
+        const size_t semi = rest.find(';');
+        if (semi == std::string::npos) {
+            return false;
+        }
+        if (rest[2] == 'u') {
+            out.ns_uri = rest.substr(4, semi - 4);
+            if (out.ns_uri.empty()) {
+                return false;
+            }
+        } else {
+            unsigned long ns = 0;
+            if (!parse_uint(rest.substr(3, semi - 3), 0xFFFF, ns)) {
+                return false;
+            }
+            out.ns = static_cast<UA_UInt16>(ns);
+        }
+        rest = rest.substr(semi + 1);
+    }
+    
+    // 标识符: "i=" / "s=" / "g="
+    if (rest.size() < 3 || rest[1] != '=') {
+        return false;
+    }
+    out.type = rest[0];
+    const std::string id = rest.substr(2);
+    switch (out.type) {
+        case 'i': {
+            unsigned long numeric = 0;
+            if (!parse_uint(id, 0xFFFFFFFFUL, numeric)) {
+                return false;
+            }
+            out.numeric = static_cast<UA_UInt32>(numeric);
+            return true;
+        }
+        case 's':
+            out.text = id;
+            return true;
+        case 'g':
+            return parse_guid(id, out.guid);
+        default:
+            return false;
+    }
+}
+
+bool OpcuaNodeMap::configure(const ConfigManager::OPCUAConfig::Nodes& nodes) {
+    const std::string configured[FIELD_COUNT] = {nodes.thickness, nodes.timestamp, nodes.status, nodes.sequence};
+    
+    bool valid = true;
+    for (int i = 0; i < FIELD_COUNT; ++i) {
+        if (!parse(configured[i], ids_[i])) {
+            LOG_ERROR("OPC UA 节点 ID 无效: '%s'", configured[i].c_str());
+            valid = false;
+        }
+    }
+    
+    for (int i = 0; i < FIELD_COUNT; ++i) {
+        texts_[i] = valid ? configured[i] : DEFAULT_NODES[i];
+        if (!valid) {
+            parse(texts_[i], ids_[i]);
+        }
+    }
+    
+    needs_namespace_ = false;
+    for (const auto& id : ids_) {
+        if (!id.ns_uri.empty()) {
+            needs_namespace_ = true;
+        }
+    }
+    
+    // 不依赖服务器的 ID 立即构造模板
+    build_templates();
+    ready_ = !needs_namespace_;
+    return valid;
+}
+
+bool OpcuaNodeMap::resolve(UA_Client* client) {
+    if (!needs_namespace_) {
+        return true;
+    }
+    
+    ready_ = false;
+    for (int i = 0; i < FIELD_COUNT; ++i) {
+        ParsedId& id = ids_[i];
+        if (id.ns_uri.empty()) {
+            continue;
+        }
+        UA_String uri = UA_STRING(const_cast<char*>(id.ns_uri.c_str()));
+        UA_UInt16 index = 0;
+        UA_StatusCode retval = UA_Client_NamespaceGetIndex(client, &uri, &index);
+        if (retval != UA_STATUSCODE_GOOD) {
+            LOG_ERROR("OPC UA 服务器没有命名空间 '%s' (%s)", id.ns_uri.c_str(), UA_StatusCode_name(retval));
+            return false;
+        }
+        id.ns = index;
+        LOG_INFO("OPC UA 命名空间 '%s' -> ns=%u", id.ns_uri.c_str(), static_cast<unsigned>(index));
+    }
+    
+    build_templates();
+    ready_ = true;
+    return true;
+}
+
+void OpcuaNodeMap::build_templates() {
+    for (int i = 0; i < FIELD_COUNT; ++i) {
+        const ParsedId& id = ids_[i];
+        UA_WriteValue& value = templates_[i];
+        UA_WriteValue_init(&value);
+        value.attributeId = UA_ATTRIBUTEID_VALUE;
+        switch (id.type) {
+            case 'i':
+                value.nodeId = UA_NODEID_NUMERIC(id.ns, id.numeric);
+                break;
+            case 'g':
+                value.nodeId = UA_NODEID_GUID(id.ns, id.guid);
+                break;
+            default:
+                // 引用 ids_[i].text 的缓冲区，不复制
+                value.nodeId = UA_NODEID_STRING(id.ns, const_cast<char*>(id.text.c_str()));
+                break;
+        }
+    }
+}
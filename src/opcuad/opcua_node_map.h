@@ -0,0 +1,111 @@
+/**
+ * @file opcua_node_map.h
+ * @brief 预解析的 OPC UA 数据节点
+ *
+ * 数据节点 ID 在加载配置时解析一次，支持 OPC UA 标准的字符串格式:
+ * - ns=2;s=Gateway.Thickness                       字符串 ID
+ * - ns=3;i=1001                                    数值 ID
+ * - ns=2;g=09087e75-8e5e-499b-954f-f2a9603db28a    GUID
+ * - nsu=http://example.com/line1;s=Thickness       命名空间 URI（连接后按服务器命名空间数组解析为索引）
+ * - i=2258                                         省略 ns 时为命名空间 0
+ *
+ * 每个节点预先构造一个 UA_WriteValue 模板（NodeId + AttributeId）；字符串 ID
+ * 直接引用本类持有的字符串，写入时只需在栈上复制模板并填入值，不做堆分配。
+ *
+ * @author Gateway Project
+ * @date 2025-10-28
+ */
+
+#ifndef GATEWAY_OPCUA_NODE_MAP_H
+#define GATEWAY_OPCUA_NODE_MAP_H
+
+#include "../common/config.h"
+
+#include <cstddef>
+#include <string>
+
+extern "C" {
+    #include <open62541/client.h>
+}
+
+/**
+ * @class OpcuaNodeMap
+ * @brief 厚度/时间戳/状态/序列号 4 个节点的写入模板
+ */
+class OpcuaNodeMap {
+public:
+    /// @brief 节点顺序（与写入值的顺序一致）
+    enum Field {
+        THICKNESS = 0,
+        TIMESTAMP,
+        STATUS,
+        SEQUENCE,
+        FIELD_COUNT
+    };
+
+    /// @brief 解析后的节点 ID（命名空间 URI 尚未解析为索引）
+    struct ParsedId {
+        std::string ns_uri;              ///< 非空时连接后解析为 ns
+        UA_UInt16 ns = 0;
+        char type = 's';                 ///< 'i' / 's' / 'g'
+        UA_UInt32 numeric = 0;
+        std::string text;
+        UA_Guid guid{};
+    };
+
+    OpcuaNodeMap();
+
+    OpcuaNodeMap(const OpcuaNodeMap&) = delete;
+    OpcuaNodeMap& operator=(const OpcuaNodeMap&) = delete;
+
+    /**
+     * @brief 解析一个节点 ID 字符串
+     *
+     * @param text 如 "ns=2;s=Gateway.Thickness"
+     * @param[out] out 解析结果
+     * @return bool false=格式无效
+     */
+    static bool parse(const std::string& text, ParsedId& out);
+
+    /**
+     * @brief 解析配置中的 4 个节点 ID（加载/重载配置时调用）
+     *
+     * 任一 ID 无效时整体回退到默认节点（ns=2;s=Gateway.*）。
+     *
+     * @return bool false=配置无效，已使用默认节点
+     */
+    bool configure(const ConfigManager::OPCUAConfig::Nodes& nodes);
+
+    /**
+     * @brief 连接成功后解析命名空间 URI 并构造写入模板
+     *
+     * 没有使用 nsu= 的配置不访问服务器。
+     *
+     * @param client 已连接的客户端
+     * @return bool false=服务器没有配置的命名空间（不能写入）
+     */
+    bool resolve(UA_Client* client);
+
+    /// @brief 连接断开时调用；命名空间索引可能随服务器重启变化
+    void invalidate() { ready_ = !needs_namespace_; }
+
+    /// @brief 写入模板是否可用
+    bool ready() const { return ready_; }
+
+    /// @brief 写入模板（FIELD_COUNT 个，ready() 为 true 时有效）
+    const UA_WriteValue* templates() const { return templates_; }
+
+    /// @brief 节点的配置文本（日志用）
+    const std::string& text(int field) const { return texts_[field]; }
+
+private:
+    void build_templates();
+
+    std::string texts_[FIELD_COUNT];
+    ParsedId ids_[FIELD_COUNT];
+    UA_WriteValue templates_[FIELD_COUNT];
+    bool needs_namespace_ = false;
+    bool ready_ = false;
+};
+
+#endif // GATEWAY_OPCUA_NODE_MAP_H
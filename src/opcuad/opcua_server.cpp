@@ -0,0 +1,299 @@
+#include "opcua_server.h"
+
+#include "../common/logger.h"
+
+#include <cstring>
+
+extern "C" {
+    #include <open62541/server_config_default.h>
+#ifdef UA_ENABLE_HISTORIZING
+    #include <open62541/plugin/historydata/history_data_backend_memory.h>
+    #include <open62541/plugin/historydata/history_database_default.h>
+#endif
+}
+
+namespace {
+const char* const FIELD_NAMES[OpcuaGatewayServer::FIELD_COUNT] = {
+    "Thickness",
+    "Timestamp",
+    "Status",
+    "Sequence",
+    "Quality",
+};
+
+const int FIELD_TYPES[OpcuaGatewayServer::FIELD_COUNT] = {
+    UA_TYPES_FLOAT,
+    UA_TYPES_DATETIME,
+    UA_TYPES_UINT16,
+    UA_TYPES_UINT32,
+    UA_TYPES_STATUSCODE,
+};
+
+/// @brief 保留历史的变量（Timestamp 即 SourceTimestamp，Quality 即 Thickness 的状态码）
+const bool FIELD_HISTORIZED[OpcuaGatewayServer::FIELD_COUNT] = {
+    true,
+    false,
+    true,
+    true,
+    false,
+};
+
+/// @brief 单次 HistoryRead 返回的样本数上限（超出部分通过 ContinuationPoint 继续读取）
+constexpr size_t MAX_HISTORY_RESPONSE = 1000;
+
+/// @brief 网关根对象的节点 ID
+char GATEWAY_OBJECT_ID[] = "Gateway";
+}  // namespace
+
+bool OpcuaGatewayServer::start(const Options& options) {
+    stop();
+    
+    const int port = options.port;
+    int channels = options.channels;
+    if (port <= 0 || port > 65535) {
+        LOG_ERROR("OPC UA 服务器端口无效: %d", port);
+        return false;
+    }
+    if (channels < 1 || channels > MAX_CHANNELS) {
+        LOG_WARN("OPC UA 服务器通道数 %d 超出范围,使用 %d", channels, channels < 1 ? 1 : MAX_CHANNELS);
+        channels = channels < 1 ? 1 : MAX_CHANNELS;
+    }
+    
+    server_ = UA_Server_new();
+    if (!server_) {
+        LOG_ERROR("创建 OPC UA 服务器失败");
+        return false;
+    }
+    UA_ServerConfig* config = UA_Server_getConfig(server_);
+    UA_ServerConfig_setMinimal(config, static_cast<UA_UInt16>(port), nullptr);
+    ns_ = UA_Server_addNamespace(server_, NAMESPACE_URI);
+    port_ = port;
+    channels_ = channels;
+    updates_ = 0;
+    historized_nodes_ = 0;
+    
+    // 允许 samplingInterval=0（每次写入采样）和较长的队列，默认下限 50 ms 会丢样本
+    config->samplingIntervalLimits.min = 0.0;
+    max_queue_size_ = options.max_queue_size > 0 ? options.max_queue_size : 1;
+    config->queueSizeLimits.max = static_cast<UA_UInt32>(max_queue_size_);
+    
+    history_size_ = options.history_size > 0 ? options.history_size : 0;
+    if (history_size_ > 0 && !enable_history()) {
+        history_size_ = 0;
+    }
+    
+    // Objects/Gateway
+    UA_ObjectAttributes attr = UA_ObjectAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT(const_cast<char*>("en-US"), GATEWAY_OBJECT_ID);
+    UA_StatusCode retval = UA_Server_addObjectNode(server_,
+        UA_NODEID_STRING(ns_, GATEWAY_OBJECT_ID),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_OBJECTSFOLDER),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+        UA_QUALIFIEDNAME(ns_, GATEWAY_OBJECT_ID),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_FOLDERTYPE),
+        attr, nullptr, nullptr);
+    if (retval != UA_STATUSCODE_GOOD) {
+        LOG_ERROR("OPC UA 服务器创建 Gateway 对象失败: %s", UA_StatusCode_name(retval));
+        stop();
+        return false;
+    }
+    
+    for (int ch = 0; ch < channels_; ++ch) {
+        if (!add_channel(ch)) {
+            stop();
+            return false;
+        }
+    }
+    
+    retval = UA_Server_run_startup(server_);
+    if (retval != UA_STATUSCODE_GOOD) {
+        LOG_ERROR("OPC UA 服务器启动失败 (端口 %d): %s", port_, UA_StatusCode_name(retval));
+        stop();
+        return false;
+    }
+    
+    LOG_INFO("OPC UA 服务器已启动: opc.tcp://0.0.0.0:%d, 命名空间 %s (ns=%u), %d 个通道",
+             port_, NAMESPACE_URI, static_cast<unsigned>(ns_), channels_);
+    if (history_size_ > 0) {
+        LOG_INFO("OPC UA 历史: %d 个变量, 每个保留 %d 个样本", historized_nodes_, history_size_);
+    }
+    return true;
+}
+
+bool OpcuaGatewayServer::add_channel(int channel) {
+    // 添加节点时服务器复制 NodeId / 名称，临时字符串即可
+    std::string object = "Channel" + std::to_string(channel);
+    char* object_id = const_cast<char*>(object.c_str());
+    
+    UA_ObjectAttributes oattr = UA_ObjectAttributes_default;
+    oattr.displayName = UA_LOCALIZEDTEXT(const_cast<char*>("en-US"), object_id);
+    UA_StatusCode retval = UA_Server_addObjectNode(server_,
+        UA_NODEID_STRING(ns_, object_id),
+        UA_NODEID_STRING(ns_, GATEWAY_OBJECT_ID),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_ORGANIZES),
+        UA_QUALIFIEDNAME(ns_, object_id),
+        UA_NODEID_NUMERIC(0, UA_NS0ID_BASEOBJECTTYPE),
+        oattr, nullptr, nullptr);
+    if (retval != UA_STATUSCODE_GOOD) {
+        LOG_ERROR("OPC UA 服务器创建 %s 失败: %s", object.c_str(), UA_StatusCode_name(retval));
+        return false;
+    }
+    
+    for (int field = 0; field < FIELD_COUNT; ++field) {
+        ids_[channel][field] = object + "." + FIELD_NAMES[field];
+        
+        // 初始值: 全零（各类型均为 0）/ Quality 为 Bad（尚未收到数据）
+        uint64_t zero = 0;
+        UA_StatusCode no_data = UA_STATUSCODE_BAD;
+        
+        UA_VariableAttributes vattr = UA_VariableAttributes_default;
+        vattr.displayName = UA_LOCALIZEDTEXT(const_cast<char*>("en-US"), const_cast<char*>(FIELD_NAMES[field]));
+        vattr.dataType = UA_TYPES[FIELD_TYPES[field]].typeId;
+        vattr.valueRank = UA_VALUERANK_SCALAR;
+        vattr.accessLevel = UA_ACCESSLEVELMASK_READ;
+        vattr.minimumSamplingInterval = 0.0;
+        const bool historized = history_size_ > 0 && FIELD_HISTORIZED[field];
+        if (historized) {
+            vattr.historizing = true;
+            vattr.accessLevel |= UA_ACCESSLEVELMASK_HISTORYREAD;
+        }
+        UA_Variant_setScalar(&vattr.value, field == QUALITY ? static_cast<void*>(&no_data) : static_cast<void*>(&zero),
+                             &UA_TYPES[FIELD_TYPES[field]]);
+        
+        const UA_NodeId node = UA_NODEID_STRING(ns_, const_cast<char*>(ids_[channel][field].c_str()));
+        retval = UA_Server_addVariableNode(server_,
+            node,
+            UA_NODEID_STRING(ns_, object_id),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_HASCOMPONENT),
+            UA_QUALIFIEDNAME(ns_, const_cast<char*>(FIELD_NAMES[field])),
+            UA_NODEID_NUMERIC(0, UA_NS0ID_BASEDATAVARIABLETYPE),
+            vattr, nullptr, nullptr);
+        if (retval != UA_STATUSCODE_GOOD) {
+            LOG_ERROR("OPC UA 服务器创建 %s 失败: %s", ids_[channel][field].c_str(), UA_StatusCode_name(retval));
+            return false;
+        }
+        if (historized && !register_history(node)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool OpcuaGatewayServer::enable_history() {
+#ifdef UA_ENABLE_HISTORIZING
+    // 历史数据库: 写入变量值时自动记录（VALUESET 策略），每个变量一个环形内存存储
+    UA_ServerConfig* config = UA_Server_getConfig(server_);
+    gathering_ = UA_HistoryDataGathering_Default(static_cast<size_t>(channels_) * FIELD_COUNT);
+    config->historyDatabase = UA_HistoryDatabase_default(gathering_);
+    config->accessHistoryDataCapability = true;
+    config->maxReturnDataValues = static_cast<UA_UInt32>(MAX_HISTORY_RESPONSE);
+    return true;
+#else
+    LOG_WARN("open62541 未启用 UA_ENABLE_HISTORIZING,OPC UA 服务器不保留历史");
+    return false;
+#endif
+}
+
+bool OpcuaGatewayServer::register_history(const UA_NodeId& node) {
+#ifdef UA_ENABLE_HISTORIZING
+    UA_HistorizingNodeIdSettings setting;
+    std::memset(&setting, 0, sizeof(setting));
+    // 环形存储: 超过 history_size 个样本时覆盖最旧的，内存占用固定
+    setting.historizingBackend = UA_HistoryDataBackend_Memory_Circular(1, static_cast<size_t>(history_size_));
+    setting.maxHistoryDataResponseSize = MAX_HISTORY_RESPONSE;
+    setting.historizingUpdateStrategy = UA_HISTORIZINGUPDATESTRATEGY_VALUESET;
+    UA_StatusCode retval = gathering_.registerNodeId(server_, gathering_.context, &node, setting);
+    if (retval != UA_STATUSCODE_GOOD) {
+        LOG_ERROR("OPC UA 历史注册失败: %s", UA_StatusCode_name(retval));
+        return false;
+    }
+    historized_nodes_++;
+    return true;
+#else
+    (void)node;
+    return false;
+#endif
+}
+
+void OpcuaGatewayServer::stop() {
+    if (!server_) {
+        return;
+    }
+    UA_Server_run_shutdown(server_);
+    UA_Server_delete(server_);
+    server_ = nullptr;
+    channels_ = 0;
+    LOG_INFO("OPC UA 服务器已停止");
+}
+
+void OpcuaGatewayServer::update(const NormalizedData& data) {
+    if (!server_ || data.channel >= channels_) {
+        return;
+    }
+    
+    const UA_DateTime sampled = source_time(data.timestamp_ns);
+    const UA_StatusCode quality = quality_of(data.status);
+    
+    UA_Float thickness = data.thickness_mm;
+    UA_DateTime timestamp = sampled;
+    UA_UInt16 status = data.status;
+    UA_UInt32 sequence = data.sequence;
+    UA_StatusCode quality_value = quality;
+    void* values[FIELD_COUNT] = {&thickness, &timestamp, &status, &sequence, &quality_value};
+    
+    for (int field = 0; field < FIELD_COUNT; ++field) {
+        UA_DataValue value;
+        UA_DataValue_init(&value);
+        UA_Variant_setScalar(&value.value, values[field], &UA_TYPES[FIELD_TYPES[field]]);
+        value.hasValue = true;
+        value.sourceTimestamp = sampled;
+        value.hasSourceTimestamp = true;
+        if (field == THICKNESS && quality != UA_STATUSCODE_GOOD) {
+            // 测量值本身带质量，订阅方不需要另外读 Quality
+            value.status = quality;
+            value.hasStatus = true;
+        }
+        UA_Server_writeDataValue(server_,
+            UA_NODEID_STRING(ns_, const_cast<char*>(ids_[data.channel][field].c_str())), value);
+    }
+    updates_++;
+}
+
+uint32_t OpcuaGatewayServer::iterate() {
+    if (!server_) {
+        return 1000;
+    }
+    return UA_Server_run_iterate(server_, false);
+}
+
+Json::Value OpcuaGatewayServer::stats() const {
+    Json::Value stats(Json::objectValue);
+    stats["running"] = running();
+    stats["port"] = port_;
+    stats["channels"] = channels_;
+    stats["namespace"] = NAMESPACE_URI;
+    stats["namespace_index"] = static_cast<Json::UInt>(ns_);
+    stats["updates"] = static_cast<Json::UInt64>(updates_);
+    stats["history_size"] = history_size_;
+    stats["historized_nodes"] = historized_nodes_;
+    stats["max_queue_size"] = max_queue_size_;
+    return stats;
+}
+
+UA_StatusCode OpcuaGatewayServer::quality_of(uint16_t status) {
+    if ((status & NDMStatus::ERROR_MASK) != 0 || (status & NDMStatus::DATA_VALID) == 0) {
+        return UA_STATUSCODE_BAD;
+    }
+    if ((status & NDMStatus::RS485_OK) == 0 || (status & NDMStatus::SENSOR_OK) == 0) {
+        return UA_STATUSCODE_UNCERTAIN;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_DateTime OpcuaGatewayServer::source_time(uint64_t timestamp_ns) {
+    return wall_time(ndm_wall_time_ns(timestamp_ns));
+}
+
+UA_DateTime OpcuaGatewayServer::wall_time(uint64_t wall_ns) {
+    return static_cast<UA_DateTime>(wall_ns / 100ULL) + UA_DATETIME_UNIX_EPOCH;
+}
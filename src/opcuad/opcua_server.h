@@ -0,0 +1,155 @@
+/**
+ * @file opcua_server.h
+ * @brief 内嵌 OPC UA 服务器（网关地址空间）
+ *
+ * 客户端模式下网关把每个样本写入对方的服务器；MES 等系统更希望直接订阅网关。
+ * 服务器模式在 opcuad 内运行一个 open62541 服务器，每个通道发布一组变量:
+ *
+ *   Objects/Gateway/Channel<N>/
+ *     Thickness  Float      厚度值 (mm)，DataValue 状态码即数据质量
+ *     Timestamp  DateTime   样本采集时间
+ *     Status     UInt16     原始状态位
+ *     Sequence   UInt32     序列号
+ *     Quality    StatusCode Good / Uncertain / Bad（由状态位推导）
+ *
+ * 节点 ID 为 "ns=<网关命名空间>;s=Channel<N>.<变量名>"，命名空间 URI 为
+ * urn:gateway:thickness（索引以服务器命名空间数组为准）。
+ *
+ * 每个样本直接从共享内存环形缓冲区更新到地址空间，SourceTimestamp 取样本采集时间；
+ * 客户端通过订阅（MonitoredItem）按需接收数据变化。
+ * 服务器与主循环在同一线程中运行（UA_Server_run_iterate），不需要加锁。
+ *
+ * 全分辨率数据:
+ * - 变量的 MinimumSamplingInterval 为 0，服务器采样下限放开到 0；
+ *   samplingInterval=0 的 MonitoredItem 在每次写入时采样，配合 queueSize>1
+ *   可在一个发布周期内收到全部 50 Hz 样本（队列上限见 max_queue_size）
+ * - Thickness/Status/Sequence 保留最近 history_size 个样本的历史（内存环形存储），
+ *   支持 HistoryRead (ReadRawModified)；需要 open62541 以 UA_ENABLE_HISTORIZING 编译
+ *
+ * @author Gateway Project
+ * @date 2025-10-29
+ */
+
+#ifndef GATEWAY_OPCUA_SERVER_H
+#define GATEWAY_OPCUA_SERVER_H
+
+#include "../common/ndm.h"
+
+#include <json/json.h>
+
+#include <cstdint>
+#include <string>
+
+extern "C" {
+    #include <open62541/server.h>
+#ifdef UA_ENABLE_HISTORIZING
+    #include <open62541/plugin/historydata/history_data_gathering_default.h>
+#endif
+}
+
+/**
+ * @class OpcuaGatewayServer
+ * @brief 发布各通道最新数据的 OPC UA 服务器
+ */
+class OpcuaGatewayServer {
+public:
+    static constexpr int MAX_CHANNELS = 16;
+    static constexpr const char* NAMESPACE_URI = "urn:gateway:thickness";
+
+    /// @brief 每个通道的变量
+    enum Field {
+        THICKNESS = 0,
+        TIMESTAMP,
+        STATUS,
+        SEQUENCE,
+        QUALITY,
+        FIELD_COUNT
+    };
+
+    /// @brief 启动参数
+    struct Options {
+        int port = 4840;
+        int channels = 1;               ///< 发布的通道数 (1..MAX_CHANNELS)
+        int history_size = 3000;        ///< 每个变量保留的历史样本数，0=不保留历史
+        int max_queue_size = 1000;      ///< MonitoredItem 队列长度上限
+    };
+
+    OpcuaGatewayServer() = default;
+    ~OpcuaGatewayServer() { stop(); }
+
+    OpcuaGatewayServer(const OpcuaGatewayServer&) = delete;
+    OpcuaGatewayServer& operator=(const OpcuaGatewayServer&) = delete;
+
+    /**
+     * @brief 创建地址空间并开始监听
+     *
+     * @param options 端口、通道数、历史与队列设置
+     * @return bool false=创建失败（如端口被占用）
+     */
+    bool start(const Options& options);
+
+    /**
+     * @brief 停止服务器并释放地址空间
+     */
+    void stop();
+
+    bool running() const { return server_ != nullptr; }
+
+    /**
+     * @brief 用一个样本更新对应通道的变量（通道超出范围时忽略）
+     */
+    void update(const NormalizedData& data);
+
+    /**
+     * @brief 处理网络事件和订阅发布（不阻塞）
+     *
+     * @return uint32_t 距下一次需要调用的毫秒数
+     */
+    uint32_t iterate();
+
+    /**
+     * @brief 服务器状态（端口、通道数、命名空间索引、更新次数）
+     */
+    Json::Value stats() const;
+
+    /**
+     * @brief 由状态位推导数据质量
+     *
+     * - 有错误码或数据无效: Bad
+     * - RS-485 或传感器状态异常: Uncertain
+     * - 其余: Good
+     */
+    static UA_StatusCode quality_of(uint16_t status);
+
+    /**
+     * @brief 把样本的单调时钟时间戳换算为 UA_DateTime（墙上时间）
+     */
+    static UA_DateTime source_time(uint64_t timestamp_ns);
+
+    /**
+     * @brief 把墙上时间（Unix 纪元纳秒，见 Outbox）换算为 UA_DateTime
+     */
+    static UA_DateTime wall_time(uint64_t wall_ns);
+
+private:
+    bool add_channel(int channel);
+    bool enable_history();
+    bool register_history(const UA_NodeId& node);
+
+    UA_Server* server_ = nullptr;
+    UA_UInt16 ns_ = 0;
+    int port_ = 0;
+    int channels_ = 0;
+    int history_size_ = 0;              ///< 实际生效的历史长度（不支持时为 0）
+    int max_queue_size_ = 0;
+    int historized_nodes_ = 0;
+    uint64_t updates_ = 0;
+#ifdef UA_ENABLE_HISTORIZING
+    UA_HistoryDataGathering gathering_{};
+#endif
+
+    /// @brief 节点 ID 字符串（节点 ID 直接引用，更新时不分配）
+    std::string ids_[MAX_CHANNELS][FIELD_COUNT];
+};
+
+#endif // GATEWAY_OPCUA_SERVER_H
@@ -0,0 +1,264 @@
+#include "uadp_publisher.h"
+
+#include "../common/logger.h"
+
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#include <arpa/inet.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace {
+// NetworkMessage 头
+constexpr uint8_t UADP_FLAGS = 0xF1;          ///< v1 | PublisherId | GroupHeader | PayloadHeader | ExtendedFlags1
+constexpr uint8_t UADP_EXT_FLAGS1 = 0x21;     ///< PublisherId=UInt16 | Timestamp
+constexpr uint8_t GROUP_FLAGS = 0x0B;         ///< WriterGroupId | GroupVersion | SequenceNumber
+// DataSetMessage 头
+constexpr uint8_t DATASET_FLAGS1 = 0x99;      ///< Valid | Variant 编码 | SequenceNumber | Status | DataSetFlags2
+constexpr uint8_t DATASET_FLAGS2 = 0x10;      ///< KeyFrame | Timestamp
+// Variant 内置类型 ID
+constexpr uint8_t TYPE_UINT16 = 5;
+constexpr uint8_t TYPE_UINT32 = 7;
+constexpr uint8_t TYPE_FLOAT = 10;
+constexpr uint8_t TYPE_DATETIME = 13;
+
+// 固定布局中的偏移
+constexpr size_t OFF_PUBLISHER_ID = 2;
+constexpr size_t OFF_WRITER_GROUP_ID = 5;
+constexpr size_t OFF_GROUP_VERSION = 7;
+constexpr size_t OFF_NETWORK_SEQUENCE = 11;
+constexpr size_t OFF_WRITER_ID = 14;
+constexpr size_t OFF_NETWORK_TIME = 16;
+constexpr size_t OFF_DATASET_SEQUENCE = 26;
+constexpr size_t OFF_DATASET_TIME = 28;
+constexpr size_t OFF_DATASET_STATUS = 36;
+constexpr size_t OFF_FIELD_COUNT = 38;
+constexpr size_t OFF_THICKNESS = 40;
+constexpr size_t OFF_TIMESTAMP = 45;
+constexpr size_t OFF_STATUS = 54;
+constexpr size_t OFF_SEQUENCE = 57;
+static_assert(OFF_SEQUENCE + 1 + 4 == UadpPublisher::MESSAGE_SIZE, "UADP layout size mismatch");
+
+/// @brief 1601-01-01 到 1970-01-01 的 100 ns 间隔数
+constexpr int64_t DATETIME_UNIX_EPOCH = 116444736000000000LL;
+
+// UADP 为小端编码
+inline void put_u16(uint8_t* p, uint16_t v) {
+    p[0] = static_cast<uint8_t>(v);
+    p[1] = static_cast<uint8_t>(v >> 8);
+}
+
+inline void put_u32(uint8_t* p, uint32_t v) {
+    for (int i = 0; i < 4; ++i) {
+        p[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+}
+
+inline void put_i64(uint8_t* p, int64_t value) {
+    const uint64_t v = static_cast<uint64_t>(value);
+    for (int i = 0; i < 8; ++i) {
+        p[i] = static_cast<uint8_t>(v >> (8 * i));
+    }
+}
+}  // namespace
+
+bool UadpPublisher::parse_url(const std::string& url, std::string& host, int& port) {
+    const std::string scheme = "opc.udp://";
+    if (url.compare(0, scheme.size(), scheme) != 0) {
+        return false;
+    }
+    std::string rest = url.substr(scheme.size());
+    rest = rest.substr(0, rest.find('/'));
+    port = 4840;
+    const size_t colon = rest.rfind(':');
+    if (colon != std::string::npos) {
+        port = std::atoi(rest.c_str() + colon + 1);
+        rest.resize(colon);
+    }
+    host = rest;
+    return !host.empty() && port > 0 && port <= 65535;
+}
+
+bool UadpPublisher::open(const Options& options) {
+    close();
+    options_ = options;
+    
+    std::string host;
+    int port = 0;
+    if (!parse_url(options.url, host, port)) {
+        LOG_ERROR("UADP 发布地址无效: %s", options.url.c_str());
+        return false;
+    }
+    
+    std::memset(&dest_, 0, sizeof(dest_));
+    dest_.sin_family = AF_INET;
+    dest_.sin_port = htons(static_cast<uint16_t>(port));
+    if (inet_pton(AF_INET, host.c_str(), &dest_.sin_addr) != 1) {
+        // 主机名: 只在打开时解析一次
+        addrinfo hints{};
+        hints.ai_family = AF_INET;
+        hints.ai_socktype = SOCK_DGRAM;
+        addrinfo* result = nullptr;
+        if (getaddrinfo(host.c_str(), nullptr, &hints, &result) != 0 || !result) {
+            LOG_ERROR("UADP 无法解析主机: %s", host.c_str());
+            return false;
+        }
+        dest_.sin_addr = reinterpret_cast<sockaddr_in*>(result->ai_addr)->sin_addr;
+        freeaddrinfo(result);
+    }
+    
+    fd_ = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) {
+        LOG_ERROR("UADP 创建套接字失败: %s", strerror(errno));
+        return false;
+    }
+    
+    if (IN_MULTICAST(ntohl(dest_.sin_addr.s_addr))) {
+        const int ttl = options.ttl > 0 ? options.ttl : 1;
+        const unsigned char loop = 1;  // 本机订阅方（及回环测试）也能收到
+        setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_TTL, &ttl, sizeof(ttl));
+        setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_LOOP, &loop, sizeof(loop));
+        if (!options.interface_ip.empty()) {
+            in_addr iface{};
+            if (inet_pton(AF_INET, options.interface_ip.c_str(), &iface) != 1 ||
+                setsockopt(fd_, IPPROTO_IP, IP_MULTICAST_IF, &iface, sizeof(iface)) != 0) {
+                LOG_WARN("UADP 组播网卡 %s 设置失败,按路由选择", options.interface_ip.c_str());
+            }
+        }
+    }
+    
+    build_header();
+    sent_ = 0;
+    failed_ = 0;
+    rejected_ = 0;
+    LOG_INFO("UADP 发布器已启动: %s (PublisherId=%u, WriterGroupId=%u, DataSetWriterId=%u+通道)",
+             options.url.c_str(), options.publisher_id, options.writer_group_id, options.dataset_writer_id);
+    return true;
+}
+
+void UadpPublisher::close() {
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
+
+void UadpPublisher::build_header() {
+    std::memset(message_, 0, sizeof(message_));
+    message_[0] = UADP_FLAGS;
+    message_[1] = UADP_EXT_FLAGS1;
+    put_u16(message_ + OFF_PUBLISHER_ID, options_.publisher_id);
+    message_[OFF_WRITER_GROUP_ID - 1] = GROUP_FLAGS;
+    put_u16(message_ + OFF_WRITER_GROUP_ID, options_.writer_group_id);
+    put_u32(message_ + OFF_GROUP_VERSION, group_version(options_));
+    message_[OFF_WRITER_ID - 1] = 1;  // PayloadHeader.Count
+    message_[OFF_DATASET_SEQUENCE - 2] = DATASET_FLAGS1;
+    message_[OFF_DATASET_SEQUENCE - 1] = DATASET_FLAGS2;
+    put_u16(message_ + OFF_FIELD_COUNT, 4);
+    message_[OFF_THICKNESS] = TYPE_FLOAT;
+    message_[OFF_TIMESTAMP] = TYPE_DATETIME;
+    message_[OFF_STATUS] = TYPE_UINT16;
+    message_[OFF_SEQUENCE] = TYPE_UINT32;
+}
+
+const uint8_t* UadpPublisher::encode(const NormalizedData& data, int64_t now, int64_t sampled) {
+    // DataSetWriterId 与序列号计数使用同一个通道号；超出范围的样本不编码
+    if (data.channel >= MAX_CHANNELS) {
+        return nullptr;
+    }
+    const int channel = data.channel;
+    
+    put_u16(message_ + OFF_NETWORK_SEQUENCE, network_sequence_++);
+    put_u16(message_ + OFF_WRITER_ID, static_cast<uint16_t>(options_.dataset_writer_id + channel));
+    put_i64(message_ + OFF_NETWORK_TIME, now);
+    
+    put_u16(message_ + OFF_DATASET_SEQUENCE, dataset_sequence_[channel]++);
+    put_i64(message_ + OFF_DATASET_TIME, sampled);
+    put_u16(message_ + OFF_DATASET_STATUS, status_of(data.status));
+    
+    uint32_t thickness_raw = 0;
+    static_assert(sizeof(thickness_raw) == sizeof(data.thickness_mm), "float size mismatch");
+    std::memcpy(&thickness_raw, &data.thickness_mm, sizeof(thickness_raw));
+    put_u32(message_ + OFF_THICKNESS + 1, thickness_raw);
+    put_i64(message_ + OFF_TIMESTAMP + 1, sampled);
+    put_u16(message_ + OFF_STATUS + 1, data.status);
+    put_u32(message_ + OFF_SEQUENCE + 1, data.sequence);
+    return message_;
+}
+
+bool UadpPublisher::publish(const NormalizedData& data) {
+    if (fd_ < 0) {
+        return false;
+    }
+    
+    const int64_t now = datetime_now();
+    if (!encode(data, now, datetime_of(data.timestamp_ns))) {
+        if (rejected_++ == 0) {
+            LOG_WARN("UADP 通道号 %u 超出范围 (0-%d),样本未发送", data.channel, MAX_CHANNELS - 1);
+        }
+        return false;
+    }
+    ssize_t n = sendto(fd_, message_, MESSAGE_SIZE, MSG_DONTWAIT,
+                       reinterpret_cast<const sockaddr*>(&dest_), sizeof(dest_));
+    if (n != static_cast<ssize_t>(MESSAGE_SIZE)) {
+        // 发送缓冲区满或网络不可达: 丢弃本样本，不阻塞主循环
+        if (failed_++ == 0) {
+            LOG_WARN("UADP 发送失败: %s", strerror(errno));
+        }
+        return false;
+    }
+    sent_++;
+    return true;
+}
+
+Json::Value UadpPublisher::stats() const {
+    Json::Value stats(Json::objectValue);
+    stats["open"] = is_open();
+    stats["url"] = options_.url;
+    stats["publisher_id"] = options_.publisher_id;
+    stats["writer_group_id"] = options_.writer_group_id;
+    stats["sent"] = static_cast<Json::UInt64>(sent_);
+    stats["failed"] = static_cast<Json::UInt64>(failed_);
+    stats["rejected"] = static_cast<Json::UInt64>(rejected_);
+    return stats;
+}
+
+uint32_t UadpPublisher::group_version(const Options& options) {
+    // FNV-1a: 布局（报文大小、字段数）+ 各 Id
+    const uint32_t words[] = {
+        static_cast<uint32_t>(MESSAGE_SIZE), 4u,
+        options.publisher_id, options.writer_group_id, options.dataset_writer_id,
+    };
+    uint32_t hash = 2166136261u;
+    for (uint32_t word : words) {
+        for (int i = 0; i < 4; ++i) {
+            hash ^= (word >> (8 * i)) & 0xFFu;
+            hash *= 16777619u;
+        }
+    }
+    return hash != 0 ? hash : 1;
+}
+
+int64_t UadpPublisher::datetime_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<int64_t>(ts.tv_sec) * 10000000LL + ts.tv_nsec / 100 + DATETIME_UNIX_EPOCH;
+}
+
+int64_t UadpPublisher::datetime_of(uint64_t timestamp_ns) {
+    return static_cast<int64_t>(ndm_wall_time_ns(timestamp_ns) / 100ULL) + DATETIME_UNIX_EPOCH;
+}
+
+uint16_t UadpPublisher::status_of(uint16_t status) {
+    if ((status & NDMStatus::ERROR_MASK) != 0 || (status & NDMStatus::DATA_VALID) == 0) {
+        return 0x8000;  // Bad
+    }
+    if ((status & NDMStatus::RS485_OK) == 0 || (status & NDMStatus::SENSOR_OK) == 0) {
+        return 0x4000;  // Uncertain
+    }
+    return 0x0000;      // Good
+}
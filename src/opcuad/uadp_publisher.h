@@ -0,0 +1,142 @@
+/**
+ * @file uadp_publisher.h
+ * @brief OPC UA PubSub UADP 发布器（UDP 组播/单播）
+ *
+ * 客户端/服务器写入每个样本都需要一次会话往返。PubSub 发布器把每个样本
+ * 编码为一个 UADP NetworkMessage（OPC UA Part 14），直接通过 UDP 发出，
+ * 订阅方无需建立会话，单向时延在局域网内小于 1 ms。
+ *
+ * 报文为固定布局（62 字节），头部在 open() 时预先编码，每个样本只改写
+ * 序列号、时间戳和字段值，不做分配:
+ *
+ *   NetworkMessage
+ *     Flags              0xF1  (UADP v1, PublisherId/GroupHeader/PayloadHeader/ExtendedFlags1)
+ *     ExtendedFlags1     0x21  (PublisherId=UInt16, Timestamp)
+ *     PublisherId        UInt16
+ *     GroupHeader        flags 0x0B: WriterGroupId UInt16, GroupVersion UInt32 (由配置推导), SequenceNumber UInt16
+ *     PayloadHeader      Count=1, DataSetWriterId UInt16 (= dataset_writer_id + 通道号)
+ *     Timestamp          DateTime (发送时间)
+ *   DataSetMessage (key frame, Variant 编码)
+ *     DataSetFlags1      0x99  (Valid, SequenceNumber, Status, DataSetFlags2)
+ *     DataSetFlags2      0x10  (KeyFrame, Timestamp)
+ *     SequenceNumber     UInt16 (每个 DataSetWriter 独立计数)
+ *     Timestamp          DateTime (样本采集时间)
+ *     Status             UInt16 (StatusCode 高 16 位: Good/Uncertain/Bad)
+ *     FieldCount         UInt16 = 4
+ *     Thickness          Variant<Float>
+ *     Timestamp          Variant<DateTime>
+ *     Status             Variant<UInt16>
+ *     Sequence           Variant<UInt32>
+ *
+ * 编码不依赖 open62541 的 PubSub 模块（最小化编译的库中未启用）。
+ *
+ * @author Gateway Project
+ * @date 2025-10-29
+ */
+
+#ifndef GATEWAY_UADP_PUBLISHER_H
+#define GATEWAY_UADP_PUBLISHER_H
+
+#include "../common/ndm.h"
+
+#include <json/json.h>
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include <netinet/in.h>
+
+/**
+ * @class UadpPublisher
+ * @brief 每个样本一个 UADP NetworkMessage
+ */
+class UadpPublisher {
+public:
+    static constexpr size_t MESSAGE_SIZE = 62;
+    static constexpr int MAX_CHANNELS = 16;
+
+    /// @brief 发布参数
+    struct Options {
+        std::string url = "opc.udp://239.0.0.1:4840";  ///< 组播或单播地址
+        uint16_t publisher_id = 1;
+        uint16_t writer_group_id = 1;
+        uint16_t dataset_writer_id = 1;                 ///< 通道 N 使用 dataset_writer_id + N
+        int ttl = 1;                                    ///< 组播 TTL
+        std::string interface_ip;                       ///< 组播出口网卡地址，空=按路由
+    };
+
+    UadpPublisher() = default;
+    ~UadpPublisher() { close(); }
+
+    UadpPublisher(const UadpPublisher&) = delete;
+    UadpPublisher& operator=(const UadpPublisher&) = delete;
+
+    /**
+     * @brief 创建 UDP 套接字并预编码报文头
+     * @return bool false=地址无效或套接字创建失败
+     */
+    bool open(const Options& options);
+
+    void close();
+
+    bool is_open() const { return fd_ >= 0; }
+
+    /**
+     * @brief 编码并发送一个样本（非阻塞，发送缓冲区满时丢弃）
+     * @return bool false=未打开或发送失败
+     */
+    bool publish(const NormalizedData& data);
+
+    /**
+     * @brief 把一个样本编码到报文缓冲区（publish() 内部使用，可用于检查报文）
+     *
+     * @param data 样本
+     * @param now 发送时间 (UA DateTime，100 ns，自 1601-01-01)
+     * @param sampled 采集时间 (UA DateTime)
+     * @return const uint8_t* MESSAGE_SIZE 字节的报文；通道号 >= MAX_CHANNELS 时为 nullptr
+     */
+    const uint8_t* encode(const NormalizedData& data, int64_t now, int64_t sampled);
+
+    /**
+     * @brief 发布统计（已发送、失败、目标地址）
+     */
+    Json::Value stats() const;
+
+    /**
+     * @brief 解析 "opc.udp://host:port"
+     */
+    static bool parse_url(const std::string& url, std::string& host, int& port);
+
+    /// @brief 当前墙上时间 (UA DateTime)
+    static int64_t datetime_now();
+
+    /// @brief 单调时钟时间戳换算为 UA DateTime
+    static int64_t datetime_of(uint64_t timestamp_ns);
+
+    /// @brief 状态位换算为 DataSetMessage 状态 (StatusCode 高 16 位)
+    static uint16_t status_of(uint16_t status);
+
+    /**
+     * @brief 由发布参数推导 GroupVersion
+     *
+     * 订阅方按 GroupVersion 判断报文布局是否变化；取 Id 与布局的哈希，
+     * 同一配置重启后不变，Id 变化时随之变化。
+     */
+    static uint32_t group_version(const Options& options);
+
+private:
+    void build_header();
+
+    Options options_;
+    int fd_ = -1;
+    sockaddr_in dest_{};
+    uint8_t message_[MESSAGE_SIZE] = {};
+    uint16_t network_sequence_ = 0;
+    uint16_t dataset_sequence_[MAX_CHANNELS] = {};
+    uint64_t sent_ = 0;
+    uint64_t failed_ = 0;
+    uint64_t rejected_ = 0;   ///< 通道号超出范围未发送的样本
+};
+
+#endif // GATEWAY_UADP_PUBLISHER_H
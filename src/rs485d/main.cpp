@@ -7,6 +7,7 @@
  * 2. 将原始数据转换为 NDM 格式
  * 3. 通过共享内存传递给其他模块（modbusd、s7d 等）
  * 4. 提供统计信息和错误处理
+ * 5. 执行协议守护进程经命令队列下发的命令（清零、去皮、模式、设定值）
  * 
  * 数据流:
  * 测厚仪 (RS-485) → rs485d → 共享内存 → modbusd/s7d/opcuad → PLC/CNC
@@ -24,11 +25,17 @@
 #include "../common/logger.h"
 #include "../common/config.h"
 #include "../common/shm_ring.h"
+#include "../common/cmd_queue.h"
+#include "../common/modbus_crc.h"
+#include "../common/service_host.h"
+#include <algorithm>
 #include <iostream>
 #include <thread>
 #include <chrono>
+#include <atomic>
 #include <csignal>
 #include <fcntl.h>
+#include <poll.h>
 #include <termios.h>
 #include <unistd.h>
 #include <cstring>
@@ -36,9 +43,11 @@
 #include <cmath>
 #include <cstdlib>
 
+namespace rs485d {
+
 /// @brief 全局运行标志，用于优雅退出
-/// @note volatile sig_atomic_t 保证信号处理器的线程安全
-volatile sig_atomic_t g_running = 1;
+/// @note 无锁原子量: 信号处理器中可安全写入，托管模式下 stop() 从其他线程写入
+std::atomic<bool> g_running{true};
 
 /**
  * @brief 信号处理函数
@@ -50,7 +59,7 @@ volatile sig_atomic_t g_running = 1;
  */
 void signal_handler(int signum) {
     LOG_INFO("收到信号 %d, 正在关闭...", signum);
-    g_running = 0;
+    g_running = false;
 }
 
 /**
@@ -85,15 +94,18 @@ public:
      * @param device 串口设备路径（如 "/dev/ttyUSB0"）
      * @param baudrate 波特率（9600/19200/38400/57600/115200）
      */
-    RS485Handler(const std::string& device, int baudrate, bool simulate)
+    RS485Handler(const std::string& device, int baudrate, bool simulate, int timeout_ms = 200,
+                 const ConfigManager::RS485Config::GaugeCommands& commands = {})
         : device_(device),
           baudrate_(baudrate),
+          timeout_ms_(timeout_ms > 0 ? timeout_ms : 200),
           fd_(-1),
           simulate_(simulate ||
                     device == "SIMULATED" ||
                     device == "simulated" ||
                     device.rfind("sim://", 0) == 0),
-          sim_start_(std::chrono::steady_clock::now()) {
+          sim_start_(std::chrono::steady_clock::now()),
+          commands_(commands) {
     }
     
     /**
@@ -244,6 +256,9 @@ public:
             0xC4, 0x0B  // CRC-16 (需要根据实际数据计算)
         };
         
+        // 丢弃上一条命令超出等待时间后才到达的应答
+        tcflush(fd_, TCIFLUSH);
+        
         // 发送查询命令
         ssize_t written = write(fd_, query, sizeof(query));
         if (written != sizeof(query)) {
@@ -303,6 +318,70 @@ public:
         // ====================================================================
     }
     
+    /**
+     * @brief 执行一条反向命令
+     * 
+     * 把命令转换为对测厚仪的 Modbus RTU 写操作，并等待测厚仪确认。
+     * 等待以 cycle_deadline（本采样周期结束）为限，不占用下一个周期的采集；
+     * 剩余时间不足一次收发时至少等待收发所需时间，另以 timeout_ms_ 为上限。
+     * 寄存器地址未在 rs485.commands 中配置的命令直接拒绝，不写入测厚仪。
+     * 模拟模式下直接作用于模拟数据（去皮=以当前值为零点，清零=取消去皮）。
+     * 
+     * @param cmd 命令
+     * @param cycle_deadline 本采样周期的结束时间
+     * @return uint16_t CommandResult::OK / FAILED / REJECTED
+     */
+    uint16_t execute_command(const GaugeCommand& cmd, std::chrono::steady_clock::time_point cycle_deadline) {
+        // 参数来自网络上的 Modbus 客户端: 转换为寄存器值之前检查
+        if (!GaugeCommandCode::arg_valid(cmd.code, cmd.arg)) {
+            LOG_WARN("命令 #%u 参数无效 (代码 %u, 参数 %g),已拒绝", cmd.id, cmd.code, cmd.arg);
+            return CommandResult::REJECTED;
+        }
+        if (simulate_ && fd_ < 0) {
+            switch (cmd.code) {
+                case GaugeCommandCode::ZERO:
+                    sim_tare_mm_ = 0.0f;
+                    return CommandResult::OK;
+                case GaugeCommandCode::TARE:
+                    sim_tare_mm_ += last_thickness_;
+                    return CommandResult::OK;
+                case GaugeCommandCode::SET_MODE:
+                case GaugeCommandCode::SETPOINT:
+                    return CommandResult::OK;
+                default:
+                    return CommandResult::REJECTED;
+            }
+        }
+        
+        int reg = -1;
+        switch (cmd.code) {
+            case GaugeCommandCode::ZERO:     reg = commands_.zero_register; break;
+            case GaugeCommandCode::TARE:     reg = commands_.tare_register; break;
+            case GaugeCommandCode::SET_MODE: reg = commands_.mode_register; break;
+            case GaugeCommandCode::SETPOINT: reg = commands_.setpoint_register; break;
+            default: break;
+        }
+        if (reg < 0 || reg > 0xFFFF) {
+            LOG_WARN("命令代码 %u 未配置测厚仪寄存器 (rs485.commands),已拒绝", cmd.code);
+            return CommandResult::REJECTED;
+        }
+        
+        bool ok = false;
+        switch (cmd.code) {
+            case GaugeCommandCode::ZERO:
+            case GaugeCommandCode::TARE:
+                ok = write_register(static_cast<uint16_t>(reg), 1, cycle_deadline);
+                break;
+            case GaugeCommandCode::SET_MODE:
+                ok = write_register(static_cast<uint16_t>(reg), static_cast<uint16_t>(cmd.arg), cycle_deadline);
+                break;
+            case GaugeCommandCode::SETPOINT:
+                ok = write_float(static_cast<uint16_t>(reg), cmd.arg, cycle_deadline);
+                break;
+        }
+        return ok ? CommandResult::OK : CommandResult::FAILED;
+    }
+    
     /**
      * @brief 检查串口是否已打开
      * 
@@ -313,6 +392,88 @@ public:
     }
     
 private:
+    /**
+     * @brief 写单个保持寄存器 (FC06)，测厚仪原样回显请求即为确认
+     */
+    bool write_register(uint16_t reg, uint16_t value, std::chrono::steady_clock::time_point cycle_deadline) {
+        uint8_t frame[8] = {
+            static_cast<uint8_t>(commands_.slave_address), 0x06,
+            static_cast<uint8_t>(reg >> 8), static_cast<uint8_t>(reg & 0xFF),
+            static_cast<uint8_t>(value >> 8), static_cast<uint8_t>(value & 0xFF)
+        };
+        modbus_append_crc(frame, 6);
+        return transact(frame, sizeof(frame), cycle_deadline);
+    }
+    
+    /**
+     * @brief 写 Float32 到两个连续保持寄存器 (FC16)
+     */
+    bool write_float(uint16_t reg, float value, std::chrono::steady_clock::time_point cycle_deadline) {
+        uint32_t raw;
+        memcpy(&raw, &value, sizeof(raw));
+        uint8_t frame[13] = {
+            static_cast<uint8_t>(commands_.slave_address), 0x10,
+            static_cast<uint8_t>(reg >> 8), static_cast<uint8_t>(reg & 0xFF),
+            0x00, 0x02, 0x04,
+            static_cast<uint8_t>(raw >> 24), static_cast<uint8_t>(raw >> 16),
+            static_cast<uint8_t>(raw >> 8), static_cast<uint8_t>(raw)
+        };
+        modbus_append_crc(frame, 11);
+        return transact(frame, sizeof(frame), cycle_deadline);
+    }
+    
+    /**
+     * @brief 发送写请求并等待 8 字节确认帧（FC06 回显 / FC16 应答）
+     * 
+     * 等待截止时间见 execute_command()；收到异常应答（5 字节）立即返回失败。
+     * 超时后到达的应答在下一次查询前丢弃。
+     */
+    bool transact(const uint8_t* request, size_t len, std::chrono::steady_clock::time_point cycle_deadline) {
+        tcflush(fd_, TCIFLUSH);
+        if (write(fd_, request, len) != static_cast<ssize_t>(len)) {
+            LOG_ERROR("发送命令失败: %s", strerror(errno));
+            return false;
+        }
+        
+        // 请求 + 8 字节应答在线路上的传输时间（每字节 10 位）加 2ms 应答余量
+        const auto now = std::chrono::steady_clock::now();
+        const auto exchange = std::chrono::microseconds((len + 8) * 10 * 1000000LL / baudrate_ + 2000);
+        auto deadline = std::max(cycle_deadline, now + exchange);
+        deadline = std::min(deadline, now + std::chrono::milliseconds(timeout_ms_));
+        
+        uint8_t response[16];
+        size_t got = 0;
+        while (got < 8) {
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                deadline - std::chrono::steady_clock::now()).count();
+            if (remaining <= 0) {
+                LOG_WARN("测厚仪命令应答超时 (已收到 %zu 字节)", got);
+                return false;
+            }
+            struct pollfd pfd = {fd_, POLLIN, 0};
+            if (poll(&pfd, 1, static_cast<int>(remaining)) <= 0) {
+                continue;
+            }
+            ssize_t n = read(fd_, response + got, sizeof(response) - got);
+            if (n > 0) {
+                got += static_cast<size_t>(n);
+            }
+            // 异常应答: 地址 功能码|0x80 异常码 CRC
+            if (got >= 5 && (response[1] & 0x80) && modbus_check_crc(response, 5)) {
+                LOG_WARN("测厚仪拒绝命令: 功能码=0x%02X 异常码=%u", request[1], response[2]);
+                return false;
+            }
+        }
+        
+        if (!modbus_check_crc(response, 8) ||
+            response[0] != request[0] || response[1] != request[1] ||
+            response[2] != request[2] || response[3] != request[3]) {
+            LOG_WARN("测厚仪命令应答无效");
+            return false;
+        }
+        return true;
+    }
+    
     float generate_simulated_thickness() {
         using clock = std::chrono::steady_clock;
         const auto elapsed = std::chrono::duration<float>(clock::now() - sim_start_).count();
@@ -320,14 +481,19 @@ private:
         float base = 1.5f + 0.2f * std::sin(elapsed * 0.4f);
         float ripple = 0.05f * std::sin(elapsed * 3.2f);
         float noise = 0.01f * std::sin(elapsed * 12.7f);
-        return base + ripple + noise;
+        last_thickness_ = base + ripple + noise - sim_tare_mm_;
+        return last_thickness_;
     }
 
     std::string device_;    ///< 串口设备路径
     int baudrate_;          ///< 波特率
+    int timeout_ms_;        ///< 命令应答超时（毫秒）
     int fd_;                ///< 文件描述符
     bool simulate_;         ///< 是否启用模拟模式
     std::chrono::steady_clock::time_point sim_start_; ///< 模拟起始时间
+    float sim_tare_mm_ = 0.0f;     ///< 模拟模式下的去皮量
+    float last_thickness_ = 0.0f;  ///< 最近一次模拟厚度（去皮用）
+    ConfigManager::RS485Config::GaugeCommands commands_;  ///< 命令寄存器
 };
 
 /**
@@ -342,6 +508,7 @@ private:
  *    - 以 50Hz 频率查询测厚仪
  *    - 将数据封装为 NDM 格式
  *    - 写入共享内存
+ *    - 每周期最多执行一条命令队列中的命令
  *    - 定期输出统计信息
  * 6. 收到退出信号后优雅关闭
  * 
@@ -349,20 +516,15 @@ private:
  * @param argv 参数数组（argv[1] 是配置文件路径，可选）
  * @return int 退出码 (0=正常, 1=错误)
  */
-int main(int argc, char* argv[]) {
-    // 初始化日志系统
-    // 参数1: 程序名称（会出现在日志中）
-    // 参数2: 是否使用 syslog (false=输出到控制台，true=输出到系统日志)
-    Logger::init("rs485d", false);
+int run(int argc, char* argv[]) {
+    // 初始化日志系统，注册信号处理函数用于优雅退出
+    // （gatewayd 中只设置本线程的日志名，信号由 gatewayd 统一处理）
+    ServiceHost::init("rs485d", signal_handler);
     
     LOG_INFO("========================================");
     LOG_INFO("RS485 数据采集守护进程启动中...");
     LOG_INFO("========================================");
     
-    // 注册信号处理函数，用于优雅退出
-    signal(SIGINT, signal_handler);   // Ctrl+C
-    signal(SIGTERM, signal_handler);  // kill 命令
-    
     // 加载配置文件
     ConfigManager& config = ConfigManager::instance();
     
@@ -405,9 +567,23 @@ int main(int argc, char* argv[]) {
     
     LOG_INFO("共享内存创建成功 (容量: %d 条数据)", RING_SIZE);
     
+    // 创建命令队列（协议守护进程 → rs485d）
+    CommandChannel cmd_channel;
+    CommandQueue* cmd_queue = nullptr;
+    if (cmd_channel.create()) {
+        cmd_queue = cmd_channel.queue();
+        LOG_INFO("命令队列创建成功 (容量: %d 条命令)", CMD_QUEUE_SIZE);
+    } else {
+        LOG_WARN("命令队列创建失败，测厚仪命令功能不可用");
+    }
+    
+    // 环形缓冲区和命令队列已就绪，gatewayd 此后启动各协议服务
+    ServiceHost::notify_ready("rs485d");
+    
     // 打开串口设备
     LOG_INFO("打开串口设备...");
-    RS485Handler rs485(rs485_cfg.device, rs485_cfg.baudrate, rs485_cfg.simulate);
+    RS485Handler rs485(rs485_cfg.device, rs485_cfg.baudrate, rs485_cfg.simulate, rs485_cfg.timeout_ms,
+                       rs485_cfg.commands);
     if (!rs485.open()) {
         LOG_FATAL("串口设备打开失败！");
         LOG_FATAL("请检查:");
@@ -444,7 +620,7 @@ int main(int argc, char* argv[]) {
         data.sequence = sequence++;              // 序列号递增
         data.thickness_mm = thickness;           // 厚度值
         data.status = 0;                         // 初始化状态为 0
-        data.reserved = 0;                       // 保留字段
+        data.channel = 0;                        // 单台测厚仪，通道 0
         
         // 3. 设置状态位
         if (success) {
@@ -466,7 +642,19 @@ int main(int argc, char* argv[]) {
         // 5. 推入共享内存环形缓冲区
         ring->push(data);
         
-        // 6. 定期输出统计信息（每 10 秒）
+        // 6. 处理命令队列（每周期最多一条，应答只在本周期剩余时间内等待，
+        //    测厚仪不应答时也不会占用后续周期的采集）
+        GaugeCommand cmd;
+        if (cmd_queue && cmd_queue->try_pop(cmd)) {
+            const auto cycle_deadline = loop_start + std::chrono::milliseconds(rs485_cfg.poll_rate_ms);
+            const uint16_t result = rs485.execute_command(cmd, cycle_deadline);
+            cmd_queue->set_result(cmd.id, result);
+            LOG_INFO("命令 #%u (代码=%u, 参数=%.3f) 执行%s",
+                     cmd.id, cmd.code, cmd.arg,
+                     result == CommandResult::OK ? "成功" : (result == CommandResult::REJECTED ? "被拒绝" : "失败"));
+        }
+        
+        // 7. 定期输出统计信息（每 10 秒）
         auto now = std::chrono::steady_clock::now();
         auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(
             now - last_stats_time).count();
@@ -484,7 +672,7 @@ int main(int argc, char* argv[]) {
             last_stats_time = now;
         }
         
-        // 7. 精确控制采样频率
+        // 8. 精确控制采样频率
         // 计算本次循环实际耗时
         auto loop_end = std::chrono::steady_clock::now();
         auto elapsed_us = std::chrono::duration_cast<std::chrono::microseconds>(
@@ -512,6 +700,7 @@ int main(int argc, char* argv[]) {
     rs485.close();
     
     LOG_INFO("销毁共享内存...");
+    cmd_channel.destroy();
     shm.destroy();
     
     LOG_INFO("最终统计: 序列号=%u, 成功=%u, 失败=%u", 
@@ -523,3 +712,18 @@ int main(int argc, char* argv[]) {
     
     return 0;
 }
+
+/**
+ * @brief 请求退出（gatewayd 收到信号时调用）
+ */
+void stop() {
+    g_running = false;
+}
+
+}  // namespace rs485d
+
+#ifndef GATEWAY_HOSTED
+int main(int argc, char* argv[]) {
+    return rs485d::run(argc, argv);
+}
+#endif
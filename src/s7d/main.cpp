@@ -6,20 +6,38 @@
  * - 从共享内存读取测厚仪数据
  * - 将数据写入 S7 PLC 的 DB 块
  * - 支持配置热重载
- * - 自动重连机制
+ * - 自动重连机制（后台线程，指数退避 + TCP 预探测，见 connect_worker.h）
  * 
  * S7 通信协议:
  * - 使用 Snap7 库实现
  * - 支持 S7-200/300/400/1200/1500 系列 PLC
  * - TCP/IP 通信,默认端口 102
  * 
- * 数据布局 (写入 PLC DB块):
+ * 数据布局 (写入 PLC DB块，通道 N 的数据块从 DBB(N*16) 开始):
  * - DB{db_number}.DBD0: Float32 - 厚度值 (mm)
  * - DB{db_number}.DBD4: DWord - 时间戳低32位
  * - DB{db_number}.DBD8: DWord - 时间戳高32位
  * - DB{db_number}.DBW12: Word - 状态位
  * - DB{db_number}.DBW14: Word - 序列号
  * 
+ * 每个周期各通道的最新数据通过 Cli_WriteMultiVars() 合并写入，
+ * 连接状态由写入结果判断，不再逐次调用 Cli_GetConnected()。
+ * async_write 模式下改用 Cli_AsDBWrite() 一次写入相邻通道区间，
+ * PLC 往返与环形缓冲区读取重叠进行。
+ * 
+ * 可选的样本环（sample_ring）在 DB 中保留 ring_channel 通道最近 N 个样本，
+ * 每周期一次写出新增样本，见 s7_sample_ring.h。
+ * 启用 outbox 时，断线期间该通道的样本缓存到磁盘，恢复后限速补发到样本环。
+ * 
+ * 配置 tags 后按变量映射写入（地址/类型/字节序可配置，相邻变量合并传输），
+ * 见 s7_tag_map.h。
+ * 
+ * 主循环按截止时间调度（sleep_until），周期不随写入耗时漂移。
+ * 
+ * 配置 protocol.s7.plcs 后同时写入多台 PLC: 每台 PLC 一个 S7Session
+ * （独立的客户端、变量映射、更新间隔和重连状态机，见 s7_session.h），
+ * 主循环读取一次环形缓冲区后分发给所有会话，并按最早的截止时间休眠。
+ * 
  * @author Gateway Project
  * @date 2025-10-11
  * @version 2.0
@@ -27,35 +45,32 @@
 
 #include "../common/logger.h"
 #include "../common/config.h"
+#include "../common/config_watcher.h"
 #include "../common/shm_ring.h"
 #include "../common/status_writer.h"
+#include "../common/service_host.h"
+#include "s7_session.h"
 
+#include <algorithm>
 #include <atomic>
 #include <chrono>
 #include <csignal>
-#include <filesystem>
 #include <iostream>
+#include <memory>
+#include <set>
 #include <thread>
-#include <cstring>
-#include <arpa/inet.h>
-
-// Snap7 库头文件 (需要安装: sudo apt install libsnap7-dev)
-// 如果没有安装,可以从 https://snap7.sourceforge.net/ 下载
-extern "C" {
-    #include <snap7.h>
-}
+#include <vector>
 
 using namespace std::chrono_literals;
 
+namespace s7d {
+
 // ============================================================================
 // 全局变量
 // ============================================================================
 
 /// @brief 运行标志,收到信号时设置为0
-volatile sig_atomic_t g_running = 1;
-
-/// @brief S7 客户端句柄
-S7Object g_s7_client = 0;
+std::atomic<bool> g_running{true};
 
 // ============================================================================
 // 信号处理
@@ -67,170 +82,65 @@ S7Object g_s7_client = 0;
  */
 void signal_handler(int signum) {
     LOG_INFO("收到信号 %d, 正在关闭...", signum);
-    g_running = 0;
+    g_running = false;
 }
 
 // ============================================================================
-// S7 客户端管理
+// 状态写入
 // ============================================================================
 
-/**
- * @brief 连接到 S7 PLC
- * 
- * @param plc_ip PLC IP地址
- * @param rack 机架号 (通常为0)
- * @param slot 槽位号 (S7-300为2, S7-1200/1500为1)
- * @return bool true=连接成功, false=连接失败
- */
-bool s7_connect(const std::string& plc_ip, int rack, int slot) {
-    if (!g_s7_client) {
-        g_s7_client = Cli_Create();
-        if (!g_s7_client) {
-            LOG_ERROR("创建 S7 客户端失败");
-            return false;
-        }
-    }
-    
-    // 连接到 PLC (IP, Rack, Slot)
-    int result = Cli_ConnectTo(g_s7_client, plc_ip.c_str(), rack, slot);
-    if (result == 0) {
-        LOG_INFO("S7 连接成功: %s (Rack=%d, Slot=%d)", plc_ip.c_str(), rack, slot);
-        return true;
-    } else {
-        char error_text[256];
-        Cli_ErrorText(result, error_text, 256);
-        LOG_ERROR("S7 连接失败: %s (错误码: 0x%08X)", error_text, result);
-        return false;
-    }
-}
+using SessionList = std::vector<std::unique_ptr<S7Session>>;
 
 /**
- * @brief 断开 S7 连接
+ * @brief 所有会话是否都已连接（没有会话时为 false）
  */
-void s7_disconnect() {
-    if (g_s7_client) {
-        Cli_Disconnect(g_s7_client);
-        LOG_INFO("S7 已断开连接");
-    }
-}
-
-/**
- * @brief 检查 S7 连接状态
- * @return bool true=已连接, false=未连接
- */
-bool s7_is_connected() {
-    if (!g_s7_client) {
+static bool all_connected(const SessionList& sessions) {
+    if (sessions.empty()) {
         return false;
     }
-    int connected = 0;
-    int status = Cli_GetConnected(g_s7_client, &connected);
-    if (status != 0) {
-        return false;
+    for (const auto& session : sessions) {
+        if (!session->connected()) {
+            return false;
+        }
     }
-    return connected != 0;
+    return true;
 }
 
 /**
- * @brief 写入数据到 S7 PLC DB块
+ * @brief 写入组件状态详情到状态表
  * 
- * 数据布局 (16字节):
- * - Byte 0-3:  Float32 - 厚度值 (Big-Endian)
- * - Byte 4-7:  DWord - 时间戳低32位 (Big-Endian)
- * - Byte 8-11: DWord - 时间戳高32位 (Big-Endian)
- * - Byte 12-13: Word - 状态位 (Big-Endian)
- * - Byte 14-15: Word - 序列号 (Big-Endian)
+ * 顶层 config/publish/connection 取第一个会话（兼容单 PLC 的状态格式），
+ * plcs 数组包含每个会话的状态。最新样本和读游标由 StatusWriter::update() 更新。
  * 
- * @param db_number DB块编号 (如 DB10)
- * @param data 归一化数据
- * @return bool true=写入成功, false=写入失败
- */
-bool s7_write_data(int db_number, const NormalizedData& data) {
-    if (!g_s7_client || !s7_is_connected()) {
-        LOG_WARN("S7 未连接,无法写入数据");
-        return false;
-    }
-    
-    // 准备数据缓冲区 (16字节)
-    uint8_t buffer[16];
-    std::memset(buffer, 0, sizeof(buffer));
-    
-    // 1. 写入厚度值 (Float32, Big-Endian)
-    union {
-        float f;
-        uint32_t u;
-    } thickness;
-    thickness.f = data.thickness_mm;
-    uint32_t thickness_be = htonl(thickness.u);
-    std::memcpy(buffer + 0, &thickness_be, 4);
-    
-    // 2. 写入时间戳 (Uint64, Big-Endian, 分成高低32位)
-    uint64_t timestamp_ms = data.timestamp_ns / 1000000ULL;
-    uint32_t timestamp_low = htonl(static_cast<uint32_t>(timestamp_ms & 0xFFFFFFFFULL));
-    uint32_t timestamp_high = htonl(static_cast<uint32_t>(timestamp_ms >> 32));
-    std::memcpy(buffer + 4, &timestamp_low, 4);
-    std::memcpy(buffer + 8, &timestamp_high, 4);
-    
-    // 3. 写入状态位 (Word, Big-Endian)
-    uint16_t status_be = htons(data.status);
-    std::memcpy(buffer + 12, &status_be, 2);
-    
-    // 4. 写入序列号 (Word, Big-Endian)
-    uint16_t sequence_be = htons(static_cast<uint16_t>(data.sequence & 0xFFFF));
-    std::memcpy(buffer + 14, &sequence_be, 2);
-    
-    // 写入到 PLC (DB块, 起始地址0, 长度16字节)
-    int result = Cli_DBWrite(g_s7_client, db_number, 0, 16, buffer);
-    if (result == 0) {
-        LOG_DEBUG("S7 写入成功: thickness=%.3f mm, seq=%u", data.thickness_mm, data.sequence);
-        return true;
-    } else {
-        char error_text[256];
-        Cli_ErrorText(result, error_text, 256);
-        LOG_ERROR("S7 写入失败: %s (错误码: 0x%08X)", error_text, result);
-        return false;
-    }
-}
-
-// ============================================================================
-// 状态写入
-// ============================================================================
-
-/**
- * @brief 写入组件状态到状态文件
- * @param sample 数据样本 (可为nullptr)
- * @param connected 是否已连接
- * @param cfg S7配置
+ * @param sessions PLC 会话
  * @param active_protocol 当前激活的协议
  */
-static void write_status(const NormalizedData* sample,
-                         bool connected,
-                         const ConfigManager::S7Config& cfg,
+static void write_status(const SessionList& sessions,
                          const std::string& active_protocol) {
     Json::Value extra(Json::objectValue);
-    Json::Value conf(Json::objectValue);
-    conf["enabled"] = cfg.enabled;
-    conf["plc_ip"] = cfg.plc_ip;
-    conf["rack"] = cfg.rack;
-    conf["slot"] = cfg.slot;
-    conf["db_number"] = cfg.db_number;
-    conf["update_interval_ms"] = cfg.update_interval_ms;
-    extra["config"] = conf;
+    Json::Value plcs(Json::arrayValue);
+    for (const auto& session : sessions) {
+        plcs.append(session->status());
+    }
+    const bool connected = all_connected(sessions);
+    if (!plcs.empty()) {
+        extra["config"] = plcs[0]["config"];
+        extra["publish"] = plcs[0]["publish"];
+        extra["connection"] = plcs[0]["connection"];
+    }
     extra["active_protocol"] = active_protocol;
     extra["connected"] = connected;
-    StatusWriter::write_component_status("s7", sample, connected, extra);
+    extra["plcs"] = plcs;
+    StatusWriter::write_detail(StatusComponent::S7, extra);
 }
 
 // ============================================================================
 // 主程序
 // ============================================================================
 
-int main(int argc, char* argv[]) {
-    // 初始化日志
-    Logger::init("s7d", false);
-    
-    // 注册信号处理
-    signal(SIGINT, signal_handler);
-    signal(SIGTERM, signal_handler);
+int run(int argc, char* argv[]) {
+    // 初始化日志和信号处理
+    ServiceHost::init("s7d", signal_handler);
     
     // 加载配置
     ConfigManager& config = ConfigManager::instance();
@@ -242,28 +152,21 @@ int main(int argc, char* argv[]) {
     if (!config.load(config_path)) {
         LOG_WARN("配置加载失败,使用默认配置");
     }
+    StatusWriter::configure_files(config.get_status_file_config());
     
-    // 获取配置
-    auto s7_cfg = config.get_s7_config();
-    auto active_protocol = config.get_string("protocol.active", "modbus");
-    
-    // 配置签名 (用于检测配置变化)
-    auto make_signature = [](const ConfigManager::S7Config& cfg, const std::string& proto) {
-        return proto + "|" + (cfg.enabled ? "1" : "0") + "|" + cfg.plc_ip + "|" +
-               std::to_string(cfg.rack) + "|" + std::to_string(cfg.slot) + "|" +
-               std::to_string(cfg.db_number) + "|" + std::to_string(cfg.update_interval_ms);
-    };
-    std::string config_signature = make_signature(s7_cfg, active_protocol);
+    // 获取配置（同一快照，之后由 watcher 分发的快照替换）
+    const auto startup_cfg = config.snapshot();
+    auto plc_cfgs = startup_cfg->s7_plcs;
+    auto active_protocol = startup_cfg->active_protocol;
+    bool output_active = startup_cfg->s7_active;
     
     // 打印启动信息
     LOG_INFO("========================================");
     LOG_INFO("S7 PLC 客户端守护进程启动");
     LOG_INFO("========================================");
-    LOG_INFO("PLC IP: %s", s7_cfg.plc_ip.c_str());
-    LOG_INFO("Rack: %d, Slot: %d, DB: %d", s7_cfg.rack, s7_cfg.slot, s7_cfg.db_number);
-    LOG_INFO("更新间隔: %d ms", s7_cfg.update_interval_ms);
+    LOG_INFO("PLC 数量: %zu", plc_cfgs.size());
     LOG_INFO("激活协议: %s", active_protocol.c_str());
-    LOG_INFO("S7 启用: %s", s7_cfg.enabled ? "是" : "否");
+    LOG_INFO("S7 启用: %s", plc_cfgs.front().enabled ? "是" : "否");
     
     // 打开共享内存
     SharedMemoryManager shm;
@@ -273,104 +176,101 @@ int main(int argc, char* argv[]) {
     }
     RingBuffer* ring = shm.get_ring();
     
+    // 每台 PLC 一个会话；名称重复的项会共用 outbox 文件，跳过
+    SessionList sessions;
+    auto build_sessions = [&]() {
+        sessions.clear();
+        std::set<std::string> names;
+        for (const auto& cfg : plc_cfgs) {
+            if (!names.insert(cfg.name).second) {
+                LOG_WARN("S7 PLC 名称重复: %s,已忽略", cfg.name.c_str());
+                continue;
+            }
+            const bool active = output_active && cfg.enabled;
+            sessions.push_back(std::make_unique<S7Session>(cfg, active));
+        }
+    };
+    build_sessions();
+    
+    // 独立游标: 与其他输出同时运行，按本进程的速率读取
+    RingCursor cursor(ring);
+    
     // 状态变量
-    bool is_connected = false;
-    bool protocol_active = (active_protocol == "s7" && s7_cfg.enabled);
     NormalizedData last_data{};
     bool has_data = false;
-    auto last_reload = std::chrono::steady_clock::now();
-    auto last_connect_attempt = std::chrono::steady_clock::now();
-    std::filesystem::file_time_type last_mtime{};
-    
-    // 统计信息
-    uint64_t total_writes = 0;
-    uint64_t failed_writes = 0;
     auto stats_start = std::chrono::steady_clock::now();
     
+    // 状态表: 热字段（连接状态、最新样本、读游标）每个周期更新；
+    // 详情 JSON 连接状态变化时立即写，其余每秒写一次
+    auto last_status_write = std::chrono::steady_clock::now();
+    bool status_connected = all_connected(sessions);
+    auto update_status = [&]() {
+        const bool connected = all_connected(sessions);
+        StatusWriter::update(StatusComponent::S7, has_data ? &last_data : nullptr, connected, connected, &cursor);
+    };
+    auto report_status = [&]() {
+        update_status();
+        write_status(sessions, active_protocol);
+        last_status_write = std::chrono::steady_clock::now();
+    };
+    
     // 写入初始状态
-    write_status(nullptr, is_connected, s7_cfg, active_protocol);
+    report_status();
+    
+    // 配置热重载: PLC 列表或激活状态变化时重建全部会话
+    ConfigWatcher watcher(config_path);
+    watcher.on_change(ConfigWatcher::S7 | ConfigWatcher::ACTIVE, [&](const ConfigManager::Snapshot& cfg) {
+        LOG_INFO("配置已更新,重新连接...");
+        
+        // 先销毁旧会话（停止连接线程、断开连接、关闭 outbox），再按新配置建立
+        sessions.clear();
+        plc_cfgs = cfg.s7_plcs;
+        active_protocol = cfg.active_protocol;
+        output_active = cfg.s7_active;
+        build_sessions();
+        
+        LOG_INFO("新配置: active=%s, PLC 数量=%zu", active_protocol.c_str(), sessions.size());
+        
+        report_status();
+    });
+    watcher.on_change(ConfigWatcher::STATUS_FILE, [](const ConfigManager::Snapshot& cfg) {
+        StatusWriter::configure_files(cfg.status_file);
+    });
+    watcher.start();
     
     // 主循环
     while (g_running) {
         auto now = std::chrono::steady_clock::now();
         
         // ====================================================================
-        // 1. 配置热重载 (每1秒检查一次)
+        // 1. 配置热重载 (文件变化时由 watcher 重载，这里只分发)
         // ====================================================================
-        if (now - last_reload > 1s) {
-            std::error_code ec;
-            auto current_mtime = std::filesystem::last_write_time(config_path, ec);
-            if (!ec && current_mtime != last_mtime) {
-                last_mtime = current_mtime;
-                if (config.load(config_path)) {
-                    auto new_cfg = config.get_s7_config();
-                    auto new_active_protocol = config.get_string("protocol.active", "modbus");
-                    auto new_signature = make_signature(new_cfg, new_active_protocol);
-                    
-                    if (new_signature != config_signature) {
-                        LOG_INFO("配置已更新,重新连接...");
-                        
-                        // 断开旧连接
-                        if (is_connected) {
-                            s7_disconnect();
-                            is_connected = false;
-                        }
-                        
-                        // 更新配置
-                        s7_cfg = new_cfg;
-                        active_protocol = new_active_protocol;
-                        protocol_active = (active_protocol == "s7" && s7_cfg.enabled);
-                        config_signature = new_signature;
-                        
-                        LOG_INFO("新配置: active=%s, enabled=%s, ip=%s",
-                                active_protocol.c_str(),
-                                s7_cfg.enabled ? "true" : "false",
-                                s7_cfg.plc_ip.c_str());
-                        
-                        write_status(has_data ? &last_data : nullptr, is_connected, s7_cfg, active_protocol);
-                    }
-                }
-            }
-            last_reload = now;
-        }
+        watcher.dispatch();
         
         // ====================================================================
-        // 2. 连接管理 (每5秒尝试一次重连)
+        // 2. 数据读取: 读取一次，分发给所有会话
         // ====================================================================
-        if (protocol_active && !is_connected) {
-            if (now - last_connect_attempt > 5s) {
-                LOG_INFO("尝试连接 PLC: %s ...", s7_cfg.plc_ip.c_str());
-                is_connected = s7_connect(s7_cfg.plc_ip, s7_cfg.rack, s7_cfg.slot);
-                last_connect_attempt = now;
-                write_status(has_data ? &last_data : nullptr, is_connected, s7_cfg, active_protocol);
+        if (ring) {
+            NormalizedData data;
+            while (cursor.next(data)) {
+                // 验证CRC
+                if (!ndm_verify_crc(data)) {
+                    continue;
+                }
+                last_data = data;
+                has_data = true;
+                for (auto& session : sessions) {
+                    session->on_sample(data);
+                }
             }
         }
         
         // ====================================================================
-        // 3. 数据读取和写入
+        // 3. 到期的会话执行写入周期
         // ====================================================================
-        if (ring) {
-            NormalizedData data;
-            if (ring->pop_latest(data)) {
-                // 验证CRC
-                if (ndm_verify_crc(data)) {
-                    last_data = data;
-                    has_data = true;
-                    
-                    // 如果S7已激活且已连接,写入数据
-                    if (protocol_active && is_connected) {
-                        bool write_ok = s7_write_data(s7_cfg.db_number, data);
-                        total_writes++;
-                        if (!write_ok) {
-                            failed_writes++;
-                            // 写入失败可能是连接断开
-                            if (!s7_is_connected()) {
-                                LOG_WARN("S7 连接断开,将尝试重连");
-                                is_connected = false;
-                            }
-                        }
-                    }
-                }
+        for (auto& session : sessions) {
+            if (session->deadline() <= now) {
+                session->run_cycle();
             }
         }
         
@@ -379,25 +279,29 @@ int main(int argc, char* argv[]) {
         // ====================================================================
         auto elapsed = std::chrono::duration_cast<std::chrono::seconds>(now - stats_start).count();
         if (elapsed >= 10) {
-            if (protocol_active && total_writes > 0) {
-                double error_rate = (double)failed_writes / total_writes * 100.0;
-                LOG_INFO("S7 统计: 总写入=%llu, 失败=%llu, 失败率=%.2f%%",
-                        static_cast<unsigned long long>(total_writes),
-                        static_cast<unsigned long long>(failed_writes),
-                        error_rate);
+            for (auto& session : sessions) {
+                session->log_stats();
             }
             stats_start = now;
-            total_writes = 0;
-            failed_writes = 0;
         }
         
         // ====================================================================
-        // 5. 周期性状态更新
+        // 5. 状态更新 (热字段每个周期; 详情每1秒, 连接状态变化时立即更新)
         // ====================================================================
-        write_status(has_data ? &last_data : nullptr, is_connected, s7_cfg, active_protocol);
+        const bool connected = all_connected(sessions);
+        if (connected != status_connected || now - last_status_write >= 1s) {
+            report_status();
+            status_connected = connected;
+        } else {
+            update_status();
+        }
         
-        // 休眠一段时间 (根据配置的更新间隔)
-        std::this_thread::sleep_for(std::chrono::milliseconds(s7_cfg.update_interval_ms));
+        // 休眠到最早的会话截止时间（至多 1 秒，保证状态更新；配置重载时提前唤醒）
+        auto wake = std::chrono::steady_clock::now() + 1s;
+        for (const auto& session : sessions) {
+            wake = std::min(wake, session->deadline());
+        }
+        watcher.wait_until(wake);
     }
     
     // ========================================================================
@@ -406,19 +310,27 @@ int main(int argc, char* argv[]) {
     
     LOG_INFO("S7 守护进程正在退出...");
     
-    // 断开连接
-    if (is_connected) {
-        s7_disconnect();
-    }
-    
-    // 销毁客户端
-    if (g_s7_client) {
-        Cli_Destroy(&g_s7_client);
-    }
+    // 会话析构: 未补发的样本留在 outbox 文件中，停止连接线程后断开连接
+    sessions.clear();
     
     // 写入最终状态
-    write_status(has_data ? &last_data : nullptr, false, s7_cfg, active_protocol);
+    report_status();
     
     LOG_INFO("S7 守护进程已退出");
     return 0;
 }
+
+/**
+ * @brief 请求退出（gatewayd 收到信号时调用）
+ */
+void stop() {
+    g_running = false;
+}
+
+}  // namespace s7d
+
+#ifndef GATEWAY_HOSTED
+int main(int argc, char* argv[]) {
+    return s7d::run(argc, argv);
+}
+#endif
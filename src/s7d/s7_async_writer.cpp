@@ -0,0 +1,43 @@
+#include "s7_async_writer.h"
+
+#include "../common/ndm.h"
+
+#include <cstring>
+
+namespace {
+/// @brief 作业长时间未完成时返回的错误码（errTCPReceiveTimeout，按链路故障处理）
+constexpr int STALLED_JOB_ERROR = 0x00000004;
+}
+
+int S7AsyncWriter::start(S7Object client, int db_number, int start, const void* data, int size) {
+    if (pending_ || size <= 0 || static_cast<size_t>(size) > BUFFER_SIZE) {
+        return -1;
+    }
+
+    std::memcpy(buffer_, data, static_cast<size_t>(size));
+    int result = Cli_AsDBWrite(client, db_number, start, size, buffer_);
+    if (result == 0) {
+        pending_ = true;
+        started_ns_ = get_timestamp_ns();
+    }
+    return result;
+}
+
+bool S7AsyncWriter::poll(S7Object client, int& result) {
+    if (!pending_) {
+        return false;
+    }
+
+    int op_result = 0;
+    if (Cli_CheckAsCompletion(client, &op_result) == JobPending) {
+        if (get_timestamp_ns() - started_ns_ < STALL_TIMEOUT_NS) {
+            return false;
+        }
+        op_result = STALLED_JOB_ERROR;
+    }
+
+    pending_ = false;
+    last_latency_us_ = (get_timestamp_ns() - started_ns_) / 1000ULL;
+    result = op_result;
+    return true;
+}
@@ -0,0 +1,84 @@
+/**
+ * @file s7_async_writer.h
+ * @brief S7 异步写入（Cli_AsDBWrite + 完成轮询）
+ *
+ * 同步写入时主循环阻塞在一次 PLC 往返上，实际周期 = 往返时间 + 间隔。
+ * 异步模式下写请求由 Snap7 的工作线程发出，主循环在等待应答期间继续
+ * 读取环形缓冲区，到下一个周期再检查上一次写入是否完成:
+ * - 已完成: 处理结果并立即发起新的写入（使用最新数据）
+ * - 未完成: 本周期不再发起写入，数据保留到下一周期（只写最新值）
+ *
+ * Snap7 每个客户端同一时间只允许一个异步作业，
+ * 因此本类只跟踪一个在途请求。写入数据复制到内部缓冲区，
+ * 在作业完成前保持有效。
+ *
+ * @author Gateway Project
+ * @date 2025-10-26
+ */
+
+#ifndef GATEWAY_S7_ASYNC_WRITER_H
+#define GATEWAY_S7_ASYNC_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+
+extern "C" {
+    #include <snap7.h>
+}
+
+/**
+ * @class S7AsyncWriter
+ * @brief 单个在途异步 DB 写入
+ */
+class S7AsyncWriter {
+public:
+    static constexpr size_t BUFFER_SIZE = 4096;               ///< 单次写入上限
+    static constexpr uint64_t STALL_TIMEOUT_NS = 5000000000ULL; ///< 作业挂起超过该时间视为链路故障
+
+    S7AsyncWriter() = default;
+
+    S7AsyncWriter(const S7AsyncWriter&) = delete;
+    S7AsyncWriter& operator=(const S7AsyncWriter&) = delete;
+
+    /**
+     * @brief 是否有在途写入
+     */
+    bool busy() const { return pending_; }
+
+    /**
+     * @brief 发起一次异步 DB 写入
+     *
+     * @param client Snap7 客户端
+     * @param db_number DB 编号
+     * @param start 起始字节偏移
+     * @param data 数据（复制到内部缓冲区）
+     * @param size 字节数
+     * @return int 0=已提交；否则为 Snap7 错误码
+     */
+    int start(S7Object client, int db_number, int start, const void* data, int size);
+
+    /**
+     * @brief 检查在途写入是否完成（不阻塞）
+     *
+     * @param client Snap7 客户端
+     * @param[out] result 完成时的结果码
+     * @return bool true=已完成（result 有效）, false=仍在进行或没有在途写入
+     */
+    bool poll(S7Object client, int& result);
+
+    /**
+     * @brief 放弃在途写入（断开连接前调用）
+     */
+    void reset() { pending_ = false; }
+
+    /// @brief 上一次完成的写入从提交到完成的时间（微秒）
+    uint64_t last_latency_us() const { return last_latency_us_; }
+
+private:
+    uint8_t buffer_[BUFFER_SIZE];
+    bool pending_ = false;
+    uint64_t started_ns_ = 0;
+    uint64_t last_latency_us_ = 0;
+};
+
+#endif // GATEWAY_S7_ASYNC_WRITER_H
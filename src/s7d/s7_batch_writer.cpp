@@ -0,0 +1,99 @@
+#include "s7_batch_writer.h"
+
+#include "../common/logger.h"
+
+#include <cstring>
+
+namespace {
+constexpr int REQUEST_HEADER = 10 + 2;  ///< 报文头 + 功能码/变量数
+}
+
+bool S7BatchWriter::add(int area, int db_number, int start, const void* data, int length) {
+    if (length <= 0 || count_ >= MAX_ITEMS || used_ + static_cast<size_t>(length) > BUFFER_SIZE) {
+        return false;
+    }
+
+    uint8_t* dst = buffer_ + used_;
+    std::memcpy(dst, data, static_cast<size_t>(length));
+    used_ += static_cast<size_t>(length);
+
+    TS7DataItem& item = items_[count_++];
+    item.Area = area;
+    item.WordLen = S7WLByte;
+    item.Result = 0;
+    item.DBNumber = db_number;
+    item.Start = start;
+    item.Amount = length;
+    item.pdata = dst;
+    return true;
+}
+
+int S7BatchWriter::write_group(S7Object client, int first, int count) {
+    last_requests_++;
+
+    if (count == 1 && REQUEST_HEADER + item_cost(items_[first].Amount, true) > pdu_length_) {
+        // 单个变量超过 PDU，交给 Cli_WriteArea() 内部拆分
+        TS7DataItem& item = items_[first];
+        item.Result = Cli_WriteArea(client, item.Area, item.DBNumber, item.Start,
+                                    item.Amount, item.WordLen, item.pdata);
+        return item.Result;
+    }
+
+    int result = Cli_WriteMultiVars(client, &items_[first], count);
+    if (result != 0) {
+        return result;
+    }
+
+    // 请求成功时，各变量仍可能被 CPU 单独拒绝（地址越界、DB 不存在等）
+    for (int i = first; i < first + count; ++i) {
+        if (items_[i].Result != 0) {
+            return items_[i].Result;
+        }
+    }
+    return 0;
+}
+
+int S7BatchWriter::flush(S7Object client) {
+    last_requests_ = 0;
+    last_item_errors_ = 0;
+
+    int first_error = 0;
+    int first = 0;
+    while (first < count_) {
+        // 贪心装填：在 PDU 长度和 MaxVars 以内尽量多放变量
+        int size = REQUEST_HEADER + item_cost(items_[first].Amount, true);
+        int n = 1;
+        while (first + n < count_ && n < MaxVars) {
+            // 原最后一项不再是最后一项，可能需要补齐
+            int grown = size - item_cost(items_[first + n - 1].Amount, true)
+                             + item_cost(items_[first + n - 1].Amount, false)
+                             + item_cost(items_[first + n].Amount, true);
+            if (grown > pdu_length_) {
+                break;
+            }
+            size = grown;
+            n++;
+        }
+
+        int result = write_group(client, first, n);
+        if (result != 0) {
+            if (is_link_error(result)) {
+                // 链路已断开，剩余变量没有必要再尝试
+                first_error = result;
+                break;
+            }
+            for (int i = first; i < first + n; ++i) {
+                if (items_[i].Result != 0) {
+                    last_item_errors_++;
+                }
+            }
+            if (first_error == 0) {
+                first_error = result;
+            }
+        }
+        first += n;
+    }
+
+    clear();
+    return first_error;
+}
@@ -0,0 +1,115 @@
+/**
+ * @file s7_batch_writer.h
+ * @brief S7 多变量批量写入
+ *
+ * 一个周期内要写入的多个区域（多个通道的 DB 块、不同 DB 的变量等）
+ * 先收集到本类中，再用 Cli_WriteMultiVars() 合并为尽量少的 S7 请求。
+ * 每个请求的大小按连接时协商的 PDU 长度计算，且不超过 Snap7 的
+ * MaxVars (20) 个变量；S7-1200 上每省掉一次往返可节省数毫秒。
+ *
+ * S7 写请求的 PDU 组成:
+ * - 10 字节报文头 + 2 字节（功能码、变量数）
+ * - 每个变量 12 字节参数 + 4 字节数据头 + 数据（非最后一项按偶数字节对齐）
+ *
+ * 数据复制到内部固定缓冲区，周期内不做堆分配。
+ *
+ * @author Gateway Project
+ * @date 2025-10-25
+ */
+
+#ifndef GATEWAY_S7_BATCH_WRITER_H
+#define GATEWAY_S7_BATCH_WRITER_H
+
+#include <cstddef>
+#include <cstdint>
+
+extern "C" {
+    #include <snap7.h>
+}
+
+/**
+ * @class S7BatchWriter
+ * @brief 按 PDU 长度分组的多变量写入
+ */
+class S7BatchWriter {
+public:
+    static constexpr size_t BUFFER_SIZE = 4096;  ///< 单周期数据总量上限
+    static constexpr int MAX_ITEMS = 64;         ///< 单周期变量数上限
+    static constexpr int DEFAULT_PDU_LENGTH = 240; ///< 未协商时使用 S7-200/300 的最小值
+
+    S7BatchWriter() = default;
+
+    S7BatchWriter(const S7BatchWriter&) = delete;
+    S7BatchWriter& operator=(const S7BatchWriter&) = delete;
+
+    /**
+     * @brief 设置协商得到的 PDU 长度（连接成功后调用）
+     */
+    void set_pdu_length(int pdu_length) {
+        pdu_length_ = pdu_length > 0 ? pdu_length : DEFAULT_PDU_LENGTH;
+    }
+
+    int pdu_length() const { return pdu_length_; }
+
+    /**
+     * @brief 清空已收集的变量
+     */
+    void clear() {
+        count_ = 0;
+        used_ = 0;
+    }
+
+    /**
+     * @brief 添加一个字节区域
+     *
+     * @param area S7AreaDB / S7AreaMK / S7AreaPA 等
+     * @param db_number DB 编号（非 DB 区忽略）
+     * @param start 起始字节偏移
+     * @param data 数据（复制到内部缓冲区）
+     * @param length 字节数
+     * @return bool false=缓冲区或变量数已满
+     */
+    bool add(int area, int db_number, int start, const void* data, int length);
+
+    /**
+     * @brief 写出所有变量并清空
+     *
+     * @param client Snap7 客户端
+     * @return int 0=全部成功；否则为第一个错误码（链路错误优先返回）
+     */
+    int flush(S7Object client);
+
+    int item_count() const { return count_; }
+
+    /// @brief 上一次 flush() 使用的 S7 请求次数
+    int last_requests() const { return last_requests_; }
+
+    /// @brief 上一次 flush() 中 PLC 拒绝的变量数
+    int last_item_errors() const { return last_item_errors_; }
+
+    /**
+     * @brief 错误码是否表示 TCP/ISO 链路已断开（需要重连）
+     *
+     * Snap7 错误码低 20 位为 TCP 与 ISO-on-TCP 层错误，
+     * 高位为 S7 协议 / CPU 返回的错误（链路仍然可用）。
+     */
+    static bool is_link_error(int code) { return (code & 0x000FFFFF) != 0; }
+
+private:
+    /// @brief 变量 i 加入请求后增加的 PDU 字节数
+    static int item_cost(int length, bool last) {
+        return 12 + 4 + length + ((!last && (length & 1)) ? 1 : 0);
+    }
+
+    int write_group(S7Object client, int first, int count);
+
+    TS7DataItem items_[MAX_ITEMS];
+    uint8_t buffer_[BUFFER_SIZE];
+    int count_ = 0;
+    size_t used_ = 0;
+    int pdu_length_ = DEFAULT_PDU_LENGTH;
+    int last_requests_ = 0;
+    int last_item_errors_ = 0;
+};
+
+#endif // GATEWAY_S7_BATCH_WRITER_H
@@ -0,0 +1,137 @@
+#include "s7_sample_ring.h"
+
+#include "../common/logger.h"
+
+#include <cstring>
+
+namespace {
+constexpr int REQUEST_HEADER = 10 + 2;  ///< 报文头 + 功能码/变量数
+
+/// @brief 变量加入写请求后增加的 PDU 字节数（同 S7BatchWriter）
+int item_cost(int length, bool last) {
+    return 12 + 4 + length + ((!last && (length & 1)) ? 1 : 0);
+}
+}
+
+bool S7SampleRing::configure(int db_number, int offset, int slots) {
+    image_.clear();
+    slots_ = 0;
+    write_slot_ = 0;
+    pending_ = 0;
+    total_ = 0;
+    last_samples_ = 0;
+    last_bytes_ = 0;
+    overwritten_ = 0;
+
+    if (slots == 0) {
+        return true;
+    }
+    if (slots < 0 || slots > MAX_SLOTS || offset < 0 || (offset & 1)) {
+        LOG_ERROR("S7 样本环参数无效: offset=%d, slots=%d", offset, slots);
+        return false;
+    }
+
+    db_number_ = db_number;
+    offset_ = offset;
+    slots_ = slots;
+    image_.assign(static_cast<size_t>(slots) * SLOT_SIZE + HEADER_SIZE, 0);
+    write_header();
+    return true;
+}
+
+void S7SampleRing::write_header() {
+    uint8_t* header = image_.data() + static_cast<size_t>(slots_) * SLOT_SIZE;
+    header[0] = static_cast<uint8_t>(write_slot_ >> 8);
+    header[1] = static_cast<uint8_t>(write_slot_);
+    header[2] = 0;
+    header[3] = 0;
+    header[4] = static_cast<uint8_t>(total_ >> 24);
+    header[5] = static_cast<uint8_t>(total_ >> 16);
+    header[6] = static_cast<uint8_t>(total_ >> 8);
+    header[7] = static_cast<uint8_t>(total_);
+}
+
+void S7SampleRing::push(const uint8_t* block) {
+    if (slots_ == 0) {
+        return;
+    }
+
+    std::memcpy(image_.data() + static_cast<size_t>(write_slot_) * SLOT_SIZE, block, SLOT_SIZE);
+    write_slot_ = (write_slot_ + 1) % slots_;
+    total_++;
+    if (pending_ < slots_) {
+        pending_++;
+    } else {
+        overwritten_++;
+    }
+}
+
+int S7SampleRing::flush(S7Object client, int pdu_length) {
+    last_samples_ = 0;
+    last_bytes_ = 0;
+    if (pending_ == 0) {
+        return 0;
+    }
+
+    write_header();
+
+    // 待写槽位为 [write_slot_ - pending_, write_slot_)（模 slots_）。
+    // 以 slots_ 结尾的区间与写指针区相邻，合并为一个变量；写指针区所在变量放在最后
+    const int header_start = slots_ * SLOT_SIZE;
+    int first = write_slot_ - pending_;
+    int head_end = 0;                // 回绕时先写 [0, head_end)
+    if (first < 0) {
+        first += slots_;
+        head_end = write_slot_ * SLOT_SIZE;
+    }
+
+    TS7DataItem items[2];
+    int count = 0;
+    auto add_item = [&](int start, int length) {
+        TS7DataItem& item = items[count++];
+        item.Area = S7AreaDB;
+        item.WordLen = S7WLByte;
+        item.Result = 0;
+        item.DBNumber = db_number_;
+        item.Start = offset_ + start;
+        item.Amount = length;
+        item.pdata = image_.data() + start;
+        last_bytes_ += length;
+    };
+
+    const int start = first * SLOT_SIZE;
+    if (head_end > 0) {
+        add_item(0, head_end);
+    }
+    if (first < write_slot_ && head_end == 0) {
+        // 不回绕且未到环尾: 槽位区间和写指针区分开写
+        add_item(start, write_slot_ * SLOT_SIZE - start);
+        add_item(header_start, HEADER_SIZE);
+    } else {
+        add_item(start, static_cast<int>(image_.size()) - start);
+    }
+
+    int size = REQUEST_HEADER;
+    for (int i = 0; i < count; ++i) {
+        size += item_cost(items[i].Amount, i == count - 1);
+    }
+
+    int result = 0;
+    if (size <= pdu_length) {
+        result = Cli_WriteMultiVars(client, items, count);
+        for (int i = 0; result == 0 && i < count; ++i) {
+            result = items[i].Result;
+        }
+    } else {
+        // 超过 PDU: 逐个写，Cli_DBWrite() 内部按地址递增拆分，写指针区最后到达
+        for (int i = 0; result == 0 && i < count; ++i) {
+            result = Cli_DBWrite(client, db_number_, items[i].Start, items[i].Amount, items[i].pdata);
+        }
+    }
+
+    if (result == 0) {
+        last_samples_ = pending_;
+        pending_ = 0;
+    }
+    return result;
+}
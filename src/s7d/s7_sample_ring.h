@@ -0,0 +1,120 @@
+/**
+ * @file s7_sample_ring.h
+ * @brief PLC DB 中的样本环形缓冲区
+ *
+ * 通道块（DBB(N*16)）只保存最新值，周期大于采样间隔时中间样本会丢失。
+ * 样本环在 DB 中保留最近 N 个样本，PLC 程序按写指针读取新样本，
+ * 100 ms 的网络周期也能拿到每个 50 Hz 样本。
+ *
+ * DB 布局（从 offset 开始，大端序）:
+ * - 槽位 0..N-1: 每槽 16 字节，格式同通道块（厚度/时间戳/状态/序列号）
+ * - 槽位之后: Word 写指针（下一个要写的槽位） + Word 保留 + DWord 样本总数
+ *
+ * 样本总数用于 PLC 判断是否漏读（两次读取间隔超过 N 个样本）。
+ *
+ * 本地保留整个环的镜像，每周期只写出新槽位和写指针，最多两个变量:
+ * - 不回绕: [第一个新槽位, 写指针) + 8 字节写指针区
+ * - 回绕: [0, 写指针) + [第一个新槽位, N) 连同紧随其后的写指针区
+ * 两个变量装得进一个 PDU 时用一次 Cli_WriteMultiVars()，否则按顺序
+ * 逐个 Cli_DBWrite()（超过 PDU 时按地址递增拆分）。写指针区总在最后写出，
+ * PLC 看到新写指针时对应槽位已经写入。写入失败时区间保留，下一周期重试。
+ *
+ * @author Gateway Project
+ * @date 2025-10-26
+ */
+
+#ifndef GATEWAY_S7_SAMPLE_RING_H
+#define GATEWAY_S7_SAMPLE_RING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+extern "C" {
+    #include <snap7.h>
+}
+
+/**
+ * @class S7SampleRing
+ * @brief DB 样本环的本地镜像与增量写出
+ */
+class S7SampleRing {
+public:
+    static constexpr int SLOT_SIZE = 16;      ///< 每个样本槽位字节数
+    static constexpr int HEADER_SIZE = 8;     ///< 写指针 + 保留 + 样本总数
+    static constexpr int MAX_SLOTS = 1024;    ///< 槽位数上限
+
+    S7SampleRing() = default;
+
+    S7SampleRing(const S7SampleRing&) = delete;
+    S7SampleRing& operator=(const S7SampleRing&) = delete;
+
+    /**
+     * @brief 设置 DB 位置和槽位数（配置加载时调用，清空镜像）
+     *
+     * @param db_number DB 编号
+     * @param offset 环在 DB 中的起始字节偏移（需为偶数）
+     * @param slots 槽位数，0 表示禁用
+     * @return bool false=参数无效（环被禁用）
+     */
+    bool configure(int db_number, int offset, int slots);
+
+    bool enabled() const { return slots_ > 0; }
+    int slots() const { return slots_; }
+
+    /**
+     * @brief 追加一个已编码的样本（SLOT_SIZE 字节）
+     */
+    void push(const uint8_t* block);
+
+    /**
+     * @brief 是否有尚未写入 PLC 的样本
+     */
+    bool dirty() const { return pending_ > 0; }
+
+    /// @brief 尚未写入 PLC 的样本数
+    int pending() const { return pending_; }
+
+    /**
+     * @brief 将整个环标记为待写（重连后调用，PLC 可能已重启）
+     */
+    void mark_all_dirty() {
+        if (slots_ > 0) {
+            pending_ = slots_;
+        }
+    }
+
+    /**
+     * @brief 写出待写槽位和写指针
+     *
+     * @param client Snap7 客户端
+     * @param pdu_length 协商的 PDU 长度，用于判断能否合并为一次请求
+     * @return int 0=成功或无需写入；否则为 Snap7 错误码（区间保留）
+     */
+    int flush(S7Object client, int pdu_length);
+
+    /// @brief 上一次 flush() 写出的样本数
+    int last_samples() const { return last_samples_; }
+
+    /// @brief 上一次 flush() 写出的字节数（槽位 + 写指针区）
+    int last_bytes() const { return last_bytes_; }
+
+    /// @brief 写出前被覆盖的样本数（累计；PLC 端也可由样本总数判断）
+    uint64_t overwritten() const { return overwritten_; }
+
+private:
+    void write_header();
+
+    std::vector<uint8_t> image_;   ///< 槽位 + 写指针的镜像
+    int db_number_ = 0;
+    int offset_ = 0;
+    int slots_ = 0;
+    int write_slot_ = 0;           ///< 下一个要写的槽位
+    int pending_ = 0;              ///< 尚未写出的样本数（不超过 slots_）
+    uint32_t total_ = 0;           ///< 样本总数（回绕）
+    int last_samples_ = 0;
+    int last_bytes_ = 0;
+    uint64_t overwritten_ = 0;
+};
+
+#endif // GATEWAY_S7_SAMPLE_RING_H
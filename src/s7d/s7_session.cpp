@@ -0,0 +1,457 @@
+#include "s7_session.h"
+
+#include "../common/logger.h"
+
+#include <cstring>
+#include <arpa/inet.h>
+
+void s7_encode_block(const NormalizedData& data, uint8_t* buffer) {
+    std::memset(buffer, 0, S7_BLOCK_SIZE);
+    
+    // 1. 写入厚度值 (Float32, Big-Endian)
+    union {
+        float f;
+        uint32_t u;
+    } thickness;
+    thickness.f = data.thickness_mm;
+    uint32_t thickness_be = htonl(thickness.u);
+    std::memcpy(buffer + 0, &thickness_be, 4);
+    
+    // 2. 写入时间戳 (Uint64, Big-Endian, 分成高低32位)
+    uint64_t timestamp_ms = data.timestamp_ns / 1000000ULL;
+    uint32_t timestamp_low = htonl(static_cast<uint32_t>(timestamp_ms & 0xFFFFFFFFULL));
+    uint32_t timestamp_high = htonl(static_cast<uint32_t>(timestamp_ms >> 32));
+    std::memcpy(buffer + 4, &timestamp_low, 4);
+    std::memcpy(buffer + 8, &timestamp_high, 4);
+    
+    // 3. 写入状态位 (Word, Big-Endian)
+    uint16_t status_be = htons(data.status);
+    std::memcpy(buffer + 12, &status_be, 2);
+    
+    // 4. 写入序列号 (Word, Big-Endian)
+    uint16_t sequence_be = htons(static_cast<uint16_t>(data.sequence & 0xFFFF));
+    std::memcpy(buffer + 14, &sequence_be, 2);
+}
+
+S7Session::S7Session(const ConfigManager::S7Config& cfg, bool active)
+    : cfg_(cfg), active_(active), next_cycle_(Clock::now()) {
+    // 客户端在主线程创建，后台线程只调用 Cli_ConnectTo()
+    client_ = Cli_Create();
+    if (!client_) {
+        LOG_ERROR("[%s] 创建 S7 客户端失败", cfg_.name.c_str());
+        active_ = false;
+    }
+    
+    if (!sample_ring_.configure(cfg_.db_number, cfg_.ring_offset, cfg_.ring_slots)) {
+        LOG_WARN("[%s] S7 样本环已禁用,只写通道块", cfg_.name.c_str());
+    }
+    
+    // 自定义变量映射；无效时回退到默认通道块布局
+    if (!tag_map_.compile(cfg_.tags, cfg_.db_number)) {
+        LOG_WARN("[%s] S7 变量映射无效,使用默认数据布局", cfg_.name.c_str());
+    }
+    if (tag_map_.active() && cfg_.async_write) {
+        // 异步接口一次只能写一个区域，变量映射走同步批量写入（同样一次往返）
+        LOG_WARN("[%s] 已配置 S7 变量映射,async_write 不生效", cfg_.name.c_str());
+    }
+    
+    // 断线缓存: 样本环通道的样本在断线期间落盘，恢复后从最旧的开始补发
+    if (cfg_.outbox.enabled) {
+        if (!sample_ring_.enabled()) {
+            // 通道块只保存最新值，补发旧样本没有意义
+            LOG_WARN("[%s] S7 outbox 需要启用 sample_ring,已忽略", cfg_.name.c_str());
+        } else {
+            outbox_.open(static_cast<size_t>(cfg_.outbox.capacity > 0 ? cfg_.outbox.capacity : 1), cfg_.outbox.path);
+            LOG_INFO("[%s] S7 outbox: 容量 %zu, 已缓存 %zu", cfg_.name.c_str(), outbox_.capacity(), outbox_.size());
+        }
+    }
+    
+    // 每通道死区过滤: 只有通过过滤的样本才标记为待写
+    for (auto& filter : filters_) {
+        filter.configure(cfg_.deadband);
+    }
+    
+    LOG_INFO("[%s] PLC %s (Rack=%d, Slot=%d, DB=%d), 间隔 %d ms, %s写入",
+             cfg_.name.c_str(), cfg_.plc_ip.c_str(), cfg_.rack, cfg_.slot, cfg_.db_number,
+             cfg_.update_interval_ms, cfg_.async_write ? "异步" : "同步");
+    if (sample_ring_.enabled()) {
+        LOG_INFO("[%s] 样本环: 通道 %d, %d 槽, DBB%d 起",
+                 cfg_.name.c_str(), cfg_.ring_channel, cfg_.ring_slots, cfg_.ring_offset);
+    }
+    
+    start_connector();
+}
+
+S7Session::~S7Session() {
+    // 未补发的样本留在文件中，下次启动继续
+    outbox_.close();
+    
+    // 停止连接线程后断开连接（线程可能刚连上、尚未被接管）
+    connector_.stop();
+    async_writer_.reset();
+    disconnect();
+    if (client_) {
+        Cli_Destroy(&client_);
+    }
+}
+
+bool S7Session::connect() {
+    int result = Cli_ConnectTo(client_, cfg_.plc_ip.c_str(), cfg_.rack, cfg_.slot);
+    if (result == 0) {
+        LOG_INFO("[%s] S7 连接成功: %s (Rack=%d, Slot=%d)", cfg_.name.c_str(), cfg_.plc_ip.c_str(), cfg_.rack, cfg_.slot);
+        return true;
+    }
+    char error_text[256];
+    Cli_ErrorText(result, error_text, 256);
+    LOG_ERROR("[%s] S7 连接失败: %s (错误码: 0x%08X)", cfg_.name.c_str(), error_text, result);
+    return false;
+}
+
+void S7Session::disconnect() {
+    if (client_) {
+        Cli_Disconnect(client_);
+    }
+    connected_ = false;
+}
+
+int S7Session::pdu_length() const {
+    int requested = 0;
+    int negotiated = 0;
+    if (!client_ || Cli_GetPduLength(client_, &requested, &negotiated) != 0) {
+        return 0;
+    }
+    return negotiated;
+}
+
+void S7Session::start_connector() {
+    if (!active_) {
+        return;
+    }
+    ConnectWorker::Options options;
+    options.host = cfg_.plc_ip;
+    options.port = 102;  // ISO-on-TCP
+    options.probe_timeout_ms = cfg_.reconnect.probe_timeout_ms;
+    options.initial_backoff_ms = cfg_.reconnect.initial_backoff_ms;
+    options.max_backoff_ms = cfg_.reconnect.max_backoff_ms;
+    LOG_INFO("[%s] 开始连接 PLC: %s ...", cfg_.name.c_str(), cfg_.plc_ip.c_str());
+    connector_.start(options, [this]() { return connect(); });
+}
+
+void S7Session::drop_connection() {
+    // 链路错误: 放弃在途异步作业并断开，交给后台线程重连
+    LOG_WARN("[%s] S7 连接断开,将尝试重连", cfg_.name.c_str());
+    async_writer_.reset();
+    disconnect();
+    LOG_INFO("[%s] S7 已断开连接", cfg_.name.c_str());
+    connector_.connection_lost();
+}
+
+void S7Session::on_connected() {
+    connected_ = true;
+    batch_.set_pdu_length(pdu_length());
+    LOG_INFO("[%s] S7 协商 PDU 长度: %d 字节", cfg_.name.c_str(), batch_.pdu_length());
+    // PLC 可能已重启，整个样本环重新写一遍
+    sample_ring_.mark_all_dirty();
+    // PLC 中的值可能已过期，重连后第一个样本一定写入
+    for (auto& filter : filters_) {
+        filter.reset();
+    }
+}
+
+void S7Session::report_error(const char* what, int result) {
+    char error_text[256];
+    Cli_ErrorText(result, error_text, 256);
+    LOG_ERROR("[%s] %s: %s (错误码: 0x%08X)", cfg_.name.c_str(), what, error_text, result);
+}
+
+void S7Session::on_sample(const NormalizedData& data) {
+    if (data.channel < MAX_CHANNELS) {
+        latest_[data.channel] = data;
+        seen_[data.channel] = true;
+        // 样本时间戳与 get_timestamp_ns() 同为单调时钟
+        if (filters_[data.channel].should_publish(data, data.timestamp_ns)) {
+            fresh_[data.channel] = true;
+        }
+    }
+    if (sample_ring_.enabled() && data.channel == cfg_.ring_channel) {
+        if (outbox_.is_open() && active_ && (!connected_ || !outbox_.empty())) {
+            // 断线中或仍有积压: 排在积压之后，保证 PLC 按时间顺序收到
+            outbox_.push(data);
+        } else {
+            uint8_t block[S7_BLOCK_SIZE];
+            s7_encode_block(data, block);
+            sample_ring_.push(block);
+        }
+    }
+}
+
+void S7Session::write_channels() {
+    bool submitted = true;
+    if (cfg_.async_write && !tag_map_.active()) {
+        // 有新数据的通道区间 [first, last]，中间通道用已有最新值补齐，一次写完；
+        // 从未收到样本的中间通道写全 0 块（状态字无 DATA_VALID，即无效）
+        int first = -1;
+        int last = -1;
+        for (int ch = 0; ch < MAX_CHANNELS; ++ch) {
+            if (fresh_[ch]) {
+                if (first < 0) first = ch;
+                last = ch;
+            }
+        }
+        
+        if (first >= 0 && async_writer_.busy()) {
+            // 上一次写入尚未完成，数据保留到下一周期（届时只写最新值）
+            busy_cycles_++;
+            submitted = false;
+        } else if (first >= 0) {
+            for (int ch = first; ch <= last; ++ch) {
+                uint8_t* block = async_block_ + (ch - first) * S7_BLOCK_SIZE;
+                if (seen_[ch]) {
+                    s7_encode_block(latest_[ch], block);
+                } else {
+                    memset(block, 0, S7_BLOCK_SIZE);
+                }
+            }
+            int result = async_writer_.start(client_, cfg_.db_number, first * S7_BLOCK_SIZE,
+                                             async_block_, (last - first + 1) * S7_BLOCK_SIZE);
+            total_writes_++;
+            if (result == 0) {
+                // 应答返回后再确认死区基准
+                for (int ch = 0; ch < MAX_CHANNELS; ++ch) {
+                    async_fresh_[ch] = fresh_[ch];
+                    async_data_[ch] = latest_[ch];
+                }
+            } else {
+                report_error("S7 异步写入提交失败", result);
+                failed_writes_++;
+                if (S7BatchWriter::is_link_error(result)) {
+                    drop_connection();
+                } else {
+                    // 下一周期重试
+                    revert_fresh();
+                    submitted = false;
+                }
+            }
+        }
+    } else {
+        // 同步模式: 各通道数据（或变量映射的各段传输）合并写入
+        if (tag_map_.active()) {
+            tag_map_.stage(latest_, seen_, fresh_, MAX_CHANNELS, batch_);
+        } else {
+            uint8_t block[S7_BLOCK_SIZE];
+            for (int ch = 0; ch < MAX_CHANNELS; ++ch) {
+                if (!fresh_[ch]) continue;
+                s7_encode_block(latest_[ch], block);
+                batch_.add(S7AreaDB, cfg_.db_number, ch * S7_BLOCK_SIZE, block, S7_BLOCK_SIZE);
+            }
+        }
+        
+        const int items = batch_.item_count();
+        if (items > 0) {
+            int result = batch_.flush(client_);
+            total_writes_ += static_cast<uint64_t>(items);
+            if (result == 0) {
+                LOG_DEBUG("[%s] S7 写入成功: %d 个变量, %d 次请求", cfg_.name.c_str(), items, batch_.last_requests());
+                for (int ch = 0; ch < MAX_CHANNELS; ++ch) {
+                    if (fresh_[ch]) {
+                        filters_[ch].confirm(latest_[ch], latest_[ch].timestamp_ns);
+                    }
+                }
+            } else {
+                report_error("S7 写入失败", result);
+                if (S7BatchWriter::is_link_error(result)) {
+                    // 链路错误说明连接已断开
+                    failed_writes_ += static_cast<uint64_t>(items);
+                    drop_connection();
+                } else {
+                    failed_writes_ += static_cast<uint64_t>(batch_.last_item_errors() > 0 ? batch_.last_item_errors() : items);
+                    // 失败的值不作为死区基准；无法区分是哪个变量失败，全部通道下一周期重写
+                    revert_fresh();
+                    submitted = false;
+                }
+            }
+        }
+    }
+    if (submitted) {
+        for (bool& f : fresh_) {
+            f = false;
+        }
+    }
+}
+
+void S7Session::revert_fresh() {
+    for (int ch = 0; ch < MAX_CHANNELS; ++ch) {
+        if (fresh_[ch]) {
+            filters_[ch].revert();
+        }
+    }
+}
+
+void S7Session::run_cycle() {
+    // 连接管理: 后台线程连接成功后在这里接管客户端
+    if (active_ && !connected_ && connector_.take_connected()) {
+        on_connected();
+    }
+    
+    if (active_ && connected_ && cfg_.async_write) {
+        // 异步模式: 先收取上一次写入的结果
+        int result = 0;
+        if (async_writer_.poll(client_, result)) {
+            if (result == 0) {
+                async_latency_sum_us_ += async_writer_.last_latency_us();
+                async_completed_++;
+                for (int ch = 0; ch < MAX_CHANNELS; ++ch) {
+                    if (async_fresh_[ch]) {
+                        filters_[ch].confirm(async_data_[ch], async_data_[ch].timestamp_ns);
+                    }
+                }
+            } else {
+                report_error("S7 异步写入失败", result);
+                failed_writes_++;
+                if (S7BatchWriter::is_link_error(result)) {
+                    drop_connection();
+                } else {
+                    // PLC 未收到这些通道的值: 基准退回，本周期重写（写入最新值）
+                    for (int ch = 0; ch < MAX_CHANNELS; ++ch) {
+                        if (async_fresh_[ch]) {
+                            filters_[ch].revert();
+                            fresh_[ch] = true;
+                        }
+                    }
+                }
+            }
+            for (bool& f : async_fresh_) {
+                f = false;
+            }
+        }
+    }
+    
+    // 积压补发: 每周期最多 backfill_per_cycle 个，且不超过样本环剩余空间，
+    // PLC 按正常节奏读取时不会漏读
+    if (active_ && connected_ && !outbox_.empty()) {
+        NormalizedData backlog;
+        int moved = 0;
+        while (moved < cfg_.outbox.backfill_per_cycle &&
+               sample_ring_.pending() < sample_ring_.slots() &&
+               outbox_.front(backlog)) {
+            uint8_t block[S7_BLOCK_SIZE];
+            s7_encode_block(backlog, block);
+            sample_ring_.push(block);
+            outbox_.pop();
+            moved++;
+        }
+        if (outbox_.empty()) {
+            LOG_INFO("[%s] S7 outbox 补发完成", cfg_.name.c_str());
+        }
+    }
+    
+    // 样本环: 只写出新增槽位和写指针（异步作业在途时顺延）
+    if (active_ && connected_ && sample_ring_.dirty() && !async_writer_.busy()) {
+        int result = sample_ring_.flush(client_, batch_.pdu_length());
+        total_writes_++;
+        if (result == 0) {
+            LOG_DEBUG("[%s] S7 样本环写入: %d 个样本, %d 字节", cfg_.name.c_str(),
+                      sample_ring_.last_samples(), sample_ring_.last_bytes());
+        } else {
+            report_error("S7 样本环写入失败", result);
+            failed_writes_++;
+            if (S7BatchWriter::is_link_error(result)) {
+                drop_connection();
+            }
+        }
+    }
+    
+    if (active_ && connected_) {
+        write_channels();
+    } else {
+        // 未连接时只保留最新值，连接后由死区过滤器的复位重新写入
+        for (bool& f : fresh_) {
+            f = false;
+        }
+    }
+    
+    outbox_.sync();
+    
+    // 按截止时间调度: 周期 = 更新间隔，与本周期的处理/写入耗时无关
+    const auto period = std::chrono::milliseconds(cfg_.update_interval_ms > 0 ? cfg_.update_interval_ms : 1);
+    next_cycle_ += period;
+    const auto after = Clock::now();
+    while (next_cycle_ <= after) {
+        // 处理超过一个周期: 跳过已错过的时刻，保持原有节拍
+        next_cycle_ += period;
+        missed_deadlines_++;
+    }
+}
+
+void S7Session::log_stats() {
+    if (active_ && total_writes_ > 0) {
+        double error_rate = (double)failed_writes_ / total_writes_ * 100.0;
+        uint64_t suppressed = 0;
+        for (const auto& filter : filters_) {
+            suppressed += filter.suppressed();
+        }
+        LOG_INFO("[%s] S7 统计: 总写入=%llu, 失败=%llu, 失败率=%.2f%%, 超时周期=%llu, 死区抑制(累计)=%llu",
+                cfg_.name.c_str(),
+                static_cast<unsigned long long>(total_writes_),
+                static_cast<unsigned long long>(failed_writes_),
+                error_rate,
+                static_cast<unsigned long long>(missed_deadlines_),
+                static_cast<unsigned long long>(suppressed));
+        if (sample_ring_.enabled() && sample_ring_.overwritten() > 0) {
+            LOG_WARN("[%s] S7 样本环: 累计 %llu 个样本在写出前被覆盖",
+                    cfg_.name.c_str(),
+                    static_cast<unsigned long long>(sample_ring_.overwritten()));
+        }
+        if (cfg_.async_write) {
+            LOG_INFO("[%s] S7 异步写入: 完成=%llu, 平均往返=%llu us, 顺延周期=%llu",
+                    cfg_.name.c_str(),
+                    static_cast<unsigned long long>(async_completed_),
+                    static_cast<unsigned long long>(async_completed_ ? async_latency_sum_us_ / async_completed_ : 0),
+                    static_cast<unsigned long long>(busy_cycles_));
+        }
+    }
+    total_writes_ = 0;
+    failed_writes_ = 0;
+    busy_cycles_ = 0;
+    missed_deadlines_ = 0;
+    async_latency_sum_us_ = 0;
+    async_completed_ = 0;
+}
+
+Json::Value S7Session::status() const {
+    Json::Value conf(Json::objectValue);
+    conf["enabled"] = cfg_.enabled;
+    conf["plc_ip"] = cfg_.plc_ip;
+    conf["rack"] = cfg_.rack;
+    conf["slot"] = cfg_.slot;
+    conf["db_number"] = cfg_.db_number;
+    conf["update_interval_ms"] = cfg_.update_interval_ms;
+    conf["async_write"] = cfg_.async_write;
+    conf["ring_slots"] = cfg_.ring_slots;
+    conf["ring_offset"] = cfg_.ring_offset;
+    conf["ring_channel"] = cfg_.ring_channel;
+    conf["tags"] = static_cast<Json::UInt>(cfg_.tags.size());
+    conf["deadband_absolute"] = cfg_.deadband.absolute;
+    conf["deadband_percent"] = cfg_.deadband.percent;
+    conf["heartbeat_ms"] = cfg_.deadband.heartbeat_ms;
+    
+    Json::Value publish(Json::objectValue);
+    uint64_t published = 0;
+    uint64_t suppressed = 0;
+    for (const auto& filter : filters_) {
+        published += filter.published();
+        suppressed += filter.suppressed();
+    }
+    publish["published"] = static_cast<Json::UInt64>(published);
+    publish["suppressed"] = static_cast<Json::UInt64>(suppressed);
+    publish["outbox_size"] = static_cast<Json::UInt64>(outbox_.size());
+    publish["outbox_dropped"] = static_cast<Json::UInt64>(outbox_.dropped());
+    
+    Json::Value status(Json::objectValue);
+    status["name"] = cfg_.name;
+    status["connected"] = connected_;
+    status["config"] = conf;
+    status["publish"] = publish;
+    status["connection"] = connector_.stats();
+    return status;
+}
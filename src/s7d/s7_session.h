@@ -0,0 +1,148 @@
+/**
+ * @file s7_session.h
+ * @brief 单个 PLC 的 S7 会话
+ *
+ * 同一份厚度数据常常需要同时送到产线 PLC 和质量 PLC。s7d 为每个配置的 PLC
+ * 建立一个 S7Session，各自拥有:
+ * - Snap7 客户端和后台连接线程（指数退避重连）
+ * - 写入方式（批量 / 异步）、变量映射、样本环、断线缓存、死区过滤
+ * - 更新周期和截止时间
+ *
+ * 主循环只读取一次环形缓冲区，把样本分发给所有会话（on_sample），
+ * 再按各会话的截止时间调用 run_cycle()；一个会话断线或阻塞在重连上
+ * 不影响其他会话。
+ *
+ * @author Gateway Project
+ * @date 2025-10-28
+ */
+
+#ifndef GATEWAY_S7_SESSION_H
+#define GATEWAY_S7_SESSION_H
+
+#include "../common/config.h"
+#include "../common/connect_worker.h"
+#include "../common/deadband.h"
+#include "../common/ndm.h"
+#include "../common/outbox.h"
+#include "s7_async_writer.h"
+#include "s7_batch_writer.h"
+#include "s7_sample_ring.h"
+#include "s7_tag_map.h"
+
+#include <json/json.h>
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+extern "C" {
+    #include <snap7.h>
+}
+
+/// @brief 默认布局中每个通道的数据块大小
+constexpr int S7_BLOCK_SIZE = 16;
+
+/**
+ * @brief 把一条数据编码为 DB 块数据区
+ *
+ * 数据布局 (16字节):
+ * - Byte 0-3:  Float32 - 厚度值 (Big-Endian)
+ * - Byte 4-7:  DWord - 时间戳低32位 (Big-Endian)
+ * - Byte 8-11: DWord - 时间戳高32位 (Big-Endian)
+ * - Byte 12-13: Word - 状态位 (Big-Endian)
+ * - Byte 14-15: Word - 序列号 (Big-Endian)
+ *
+ * @param data 归一化数据
+ * @param buffer 输出缓冲区 (S7_BLOCK_SIZE 字节)
+ */
+void s7_encode_block(const NormalizedData& data, uint8_t* buffer);
+
+/**
+ * @class S7Session
+ * @brief 一个 PLC 的连接、写入计划与统计
+ */
+class S7Session {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr int MAX_CHANNELS = S7TagMap::MAX_CHANNELS;
+
+    /**
+     * @param cfg 该 PLC 的配置
+     * @param active S7 协议是否激活（未激活时不连接，只保留状态）
+     */
+    S7Session(const ConfigManager::S7Config& cfg, bool active);
+    ~S7Session();
+
+    S7Session(const S7Session&) = delete;
+    S7Session& operator=(const S7Session&) = delete;
+
+    const std::string& name() const { return cfg_.name; }
+    const ConfigManager::S7Config& config() const { return cfg_; }
+    bool connected() const { return connected_; }
+
+    /**
+     * @brief 处理一个样本（每个样本都会调用）
+     */
+    void on_sample(const NormalizedData& data);
+
+    /// @brief 下一次 run_cycle() 的时间
+    Clock::time_point deadline() const { return next_cycle_; }
+
+    /**
+     * @brief 执行一个写入周期并计算下一次截止时间
+     */
+    void run_cycle();
+
+    /**
+     * @brief 输出并清零 10 秒统计
+     */
+    void log_stats();
+
+    /**
+     * @brief 会话状态（配置摘要、发布/重连统计）
+     */
+    Json::Value status() const;
+
+private:
+    bool connect();
+    void disconnect();
+    int pdu_length() const;
+    void start_connector();
+    void drop_connection();
+    void on_connected();
+    void report_error(const char* what, int result);
+    void write_channels();
+    void revert_fresh();
+
+    ConfigManager::S7Config cfg_;
+    bool active_;
+    S7Object client_ = 0;
+    bool connected_ = false;
+
+    S7BatchWriter batch_;
+    S7AsyncWriter async_writer_;
+    uint8_t async_block_[MAX_CHANNELS * S7_BLOCK_SIZE];
+    S7SampleRing sample_ring_;
+    S7TagMap tag_map_;
+    Outbox outbox_;
+    DeadbandFilter filters_[MAX_CHANNELS];
+    ConnectWorker connector_;
+
+    NormalizedData latest_[MAX_CHANNELS] = {};
+    bool seen_[MAX_CHANNELS] = {};    ///< 通道是否收到过样本（未收到的通道不编码数据）
+    bool fresh_[MAX_CHANNELS] = {};
+    bool async_fresh_[MAX_CHANNELS] = {};           ///< 在途异步写入中有新数据的通道（应答后确认死区基准）
+    NormalizedData async_data_[MAX_CHANNELS] = {};  ///< 在途异步写入中各通道的样本
+    Clock::time_point next_cycle_;
+
+    // 统计信息（每10秒清零）
+    uint64_t total_writes_ = 0;
+    uint64_t failed_writes_ = 0;
+    uint64_t busy_cycles_ = 0;        ///< 异步写入未完成、数据顺延的周期数
+    uint64_t missed_deadlines_ = 0;   ///< 处理超时、跳过的调度周期数
+    uint64_t async_latency_sum_us_ = 0;
+    uint64_t async_completed_ = 0;
+};
+
+#endif // GATEWAY_S7_SESSION_H
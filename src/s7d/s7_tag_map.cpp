@@ -0,0 +1,262 @@
+#include "s7_tag_map.h"
+
+#include "../common/logger.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <ctime>
+
+namespace {
+
+bool parse_field(const std::string& name, S7TagMap::Field& field) {
+    if (name == "thickness") field = S7TagMap::Field::THICKNESS;
+    else if (name == "timestamp") field = S7TagMap::Field::TIMESTAMP;
+    else if (name == "status") field = S7TagMap::Field::STATUS;
+    else if (name == "sequence") field = S7TagMap::Field::SEQUENCE;
+    else return false;
+    return true;
+}
+
+bool parse_type(const std::string& name, S7TagMap::Type& type) {
+    if (name == "REAL") type = S7TagMap::Type::REAL;
+    else if (name == "DINT") type = S7TagMap::Type::DINT;
+    else if (name == "WORD") type = S7TagMap::Type::WORD;
+    else if (name == "LREAL") type = S7TagMap::Type::LREAL;
+    else if (name == "DTL") type = S7TagMap::Type::DTL;
+    else return false;
+    return true;
+}
+
+bool parse_area(const std::string& name, int& area) {
+    if (name == "DB") area = S7AreaDB;
+    else if (name == "M") area = S7AreaMK;
+    else if (name == "Q") area = S7AreaPA;
+    else return false;
+    return true;
+}
+
+/// @brief 按大端序写入 size 字节；little=true 时整体倒序
+void put_bytes(uint8_t* dst, uint64_t value, int size, bool little) {
+    for (int i = 0; i < size; ++i) {
+        const int shift = little ? i * 8 : (size - 1 - i) * 8;
+        dst[i] = static_cast<uint8_t>(value >> shift);
+    }
+}
+
+/// @brief DTL: Year(UInt) Month Day Weekday Hour Minute Second(USInt) Nanosecond(UDInt)
+void put_dtl(uint8_t* dst, uint64_t monotonic_ns) {
+    // 样本时间戳为单调时钟（自启动起），先换算为 UTC 墙上时间
+    const uint64_t timestamp_ns = ndm_wall_time_ns(monotonic_ns);
+    const time_t seconds = static_cast<time_t>(timestamp_ns / 1000000000ULL);
+    const uint32_t nanos = static_cast<uint32_t>(timestamp_ns % 1000000000ULL);
+    struct tm utc;
+    gmtime_r(&seconds, &utc);
+
+    put_bytes(dst, static_cast<uint64_t>(utc.tm_year + 1900), 2, false);
+    dst[2] = static_cast<uint8_t>(utc.tm_mon + 1);
+    dst[3] = static_cast<uint8_t>(utc.tm_mday);
+    dst[4] = static_cast<uint8_t>(utc.tm_wday + 1);  // 1=星期日
+    dst[5] = static_cast<uint8_t>(utc.tm_hour);
+    dst[6] = static_cast<uint8_t>(utc.tm_min);
+    dst[7] = static_cast<uint8_t>(utc.tm_sec);
+    put_bytes(dst + 8, nanos, 4, false);
+}
+
+} // namespace
+
+int S7TagMap::type_size(Type type) {
+    switch (type) {
+        case Type::REAL:  return 4;
+        case Type::DINT:  return 4;
+        case Type::WORD:  return 2;
+        case Type::LREAL: return 8;
+        case Type::DTL:   return 12;
+    }
+    return 0;
+}
+
+bool S7TagMap::compile(const std::vector<ConfigManager::S7Config::Tag>& tags, int default_db) {
+    tags_.clear();
+    transfers_.clear();
+    buffer_.clear();
+    dirty_.clear();
+
+    std::vector<Tag> parsed;
+    parsed.reserve(tags.size());
+    for (size_t i = 0; i < tags.size(); ++i) {
+        const auto& src = tags[i];
+        Tag tag{};
+        if (!parse_field(src.field, tag.field)) {
+            LOG_ERROR("S7 变量 %zu: 未知字段 '%s'", i, src.field.c_str());
+            return false;
+        }
+        if (!parse_type(src.type, tag.type)) {
+            LOG_ERROR("S7 变量 %zu: 未知类型 '%s'", i, src.type.c_str());
+            return false;
+        }
+        if (tag.type == Type::DTL && tag.field != Field::TIMESTAMP) {
+            LOG_ERROR("S7 变量 %zu: DTL 只能用于 timestamp", i);
+            return false;
+        }
+        // timestamp 为 Unix 毫秒（约 1.7e12）: REAL 精度不足、WORD 放不下，
+        // DINT 只能放 Unix 秒（scale ≤ 0.001，到 2038 年）
+        if (tag.field == Field::TIMESTAMP &&
+            (tag.type == Type::REAL || tag.type == Type::WORD ||
+             (tag.type == Type::DINT && std::fabs(src.scale) > 0.001))) {
+            LOG_ERROR("S7 变量 %zu: timestamp 应为 LREAL / DTL，或 DINT 且 scale 不大于 0.001 (Unix 秒)", i);
+            return false;
+        }
+        if (!parse_area(src.area, tag.area)) {
+            LOG_ERROR("S7 变量 %zu: 未知区域 '%s'", i, src.area.c_str());
+            return false;
+        }
+        if (src.byte_order != "big" && src.byte_order != "little") {
+            LOG_ERROR("S7 变量 %zu: 字节序应为 big 或 little", i);
+            return false;
+        }
+        if (src.offset < 0) {
+            LOG_ERROR("S7 变量 %zu: 偏移无效", i);
+            return false;
+        }
+        if (src.channel < 0 || src.channel >= MAX_CHANNELS) {
+            LOG_ERROR("S7 变量 %zu: 通道 %d 超出范围 (0-%d)", i, src.channel, MAX_CHANNELS - 1);
+            return false;
+        }
+        tag.little_endian = (src.byte_order == "little");
+        tag.channel = static_cast<uint16_t>(src.channel);
+        tag.db_number = (tag.area == S7AreaDB) ? (src.db_number >= 0 ? src.db_number : default_db) : 0;
+        tag.offset = src.offset;
+        tag.scale = src.scale;
+        parsed.push_back(tag);
+    }
+
+    std::sort(parsed.begin(), parsed.end(), [](const Tag& a, const Tag& b) {
+        if (a.area != b.area) return a.area < b.area;
+        if (a.db_number != b.db_number) return a.db_number < b.db_number;
+        return a.offset < b.offset;
+    });
+
+    // 相同区域/DB 内首尾相接的变量合并为一次传输；有间隔时分开（不覆盖中间字节）
+    size_t used = 0;
+    for (auto& tag : parsed) {
+        const int size = type_size(tag.type);
+        if (!transfers_.empty()) {
+            Transfer& last = transfers_.back();
+            if (last.area == tag.area && last.db_number == tag.db_number) {
+                const int end = last.start + last.length;
+                if (tag.offset < end) {
+                    LOG_ERROR("S7 变量地址重叠: 区域 0x%02X DB%d 偏移 %d", tag.area, tag.db_number, tag.offset);
+                    tags_.clear();
+                    transfers_.clear();
+                    return false;
+                }
+                if (tag.offset == end) {
+                    tag.transfer = transfers_.size() - 1;
+                    tag.buffer_offset = last.buffer_offset + static_cast<size_t>(last.length);
+                    last.length += size;
+                    used += static_cast<size_t>(size);
+                    tags_.push_back(tag);
+                    continue;
+                }
+            }
+        }
+        Transfer transfer{tag.area, tag.db_number, tag.offset, size, used};
+        tag.transfer = transfers_.size();
+        tag.buffer_offset = used;
+        transfers_.push_back(transfer);
+        used += static_cast<size_t>(size);
+        tags_.push_back(tag);
+    }
+
+    if (transfers_.size() > static_cast<size_t>(S7BatchWriter::MAX_ITEMS) || used > S7BatchWriter::BUFFER_SIZE) {
+        LOG_ERROR("S7 变量映射过大: %zu 次传输, %zu 字节", transfers_.size(), used);
+        tags_.clear();
+        transfers_.clear();
+        return false;
+    }
+
+    buffer_.assign(used, 0);
+    dirty_.assign(transfers_.size(), 0);
+    if (!tags_.empty()) {
+        LOG_INFO("S7 变量映射: %zu 个变量合并为 %zu 次传输 (%zu 字节)",
+                 tags_.size(), transfers_.size(), used);
+    }
+    return true;
+}
+
+void S7TagMap::encode(const Tag& tag, const NormalizedData& data) {
+    uint8_t* dst = buffer_.data() + tag.buffer_offset;
+
+    if (tag.type == Type::DTL) {
+        put_dtl(dst, data.timestamp_ns);
+        return;
+    }
+
+    double value = 0.0;
+    switch (tag.field) {
+        case Field::THICKNESS: value = data.thickness_mm; break;
+        case Field::TIMESTAMP: value = static_cast<double>(ndm_wall_time_ns(data.timestamp_ns) / 1000000ULL); break;
+        case Field::STATUS:    value = data.status; break;
+        case Field::SEQUENCE:  value = static_cast<double>(data.sequence); break;
+    }
+    value *= tag.scale;
+
+    switch (tag.type) {
+        case Type::REAL: {
+            float f = static_cast<float>(value);
+            uint32_t raw;
+            std::memcpy(&raw, &f, sizeof(raw));
+            put_bytes(dst, raw, 4, tag.little_endian);
+            break;
+        }
+        case Type::LREAL: {
+            uint64_t raw;
+            std::memcpy(&raw, &value, sizeof(raw));
+            put_bytes(dst, raw, 8, tag.little_endian);
+            break;
+        }
+        case Type::DINT: {
+            // 超出范围时饱和，而不是回绕
+            const double clamped = std::min(std::max(std::round(value), -2147483648.0), 2147483647.0);
+            put_bytes(dst, static_cast<uint32_t>(static_cast<int32_t>(clamped)), 4, tag.little_endian);
+            break;
+        }
+        case Type::WORD: {
+            // 序列号等计数值取低 16 位，与默认布局一致
+            const uint64_t raw = (tag.field == Field::SEQUENCE)
+                ? static_cast<uint64_t>(value) & 0xFFFF
+                : static_cast<uint64_t>(std::min(std::max(std::round(value), 0.0), 65535.0));
+            put_bytes(dst, raw, 2, tag.little_endian);
+            break;
+        }
+        case Type::DTL:
+            break;
+    }
+}
+
+int S7TagMap::stage(const NormalizedData* latest, const bool* seen, const bool* fresh, int channels,
+                    S7BatchWriter& batch) {
+    for (const auto& tag : tags_) {
+        if (tag.channel < channels && fresh[tag.channel]) {
+            dirty_[tag.transfer] = 1;
+        }
+    }
+
+    int staged = 0;
+    for (const auto& tag : tags_) {
+        if (dirty_[tag.transfer] && tag.channel < channels && seen[tag.channel]) {
+            encode(tag, latest[tag.channel]);
+        }
+    }
+    for (size_t i = 0; i < transfers_.size(); ++i) {
+        if (!dirty_[i]) {
+            continue;
+        }
+        const Transfer& t = transfers_[i];
+        batch.add(t.area, t.db_number, t.start, buffer_.data() + t.buffer_offset, t.length);
+        dirty_[i] = 0;
+        staged++;
+    }
+    return staged;
+}
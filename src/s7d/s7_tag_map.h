@@ -0,0 +1,112 @@
+/**
+ * @file s7_tag_map.h
+ * @brief 可配置的 S7 变量映射（地址/类型/字节序）与合并写入计划
+ *
+ * 默认布局（DBB(N*16) 起的 16 字节通道块）固定在程序中，接入已有 PLC 程序时
+ * 往往需要改 PLC。配置 protocol.s7.tags 后，每个变量单独指定:
+ * - field: thickness / timestamp / status / sequence（timestamp 为 Unix 时间，毫秒，UTC）
+ * - channel: 数据通道
+ * - area: DB / M / Q，db: DB 编号（缺省为 db_number），offset: 字节偏移
+ * - type: REAL / DINT / WORD / LREAL / DTL（timestamp 只能用 LREAL / DTL，或 DINT 存 Unix 秒）
+ * - byte_order: big（S7 原生）/ little
+ * - scale: 写入前乘以该系数（如 timestamp 毫秒 ×0.001 得到 DINT 的 Unix 秒）
+ *
+ * 加载时把变量按 (区域, DB, 偏移) 排序，地址首尾相接的变量合并为一次传输，
+ * 生成固定的写入计划；运行时只编码到计划缓冲区并由 S7BatchWriter 写出，
+ * 不做堆分配。
+ *
+ * @author Gateway Project
+ * @date 2025-10-26
+ */
+
+#ifndef GATEWAY_S7_TAG_MAP_H
+#define GATEWAY_S7_TAG_MAP_H
+
+#include "../common/config.h"
+#include "../common/ndm.h"
+#include "s7_batch_writer.h"
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class S7TagMap
+ * @brief 编译后的变量写入计划
+ */
+class S7TagMap {
+public:
+    enum class Field : uint8_t { THICKNESS, TIMESTAMP, STATUS, SEQUENCE };
+    enum class Type : uint8_t { REAL, DINT, WORD, LREAL, DTL };
+
+    static constexpr int MAX_CHANNELS = 16;   ///< 可引用的通道数（0 起）
+
+    S7TagMap() = default;
+
+    S7TagMap(const S7TagMap&) = delete;
+    S7TagMap& operator=(const S7TagMap&) = delete;
+
+    /**
+     * @brief 编译变量列表
+     *
+     * @param tags 配置中的变量列表（为空时清空计划）
+     * @param default_db 未指定 db 时使用的 DB 编号
+     * @return bool false=配置无效（计划被清空，调用方回退到默认布局）
+     */
+    bool compile(const std::vector<ConfigManager::S7Config::Tag>& tags, int default_db);
+
+    /// @brief 是否配置了变量映射
+    bool active() const { return !tags_.empty(); }
+
+    size_t tag_count() const { return tags_.size(); }
+    size_t transfer_count() const { return transfers_.size(); }
+
+    /**
+     * @brief 编码并加入有新数据的传输
+     *
+     * 传输中任一变量所属通道有新数据时，整段传输用各通道最新值重新编码；
+     * 从未收到样本的通道的变量不编码，保持全 0（状态字无 DATA_VALID）。
+     *
+     * @param latest 各通道最新数据
+     * @param seen 各通道是否收到过样本
+     * @param fresh 各通道本周期是否有新数据
+     * @param channels 通道数
+     * @param batch 批量写入器
+     * @return int 加入的传输数
+     */
+    int stage(const NormalizedData* latest, const bool* seen, const bool* fresh, int channels,
+              S7BatchWriter& batch);
+
+    /// @brief 类型占用的字节数
+    static int type_size(Type type);
+
+private:
+    struct Tag {
+        Field field;
+        Type type;
+        bool little_endian;
+        uint16_t channel;
+        int area;
+        int db_number;
+        int offset;
+        double scale;
+        size_t transfer;           ///< 所属传输
+        size_t buffer_offset;      ///< 在计划缓冲区中的位置
+    };
+
+    struct Transfer {
+        int area;
+        int db_number;
+        int start;
+        int length;
+        size_t buffer_offset;
+    };
+
+    void encode(const Tag& tag, const NormalizedData& data);
+
+    std::vector<Tag> tags_;
+    std::vector<Transfer> transfers_;
+    std::vector<uint8_t> buffer_;
+    std::vector<uint8_t> dirty_;    ///< 每个传输本周期是否需要写入
+};
+
+#endif // GATEWAY_S7_TAG_MAP_H
@@ -1,30 +1,35 @@
 #include "../common/logger.h"
 #include "../common/config.h"
 #include "../common/shm_ring.h"
+#include "../common/status_writer.h"
+#include "../common/service_host.h"
 #include <iostream>
 #include <thread>
 #include <chrono>
+#include <atomic>
 #include <csignal>
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
 #include <unistd.h>
 #include <cstring>
+#include <cerrno>
+#include <sys/time.h>
 #include <algorithm>
 #include <cmath>
 #include <sstream>
 #include <memory>
-#include <filesystem>
-#include <fstream>
 #include <json/json.h>
 
+namespace webcfg {
+
 // 全局运行标志
-volatile sig_atomic_t g_running = 1;
+std::atomic<bool> g_running{true};
 static const auto g_start_time = std::chrono::steady_clock::now();
 
 void signal_handler(int signum) {
     LOG_INFO("Received signal %d, shutting down...", signum);
-    g_running = 0;
+    g_running = false;
 }
 
 /**
@@ -51,6 +56,12 @@ public:
         int opt = 1;
         setsockopt(server_fd_, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
         
+        // accept() 最多阻塞 500ms，以便检查退出标志（gatewayd 中由 stop() 置位）
+        struct timeval accept_timeout;
+        accept_timeout.tv_sec = 0;
+        accept_timeout.tv_usec = 500000;
+        setsockopt(server_fd_, SOL_SOCKET, SO_RCVTIMEO, &accept_timeout, sizeof(accept_timeout));
+        
         struct sockaddr_in address;
         address.sin_family = AF_INET;
         address.sin_addr.s_addr = INADDR_ANY;
@@ -88,7 +99,7 @@ public:
             
             int client_fd = accept(server_fd_, (struct sockaddr*)&client_addr, &client_len);
             if (client_fd < 0) {
-                if (g_running) {
+                if (g_running && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR) {
                     LOG_ERROR("Failed to accept connection");
                 }
                 continue;
@@ -126,7 +137,8 @@ public:
                     response = handle_404();
                 }
                 
-                send(client_fd, response.c_str(), response.length(), 0);
+                // 客户端提前关闭连接时不产生 SIGPIPE（托管模式下会终止整个网关）
+                send(client_fd, response.c_str(), response.length(), MSG_NOSIGNAL);
             }
             
             close(client_fd);
@@ -151,11 +163,13 @@ private:
     std::string handle_status(RingBuffer* ring) {
         Json::Value root;
         ConfigManager& config = ConfigManager::instance();
-        auto rs485_cfg = config.get_rs485_config();
-        auto modbus_cfg = config.get_modbus_config();
-        auto s7_cfg = config.get_s7_config();
-        auto opcua_cfg = config.get_opcua_config();
-        auto active_protocol = config.get_string("protocol.active", "modbus");
+        // 同一个快照中的各项配置彼此一致，且不复制配置结构体
+        const auto snap = config.snapshot();
+        const auto& rs485_cfg = snap->rs485;
+        const auto& modbus_cfg = snap->modbus;
+        const auto& s7_cfg = snap->s7;
+        const auto& opcua_cfg = snap->opcua;
+        const auto& active_protocol = snap->active_protocol;
         
         static bool has_prev = false;
         static uint32_t last_sequence_raw = 0;
@@ -173,7 +187,7 @@ private:
         uint64_t samples_in_window = last_samples_window;
         
         // 系统状态
-        root["running"] = (g_running != 0);
+        root["running"] = g_running.load();
         auto now = std::chrono::steady_clock::now();
         auto uptime = std::chrono::duration_cast<std::chrono::seconds>(now - g_start_time).count();
         root["uptime_seconds"] = static_cast<Json::UInt64>(uptime);
@@ -323,6 +337,14 @@ private:
         protocol_stats["opcua"] = read_component_status("opcua");
         root["protocol_stats"] = protocol_stats;
         
+        // 各输出同时运行，分别给出健康状态
+        Json::Value outputs(Json::objectValue);
+        for (const char* name : {"modbus", "s7", "opcua"}) {
+            outputs[name] = output_health(name, protocol_stats[name]);
+        }
+        root["outputs"] = outputs;
+        root["modbus_metrics"] = read_component_status("modbus_metrics");
+        
         return build_json_response("200 OK", root);
     }
     
@@ -464,25 +486,45 @@ private:
         return build_json_response("200 OK", resp);
     }
     
-    Json::Value read_component_status(const std::string& component) const {
-        namespace fs = std::filesystem;
-        fs::path path = fs::path("/tmp/gw-test") / ("status_" + component + ".json");
-        if (!fs::exists(path)) {
-            return Json::Value(Json::nullValue);
-        }
+    /**
+     * @brief 由组件状态汇总一个输出的健康状态
+     *
+     * running: 状态在 OUTPUT_STALE_MS 内更新过；connected: 组件报告的连接状态
+     * （Modbus 为从站，无连接概念，等同 running）；lag/overruns 来自组件的读游标。
+     */
+    Json::Value output_health(const std::string& name, const Json::Value& status) const {
+        static constexpr uint64_t OUTPUT_STALE_MS = 5000;
         
-        std::ifstream ifs(path);
-        if (!ifs.is_open()) {
-            return Json::Value(Json::nullValue);
-        }
+        Json::Value health(Json::objectValue);
+        const bool active = ConfigManager::instance().current().output_active(name);
+        health["active"] = active;
         
-        Json::CharReaderBuilder builder;
-        Json::Value value;
-        std::string errs;
-        if (!Json::parseFromStream(builder, ifs, &value, &errs)) {
-            return Json::Value(Json::nullValue);
+        bool running = false;
+        if (status.isObject() && status.isMember("updated_ms")) {
+            const uint64_t now_ms = get_timestamp_ns() / 1000000ULL;
+            const uint64_t updated_ms = status["updated_ms"].asUInt64();
+            const uint64_t age_ms = now_ms > updated_ms ? now_ms - updated_ms : 0;
+            running = age_ms <= OUTPUT_STALE_MS;
+            health["status_age_ms"] = static_cast<Json::UInt64>(age_ms);
+        } else {
+            health["status_age_ms"] = Json::nullValue;
         }
-        return value;
+        health["running"] = running;
+        
+        const Json::Value extra = status.isObject() ? status["extra"] : Json::Value();
+        const bool connected = running && (extra.isMember("connected") ? extra["connected"].asBool() : true);
+        health["connected"] = connected;
+        if (extra.isMember("ring")) {
+            health["lag"] = extra["ring"]["lag"];
+            health["overruns"] = extra["ring"]["overruns"];
+        }
+        health["healthy"] = !active || connected;
+        return health;
+    }
+    
+    Json::Value read_component_status(const std::string& component) const {
+        // 从共享内存状态表读取，仅在请求时生成 JSON
+        return StatusWriter::read_component_status(component);
     }
     
     std::string handle_index() {
@@ -585,6 +627,24 @@ const char* index_html = R"HTML(
             text-align: right;
             flex: 1;
         }
+        .metrics-table {
+            width: 100%;
+            border-collapse: collapse;
+            font-size: 13px;
+        }
+        .metrics-table th,
+        .metrics-table td {
+            padding: 6px 10px;
+            border-bottom: 1px solid #e5e8ec;
+            text-align: right;
+        }
+        .metrics-table th:first-child,
+        .metrics-table td:first-child {
+            text-align: left;
+        }
+        .metrics-table td {
+            font-family: "SFMono-Regular", Consolas, "Liberation Mono", Menlo, monospace;
+        }
         .status-indicator {
             display: inline-block;
             width: 12px;
@@ -868,6 +928,22 @@ const char* index_html = R"HTML(
             </div>
         </div>
         
+        <div class="section">
+            <h2>Modbus 请求统计</h2>
+            <table class="metrics-table">
+                <thead>
+                    <tr><th>客户端</th><th>请求/秒</th><th>请求数</th><th>异常</th><th>收/发字节</th><th>p50</th><th>p99</th><th>空闲</th></tr>
+                </thead>
+                <tbody id="modbus-clients"><tr><td colspan="8">等待数据...</td></tr></tbody>
+            </table>
+            <table class="metrics-table" style="margin-top:12px;">
+                <thead>
+                    <tr><th>功能码</th><th>请求数</th><th>异常</th><th>收/发字节</th><th>平均</th><th>p50</th><th>p99</th></tr>
+                </thead>
+                <tbody id="modbus-functions"><tr><td colspan="7">等待数据...</td></tr></tbody>
+            </table>
+        </div>
+        
         <div class="section">
             <h2>通信统计</h2>
             <div class="grid-two">
@@ -1058,8 +1134,10 @@ const char* index_html = R"HTML(
         const PROTOCOL_LABELS = {
             modbus: "Modbus TCP",
             s7: "S7 模拟",
-            opcua: "OPC UA 模拟"
+            opcua: "OPC UA 模拟",
+            all: "全部已启用的输出"
         };
+        const ACTIVE_CHOICES = ["all", ...PROTOCOLS];
         const BAUD_RATES = [9600, 19200, 38400, 57600, 115200];
         const SECURITY_MODES = ["None", "Sign", "SignAndEncrypt"];
         const CHART_POINTS = 300;
@@ -1232,6 +1310,7 @@ const char* index_html = R"HTML(
                     }
                     
                     updateProtocolCards(data);
+                    updateModbusMetrics(data);
                 })
                 .catch(err => {
                     console.error('获取状态失败:', err);
@@ -1274,7 +1353,7 @@ const char* index_html = R"HTML(
             
             const protoSelect = document.getElementById('form-active-protocol');
             protoSelect.innerHTML = '';
-            PROTOCOLS.forEach(proto => {
+            ACTIVE_CHOICES.forEach(proto => {
                 const option = document.createElement('option');
                 option.value = proto;
                 option.textContent = PROTOCOL_LABELS[proto];
@@ -1323,7 +1402,7 @@ const char* index_html = R"HTML(
         function populateConfigForm(config) {
             if (!config) return;
             const protoConfig = config.protocol || {};
-            document.getElementById('form-active-protocol').value = protoConfig.active || 'modbus';
+            document.getElementById('form-active-protocol').value = protoConfig.active || 'all';
             
             const rs485 = config.rs485 || {};
             document.getElementById('form-poll-rate').value = rs485.poll_rate_ms ?? 10;
@@ -1421,7 +1500,8 @@ const char* index_html = R"HTML(
         function updateProtocolCards(data) {
             const stats = data.protocol_stats || {};
             const protoConfig = data.config && data.config.protocol ? data.config.protocol : {};
-            const active = protoConfig.active || 'modbus';
+            const active = protoConfig.active || 'all';
+            const outputs = data.outputs || {};
             PROTOCOLS.forEach(proto => {
                 const card = document.querySelector(`[data-protocol-card="${proto}"]`);
                 if (!card) return;
@@ -1433,18 +1513,20 @@ const char* index_html = R"HTML(
                 const meta = card.querySelector('[data-role="meta"]');
                 const lastUpdate = card.querySelector('[data-role="last-update"]');
                 const statusText = card.querySelector('[data-role="status-text"]');
-                const isActive = active === proto;
+                // 多个输出可同时转发: 以服务端按配置计算的 outputs.<proto>.active 为准
+                const health = outputs[proto] || null;
+                const isActive = health ? health.active === true : active === proto;
                 const workerActive = info && info.active === true;
                 
                 card.classList.toggle('is-selected', isActive);
                 if (button) {
-                    button.disabled = isActive;
-                    button.textContent = isActive ? '当前协议' : `切换至 ${PROTOCOL_LABELS[proto]}`;
+                    button.disabled = active === proto;
+                    button.textContent = active === proto ? '当前协议' : `切换至 ${PROTOCOL_LABELS[proto]}`;
                 }
                 
                 if (indicator) {
                     indicator.classList.toggle('is-active', workerActive);
-                    indicator.classList.toggle('is-warning', isActive && !workerActive);
+                    indicator.classList.toggle('is-warning', isActive && (!workerActive || (health && !health.healthy)));
                     indicator.textContent = workerActive ? '转发中' : (isActive ? '待激活' : '待机');
                 }
                 
@@ -1462,6 +1544,9 @@ const char* index_html = R"HTML(
                 } else if (proto === 'opcua') {
                     metaText = `${configDetail.server_url || '--'} · 安全 ${configDetail.security_mode || 'None'}`;
                 }
+                if (health && Number.isFinite(health.lag)) {
+                    metaText += ` · 积压 ${health.lag}` + (health.overruns ? ` / 丢失 ${health.overruns}` : '');
+                }
                 meta.textContent = metaText;
                 
                 if (info && typeof info.updated_ms === 'number') {
@@ -1485,6 +1570,39 @@ const char* index_html = R"HTML(
             });
         }
         
+        function formatMicros(us) {
+            if (!Number.isFinite(us)) return '--';
+            return us >= 1000 ? `${(us / 1000).toFixed(1)} ms` : `${us} µs`;
+        }
+        
+        function updateModbusMetrics(data) {
+            const clientsBody = document.getElementById('modbus-clients');
+            const functionsBody = document.getElementById('modbus-functions');
+            if (!clientsBody || !functionsBody) return;
+            const metrics = data.modbus_metrics && data.modbus_metrics.extra ? data.modbus_metrics.extra : null;
+            if (!metrics) {
+                clientsBody.innerHTML = '<tr><td colspan="8">暂无统计</td></tr>';
+                functionsBody.innerHTML = '<tr><td colspan="7">暂无统计</td></tr>';
+                return;
+            }
+            
+            const clients = metrics.clients || [];
+            clientsBody.innerHTML = clients.length === 0
+                ? '<tr><td colspan="8">尚无客户端请求</td></tr>'
+                : clients.map(c => `<tr><td>${c.client}</td><td>${(c.rate_per_s || 0).toFixed(1)}</td>`
+                    + `<td>${c.requests}</td><td>${c.exceptions}</td><td>${c.bytes_in}/${c.bytes_out}</td>`
+                    + `<td>${formatMicros(c.p50_us)}</td><td>${formatMicros(c.p99_us)}</td>`
+                    + `<td>${formatAge(c.idle_ms)}</td></tr>`).join('');
+            
+            const functions = metrics.functions || [];
+            functionsBody.innerHTML = functions.length === 0
+                ? '<tr><td colspan="7">尚无请求</td></tr>'
+                : functions.map(f => `<tr><td>FC${String(f.function).padStart(2, '0')}</td>`
+                    + `<td>${f.requests}</td><td>${f.exceptions}</td><td>${f.bytes_in}/${f.bytes_out}</td>`
+                    + `<td>${formatMicros(f.avg_us)}</td><td>${formatMicros(f.p50_us)}</td>`
+                    + `<td>${formatMicros(f.p99_us)}</td></tr>`).join('');
+        }
+        
         function updateCharts(latencyMs, dropCount, thicknessValue, sampleRate) {
             if (!Number.isFinite(latencyMs)) latencyMs = 0;
             if (!Number.isFinite(dropCount)) dropCount = 0;
@@ -1670,16 +1788,12 @@ const char* index_html = R"HTML(
 /**
  * Web Config Daemon Main Function
  */
-int main(int argc, char* argv[]) {
-    // 初始化日志
-    Logger::init("webcfg", false);
+int run(int argc, char* argv[]) {
+    // 初始化日志和信号处理
+    ServiceHost::init("webcfg", signal_handler);
     
     LOG_INFO("Web Config Daemon starting...");
     
-    // 注册信号处理
-    signal(SIGINT, signal_handler);
-    signal(SIGTERM, signal_handler);
-    
     // 加载配置
     ConfigManager& config = ConfigManager::instance();
     
@@ -1724,3 +1838,18 @@ int main(int argc, char* argv[]) {
     LOG_INFO("Web Config Daemon stopped");
     return 0;
 }
+
+/**
+ * @brief 请求退出（gatewayd 收到信号时调用）
+ */
+void stop() {
+    g_running = false;
+}
+
+}  // namespace webcfg
+
+#ifndef GATEWAY_HOSTED
+int main(int argc, char* argv[]) {
+    return webcfg::run(argc, argv);
+}
+#endif
@@ -0,0 +1,140 @@
+/**
+ * @file test_config_watcher.cpp
+ * @brief 配置文件监视测试程序
+ *
+ * 功能：
+ * 1. 以 rename() 方式替换配置文件后，监视器重新加载并分发新快照
+ * 2. 只调用变化分区的回调（修改 protocol.modbus 不触发 S7 回调）
+ * 3. 同一进程内后启动的监视器订阅共享监视器，同样收到新快照
+ * 4. 内容不变的保存不触发任何回调
+ *
+ * 编译:
+ *   g++ -o test_config_watcher test_config_watcher.cpp ../src/common/config_watcher.cpp ../src/common/config.cpp \
+ *       ../src/common/logger.cpp -I../src -I/usr/include/jsoncpp -std=c++17 -ljsoncpp -lpthread
+ *
+ * 使用:
+ *   ./test_config_watcher [示例配置文件] [临时目录]
+ *
+ * @author Gateway Project
+ * @date 2025-11-02
+ */
+
+#include "common/config_watcher.h"
+
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+#include <json/json.h>
+
+using namespace std;
+
+// 颜色输出宏
+#define COLOR_RED     "\033[0;31m"
+#define COLOR_GREEN   "\033[0;32m"
+#define COLOR_RESET   "\033[0m"
+
+static int g_failures = 0;
+
+#define CHECK(cond) do { \
+        if (cond) { \
+            cout << COLOR_GREEN << "[PASS]  " << COLOR_RESET << #cond << endl; \
+        } else { \
+            cout << COLOR_RED << "[FAIL]  " << COLOR_RESET << #cond << " (line " << __LINE__ << ")" << endl; \
+            g_failures++; \
+        } \
+    } while (0)
+
+/**
+ * @brief 像 webcfg 一样写临时文件后 rename() 替换
+ */
+static bool write_config(const string& path, const Json::Value& root) {
+    const string tmp = path + ".tmp";
+    {
+        ofstream out(tmp);
+        if (!out) {
+            return false;
+        }
+        Json::StreamWriterBuilder builder;
+        builder["indentation"] = "  ";
+        out << Json::writeString(builder, root);
+    }
+    return rename(tmp.c_str(), path.c_str()) == 0;
+}
+
+/**
+ * @brief 等待监视器分发，最长 timeout_ms
+ * @return uint32_t 变化的分区，0=超时
+ */
+static uint32_t wait_dispatch(ConfigWatcher& watcher, int timeout_ms) {
+    const auto deadline = chrono::steady_clock::now() + chrono::milliseconds(timeout_ms);
+    while (chrono::steady_clock::now() < deadline) {
+        watcher.wait_until(deadline);
+        const uint32_t changed = watcher.dispatch();
+        if (changed != 0) {
+            return changed;
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char* argv[]) {
+    const string source = argc > 1 ? argv[1] : "../config/config.json";
+    const string dir = argc > 2 ? argv[2] : "/tmp";
+    const string path = dir + "/config_watcher_test.json";
+
+    Json::Value root;
+    {
+        ifstream in(source);
+        Json::CharReaderBuilder builder;
+        string errors;
+        if (!in || !Json::parseFromStream(builder, in, &root, &errors)) {
+            cout << COLOR_RED << "无法读取示例配置: " << source << COLOR_RESET << endl;
+            return 1;
+        }
+    }
+    CHECK(write_config(path, root));
+    CHECK(ConfigManager::instance().load(path));
+
+    // 与 gatewayd 相同: 先启动共享监视器，各服务的监视器订阅它
+    ConfigWatcher shared(path);
+    ConfigWatcher subscriber(path);
+    int modbus_port = 0;
+    int s7_calls = 0;
+    int subscriber_port = 0;
+    shared.on_change(ConfigWatcher::MODBUS, [&](const ConfigManager::Snapshot& cfg) { modbus_port = cfg.modbus.port; });
+    shared.on_change(ConfigWatcher::S7, [&](const ConfigManager::Snapshot&) { s7_calls++; });
+    subscriber.on_change(ConfigWatcher::MODBUS,
+                         [&](const ConfigManager::Snapshot& cfg) { subscriber_port = cfg.modbus.port; });
+    shared.start_shared();
+    subscriber.start();
+
+    // 修改 Modbus 端口
+    const int new_port = root["protocol"]["modbus"]["port"].asInt() + 1;
+    root["protocol"]["modbus"]["port"] = new_port;
+    CHECK(write_config(path, root));
+    CHECK(wait_dispatch(shared, 3000) == ConfigWatcher::MODBUS);
+    CHECK(modbus_port == new_port);
+    CHECK(s7_calls == 0);
+    CHECK(wait_dispatch(subscriber, 3000) == ConfigWatcher::MODBUS);
+    CHECK(subscriber_port == new_port);
+
+    // 内容不变: 重新加载但没有分区变化
+    CHECK(write_config(path, root));
+    CHECK(wait_dispatch(shared, 500) == 0);
+    CHECK(modbus_port == new_port && s7_calls == 0);
+
+    subscriber.stop();
+    shared.stop();
+    unlink(path.c_str());
+
+    if (g_failures > 0) {
+        cout << COLOR_RED << g_failures << " 项检查失败" << COLOR_RESET << endl;
+        return 1;
+    }
+    cout << COLOR_GREEN << "全部检查通过" << COLOR_RESET << endl;
+    return 0;
+}
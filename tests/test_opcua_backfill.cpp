@@ -0,0 +1,181 @@
+/**
+ * @file test_opcua_backfill.cpp
+ * @brief OPC UA 断线缓存补发窗口测试程序（不需要服务器）
+ *
+ * 功能：
+ * 1. 全部成功: 应答按顺序出队，在途请求始终是缓存中最旧的样本
+ * 2. 注入一次失败: 不再发起新的补发，其后的应答不出队；
+ *    在途请求全部完成后从失败的样本重新开始，积压最终清空
+ *
+ * 编译:
+ *   g++ -o test_opcua_backfill test_opcua_backfill.cpp ../src/common/outbox.cpp ../src/common/logger.cpp \
+ *       -I../src -std=c++17
+ *
+ * 使用:
+ *   ./test_opcua_backfill
+ *
+ * @author Gateway Project
+ * @date 2025-11-03
+ */
+
+#include "common/outbox.h"
+#include "opcuad/opcua_backfill.h"
+
+#include <deque>
+#include <iostream>
+#include <vector>
+
+using namespace std;
+
+// 颜色输出宏
+#define COLOR_RED     "\033[0;31m"
+#define COLOR_GREEN   "\033[0;32m"
+#define COLOR_RESET   "\033[0m"
+
+static int g_failures = 0;
+
+#define CHECK(cond) do { \
+        if (cond) { \
+            cout << COLOR_GREEN << "[PASS]  " << COLOR_RESET << #cond << endl; \
+        } else { \
+            cout << COLOR_RED << "[FAIL]  " << COLOR_RESET << #cond << " (line " << __LINE__ << ")" << endl; \
+            g_failures++; \
+        } \
+    } while (0)
+
+/**
+ * @brief 模拟主循环中的补发与应答处理（与 opcuad 的处理顺序相同）
+ */
+struct Harness {
+    Outbox outbox;
+    OpcuaBackfill backfill;
+    deque<uint32_t> in_flight;      ///< 在途请求中的序列号（按发送顺序）
+    vector<uint32_t> written;       ///< 服务器确认写入的序列号
+
+    /// @brief 补发一轮，最多 window 个在途
+    int send(int window) {
+        int sent = 0;
+        size_t index = 0;
+        NormalizedData data;
+        while (static_cast<int>(in_flight.size()) < window && backfill.next(index) && outbox.at(index, data)) {
+            in_flight.push_back(data.sequence);
+            backfill.sent();
+            sent++;
+        }
+        return sent;
+    }
+
+    /// @brief 最早的在途请求完成
+    void complete(bool ok) {
+        const uint32_t sequence = in_flight.front();
+        in_flight.pop_front();
+        if (ok) {
+            written.push_back(sequence);
+        }
+        if (backfill.complete(ok)) {
+            NormalizedData head;
+            if (outbox.front(head) && head.sequence != sequence) {
+                cout << COLOR_RED << "[FAIL]  " << COLOR_RESET << "出队 " << head.sequence
+                     << "，应答的是 " << sequence << endl;
+                g_failures++;
+            }
+            outbox.pop();
+        }
+    }
+};
+
+static NormalizedData make_sample(uint32_t sequence) {
+    NormalizedData data{};
+    data.timestamp_ns = get_timestamp_ns();
+    data.sequence = sequence;
+    data.status = NDMStatus::DATA_VALID;
+    ndm_set_crc(data);
+    return data;
+}
+
+/**
+ * @brief 全部成功
+ */
+static void test_success() {
+    Harness h;
+    CHECK(h.outbox.open(16, ""));
+    for (uint32_t i = 1; i <= 6; ++i) {
+        h.outbox.push(make_sample(i));
+    }
+    CHECK(h.send(4) == 4);
+    h.complete(true);
+    h.complete(true);
+    CHECK(h.outbox.size() == 4);
+    // 在途 3、4，接着发送 5、6
+    CHECK(h.send(4) == 2);
+    CHECK(h.in_flight.back() == 6);
+    while (!h.in_flight.empty()) {
+        h.complete(true);
+    }
+    CHECK(h.outbox.empty() && h.backfill.in_flight() == 0);
+    CHECK(h.written == vector<uint32_t>({1, 2, 3, 4, 5, 6}));
+}
+
+/**
+ * @brief 注入一次失败的应答
+ */
+static void test_one_failure() {
+    Harness h;
+    CHECK(h.outbox.open(16, ""));
+    for (uint32_t i = 1; i <= 8; ++i) {
+        h.outbox.push(make_sample(i));
+    }
+    CHECK(h.send(4) == 4);          // 1 2 3 4
+    h.complete(true);               // 1 出队
+    CHECK(h.send(4) == 1);          // 5
+    h.complete(false);              // 2 失败
+    CHECK(h.backfill.failed());
+
+    // 窗口有空位也不再发起补发（否则会重发仍在途的样本）
+    CHECK(h.send(4) == 0);
+    h.complete(true);               // 3
+    CHECK(h.send(4) == 0);
+    h.complete(true);               // 4
+    h.complete(true);               // 5
+    CHECK(h.outbox.size() == 7);    // 只出队了 1
+
+    // 在途请求全部完成: 从失败的样本 2 重新开始
+    CHECK(!h.backfill.failed() && h.backfill.in_flight() == 0);
+    CHECK(h.send(4) == 4);
+    CHECK(h.in_flight.front() == 2 && h.in_flight.back() == 5);
+    while (!h.in_flight.empty()) {
+        h.complete(true);
+        h.send(4);
+    }
+    CHECK(h.outbox.empty());
+    // 3、4、5 重复写入一次，每个样本都至少写入一次
+    CHECK(h.written == vector<uint32_t>({1, 3, 4, 5, 2, 3, 4, 5, 6, 7, 8}));
+}
+
+/**
+ * @brief 连接断开: 在途请求全部以失败完成，重连后从头补发
+ */
+static void test_reset() {
+    Harness h;
+    CHECK(h.outbox.open(16, ""));
+    for (uint32_t i = 1; i <= 3; ++i) {
+        h.outbox.push(make_sample(i));
+    }
+    CHECK(h.send(4) == 3);
+    h.backfill.reset();
+    h.in_flight.clear();
+    CHECK(h.send(4) == 3 && h.in_flight.front() == 1);
+}
+
+int main() {
+    test_success();
+    test_one_failure();
+    test_reset();
+
+    if (g_failures > 0) {
+        cout << COLOR_RED << g_failures << " 项检查失败" << COLOR_RESET << endl;
+        return 1;
+    }
+    cout << COLOR_GREEN << "全部检查通过" << COLOR_RESET << endl;
+    return 0;
+}
@@ -0,0 +1,155 @@
+/**
+ * @file test_opcua_node_map.cpp
+ * @brief OPC UA 节点 ID 解析测试程序
+ *
+ * 功能：
+ * 1. 字符串 / 数值 / GUID / 命名空间 URI 格式的节点 ID
+ * 2. 省略 ns 时为命名空间 0，索引与数值范围检查
+ * 3. 无效格式被拒绝，配置中任一 ID 无效时整体回退到默认节点
+ * 4. 写入模板引用解析后的节点（不访问服务器）
+ *
+ * 编译:
+ *   g++ -o test_opcua_node_map test_opcua_node_map.cpp ../src/opcuad/opcua_node_map.cpp \
+ *       ../src/common/logger.cpp -I../src -I/usr/include/jsoncpp -std=c++17 -lopen62541
+ *
+ * 使用:
+ *   ./test_opcua_node_map
+ *
+ * @author Gateway Project
+ * @date 2025-11-02
+ */
+
+#include "opcuad/opcua_node_map.h"
+
+#include <cstring>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+// 颜色输出宏
+#define COLOR_RED     "\033[0;31m"
+#define COLOR_GREEN   "\033[0;32m"
+#define COLOR_RESET   "\033[0m"
+
+static int g_failures = 0;
+
+#define CHECK(cond) do { \
+        if (cond) { \
+            cout << COLOR_GREEN << "[PASS]  " << COLOR_RESET << #cond << endl; \
+        } else { \
+            cout << COLOR_RED << "[FAIL]  " << COLOR_RESET << #cond << " (line " << __LINE__ << ")" << endl; \
+            g_failures++; \
+        } \
+    } while (0)
+
+/**
+ * @brief 各种合法格式
+ */
+static void test_valid() {
+    OpcuaNodeMap::ParsedId id;
+
+    CHECK(OpcuaNodeMap::parse("ns=2;s=Gateway.Thickness", id));
+    CHECK(id.ns == 2 && id.type == 's' && id.text == "Gateway.Thickness" && id.ns_uri.empty());
+
+    // 字符串 ID 中可以包含 ';' 和 '='
+    CHECK(OpcuaNodeMap::parse("ns=4;s=Line1;Gauge=A", id));
+    CHECK(id.ns == 4 && id.text == "Line1;Gauge=A");
+
+    CHECK(OpcuaNodeMap::parse("ns=3;i=1001", id));
+    CHECK(id.ns == 3 && id.type == 'i' && id.numeric == 1001);
+
+    CHECK(OpcuaNodeMap::parse("i=2258", id));
+    CHECK(id.ns == 0 && id.type == 'i' && id.numeric == 2258);
+
+    CHECK(OpcuaNodeMap::parse("ns=65535;i=4294967295", id));
+    CHECK(id.ns == 65535 && id.numeric == 4294967295u);
+
+    CHECK(OpcuaNodeMap::parse("ns=2;g=09087e75-8e5e-499b-954f-F2A9603DB28A", id));
+    CHECK(id.type == 'g' && id.guid.data1 == 0x09087e75u && id.guid.data2 == 0x8e5e && id.guid.data3 == 0x499b);
+    CHECK(id.guid.data4[0] == 0x95 && id.guid.data4[1] == 0x4f && id.guid.data4[2] == 0xf2 &&
+          id.guid.data4[7] == 0x8a);
+
+    CHECK(OpcuaNodeMap::parse("nsu=http://example.com/line1;s=Thickness", id));
+    CHECK(id.ns_uri == "http://example.com/line1" && id.text == "Thickness" && id.ns == 0);
+}
+
+/**
+ * @brief 非法格式
+ */
+static void test_invalid() {
+    OpcuaNodeMap::ParsedId id;
+    const char* const invalid[] = {
+        "",
+        "Gateway.Thickness",          // 缺少标识符类型
+        "ns=2",                       // 缺少 ';'
+        "ns=;s=A",                    // 空索引
+        "ns=65536;s=A",               // 索引超出 UInt16
+        "ns=-1;s=A",
+        "ns=2;i=",                    // 空数值
+        "ns=2;i=12a",
+        "ns=2;i=4294967296",          // 超出 UInt32
+        "ns=2;x=1",                   // 未知类型
+        "ns=2;s=",                    // 空字符串 ID
+        "nsu=;s=A",                   // 空 URI
+        "ns=2;g=09087e75-8e5e-499b-954f",            // GUID 长度不对
+        "ns=2;g=09087e75x8e5e-499b-954f-f2a9603db28a",
+        "ns=2;g=0908ZZ75-8e5e-499b-954f-f2a9603db28a",
+    };
+    for (const char* text : invalid) {
+        const bool parsed = OpcuaNodeMap::parse(text, id);
+        if (parsed) {
+            cout << COLOR_RED << "[FAIL]  " << COLOR_RESET << "应拒绝: '" << text << "'" << endl;
+            g_failures++;
+        }
+    }
+    cout << COLOR_GREEN << "[PASS]  " << COLOR_RESET << "非法格式全部拒绝 (" << sizeof(invalid) / sizeof(invalid[0])
+         << " 项)" << endl;
+}
+
+/**
+ * @brief configure(): 回退与模板
+ */
+static void test_configure() {
+    ConfigManager::OPCUAConfig::Nodes nodes;
+    nodes.thickness = "ns=3;i=1001";
+    nodes.timestamp = "ns=3;s=Line.Timestamp";
+    nodes.status = "ns=3;s=Line.Status";
+    nodes.sequence = "ns=3;s=Line.Sequence";
+
+    OpcuaNodeMap map;
+    CHECK(map.configure(nodes));
+    CHECK(map.ready());
+    const UA_WriteValue* templates = map.templates();
+    CHECK(templates[OpcuaNodeMap::THICKNESS].nodeId.identifierType == UA_NODEIDTYPE_NUMERIC);
+    CHECK(templates[OpcuaNodeMap::THICKNESS].nodeId.identifier.numeric == 1001);
+    CHECK(templates[OpcuaNodeMap::THICKNESS].attributeId == UA_ATTRIBUTEID_VALUE);
+    const UA_String& text = templates[OpcuaNodeMap::STATUS].nodeId.identifier.string;
+    CHECK(templates[OpcuaNodeMap::STATUS].nodeId.namespaceIndex == 3 &&
+          string(reinterpret_cast<const char*>(text.data), text.length) == "Line.Status");
+
+    // 任一无效: 4 个节点全部回退到默认值
+    nodes.sequence = "ns=3;q=bad";
+    CHECK(!map.configure(nodes));
+    CHECK(map.ready());
+    CHECK(map.text(OpcuaNodeMap::THICKNESS) == "ns=2;s=Gateway.Thickness");
+    CHECK(map.text(OpcuaNodeMap::SEQUENCE) == "ns=2;s=Gateway.Sequence");
+
+    // 命名空间 URI: 连接后才能构造模板
+    nodes.sequence = "nsu=http://example.com/line1;s=Sequence";
+    CHECK(map.configure(nodes));
+    CHECK(!map.ready());
+}
+
+int main() {
+    test_valid();
+    test_invalid();
+    test_configure();
+
+    if (g_failures > 0) {
+        cout << COLOR_RED << g_failures << " 项检查失败" << COLOR_RESET << endl;
+        return 1;
+    }
+    cout << COLOR_GREEN << "全部检查通过" << COLOR_RESET << endl;
+    return 0;
+}
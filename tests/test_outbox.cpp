@@ -0,0 +1,152 @@
+/**
+ * @file test_outbox.cpp
+ * @brief 断线缓存 (Outbox) 测试程序
+ *
+ * 功能：
+ * 1. 内存缓存的顺序、满时丢弃最旧样本
+ * 2. 持久化文件重新打开后积压不丢失（容量相同时原地沿用）
+ * 3. 容量变化时通过临时文件重写，只保留最新的样本
+ * 4. 文件中保存墙上时间，读出时换算回单调时钟
+ *
+ * 编译:
+ *   g++ -o test_outbox test_outbox.cpp ../src/common/outbox.cpp ../src/common/logger.cpp -I../src -std=c++17
+ *
+ * 使用:
+ *   ./test_outbox [临时目录]
+ *
+ * @author Gateway Project
+ * @date 2025-11-02
+ */
+
+#include "common/outbox.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <string>
+#include <unistd.h>
+
+using namespace std;
+
+// 颜色输出宏
+#define COLOR_RED     "\033[0;31m"
+#define COLOR_GREEN   "\033[0;32m"
+#define COLOR_RESET   "\033[0m"
+
+static int g_failures = 0;
+
+#define CHECK(cond) do { \
+        if (cond) { \
+            cout << COLOR_GREEN << "[PASS]  " << COLOR_RESET << #cond << endl; \
+        } else { \
+            cout << COLOR_RED << "[FAIL]  " << COLOR_RESET << #cond << " (line " << __LINE__ << ")" << endl; \
+            g_failures++; \
+        } \
+    } while (0)
+
+/**
+ * @brief 构造一个带 CRC 的样本
+ */
+static NormalizedData make_sample(uint32_t sequence) {
+    NormalizedData data{};
+    data.timestamp_ns = get_timestamp_ns();
+    data.sequence = sequence;
+    data.thickness_mm = 1.0f + static_cast<float>(sequence) / 1000.0f;
+    data.status = NDMStatus::DATA_VALID;
+    ndm_set_crc(data);
+    return data;
+}
+
+/**
+ * @brief 内存缓存: 顺序与丢弃
+ */
+static void test_memory() {
+    Outbox outbox;
+    CHECK(outbox.open(3, ""));
+    for (uint32_t i = 1; i <= 5; ++i) {
+        outbox.push(make_sample(i));
+    }
+    CHECK(outbox.size() == 3);
+    CHECK(outbox.dropped() == 2);
+
+    NormalizedData data;
+    CHECK(outbox.front(data) && data.sequence == 3);
+    CHECK(outbox.at(2, data) && data.sequence == 5);
+    CHECK(!outbox.at(3, data));
+    CHECK(ndm_verify_crc(data));
+
+    outbox.pop();
+    CHECK(outbox.front(data) && data.sequence == 4);
+}
+
+/**
+ * @brief 持久化: 重新打开、容量变化、时间戳
+ */
+static void test_persist(const string& dir) {
+    const string path = dir + "/outbox_test.bin";
+    unlink(path.c_str());
+
+    const NormalizedData first = make_sample(100);
+    {
+        Outbox outbox;
+        CHECK(outbox.open(8, path));
+        outbox.push(first);
+        for (uint32_t i = 101; i < 106; ++i) {
+            outbox.push(make_sample(i));
+        }
+        outbox.pop();   // 100 已补发
+        outbox.sync();
+        // 析构时 close() 写出头部；重新打开时文件容量相同，原地沿用
+    }
+
+    {
+        Outbox outbox;
+        CHECK(outbox.open(8, path));
+        CHECK(outbox.size() == 5);
+
+        NormalizedData data;
+        uint64_t wall_ns = 0;
+        CHECK(outbox.front(data, &wall_ns) && data.sequence == 101);
+        CHECK(ndm_verify_crc(data));
+        // 单调时钟换算误差在 1 ms 内
+        const int64_t skew = static_cast<int64_t>(ndm_wall_time_ns(data.timestamp_ns)) - static_cast<int64_t>(wall_ns);
+        CHECK(skew > -1000000 && skew < 1000000);
+        CHECK(wall_ns > 1500000000ULL * 1000000000ULL);   // 晚于 2017 年，确实是墙上时间
+        outbox.close();
+    }
+
+    {
+        // 容量变小: 重写文件，只保留最新的 3 个
+        Outbox outbox;
+        CHECK(outbox.open(3, path));
+        CHECK(outbox.size() == 3);
+        CHECK(outbox.dropped() == 2);
+        NormalizedData data;
+        CHECK(outbox.front(data) && data.sequence == 103);
+        CHECK(access((path + ".tmp").c_str(), F_OK) != 0);
+        outbox.close();
+    }
+
+    {
+        Outbox outbox;
+        CHECK(outbox.open(3, path));
+        NormalizedData data;
+        CHECK(outbox.size() == 3 && outbox.at(2, data) && data.sequence == 105);
+        outbox.close();
+    }
+
+    unlink(path.c_str());
+}
+
+int main(int argc, char* argv[]) {
+    const string dir = argc > 1 ? argv[1] : "/tmp";
+
+    test_memory();
+    test_persist(dir);
+
+    if (g_failures > 0) {
+        cout << COLOR_RED << g_failures << " 项检查失败" << COLOR_RESET << endl;
+        return 1;
+    }
+    cout << COLOR_GREEN << "全部检查通过" << COLOR_RESET << endl;
+    return 0;
+}
@@ -0,0 +1,410 @@
+/**
+ * @file test_s7_encoding.cpp
+ * @brief S7 样本环与变量映射编码测试程序（不需要 PLC）
+ *
+ * 功能：
+ * 1. 样本环只写出新槽位和写指针区，回绕时分两段，写指针区总在最后
+ * 2. 超过 PDU 时逐个 Cli_DBWrite()，写入失败时待写区间保留
+ * 3. 变量映射的合并、通道范围与地址重叠检查
+ * 4. REAL / DINT / WORD / LREAL / DTL 的字节序与缩放，未收到样本的通道不编码
+ * 5. timestamp 编码为 Unix 时间，放不下毫秒的类型被拒绝
+ *
+ * 本程序自带 Cli_WriteMultiVars / Cli_DBWrite / Cli_WriteArea 的模拟实现，
+ * 写入内存中的 PLC 映像，不链接 libsnap7。
+ *
+ * 编译:
+ *   g++ -o test_s7_encoding test_s7_encoding.cpp ../src/s7d/s7_sample_ring.cpp ../src/s7d/s7_tag_map.cpp \
+ *       ../src/s7d/s7_batch_writer.cpp ../src/common/logger.cpp -I../src -I/usr/include/jsoncpp -std=c++17
+ *
+ * 使用:
+ *   ./test_s7_encoding
+ *
+ * @author Gateway Project
+ * @date 2025-11-02
+ */
+
+#include "s7d/s7_sample_ring.h"
+#include "s7d/s7_tag_map.h"
+
+#include <cstring>
+#include <ctime>
+#include <iostream>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// 颜色输出宏
+#define COLOR_RED     "\033[0;31m"
+#define COLOR_GREEN   "\033[0;32m"
+#define COLOR_RESET   "\033[0m"
+
+static int g_failures = 0;
+
+#define CHECK(cond) do { \
+        if (cond) { \
+            cout << COLOR_GREEN << "[PASS]  " << COLOR_RESET << #cond << endl; \
+        } else { \
+            cout << COLOR_RED << "[FAIL]  " << COLOR_RESET << #cond << " (line " << __LINE__ << ")" << endl; \
+            g_failures++; \
+        } \
+    } while (0)
+
+// ============================================================================
+// 模拟 PLC
+// ============================================================================
+
+/// @brief 一次写入（按到达顺序记录）
+struct PlcWrite {
+    int area;
+    int db_number;
+    int start;
+    int length;
+};
+
+static map<pair<int, int>, vector<uint8_t>> g_memory;   ///< (区域, DB) -> 字节映像
+static vector<PlcWrite> g_writes;
+static int g_requests = 0;
+static int g_fail_code = 0;                               ///< 非 0 时所有请求返回该错误码
+
+static vector<uint8_t>& plc_area(int area, int db_number) {
+    vector<uint8_t>& memory = g_memory[make_pair(area, area == S7AreaDB ? db_number : 0)];
+    if (memory.empty()) {
+        memory.assign(65536, 0);
+    }
+    return memory;
+}
+
+static void plc_write(int area, int db_number, int start, int length, const void* data) {
+    vector<uint8_t>& memory = plc_area(area, db_number);
+    memcpy(memory.data() + start, data, static_cast<size_t>(length));
+    g_writes.push_back({area, db_number, start, length});
+}
+
+static void plc_reset() {
+    g_memory.clear();
+    g_writes.clear();
+    g_requests = 0;
+    g_fail_code = 0;
+}
+
+extern "C" {
+
+int Cli_WriteMultiVars(S7Object, PS7DataItem items, int count) {
+    g_requests++;
+    if (g_fail_code != 0) {
+        return g_fail_code;
+    }
+    for (int i = 0; i < count; ++i) {
+        plc_write(items[i].Area, items[i].DBNumber, items[i].Start, items[i].Amount, items[i].pdata);
+        items[i].Result = 0;
+    }
+    return 0;
+}
+
+int Cli_DBWrite(S7Object, int db_number, int start, int size, void* data) {
+    g_requests++;
+    if (g_fail_code != 0) {
+        return g_fail_code;
+    }
+    plc_write(S7AreaDB, db_number, start, size, data);
+    return 0;
+}
+
+int Cli_WriteArea(S7Object, int area, int db_number, int start, int amount, int, void* data) {
+    g_requests++;
+    if (g_fail_code != 0) {
+        return g_fail_code;
+    }
+    plc_write(area, db_number, start, amount, data);
+    return 0;
+}
+
+}
+
+// ============================================================================
+// 辅助函数
+// ============================================================================
+
+static uint16_t be16(const uint8_t* p) {
+    return static_cast<uint16_t>((p[0] << 8) | p[1]);
+}
+
+static uint32_t be32(const uint8_t* p) {
+    return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) |
+           (static_cast<uint32_t>(p[2]) << 8) | p[3];
+}
+
+static uint32_t le32(const uint8_t* p) {
+    return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+           (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+}
+
+/// @brief 槽位内容: 第一个字节为样本编号，便于检查
+static void make_block(uint8_t* block, uint8_t id) {
+    memset(block, 0, S7SampleRing::SLOT_SIZE);
+    block[0] = id;
+    block[S7SampleRing::SLOT_SIZE - 1] = id;
+}
+
+static NormalizedData make_sample(uint16_t channel, uint32_t sequence, float thickness, uint16_t status) {
+    NormalizedData data{};
+    data.timestamp_ns = get_timestamp_ns();
+    data.sequence = sequence;
+    data.thickness_mm = thickness;
+    data.status = status;
+    data.channel = channel;
+    ndm_set_crc(data);
+    return data;
+}
+
+static ConfigManager::S7Config::Tag make_tag(const char* field, int channel, const char* area, int offset,
+                                             const char* type, const char* byte_order = "big",
+                                             double scale = 1.0) {
+    ConfigManager::S7Config::Tag tag;
+    tag.field = field;
+    tag.channel = channel;
+    tag.area = area;
+    tag.offset = offset;
+    tag.type = type;
+    tag.byte_order = byte_order;
+    tag.scale = scale;
+    return tag;
+}
+
+// ============================================================================
+// 样本环
+// ============================================================================
+
+/**
+ * @brief 样本环: 增量写出、回绕、失败重试与 PDU 回退
+ */
+static void test_ring() {
+    const int DB = 10;
+    const int OFFSET = 100;
+    const int SLOTS = 4;
+    const int HEADER = OFFSET + SLOTS * S7SampleRing::SLOT_SIZE;
+    const S7Object client = 0;
+
+    S7SampleRing ring;
+    CHECK(!ring.configure(DB, 101, SLOTS));        // 奇数偏移
+    CHECK(!ring.enabled());
+    CHECK(ring.configure(DB, OFFSET, 0) && !ring.enabled());
+    CHECK(ring.configure(DB, OFFSET, SLOTS) && ring.enabled());
+
+    // 不回绕: 新槽位 [0, 2) + 写指针区，一次请求两个变量
+    plc_reset();
+    uint8_t block[S7SampleRing::SLOT_SIZE];
+    for (uint8_t id = 1; id <= 2; ++id) {
+        make_block(block, id);
+        ring.push(block);
+    }
+    CHECK(ring.flush(client, 240) == 0);
+    CHECK(g_requests == 1 && g_writes.size() == 2);
+    CHECK(ring.last_samples() == 2);
+    CHECK(ring.last_bytes() == 2 * S7SampleRing::SLOT_SIZE + S7SampleRing::HEADER_SIZE);
+    const uint8_t* db = plc_area(S7AreaDB, DB).data();
+    CHECK(db[OFFSET] == 1 && db[OFFSET + S7SampleRing::SLOT_SIZE] == 2);
+    CHECK(be16(&db[HEADER]) == 2 && be32(&db[HEADER + 4]) == 2);
+    CHECK(g_writes.back().start == HEADER);
+    CHECK(!ring.dirty());
+
+    // 回绕: 槽位 2、3、0 -> [0, 1) 与 [2, 4)+写指针区
+    plc_reset();
+    for (uint8_t id = 3; id <= 5; ++id) {
+        make_block(block, id);
+        ring.push(block);
+    }
+    CHECK(ring.flush(client, 240) == 0);
+    db = plc_area(S7AreaDB, DB).data();
+    CHECK(g_requests == 1 && g_writes.size() == 2);
+    CHECK(g_writes[0].start == OFFSET && g_writes[0].length == S7SampleRing::SLOT_SIZE);
+    CHECK(g_writes[1].start == OFFSET + 2 * S7SampleRing::SLOT_SIZE &&
+          g_writes[1].length == 2 * S7SampleRing::SLOT_SIZE + S7SampleRing::HEADER_SIZE);
+    CHECK(db[OFFSET] == 5 && db[OFFSET + 2 * S7SampleRing::SLOT_SIZE] == 3 &&
+          db[OFFSET + 3 * S7SampleRing::SLOT_SIZE] == 4);
+    CHECK(be16(&db[HEADER]) == 1 && be32(&db[HEADER + 4]) == 5);
+
+    // 写入失败: 区间保留，下一次一起写出
+    plc_reset();
+    make_block(block, 6);
+    ring.push(block);
+    g_fail_code = 0x00100000;
+    CHECK(ring.flush(client, 240) != 0);
+    CHECK(ring.dirty() && ring.pending() == 1);
+    g_fail_code = 0;
+    make_block(block, 7);
+    ring.push(block);
+    CHECK(ring.flush(client, 240) == 0 && ring.last_samples() == 2);
+
+    // 超过 PDU: 逐个 Cli_DBWrite()，写指针区最后到达
+    plc_reset();
+    ring.mark_all_dirty();
+    CHECK(ring.flush(client, 40) == 0);
+    CHECK(g_requests == 2 && g_writes.size() == 2);
+    CHECK(g_writes.back().start + g_writes.back().length == HEADER + S7SampleRing::HEADER_SIZE);
+
+    // 写出前被覆盖
+    for (uint8_t id = 8; id <= 13; ++id) {
+        make_block(block, id);
+        ring.push(block);
+    }
+    CHECK(ring.pending() == SLOTS && ring.overwritten() == 2);
+}
+
+// ============================================================================
+// 变量映射
+// ============================================================================
+
+/**
+ * @brief 变量映射: 合并与配置检查
+ */
+static void test_tag_compile() {
+    S7TagMap map;
+    vector<ConfigManager::S7Config::Tag> tags = {
+        make_tag("thickness", 0, "DB", 0, "REAL"),
+        make_tag("sequence", 0, "DB", 4, "DINT", "little"),
+        make_tag("status", 1, "DB", 8, "WORD"),
+        make_tag("thickness", 1, "DB", 10, "LREAL", "big", 1000.0),
+        make_tag("timestamp", 0, "M", 20, "DTL"),
+    };
+    CHECK(map.compile(tags, 5));
+    CHECK(map.tag_count() == 5 && map.transfer_count() == 2);
+
+    auto invalid = tags;
+    invalid.push_back(make_tag("status", S7TagMap::MAX_CHANNELS, "DB", 100, "WORD"));
+    CHECK(!map.compile(invalid, 5) && !map.active());
+
+    invalid = tags;
+    invalid.push_back(make_tag("status", 0, "DB", 2, "WORD"));     // 与 REAL 重叠
+    CHECK(!map.compile(invalid, 5));
+
+    invalid = tags;
+    invalid.push_back(make_tag("thickness", 0, "DB", 100, "DTL"));
+    CHECK(!map.compile(invalid, 5));
+
+    invalid = tags;
+    invalid.push_back(make_tag("thickness", 0, "DB", 100, "REAL", "middle"));
+    CHECK(!map.compile(invalid, 5));
+
+    // timestamp: 毫秒放不进 DINT / WORD，REAL 精度不足
+    const char* const narrow[] = {"DINT", "WORD", "REAL"};
+    for (const char* type : narrow) {
+        invalid = tags;
+        invalid.push_back(make_tag("timestamp", 0, "DB", 100, type));
+        CHECK(!map.compile(invalid, 5));
+    }
+    auto seconds = tags;
+    seconds.push_back(make_tag("timestamp", 0, "DB", 100, "DINT", "big", 0.001));
+    CHECK(map.compile(seconds, 5));
+}
+
+/**
+ * @brief timestamp 为 Unix 时间（墙上时间，不是自启动起的单调时间）
+ */
+static void test_tag_timestamp() {
+    S7TagMap map;
+    vector<ConfigManager::S7Config::Tag> tags = {
+        make_tag("timestamp", 0, "DB", 0, "LREAL"),
+        make_tag("timestamp", 0, "DB", 8, "DINT", "big", 0.001),
+    };
+    CHECK(map.compile(tags, 7));
+
+    NormalizedData latest[1] = {make_sample(0, 1, 1.0f, NDMStatus::DATA_VALID)};
+    bool seen[1] = {true};
+    bool fresh[1] = {true};
+    plc_reset();
+    S7BatchWriter batch;
+    CHECK(map.stage(latest, seen, fresh, 1, batch) == 1);
+    CHECK(batch.flush(0) == 0);
+
+    const uint8_t* db = plc_area(S7AreaDB, 7).data();
+    uint64_t raw = 0;
+    for (int i = 0; i < 8; ++i) {
+        raw = (raw << 8) | db[i];
+    }
+    double unix_ms = 0.0;
+    memcpy(&unix_ms, &raw, sizeof(unix_ms));
+    const double now_ms = static_cast<double>(time(nullptr)) * 1000.0;
+    CHECK(unix_ms > now_ms - 5000.0 && unix_ms < now_ms + 5000.0);
+    const int64_t unix_s = static_cast<int32_t>(be32(&db[8]));
+    CHECK(unix_s > time(nullptr) - 5 && unix_s < time(nullptr) + 5);
+}
+
+/**
+ * @brief 变量映射: 各类型编码
+ */
+static void test_tag_encode() {
+    S7TagMap map;
+    vector<ConfigManager::S7Config::Tag> tags = {
+        make_tag("thickness", 0, "DB", 0, "REAL"),
+        make_tag("sequence", 0, "DB", 4, "DINT", "little"),
+        make_tag("status", 1, "DB", 8, "WORD"),
+        make_tag("thickness", 1, "DB", 10, "LREAL", "big", 1000.0),
+        make_tag("timestamp", 0, "M", 20, "DTL"),
+    };
+    CHECK(map.compile(tags, 5));
+
+    const int CHANNELS = S7TagMap::MAX_CHANNELS;
+    NormalizedData latest[CHANNELS] = {};
+    bool seen[CHANNELS] = {};
+    bool fresh[CHANNELS] = {};
+    latest[0] = make_sample(0, 42, 1.5f, NDMStatus::DATA_VALID);
+    latest[1] = make_sample(1, 7, 2.25f, 0x0F);
+    seen[0] = fresh[0] = true;
+
+    // 通道 1 未收到样本: 同一传输中它的变量保持全 0
+    plc_reset();
+    S7BatchWriter batch;
+    CHECK(map.stage(latest, seen, fresh, CHANNELS, batch) == 2);
+    CHECK(batch.flush(0) == 0 && g_requests == 1);
+    const uint8_t* db = plc_area(S7AreaDB, 5).data();
+    CHECK(be32(&db[0]) == 0x3FC00000u);           // 1.5f 大端
+    CHECK(le32(&db[4]) == 42);                      // DINT 小端
+    CHECK(be16(&db[8]) == 0 && be32(&db[10]) == 0);
+
+    // DTL: UTC 墙上时间（不是自启动起的单调时间）
+    const uint8_t* mk = plc_area(S7AreaMK, 0).data();
+    time_t now = time(nullptr);
+    struct tm utc;
+    gmtime_r(&now, &utc);
+    CHECK(be16(&mk[20]) == utc.tm_year + 1900);
+    CHECK(mk[22] >= 1 && mk[22] <= 12);          // 月
+
+    // 通道 1 收到样本: 只重写它所在的传输
+    plc_reset();
+    seen[1] = fresh[1] = true;
+    fresh[0] = false;
+    CHECK(map.stage(latest, seen, fresh, CHANNELS, batch) == 1);
+    CHECK(batch.flush(0) == 0);
+    db = plc_area(S7AreaDB, 5).data();
+    CHECK(be16(&db[8]) == 0x0F);
+    uint64_t raw = 0;
+    for (int i = 0; i < 8; ++i) {
+        raw = (raw << 8) | db[10 + i];
+    }
+    double value = 0.0;
+    memcpy(&value, &raw, sizeof(value));
+    CHECK(value == 2250.0);
+    CHECK(be32(&db[0]) == 0x3FC00000u);            // 通道 0 的值按最新值重写
+
+    // 没有新数据: 不写
+    fresh[1] = false;
+    CHECK(map.stage(latest, seen, fresh, CHANNELS, batch) == 0);
+}
+
+int main() {
+    test_ring();
+    test_tag_compile();
+    test_tag_encode();
+    test_tag_timestamp();
+
+    if (g_failures > 0) {
+        cout << COLOR_RED << g_failures << " 项检查失败" << COLOR_RESET << endl;
+        return 1;
+    }
+    cout << COLOR_GREEN << "全部检查通过" << COLOR_RESET << endl;
+    return 0;
+}
@@ -0,0 +1,187 @@
+/**
+ * @file test_status_table.cpp
+ * @brief 状态表 seqlock 测试程序（进程内表，不需要 /dev/shm）
+ *
+ * 功能：
+ * 1. 热字段和详情的写入与读取
+ * 2. 写入方持续更新时，读取方得到的热字段和详情始终是某一次完整写入
+ *
+ * 编译:
+ *   g++ -o test_status_table test_status_table.cpp -I../src -std=c++17 -lpthread
+ *
+ * 使用:
+ *   ./test_status_table [秒数]
+ *
+ * @author Gateway Project
+ * @date 2025-11-02
+ */
+
+#include "common/status_table.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <thread>
+
+using namespace std;
+
+// 颜色输出宏
+#define COLOR_RED     "\033[0;31m"
+#define COLOR_GREEN   "\033[0;32m"
+#define COLOR_RESET   "\033[0m"
+
+static int g_failures = 0;
+
+#define CHECK(cond) do { \
+        if (cond) { \
+            cout << COLOR_GREEN << "[PASS]  " << COLOR_RESET << #cond << endl; \
+        } else { \
+            cout << COLOR_RED << "[FAIL]  " << COLOR_RESET << #cond << " (line " << __LINE__ << ")" << endl; \
+            g_failures++; \
+        } \
+    } while (0)
+
+/**
+ * @brief 第 n 次写入的热字段: 各字段都由 n 推出，便于检查是否混合了两次写入
+ */
+static StatusHot make_hot(uint32_t n) {
+    StatusHot hot{};
+    hot.updated_ns = n;
+    hot.active = static_cast<uint8_t>(n & 1);
+    hot.connected = 1;
+    hot.has_data = 1;
+    hot.has_ring = 1;
+    hot.ring_lag = n;
+    hot.ring_read = static_cast<uint64_t>(n) * 3;
+    hot.ring_overruns = static_cast<uint64_t>(n) * 7;
+    hot.sample.sequence = n;
+    hot.sample.thickness_mm = static_cast<float>(n % 1000);
+    ndm_set_crc(hot.sample);
+    return hot;
+}
+
+static bool hot_consistent(const StatusHot& hot) {
+    const uint32_t n = static_cast<uint32_t>(hot.updated_ns);
+    return hot.ring_lag == n && hot.ring_read == static_cast<uint64_t>(n) * 3 &&
+           hot.ring_overruns == static_cast<uint64_t>(n) * 7 && hot.sample.sequence == n &&
+           ndm_verify_crc(hot.sample);
+}
+
+/**
+ * @brief 第 n 次写入的详情: {"n":<n>,"pad":"xxx..."}，长度随 n 变化
+ */
+static uint32_t make_detail(uint32_t n, char* out) {
+    const int pad = static_cast<int>(n % 4000);
+    int len = snprintf(out, STATUS_DETAIL_SIZE, "{\"n\":%u,\"pad\":\"", n);
+    for (int i = 0; i < pad; ++i) {
+        out[len++] = static_cast<char>('a' + n % 26);
+    }
+    out[len++] = '"';
+    out[len++] = '}';
+    return static_cast<uint32_t>(len);
+}
+
+static bool detail_consistent(const char* text, uint32_t len, uint64_t written_ns) {
+    char expected[STATUS_DETAIL_SIZE];
+    unsigned n = 0;
+    if (len == 0 || sscanf(text, "{\"n\":%u,", &n) != 1 || n != written_ns) {
+        return false;
+    }
+    return make_detail(n, expected) == len && memcmp(expected, text, len) == 0;
+}
+
+/**
+ * @brief 单线程写入与读取
+ */
+static void test_basic(StatusBlock& block) {
+    StatusHot hot;
+    CHECK(block.read_hot(hot) && hot.updated_ns == 0);
+
+    block.write_hot(make_hot(5));
+    CHECK(block.read_hot(hot) && hot_consistent(hot) && hot.updated_ns == 5);
+    CHECK(block.hot_seq.load() == 2);
+
+    char text[STATUS_DETAIL_SIZE];
+    uint32_t len = 1;
+    uint64_t written_ns = 0;
+    CHECK(block.read_detail(text, len, written_ns) && len == 0);
+
+    char detail[STATUS_DETAIL_SIZE];
+    block.write_detail(detail, make_detail(9, detail), 9);
+    CHECK(block.read_detail(text, len, written_ns) && detail_consistent(text, len, written_ns));
+}
+
+/**
+ * @brief 并发: 一个写入线程，两个读取线程
+ */
+static void test_concurrent(StatusBlock& block, int seconds) {
+    atomic<bool> running{true};
+    atomic<uint64_t> reads{0};
+    atomic<uint64_t> torn{0};
+    atomic<uint64_t> busy{0};
+
+    thread writer([&]() {
+        char detail[STATUS_DETAIL_SIZE];
+        for (uint32_t n = 100; running.load(memory_order_relaxed); ++n) {
+            block.write_hot(make_hot(n));
+            if (n % 8 == 0) {
+                block.write_detail(detail, make_detail(n, detail), n);
+            }
+        }
+    });
+
+    auto reader = [&]() {
+        auto text = make_unique<char[]>(STATUS_DETAIL_SIZE);
+        while (running.load(memory_order_relaxed)) {
+            StatusHot hot;
+            if (!block.read_hot(hot)) {
+                busy++;
+            } else if (!hot_consistent(hot)) {
+                torn++;
+            }
+            uint32_t len = 0;
+            uint64_t written_ns = 0;
+            if (!block.read_detail(text.get(), len, written_ns)) {
+                busy++;
+            } else if (!detail_consistent(text.get(), len, written_ns)) {
+                torn++;
+            }
+            reads++;
+        }
+    };
+    thread reader1(reader);
+    thread reader2(reader);
+
+    this_thread::sleep_for(chrono::seconds(seconds));
+    running = false;
+    writer.join();
+    reader1.join();
+    reader2.join();
+
+    cout << "读取 " << reads.load() << " 次，重试用尽 " << busy.load() << " 次" << endl;
+    CHECK(reads.load() > 0);
+    CHECK(torn.load() == 0);
+    CHECK(block.hot_seq.load() % 2 == 0 && block.detail_seq.load() % 2 == 0);
+}
+
+int main(int argc, char* argv[]) {
+    const int seconds = argc > 1 ? atoi(argv[1]) : 2;
+
+    // 与共享内存中一样，从全 0 开始
+    auto block = make_unique<StatusBlock>();
+    memset(static_cast<void*>(block.get()), 0, sizeof(StatusBlock));
+
+    test_basic(*block);
+    test_concurrent(*block, seconds > 0 ? seconds : 1);
+
+    if (g_failures > 0) {
+        cout << COLOR_RED << g_failures << " 项检查失败" << COLOR_RESET << endl;
+        return 1;
+    }
+    cout << COLOR_GREEN << "全部检查通过" << COLOR_RESET << endl;
+    return 0;
+}